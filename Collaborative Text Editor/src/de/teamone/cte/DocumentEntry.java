@@ -0,0 +1,24 @@
+package de.teamone.cte;
+
+public class DocumentEntry
+{
+	public final int editors;
+	public final int modified;
+	public final String name;
+	public final int size;
+	
+	/**
+	 * Standard constructor.
+	 * @param name - document name
+	 * @param size - size of the document in bytes
+	 * @param modified - time of the last modification, seconds since the epoch
+	 * @param editors - amount of users having the document opened
+	 */
+	public DocumentEntry(String name, int size, int modified, int editors)
+	{
+		this.name = name;
+		this.size = size;
+		this.modified = modified;
+		this.editors = editors;
+	}
+}
@@ -0,0 +1,32 @@
+package de.teamone.cte;
+
+public class EditOperation
+{
+	public static enum Kind
+	{
+		KIND_INSERT, // insert bytes (position, bytes)
+		KIND_DELETE, // delete a range (position, length)
+		KIND_REPLACE // replace a range by bytes (position, length, bytes)
+	};
+	
+	public final byte[] bytes;
+	public final Kind kind;
+	public final int length;
+	public final int position;
+	
+	/**
+	 * Standard constructor.
+	 * @param kind
+	 * @param position - start of the operation, relative to the document as left
+	 * 		by the preceding operation of the same batch
+	 * @param length - amount of bytes to delete, ignored for insertions
+	 * @param bytes - bytes to insert, ignored for deletions
+	 */
+	public EditOperation(Kind kind, int position, int length, byte[] bytes)
+	{
+		this.kind = kind;
+		this.position = position;
+		this.length = kind == Kind.KIND_INSERT ? 0 : length;
+		this.bytes = kind == Kind.KIND_DELETE || bytes == null ? new byte[0] : bytes;
+	}
+}
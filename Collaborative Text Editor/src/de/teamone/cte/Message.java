@@ -4,7 +4,7 @@ import java.io.IOException;
 import java.nio.ByteBuffer;
 import java.nio.channels.ReadableByteChannel;
 import java.nio.channels.WritableByteChannel;
-import java.util.Arrays;
+import java.util.List;
 
 public class Message
 {
@@ -33,6 +33,11 @@ public class Message
 		STATUS_USER_CURSOR_UNKNOWN, // user cursor position is unknown
 		STATUS_USER_CURSOR_OUT_OF_BOUNDS, // user cursor position is out of bounds
 		STATUS_USER_LENGTH_TOO_LONG, // specified length is too long
+		STATUS_REVISION_UNKNOWN, // base revision too old or too new, reload the doc
+		STATUS_SESSION_UNKNOWN, // session expired or unknown, log in again
+		STATUS_INVALID_UTF8, // payload is not valid UTF-8
+		STATUS_QUERY_TOO_SHORT, // search query is shorter than 3 bytes
+		STATUS_INVALID_PATTERN, // replace pattern is empty or an invalid regular expression
 		STATUS_NOT_OK, // anything but success
 		STATUS_UNKNOWN // unknown/invalid status
 	};
@@ -54,102 +59,44 @@ public class Message
 		TYPE_USER_LOGIN, // user sends login credentials (name, hash)
 		TYPE_USER_LOGOUT, // user logs out
 		TYPE_USER_JOIN, // server -> client only (a new user connected)
-		TYPE_USER_QUIT; // server -> client only (a user disconnected)
-		
-		/**
-		 * Calculates the total message size for a message of this type.
-		 * @param fromServer - whether the message is from the server or the client
-		 * @param dynamic - used in only two cases:
-		 * 		TYPE_DOC_LIST: amount of document names in the list (from server)
-		 * 		TYPE_SYNC_MULTIBYTE: payload size in Bytes
-		 * 		Needs to be set to 1 if unneeded!
-		 * @return total message size for the respective type and direction in Bytes
-		 */
-		public int getMessageSize(boolean fromServer, int dynamic)
-		{
-			// type is always there
-			int result = FIELD_SIZE_TYPE;
-			
-			// byte field
-			if (this == TYPE_SYNC_BYTE ||
-				this == TYPE_SYNC_MULTIBYTE)
-			{ result += dynamic * FIELD_SIZE_BYTE; }
-			
-			// id field (user id or document id)
-			if (this == TYPE_DOC_ACTIVATE ||
-				this == TYPE_DOC_SAVE ||
-				(fromServer && (
-					this == TYPE_DOC_OPEN ||
-					this == TYPE_USER_JOIN ||
-					this == TYPE_USER_QUIT)
-				))
-			{ result += FIELD_SIZE_ID; }
-			
-			// document name field
-			if (this == TYPE_DOC_CREATE ||
-				this == TYPE_DOC_DELETE ||
-				this == TYPE_DOC_OPEN ||
-				(fromServer && (
-					this == TYPE_DOC_LIST)
-				))
-			{ result += dynamic * FIELD_SIZE_DOC_NAME; }
-			
-			// hash field
-			if (!fromServer && (
-				this == TYPE_DOC_ACTIVATE ||
-				this == TYPE_USER_LOGIN))
-			{ result += FIELD_SIZE_HASH; }
-			
-			// size field
-			if (this == TYPE_SYNC_DELETION ||
-				this == TYPE_SYNC_MULTIBYTE ||
-				(fromServer && (
-					this == TYPE_DOC_LIST ||
-					this == TYPE_SYNC_BYTE)
-				) ||
-				(!fromServer && (
-					this == TYPE_SYNC_CURSOR)
-				))
-			{ result += FIELD_SIZE_SIZE; }
-			
-			// size field (for messages with two size fields)
-			if (this == TYPE_SYNC_DELETION ||
-				(fromServer && (
-					this == TYPE_SYNC_MULTIBYTE)
-				))
-			{ result += FIELD_SIZE_SIZE; }
-			
-			// status field
-			if (fromServer && !(
-				this == TYPE_DOC_LIST ||
-				this == TYPE_SYNC_BYTE ||
-				this == TYPE_SYNC_DELETION ||
-				this == TYPE_SYNC_MULTIBYTE ||
-				this == TYPE_USER_JOIN ||
-				this == TYPE_USER_QUIT))
-			{ result += FIELD_SIZE_STATUS; }
-			
-			// user name field
-			if ((fromServer && (
-					this == TYPE_USER_JOIN)
-				) ||
-				(!fromServer && (
-					this == TYPE_USER_LOGIN)
-				))
-			{ result += FIELD_SIZE_USER_NAME; }
-			
-			return result;
-		}
-		
-		public int getMessageSize(boolean fromServer)
-		{ return getMessageSize(fromServer, 1); }
+		TYPE_USER_QUIT, // server -> client only (a user disconnected)
+		TYPE_PROTOCOL_VERSION, // user requests a protocol version (version)
+		TYPE_SYNC_BATCH, // user sends edit operations applied atomically (revision, operations)
+		TYPE_SYNC_SEQUENCE, // user switches its active doc to sequence mode
+		TYPE_SYNC_MERGE, // user merges sequence operations (id, site, revision, sequence)
+		TYPE_SESSION_TOKEN, // server -> client only (token to resume the session with)
+		TYPE_SESSION_RESUME, // user resumes a dropped session (hash, revision)
+		TYPE_COMPRESSION, // user negotiates the compression of document contents (compression)
+		TYPE_SYNC_COMPRESSED, // server -> client only (position, length, zlib stream)
+		TYPE_DOC_LIST_PAGE, // user lists a page of docs (offset, limit, name prefix)
+		TYPE_DOC_LINE, // user looks up where a line of its active doc starts (line)
+		TYPE_SYNC_CURSOR_LINE, // like TYPE_SYNC_CURSOR (line, column)
+		TYPE_SYNC_DELETION_LINE, // like TYPE_SYNC_DELETION (line, column, length)
+		TYPE_SYNC_MULTIBYTE_LINE, // like TYPE_SYNC_MULTIBYTE (line, column, length, payload)
+		TYPE_DOC_VIEWPORT, // user fetches and follows a range of its active doc (position, length)
+		TYPE_DOC_VIEWPORT_LINE, // like TYPE_DOC_VIEWPORT (line, amount of lines)
+		TYPE_SYNC_RESIZE, // server -> client only (revision, position, length, inserted)
+		TYPE_DOC_SEARCH, // user searches all docs for bytes (offset, limit, query as name)
+		TYPE_DOC_REPLACE, // user replaces bytes throughout its active doc
+						// (pattern as name, length, replacement as payload)
+		TYPE_DOC_REPLACE_REGEX, // like TYPE_DOC_REPLACE, pattern and replacement as regular
+								// expression (an ECMAScript subset) and format
+		TYPE_DOC_CLOSE; // user closes an opened doc (id)
 	}
 	
 	public byte[] bytes;
+	public int column;
+	public List<DocumentEntry> entries;
 	public int id;
+	public int inserted;
 	public int length;
+	public int line;
+	public List<EditOperation> operations;
 	public String name;
 	public int position;
+	public int revision;
+	public List<SequenceOperation> sequence;
+	public int site;
 	public MessageStatus status;
 	public final MessageType type;
 	
@@ -157,203 +104,47 @@ public class Message
 	{ this.type = type; }
 	
 	/**
-	 * Receives a message from the server. The given channel should be readable at
-	 * all, i.e. there should be a message in the reception queue.
+	 * Receives a message from the server. Blocks until the whole message has
+	 * been received.
 	 * @param channel
+	 * @param version - the negotiated protocol version
 	 * @throws CTEException - if the type of the received message is invalid
 	 * @throws IOException - if an error occurred while reading from the channel
+	 * @see MessageCodec#decode(ReadableByteChannel, int)
+	 */
+	public static Message receiveFrom(ReadableByteChannel channel, int version)
+	throws CTEException, IOException
+	{ return MessageCodec.decode(channel, version); }
+	
+	/**
+	 * Receives a message from the server in protocol version 1.
+	 * @see #receiveFrom(ReadableByteChannel, int)
 	 */
 	public static Message receiveFrom(ReadableByteChannel channel)
 	throws CTEException, IOException
-	{
-		byte[] nameBuffer;
-		
-		// initialize buffer for reading message type
-		ByteBuffer buffer = ByteBuffer.allocate(FIELD_SIZE_TYPE);
-		channel.read(buffer);
-		buffer.flip();
-		//ByteBuffer buffer = readField(channel, FIELD_SIZE_TYPE);
-		
-		// read Message type
-		MessageType type;
-		try
-		{ type = MessageType.values()[buffer.get()]; }
-		catch (IndexOutOfBoundsException e)
-		{
-			throw new CTEException("invalid message type",
-					CTEException.ExceptionType.INVALID_TYPE);
-		}
-		Message result = new Message(type);
-		
-		// initialize buffer for reading the rest of the message
-		if (type == MessageType.TYPE_SYNC_MULTIBYTE)
-		{ buffer = ByteBuffer.allocate(type.getMessageSize(true, 0) - FIELD_SIZE_TYPE); }
-		else
-		{ buffer = ByteBuffer.allocate(type.getMessageSize(true) - FIELD_SIZE_TYPE); }
-		
-		// read the message
-		channel.read(buffer);
-		buffer.flip();
-		
-		// read first field
-		switch (type)
-		{
-		case TYPE_DOC_ACTIVATE:
-		case TYPE_DOC_CREATE:
-		case TYPE_DOC_DELETE:
-		case TYPE_DOC_OPEN:
-		case TYPE_DOC_SAVE:
-		case TYPE_USER_LOGIN:
-		case TYPE_USER_LOGOUT:
-		case TYPE_STATUS:
-			try
-			{ result.status = MessageStatus.values()[buffer.get()]; }
-			catch (IndexOutOfBoundsException e)
-			{ result.status = MessageStatus.STATUS_UNKNOWN; }
-			break;
-		case TYPE_DOC_LIST:
-			result.length = buffer.getInt();
-			break;
-		case TYPE_SYNC_BYTE:
-		case TYPE_SYNC_DELETION:
-		case TYPE_SYNC_MULTIBYTE:
-			result.position = buffer.getInt();
-			break;
-		case TYPE_USER_JOIN:
-		case TYPE_USER_QUIT:
-			result.id = buffer.getInt();
-			break;
-		}
-
-		// read second field
-		switch (type)
-		{
-		case TYPE_DOC_ACTIVATE:
-		case TYPE_DOC_OPEN:
-		case TYPE_DOC_SAVE:
-			result.id = buffer.getInt();
-			break;
-		case TYPE_DOC_CREATE:
-		case TYPE_DOC_DELETE:
-			buffer.get(nameBuffer = new byte[FIELD_SIZE_DOC_NAME]);
-			result.name = new String(nameBuffer);
-			break;
-		case TYPE_DOC_LIST:
-			result.bytes = new byte[result.length * FIELD_SIZE_DOC_NAME];
-			for (int i = 0; i < result.length; ++i)
-			{
-				buffer.get(result.bytes, i * FIELD_SIZE_DOC_NAME,
-					FIELD_SIZE_DOC_NAME);
-			}
-			break;
-		case TYPE_SYNC_BYTE:
-			result.bytes = new byte[] { buffer.get() };
-			break;
-		case TYPE_SYNC_DELETION:
-		case TYPE_SYNC_MULTIBYTE:
-			result.length = buffer.getInt();
-			break;
-		case TYPE_USER_JOIN:
-			buffer.get(nameBuffer = new byte[FIELD_SIZE_USER_NAME]);
-			result.name = new String(nameBuffer);
-			break;
-		}
-		
-		// read third field
-		switch (type)
-		{
-		case TYPE_DOC_OPEN:
-			buffer.get(nameBuffer = new byte[FIELD_SIZE_DOC_NAME]);
-			result.name = new String(nameBuffer);
-			break;
-		case TYPE_SYNC_MULTIBYTE:
-			buffer.get(result.bytes = new byte[result.length]);
-			break;
-		}
-		
-		return result;
-	}
+	{ return receiveFrom(channel, MessageCodec.PROTOCOL_VERSION_1); }
 	
 	/**
 	 * Sends this message to the given channel.
 	 * @param channel
+	 * @param version - the negotiated protocol version
 	 * @throws CTEException - if the type is invalid
 	 * @throws IOException - if an error occurred while sending
+	 * @see MessageCodec#encode(Message, int)
 	 */
-	public void sendTo(WritableByteChannel channel)
+	public void sendTo(WritableByteChannel channel, int version)
 	throws CTEException, IOException
 	{
-		byte[] nameBuffer;
-		
-		// initialize buffer
-		ByteBuffer buffer;
-		if (type == MessageType.TYPE_SYNC_MULTIBYTE)
-		{ buffer = ByteBuffer.allocate(type.getMessageSize(false, length)); }
-		else
-		{ buffer = ByteBuffer.allocate(type.getMessageSize(false)); }
-		
-		// append message type
-		buffer.put((byte)type.ordinal());
-		
-		// append first field
-		switch (type)
-		{
-		case TYPE_DOC_ACTIVATE:
-		case TYPE_DOC_SAVE:
-			buffer.putInt(id);
-			break;
-		case TYPE_DOC_CREATE:
-		case TYPE_DOC_DELETE:
-		case TYPE_DOC_OPEN:
-			nameBuffer = Arrays.copyOf(name.getBytes(), FIELD_SIZE_DOC_NAME);
-			Arrays.fill(nameBuffer, name.length(), nameBuffer.length, (byte)0x00);
-			buffer.put(nameBuffer);
-			break;
-		case TYPE_DOC_LIST:
-		case TYPE_USER_LOGOUT:
-			break;
-		case TYPE_SYNC_BYTE:
-			buffer.put(bytes[0]);
-			break;
-		case TYPE_SYNC_CURSOR:
-		case TYPE_SYNC_DELETION:
-			buffer.putInt(position);
-			break;
-		case TYPE_SYNC_MULTIBYTE:
-			buffer.putInt(length);
-			buffer.put(bytes, 0, length);
-			break;
-		case TYPE_USER_LOGIN:
-			nameBuffer = Arrays.copyOf(name.getBytes(), FIELD_SIZE_USER_NAME);
-			Arrays.fill(nameBuffer, name.length(), nameBuffer.length, (byte)0x00);
-			buffer.put(nameBuffer);
-			break;
-		default:
-			throw new CTEException("invalid message type for sending",
-					CTEException.ExceptionType.INVALID_TYPE);
-		}
-		
-		// append second field
-		switch (type)
-		{
-		case TYPE_DOC_ACTIVATE:
-		case TYPE_USER_LOGIN:
-			if (bytes.length < FIELD_SIZE_HASH)
-			{ Arrays.fill(bytes, bytes.length, FIELD_SIZE_HASH, (byte)0x00); }
-			buffer.put(bytes, 0, FIELD_SIZE_HASH);
-			break;
-		case TYPE_SYNC_DELETION:
-			buffer.putInt(length);
-			break;
-		case TYPE_SYNC_MULTIBYTE:
-			if (bytes.length < length)
-			{ Arrays.fill(bytes, bytes.length, length, (byte)0x00); }
-			buffer.put(bytes, 0, length);
-			break;
-		}
-		
-		// send
-		buffer.flip();
-		channel.write(buffer);
+		ByteBuffer buffer = MessageCodec.encode(this, version);
+		while (buffer.hasRemaining())
+		{ channel.write(buffer); }
 	}
+	
+	/**
+	 * Sends this message to the given channel in protocol version 1.
+	 * @see #sendTo(WritableByteChannel, int)
+	 */
+	public void sendTo(WritableByteChannel channel)
+	throws CTEException, IOException
+	{ sendTo(channel, MessageCodec.PROTOCOL_VERSION_1); }
 }
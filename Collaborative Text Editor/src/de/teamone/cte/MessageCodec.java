@@ -0,0 +1,1140 @@
+// Generated by server/tools/generate_java_codec from server/MessageSchema.h.
+// Do not edit, run `make java_codec` in server/ instead.
+
+package de.teamone.cte;
+
+import java.io.EOFException;
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.channels.ReadableByteChannel;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+
+import static de.teamone.cte.Message.*;
+import static de.teamone.cte.Message.MessageType.*;
+
+final class MessageCodec
+{
+	static final int
+		PROTOCOL_VERSION_1 = 1,
+		PROTOCOL_VERSION_2 = 2,
+		PROTOCOL_VERSION_LATEST = 2;
+	
+	// the wire values are the ordinals, make sure they match the server
+	static
+	{
+		if (TYPE_DOC_ACTIVATE.ordinal() != 1)
+		{ throw new IllegalStateException("TYPE_DOC_ACTIVATE doesn't match the server"); }
+		if (TYPE_DOC_CREATE.ordinal() != 2)
+		{ throw new IllegalStateException("TYPE_DOC_CREATE doesn't match the server"); }
+		if (TYPE_DOC_DELETE.ordinal() != 3)
+		{ throw new IllegalStateException("TYPE_DOC_DELETE doesn't match the server"); }
+		if (TYPE_DOC_LIST.ordinal() != 4)
+		{ throw new IllegalStateException("TYPE_DOC_LIST doesn't match the server"); }
+		if (TYPE_DOC_OPEN.ordinal() != 5)
+		{ throw new IllegalStateException("TYPE_DOC_OPEN doesn't match the server"); }
+		if (TYPE_DOC_SAVE.ordinal() != 6)
+		{ throw new IllegalStateException("TYPE_DOC_SAVE doesn't match the server"); }
+		if (TYPE_SYNC_BYTE.ordinal() != 8)
+		{ throw new IllegalStateException("TYPE_SYNC_BYTE doesn't match the server"); }
+		if (TYPE_SYNC_CURSOR.ordinal() != 9)
+		{ throw new IllegalStateException("TYPE_SYNC_CURSOR doesn't match the server"); }
+		if (TYPE_SYNC_DELETION.ordinal() != 10)
+		{ throw new IllegalStateException("TYPE_SYNC_DELETION doesn't match the server"); }
+		if (TYPE_SYNC_MULTIBYTE.ordinal() != 11)
+		{ throw new IllegalStateException("TYPE_SYNC_MULTIBYTE doesn't match the server"); }
+		if (TYPE_USER_LOGIN.ordinal() != 12)
+		{ throw new IllegalStateException("TYPE_USER_LOGIN doesn't match the server"); }
+		if (TYPE_USER_LOGOUT.ordinal() != 13)
+		{ throw new IllegalStateException("TYPE_USER_LOGOUT doesn't match the server"); }
+		if (TYPE_PROTOCOL_VERSION.ordinal() != 16)
+		{ throw new IllegalStateException("TYPE_PROTOCOL_VERSION doesn't match the server"); }
+		if (TYPE_SYNC_BATCH.ordinal() != 17)
+		{ throw new IllegalStateException("TYPE_SYNC_BATCH doesn't match the server"); }
+		if (TYPE_SYNC_SEQUENCE.ordinal() != 18)
+		{ throw new IllegalStateException("TYPE_SYNC_SEQUENCE doesn't match the server"); }
+		if (TYPE_SYNC_MERGE.ordinal() != 19)
+		{ throw new IllegalStateException("TYPE_SYNC_MERGE doesn't match the server"); }
+		if (TYPE_SESSION_RESUME.ordinal() != 21)
+		{ throw new IllegalStateException("TYPE_SESSION_RESUME doesn't match the server"); }
+		if (TYPE_COMPRESSION.ordinal() != 22)
+		{ throw new IllegalStateException("TYPE_COMPRESSION doesn't match the server"); }
+		if (TYPE_DOC_LIST_PAGE.ordinal() != 24)
+		{ throw new IllegalStateException("TYPE_DOC_LIST_PAGE doesn't match the server"); }
+		if (TYPE_DOC_LINE.ordinal() != 25)
+		{ throw new IllegalStateException("TYPE_DOC_LINE doesn't match the server"); }
+		if (TYPE_SYNC_CURSOR_LINE.ordinal() != 26)
+		{ throw new IllegalStateException("TYPE_SYNC_CURSOR_LINE doesn't match the server"); }
+		if (TYPE_SYNC_DELETION_LINE.ordinal() != 27)
+		{ throw new IllegalStateException("TYPE_SYNC_DELETION_LINE doesn't match the server"); }
+		if (TYPE_SYNC_MULTIBYTE_LINE.ordinal() != 28)
+		{ throw new IllegalStateException("TYPE_SYNC_MULTIBYTE_LINE doesn't match the server"); }
+		if (TYPE_DOC_VIEWPORT.ordinal() != 29)
+		{ throw new IllegalStateException("TYPE_DOC_VIEWPORT doesn't match the server"); }
+		if (TYPE_DOC_VIEWPORT_LINE.ordinal() != 30)
+		{ throw new IllegalStateException("TYPE_DOC_VIEWPORT_LINE doesn't match the server"); }
+		if (TYPE_DOC_SEARCH.ordinal() != 32)
+		{ throw new IllegalStateException("TYPE_DOC_SEARCH doesn't match the server"); }
+		if (TYPE_DOC_REPLACE.ordinal() != 33)
+		{ throw new IllegalStateException("TYPE_DOC_REPLACE doesn't match the server"); }
+		if (TYPE_DOC_REPLACE_REGEX.ordinal() != 34)
+		{ throw new IllegalStateException("TYPE_DOC_REPLACE_REGEX doesn't match the server"); }
+		if (TYPE_DOC_CLOSE.ordinal() != 35)
+		{ throw new IllegalStateException("TYPE_DOC_CLOSE doesn't match the server"); }
+		if (TYPE_STATUS.ordinal() != 7)
+		{ throw new IllegalStateException("TYPE_STATUS doesn't match the server"); }
+		if (TYPE_USER_JOIN.ordinal() != 14)
+		{ throw new IllegalStateException("TYPE_USER_JOIN doesn't match the server"); }
+		if (TYPE_USER_QUIT.ordinal() != 15)
+		{ throw new IllegalStateException("TYPE_USER_QUIT doesn't match the server"); }
+		if (TYPE_SESSION_TOKEN.ordinal() != 20)
+		{ throw new IllegalStateException("TYPE_SESSION_TOKEN doesn't match the server"); }
+		if (TYPE_SYNC_COMPRESSED.ordinal() != 23)
+		{ throw new IllegalStateException("TYPE_SYNC_COMPRESSED doesn't match the server"); }
+		if (TYPE_SYNC_RESIZE.ordinal() != 31)
+		{ throw new IllegalStateException("TYPE_SYNC_RESIZE doesn't match the server"); }
+	}
+	
+	private MessageCodec()
+	{}
+	
+	/**
+	 * Encodes a message for sending it to the server.
+	 * @param message
+	 * @param version - the negotiated protocol version
+	 * @return a buffer containing exactly the frame, ready to be written
+	 * @throws CTEException - if the type can't be sent to the server
+	 */
+	static ByteBuffer encode(Message message, int version)
+	throws CTEException
+	{
+		int size = FIELD_SIZE_TYPE;
+		switch (message.type)
+		{
+		case TYPE_DOC_ACTIVATE:
+			size += integerSize(message.id, version);
+			size += FIELD_SIZE_HASH;
+			break;
+		case TYPE_DOC_CREATE:
+			size += nameSize(message.name, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_DELETE:
+			size += nameSize(message.name, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_LIST:
+			break;
+		case TYPE_DOC_OPEN:
+			size += nameSize(message.name, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_SAVE:
+			size += integerSize(message.id, version);
+			break;
+		case TYPE_SYNC_BYTE:
+			size += FIELD_SIZE_BYTE;
+			break;
+		case TYPE_SYNC_CURSOR:
+			size += integerSize(message.position, version);
+			break;
+		case TYPE_SYNC_DELETION:
+			size += integerSize(message.position, version);
+			size += integerSize(message.length, version);
+			break;
+		case TYPE_SYNC_MULTIBYTE:
+			size += integerSize(message.length, version);
+			size += message.length;
+			break;
+		case TYPE_USER_LOGIN:
+			size += nameSize(message.name, FIELD_SIZE_USER_NAME, version);
+			size += FIELD_SIZE_HASH;
+			break;
+		case TYPE_USER_LOGOUT:
+			break;
+		case TYPE_PROTOCOL_VERSION:
+			size += FIELD_SIZE_BYTE;
+			break;
+		case TYPE_SYNC_BATCH:
+			size += integerSize(message.revision, version);
+			size += operationsSize(message.operations, version);
+			break;
+		case TYPE_SYNC_SEQUENCE:
+			break;
+		case TYPE_SYNC_MERGE:
+			size += integerSize(message.id, version);
+			size += integerSize(message.site, version);
+			size += integerSize(message.revision, version);
+			size += sequenceSize(message.sequence, version);
+			break;
+		case TYPE_SESSION_RESUME:
+			size += FIELD_SIZE_HASH;
+			size += integerSize(message.revision, version);
+			break;
+		case TYPE_COMPRESSION:
+			size += FIELD_SIZE_BYTE;
+			break;
+		case TYPE_DOC_LIST_PAGE:
+			size += integerSize(message.position, version);
+			size += integerSize(message.length, version);
+			size += nameSize(message.name, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_LINE:
+			size += integerSize(message.line, version);
+			break;
+		case TYPE_SYNC_CURSOR_LINE:
+			size += integerSize(message.line, version);
+			size += integerSize(message.column, version);
+			break;
+		case TYPE_SYNC_DELETION_LINE:
+			size += integerSize(message.line, version);
+			size += integerSize(message.column, version);
+			size += integerSize(message.length, version);
+			break;
+		case TYPE_SYNC_MULTIBYTE_LINE:
+			size += integerSize(message.line, version);
+			size += integerSize(message.column, version);
+			size += integerSize(message.length, version);
+			size += message.length;
+			break;
+		case TYPE_DOC_VIEWPORT:
+			size += integerSize(message.position, version);
+			size += integerSize(message.length, version);
+			break;
+		case TYPE_DOC_VIEWPORT_LINE:
+			size += integerSize(message.line, version);
+			size += integerSize(message.length, version);
+			break;
+		case TYPE_DOC_SEARCH:
+			size += integerSize(message.position, version);
+			size += integerSize(message.length, version);
+			size += nameSize(message.name, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_REPLACE:
+			size += nameSize(message.name, FIELD_SIZE_DOC_NAME, version);
+			size += integerSize(message.length, version);
+			size += message.length;
+			break;
+		case TYPE_DOC_REPLACE_REGEX:
+			size += nameSize(message.name, FIELD_SIZE_DOC_NAME, version);
+			size += integerSize(message.length, version);
+			size += message.length;
+			break;
+		case TYPE_DOC_CLOSE:
+			size += integerSize(message.id, version);
+			break;
+		default:
+			throw new CTEException("invalid message type for sending",
+				CTEException.ExceptionType.INVALID_TYPE);
+		}
+		
+		ByteBuffer buffer = ByteBuffer.allocate(
+			(version == PROTOCOL_VERSION_1 ? 0 : varintSize(size)) + size);
+		if (version != PROTOCOL_VERSION_1)
+		{ putVarint(buffer, size); }
+		buffer.put((byte)message.type.ordinal());
+		switch (message.type)
+		{
+		case TYPE_DOC_ACTIVATE:
+			putInteger(buffer, message.id, version);
+			putBytes(buffer, message.bytes, FIELD_SIZE_HASH);
+			break;
+		case TYPE_DOC_CREATE:
+			putName(buffer, message.name, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_DELETE:
+			putName(buffer, message.name, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_LIST:
+			break;
+		case TYPE_DOC_OPEN:
+			putName(buffer, message.name, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_SAVE:
+			putInteger(buffer, message.id, version);
+			break;
+		case TYPE_SYNC_BYTE:
+			buffer.put(message.bytes[0]);
+			break;
+		case TYPE_SYNC_CURSOR:
+			putInteger(buffer, message.position, version);
+			break;
+		case TYPE_SYNC_DELETION:
+			putInteger(buffer, message.position, version);
+			putInteger(buffer, message.length, version);
+			break;
+		case TYPE_SYNC_MULTIBYTE:
+			putInteger(buffer, message.length, version);
+			putBytes(buffer, message.bytes, message.length);
+			break;
+		case TYPE_USER_LOGIN:
+			putName(buffer, message.name, FIELD_SIZE_USER_NAME, version);
+			putBytes(buffer, message.bytes, FIELD_SIZE_HASH);
+			break;
+		case TYPE_USER_LOGOUT:
+			break;
+		case TYPE_PROTOCOL_VERSION:
+			buffer.put((byte)message.length);
+			break;
+		case TYPE_SYNC_BATCH:
+			putInteger(buffer, message.revision, version);
+			putOperations(buffer, message.operations, version);
+			break;
+		case TYPE_SYNC_SEQUENCE:
+			break;
+		case TYPE_SYNC_MERGE:
+			putInteger(buffer, message.id, version);
+			putInteger(buffer, message.site, version);
+			putInteger(buffer, message.revision, version);
+			putSequence(buffer, message.sequence, version);
+			break;
+		case TYPE_SESSION_RESUME:
+			putBytes(buffer, message.bytes, FIELD_SIZE_HASH);
+			putInteger(buffer, message.revision, version);
+			break;
+		case TYPE_COMPRESSION:
+			buffer.put((byte)message.length);
+			break;
+		case TYPE_DOC_LIST_PAGE:
+			putInteger(buffer, message.position, version);
+			putInteger(buffer, message.length, version);
+			putName(buffer, message.name, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_LINE:
+			putInteger(buffer, message.line, version);
+			break;
+		case TYPE_SYNC_CURSOR_LINE:
+			putInteger(buffer, message.line, version);
+			putInteger(buffer, message.column, version);
+			break;
+		case TYPE_SYNC_DELETION_LINE:
+			putInteger(buffer, message.line, version);
+			putInteger(buffer, message.column, version);
+			putInteger(buffer, message.length, version);
+			break;
+		case TYPE_SYNC_MULTIBYTE_LINE:
+			putInteger(buffer, message.line, version);
+			putInteger(buffer, message.column, version);
+			putInteger(buffer, message.length, version);
+			putBytes(buffer, message.bytes, message.length);
+			break;
+		case TYPE_DOC_VIEWPORT:
+			putInteger(buffer, message.position, version);
+			putInteger(buffer, message.length, version);
+			break;
+		case TYPE_DOC_VIEWPORT_LINE:
+			putInteger(buffer, message.line, version);
+			putInteger(buffer, message.length, version);
+			break;
+		case TYPE_DOC_SEARCH:
+			putInteger(buffer, message.position, version);
+			putInteger(buffer, message.length, version);
+			putName(buffer, message.name, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_REPLACE:
+			putName(buffer, message.name, FIELD_SIZE_DOC_NAME, version);
+			putInteger(buffer, message.length, version);
+			putBytes(buffer, message.bytes, message.length);
+			break;
+		case TYPE_DOC_REPLACE_REGEX:
+			putName(buffer, message.name, FIELD_SIZE_DOC_NAME, version);
+			putInteger(buffer, message.length, version);
+			putBytes(buffer, message.bytes, message.length);
+			break;
+		case TYPE_DOC_CLOSE:
+			putInteger(buffer, message.id, version);
+			break;
+		default:
+			throw new CTEException("invalid message type for sending",
+				CTEException.ExceptionType.INVALID_TYPE);
+		}
+		
+		buffer.flip();
+		return buffer;
+	}
+	
+	/**
+	 * Receives and decodes a message from the server. Blocks until the whole
+	 * message has been received.
+	 * @param channel
+	 * @param version - the negotiated protocol version
+	 * @throws CTEException - if the message is invalid
+	 * @throws IOException - if an error occurred while reading from the channel
+	 */
+	static Message decode(ReadableByteChannel channel, int version)
+	throws CTEException, IOException
+	{
+		ByteBuffer buffer = version == PROTOCOL_VERSION_1 ?
+			readFully(channel, FIELD_SIZE_TYPE) : readFully(channel, readVarint(channel));
+		
+		int value = buffer.get();
+		if (value < 0 || value >= MessageType.values().length)
+		{
+			throw new CTEException("invalid message type",
+				CTEException.ExceptionType.INVALID_TYPE);
+		}
+		MessageType type = MessageType.values()[value];
+		Message message = new Message(type);
+		
+		try
+		{
+			if (version == PROTOCOL_VERSION_1)
+			{ decodeV1(channel, message); }
+			else
+			{
+				decodeV2(buffer, message);
+				if (buffer.hasRemaining())
+				{
+					throw new CTEException("trailing bytes in frame",
+						CTEException.ExceptionType.UNEXPECTED_EXCEPTION);
+				}
+			}
+		}
+		catch (java.nio.BufferUnderflowException e)
+		{
+			throw new CTEException("truncated frame",
+				CTEException.ExceptionType.UNEXPECTED_EXCEPTION, e);
+		}
+		
+		return message;
+	}
+	
+	private static void decodeV1(ReadableByteChannel channel, Message message)
+	throws CTEException, IOException
+	{
+		final int version = PROTOCOL_VERSION_1;
+		ByteBuffer buffer;
+		switch (message.type)
+		{
+		case TYPE_DOC_ACTIVATE:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_ID);
+			message.status = getStatus(buffer);
+			message.id = getInteger(buffer, version);
+			break;
+		case TYPE_DOC_CREATE:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_DOC_NAME);
+			message.status = getStatus(buffer);
+			message.name = getName(buffer, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_DELETE:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_DOC_NAME);
+			message.status = getStatus(buffer);
+			message.name = getName(buffer, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_LIST:
+			buffer = readFully(channel, FIELD_SIZE_SIZE);
+			message.length = getInteger(buffer, version);
+			buffer = readFully(channel, message.length * FIELD_SIZE_DOC_NAME);
+			message.bytes = getDocList(buffer, message.length, version);
+			break;
+		case TYPE_DOC_OPEN:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_ID + FIELD_SIZE_DOC_NAME);
+			message.status = getStatus(buffer);
+			message.id = getInteger(buffer, version);
+			message.name = getName(buffer, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_SAVE:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_ID);
+			message.status = getStatus(buffer);
+			message.id = getInteger(buffer, version);
+			break;
+		case TYPE_STATUS:
+			buffer = readFully(channel, FIELD_SIZE_STATUS);
+			message.status = getStatus(buffer);
+			break;
+		case TYPE_SYNC_BYTE:
+			buffer = readFully(channel, FIELD_SIZE_SIZE + FIELD_SIZE_BYTE);
+			message.position = getInteger(buffer, version);
+			message.bytes = new byte[] { buffer.get() };
+			break;
+		case TYPE_SYNC_DELETION:
+			buffer = readFully(channel, FIELD_SIZE_SIZE + FIELD_SIZE_SIZE);
+			message.position = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			break;
+		case TYPE_SYNC_MULTIBYTE:
+			buffer = readFully(channel, FIELD_SIZE_SIZE + FIELD_SIZE_SIZE);
+			message.position = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			buffer = readFully(channel, message.length);
+			message.bytes = getBytes(buffer, message.length);
+			break;
+		case TYPE_USER_LOGIN:
+			buffer = readFully(channel, FIELD_SIZE_STATUS);
+			message.status = getStatus(buffer);
+			break;
+		case TYPE_USER_LOGOUT:
+			buffer = readFully(channel, FIELD_SIZE_STATUS);
+			message.status = getStatus(buffer);
+			break;
+		case TYPE_USER_JOIN:
+			buffer = readFully(channel, FIELD_SIZE_ID + FIELD_SIZE_USER_NAME);
+			message.id = getInteger(buffer, version);
+			message.name = getName(buffer, FIELD_SIZE_USER_NAME, version);
+			break;
+		case TYPE_USER_QUIT:
+			buffer = readFully(channel, FIELD_SIZE_ID);
+			message.id = getInteger(buffer, version);
+			break;
+		case TYPE_PROTOCOL_VERSION:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_BYTE);
+			message.status = getStatus(buffer);
+			message.length = buffer.get() & 0xff;
+			break;
+		case TYPE_SYNC_BATCH:
+			buffer = readFully(channel, FIELD_SIZE_SIZE);
+			message.revision = getInteger(buffer, version);
+			message.operations = readOperations(channel);
+			break;
+		case TYPE_SYNC_SEQUENCE:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_SIZE + FIELD_SIZE_SIZE);
+			message.status = getStatus(buffer);
+			message.site = getInteger(buffer, version);
+			message.revision = getInteger(buffer, version);
+			message.sequence = readSequence(channel);
+			break;
+		case TYPE_SYNC_MERGE:
+			buffer = readFully(channel, FIELD_SIZE_SIZE);
+			message.revision = getInteger(buffer, version);
+			message.sequence = readSequence(channel);
+			break;
+		case TYPE_SESSION_TOKEN:
+			buffer = readFully(channel, FIELD_SIZE_HASH);
+			message.bytes = getBytes(buffer, FIELD_SIZE_HASH);
+			break;
+		case TYPE_SESSION_RESUME:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_ID + FIELD_SIZE_SIZE);
+			message.status = getStatus(buffer);
+			message.id = getInteger(buffer, version);
+			message.revision = getInteger(buffer, version);
+			break;
+		case TYPE_COMPRESSION:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_BYTE);
+			message.status = getStatus(buffer);
+			message.length = buffer.get() & 0xff;
+			break;
+		case TYPE_SYNC_COMPRESSED:
+			buffer = readFully(channel, FIELD_SIZE_SIZE + FIELD_SIZE_SIZE);
+			message.position = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			buffer = readFully(channel, message.length);
+			message.bytes = getBytes(buffer, message.length);
+			break;
+		case TYPE_DOC_LIST_PAGE:
+			buffer = readFully(channel, FIELD_SIZE_SIZE + FIELD_SIZE_ID + FIELD_SIZE_SIZE);
+			message.position = getInteger(buffer, version);
+			message.id = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			buffer = readFully(channel, message.length * (FIELD_SIZE_DOC_NAME + 3 * FIELD_SIZE_SIZE));
+			message.entries = getDocEntries(buffer, message.length, version);
+			break;
+		case TYPE_DOC_LINE:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_SIZE + FIELD_SIZE_SIZE + FIELD_SIZE_SIZE);
+			message.status = getStatus(buffer);
+			message.line = getInteger(buffer, version);
+			message.position = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			break;
+		case TYPE_DOC_VIEWPORT:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_SIZE + FIELD_SIZE_SIZE + FIELD_SIZE_SIZE);
+			message.status = getStatus(buffer);
+			message.revision = getInteger(buffer, version);
+			message.position = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			buffer = readFully(channel, message.length);
+			message.bytes = getBytes(buffer, message.length);
+			break;
+		case TYPE_SYNC_RESIZE:
+			buffer = readFully(channel, FIELD_SIZE_SIZE + FIELD_SIZE_SIZE + FIELD_SIZE_SIZE + FIELD_SIZE_SIZE);
+			message.revision = getInteger(buffer, version);
+			message.position = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			message.inserted = getInteger(buffer, version);
+			break;
+		case TYPE_DOC_SEARCH:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_SIZE + FIELD_SIZE_ID + FIELD_SIZE_SIZE);
+			message.status = getStatus(buffer);
+			message.position = getInteger(buffer, version);
+			message.id = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			buffer = readFully(channel, message.length * (FIELD_SIZE_DOC_NAME + 3 * FIELD_SIZE_SIZE));
+			message.entries = getDocEntries(buffer, message.length, version);
+			break;
+		case TYPE_DOC_REPLACE:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_SIZE + FIELD_SIZE_SIZE);
+			message.status = getStatus(buffer);
+			message.revision = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			break;
+		case TYPE_DOC_REPLACE_REGEX:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_SIZE + FIELD_SIZE_SIZE);
+			message.status = getStatus(buffer);
+			message.revision = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			break;
+		case TYPE_DOC_CLOSE:
+			buffer = readFully(channel, FIELD_SIZE_STATUS + FIELD_SIZE_ID);
+			message.status = getStatus(buffer);
+			message.id = getInteger(buffer, version);
+			break;
+		default:
+			throw new CTEException("invalid message type",
+				CTEException.ExceptionType.INVALID_TYPE);
+		}
+	}
+	
+	private static void decodeV2(ByteBuffer buffer, Message message)
+	throws CTEException
+	{
+		final int version = PROTOCOL_VERSION_2;
+		switch (message.type)
+		{
+		case TYPE_DOC_ACTIVATE:
+			message.status = getStatus(buffer);
+			message.id = getInteger(buffer, version);
+			break;
+		case TYPE_DOC_CREATE:
+			message.status = getStatus(buffer);
+			message.name = getName(buffer, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_DELETE:
+			message.status = getStatus(buffer);
+			message.name = getName(buffer, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_LIST:
+			message.length = getInteger(buffer, version);
+			message.bytes = getDocList(buffer, message.length, version);
+			break;
+		case TYPE_DOC_OPEN:
+			message.status = getStatus(buffer);
+			message.id = getInteger(buffer, version);
+			message.name = getName(buffer, FIELD_SIZE_DOC_NAME, version);
+			break;
+		case TYPE_DOC_SAVE:
+			message.status = getStatus(buffer);
+			message.id = getInteger(buffer, version);
+			break;
+		case TYPE_STATUS:
+			message.status = getStatus(buffer);
+			break;
+		case TYPE_SYNC_BYTE:
+			message.position = getInteger(buffer, version);
+			message.bytes = new byte[] { buffer.get() };
+			break;
+		case TYPE_SYNC_DELETION:
+			message.position = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			break;
+		case TYPE_SYNC_MULTIBYTE:
+			message.position = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			message.bytes = getBytes(buffer, message.length);
+			break;
+		case TYPE_USER_LOGIN:
+			message.status = getStatus(buffer);
+			break;
+		case TYPE_USER_LOGOUT:
+			message.status = getStatus(buffer);
+			break;
+		case TYPE_USER_JOIN:
+			message.id = getInteger(buffer, version);
+			message.name = getName(buffer, FIELD_SIZE_USER_NAME, version);
+			break;
+		case TYPE_USER_QUIT:
+			message.id = getInteger(buffer, version);
+			break;
+		case TYPE_PROTOCOL_VERSION:
+			message.status = getStatus(buffer);
+			message.length = buffer.get() & 0xff;
+			break;
+		case TYPE_SYNC_BATCH:
+			message.revision = getInteger(buffer, version);
+			message.operations = getOperations(buffer, version);
+			break;
+		case TYPE_SYNC_SEQUENCE:
+			message.status = getStatus(buffer);
+			message.site = getInteger(buffer, version);
+			message.revision = getInteger(buffer, version);
+			message.sequence = getSequence(buffer, version);
+			break;
+		case TYPE_SYNC_MERGE:
+			message.revision = getInteger(buffer, version);
+			message.sequence = getSequence(buffer, version);
+			break;
+		case TYPE_SESSION_TOKEN:
+			message.bytes = getBytes(buffer, FIELD_SIZE_HASH);
+			break;
+		case TYPE_SESSION_RESUME:
+			message.status = getStatus(buffer);
+			message.id = getInteger(buffer, version);
+			message.revision = getInteger(buffer, version);
+			break;
+		case TYPE_COMPRESSION:
+			message.status = getStatus(buffer);
+			message.length = buffer.get() & 0xff;
+			break;
+		case TYPE_SYNC_COMPRESSED:
+			message.position = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			message.bytes = getBytes(buffer, message.length);
+			break;
+		case TYPE_DOC_LIST_PAGE:
+			message.position = getInteger(buffer, version);
+			message.id = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			message.entries = getDocEntries(buffer, message.length, version);
+			break;
+		case TYPE_DOC_LINE:
+			message.status = getStatus(buffer);
+			message.line = getInteger(buffer, version);
+			message.position = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			break;
+		case TYPE_DOC_VIEWPORT:
+			message.status = getStatus(buffer);
+			message.revision = getInteger(buffer, version);
+			message.position = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			message.bytes = getBytes(buffer, message.length);
+			break;
+		case TYPE_SYNC_RESIZE:
+			message.revision = getInteger(buffer, version);
+			message.position = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			message.inserted = getInteger(buffer, version);
+			break;
+		case TYPE_DOC_SEARCH:
+			message.status = getStatus(buffer);
+			message.position = getInteger(buffer, version);
+			message.id = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			message.entries = getDocEntries(buffer, message.length, version);
+			break;
+		case TYPE_DOC_REPLACE:
+			message.status = getStatus(buffer);
+			message.revision = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			break;
+		case TYPE_DOC_REPLACE_REGEX:
+			message.status = getStatus(buffer);
+			message.revision = getInteger(buffer, version);
+			message.length = getInteger(buffer, version);
+			break;
+		case TYPE_DOC_CLOSE:
+			message.status = getStatus(buffer);
+			message.id = getInteger(buffer, version);
+			break;
+		default:
+			throw new CTEException("invalid message type",
+				CTEException.ExceptionType.INVALID_TYPE);
+		}
+	}
+	
+	private static int integerSize(int value, int version)
+	{ return version == PROTOCOL_VERSION_1 ? FIELD_SIZE_SIZE : varintSize(value); }
+
+	private static int varintSize(int value)
+	{
+		int size = 1;
+		for (; (value & ~0x7f) != 0; value >>>= 7)
+		{ ++size; }
+		return size;
+	}
+
+	private static byte[] nameBytes(String name, int fieldSize)
+	{
+		byte[] bytes = name == null ? new byte[0] : name.getBytes();
+		return bytes.length > fieldSize ? Arrays.copyOf(bytes, fieldSize) : bytes;
+	}
+
+	private static int nameSize(String name, int fieldSize, int version)
+	{
+		if (version == PROTOCOL_VERSION_1)
+		{ return fieldSize; }
+
+		int length = nameBytes(name, fieldSize).length;
+		return varintSize(length) + length;
+	}
+
+	private static int entryLength(byte[] list, int index)
+	{
+		int offset = index * FIELD_SIZE_DOC_NAME, length = 0;
+		while (list != null && length < FIELD_SIZE_DOC_NAME && offset + length < list.length &&
+			list[offset + length] != 0)
+		{ ++length; }
+		return length;
+	}
+
+	private static int docListSize(byte[] list, int count, int version)
+	{
+		if (version == PROTOCOL_VERSION_1)
+		{ return count * FIELD_SIZE_DOC_NAME; }
+
+		int size = 0;
+		for (int i = 0; i < count; ++i)
+		{ size += varintSize(entryLength(list, i)) + entryLength(list, i); }
+		return size;
+	}
+
+	private static int docEntriesSize(List<DocumentEntry> entries, int version)
+	{
+		int size = 0;
+		for (DocumentEntry entry: entries)
+		{
+			size += nameSize(entry.name, FIELD_SIZE_DOC_NAME, version) +
+				integerSize(entry.size, version) + integerSize(entry.modified, version) +
+				integerSize(entry.editors, version);
+		}
+		return size;
+	}
+
+	private static void putVarint(ByteBuffer buffer, int value)
+	{
+		for (; (value & ~0x7f) != 0; value >>>= 7)
+		{ buffer.put((byte)((value & 0x7f) | 0x80)); }
+		buffer.put((byte)value);
+	}
+
+	private static void putInteger(ByteBuffer buffer, int value, int version)
+	{
+		if (version == PROTOCOL_VERSION_1)
+		{ buffer.putInt(value); }
+		else
+		{ putVarint(buffer, value); }
+	}
+
+	private static void putBytes(ByteBuffer buffer, byte[] bytes, int size)
+	{
+		int copied = bytes == null ? 0 : Math.min(bytes.length, size);
+		buffer.put(bytes == null ? new byte[0] : bytes, 0, copied);
+		buffer.put(new byte[size - copied]);
+	}
+
+	private static void putName(ByteBuffer buffer, String name, int fieldSize, int version)
+	{
+		byte[] bytes = nameBytes(name, fieldSize);
+		if (version == PROTOCOL_VERSION_1)
+		{ putBytes(buffer, bytes, fieldSize); }
+		else
+		{
+			putVarint(buffer, bytes.length);
+			buffer.put(bytes);
+		}
+	}
+
+	private static void putDocList(ByteBuffer buffer, byte[] list, int count, int version)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			int length = entryLength(list, i);
+			if (version != PROTOCOL_VERSION_1)
+			{ putVarint(buffer, length); }
+			buffer.put(list, i * FIELD_SIZE_DOC_NAME, length);
+			if (version == PROTOCOL_VERSION_1)
+			{ buffer.put(new byte[FIELD_SIZE_DOC_NAME - length]); }
+		}
+	}
+
+	private static void putDocEntries(ByteBuffer buffer, List<DocumentEntry> entries, int version)
+	{
+		for (DocumentEntry entry: entries)
+		{
+			putName(buffer, entry.name, FIELD_SIZE_DOC_NAME, version);
+			putInteger(buffer, entry.size, version);
+			putInteger(buffer, entry.modified, version);
+			putInteger(buffer, entry.editors, version);
+		}
+	}
+
+	private static ByteBuffer readFully(ReadableByteChannel channel, int size)
+	throws CTEException, IOException
+	{
+		if (size < 0)
+		{
+			throw new CTEException("negative field size",
+				CTEException.ExceptionType.UNEXPECTED_EXCEPTION);
+		}
+
+		ByteBuffer buffer = ByteBuffer.allocate(size);
+		while (buffer.hasRemaining())
+		{
+			if (channel.read(buffer) < 0)
+			{ throw new EOFException("connection closed within a message"); }
+		}
+		buffer.flip();
+		return buffer;
+	}
+
+	private static int readVarint(ReadableByteChannel channel)
+	throws CTEException, IOException
+	{
+		int value = 0;
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			byte b = readFully(channel, 1).get();
+			value |= (b & 0x7f) << shift;
+			if ((b & 0x80) == 0)
+			{ return value; }
+		}
+		throw new CTEException("varint too long",
+			CTEException.ExceptionType.UNEXPECTED_EXCEPTION);
+	}
+
+	private static int getVarint(ByteBuffer buffer)
+	throws CTEException
+	{
+		int value = 0;
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			byte b = buffer.get();
+			value |= (b & 0x7f) << shift;
+			if ((b & 0x80) == 0)
+			{ return value; }
+		}
+		throw new CTEException("varint too long",
+			CTEException.ExceptionType.UNEXPECTED_EXCEPTION);
+	}
+
+	private static int getInteger(ByteBuffer buffer, int version)
+	throws CTEException
+	{ return version == PROTOCOL_VERSION_1 ? buffer.getInt() : getVarint(buffer); }
+
+	private static byte[] getBytes(ByteBuffer buffer, int size)
+	{
+		byte[] bytes = new byte[size];
+		buffer.get(bytes);
+		return bytes;
+	}
+
+	private static String getName(ByteBuffer buffer, int fieldSize, int version)
+	throws CTEException
+	{
+		byte[] bytes = getBytes(buffer, version == PROTOCOL_VERSION_1 ? fieldSize :
+			getVarint(buffer));
+		int length = 0;
+		while (length < bytes.length && bytes[length] != 0)
+		{ ++length; }
+		return new String(bytes, 0, length);
+	}
+
+	private static byte[] getDocList(ByteBuffer buffer, int count, int version)
+	throws CTEException
+	{
+		byte[] list = new byte[count * FIELD_SIZE_DOC_NAME];
+		for (int i = 0; i < count; ++i)
+		{
+			int length = version == PROTOCOL_VERSION_1 ? FIELD_SIZE_DOC_NAME : getVarint(buffer);
+			if (length > FIELD_SIZE_DOC_NAME)
+			{
+				throw new CTEException("document name too long",
+					CTEException.ExceptionType.UNEXPECTED_EXCEPTION);
+			}
+			buffer.get(list, i * FIELD_SIZE_DOC_NAME, length);
+		}
+		return list;
+	}
+
+	private static List<DocumentEntry> getDocEntries(ByteBuffer buffer, int count, int version)
+	throws CTEException
+	{
+		List<DocumentEntry> entries = new ArrayList<DocumentEntry>();
+		for (int i = 0; i < count; ++i)
+		{
+			String name = getName(buffer, FIELD_SIZE_DOC_NAME, version);
+			int size = getInteger(buffer, version), modified = getInteger(buffer, version);
+			entries.add(new DocumentEntry(name, size, modified, getInteger(buffer, version)));
+		}
+		return entries;
+	}
+
+	private static int operationsSize(List<EditOperation> operations, int version)
+	{
+		int size = integerSize(operations.size(), version);
+		for (EditOperation operation: operations)
+		{
+			size += FIELD_SIZE_BYTE + integerSize(operation.position, version);
+			if (operation.kind != EditOperation.Kind.KIND_INSERT)
+			{ size += integerSize(operation.length, version); }
+			if (operation.kind != EditOperation.Kind.KIND_DELETE)
+			{ size += integerSize(operation.bytes.length, version) + operation.bytes.length; }
+		}
+		return size;
+	}
+
+	private static void putOperations(ByteBuffer buffer, List<EditOperation> operations,
+		int version)
+	{
+		putInteger(buffer, operations.size(), version);
+		for (EditOperation operation: operations)
+		{
+			buffer.put((byte)operation.kind.ordinal());
+			putInteger(buffer, operation.position, version);
+			if (operation.kind != EditOperation.Kind.KIND_INSERT)
+			{ putInteger(buffer, operation.length, version); }
+			if (operation.kind != EditOperation.Kind.KIND_DELETE)
+			{
+				putInteger(buffer, operation.bytes.length, version);
+				buffer.put(operation.bytes);
+			}
+		}
+	}
+
+	private static EditOperation.Kind getKind(byte value)
+	throws CTEException
+	{
+		if (value < 0 || value >= EditOperation.Kind.values().length)
+		{
+			throw new CTEException("invalid edit operation",
+				CTEException.ExceptionType.UNEXPECTED_EXCEPTION);
+		}
+		return EditOperation.Kind.values()[value];
+	}
+
+	private static List<EditOperation> getOperations(ByteBuffer buffer, int version)
+	throws CTEException
+	{
+		int count = getInteger(buffer, version);
+		List<EditOperation> operations = new ArrayList<EditOperation>();
+		for (int i = 0; i < count; ++i)
+		{
+			EditOperation.Kind kind = getKind(buffer.get());
+			int position = getInteger(buffer, version), length = 0;
+			byte[] bytes = new byte[0];
+			if (kind != EditOperation.Kind.KIND_INSERT)
+			{ length = getInteger(buffer, version); }
+			if (kind != EditOperation.Kind.KIND_DELETE)
+			{ bytes = getBytes(buffer, getInteger(buffer, version)); }
+			operations.add(new EditOperation(kind, position, length, bytes));
+		}
+		return operations;
+	}
+
+	private static List<EditOperation> readOperations(ReadableByteChannel channel)
+	throws CTEException, IOException
+	{
+		int count = readFully(channel, FIELD_SIZE_SIZE).getInt();
+		List<EditOperation> operations = new ArrayList<EditOperation>();
+		for (int i = 0; i < count; ++i)
+		{
+			EditOperation.Kind kind = getKind(readFully(channel, FIELD_SIZE_BYTE).get());
+			int position = readFully(channel, FIELD_SIZE_SIZE).getInt(), length = 0;
+			byte[] bytes = new byte[0];
+			if (kind != EditOperation.Kind.KIND_INSERT)
+			{ length = readFully(channel, FIELD_SIZE_SIZE).getInt(); }
+			if (kind != EditOperation.Kind.KIND_DELETE)
+			{ bytes = readFully(channel, readFully(channel, FIELD_SIZE_SIZE).getInt()).array(); }
+			operations.add(new EditOperation(kind, position, length, bytes));
+		}
+		return operations;
+	}
+
+	private static int sequenceSize(List<SequenceOperation> sequence, int version)
+	{
+		int size = integerSize(sequence.size(), version);
+		for (SequenceOperation operation: sequence)
+		{
+			size += FIELD_SIZE_BYTE + integerSize(operation.site, version) +
+				integerSize(operation.clock, version);
+			if (operation.kind == SequenceOperation.Kind.KIND_INSERT)
+			{
+				size += integerSize(operation.originSite, version) +
+					integerSize(operation.originClock, version) +
+					integerSize(operation.bytes.length, version) + operation.bytes.length;
+			}
+			else
+			{ size += integerSize(operation.length, version); }
+		}
+		return size;
+	}
+
+	private static void putSequence(ByteBuffer buffer, List<SequenceOperation> sequence,
+		int version)
+	{
+		putInteger(buffer, sequence.size(), version);
+		for (SequenceOperation operation: sequence)
+		{
+			buffer.put((byte)operation.kind.ordinal());
+			putInteger(buffer, operation.site, version);
+			putInteger(buffer, operation.clock, version);
+			if (operation.kind == SequenceOperation.Kind.KIND_INSERT)
+			{
+				putInteger(buffer, operation.originSite, version);
+				putInteger(buffer, operation.originClock, version);
+				putInteger(buffer, operation.bytes.length, version);
+				buffer.put(operation.bytes);
+			}
+			else
+			{ putInteger(buffer, operation.length, version); }
+		}
+	}
+
+	private static SequenceOperation.Kind getSequenceKind(byte value)
+	throws CTEException
+	{
+		if (value < 0 || value >= SequenceOperation.Kind.values().length)
+		{
+			throw new CTEException("invalid sequence operation",
+				CTEException.ExceptionType.UNEXPECTED_EXCEPTION);
+		}
+		return SequenceOperation.Kind.values()[value];
+	}
+
+	private static List<SequenceOperation> getSequence(ByteBuffer buffer, int version)
+	throws CTEException
+	{
+		int count = getInteger(buffer, version);
+		List<SequenceOperation> sequence = new ArrayList<SequenceOperation>();
+		for (int i = 0; i < count; ++i)
+		{
+			SequenceOperation.Kind kind = getSequenceKind(buffer.get());
+			int site = getInteger(buffer, version), clock = getInteger(buffer, version);
+			int length = 0, originSite = 0, originClock = 0;
+			byte[] bytes = new byte[0];
+			if (kind == SequenceOperation.Kind.KIND_INSERT)
+			{
+				originSite = getInteger(buffer, version);
+				originClock = getInteger(buffer, version);
+				bytes = getBytes(buffer, getInteger(buffer, version));
+			}
+			else
+			{ length = getInteger(buffer, version); }
+			sequence.add(new SequenceOperation(kind, site, clock, length, originSite,
+				originClock, bytes));
+		}
+		return sequence;
+	}
+
+	private static List<SequenceOperation> readSequence(ReadableByteChannel channel)
+	throws CTEException, IOException
+	{
+		int count = readFully(channel, FIELD_SIZE_SIZE).getInt();
+		List<SequenceOperation> sequence = new ArrayList<SequenceOperation>();
+		for (int i = 0; i < count; ++i)
+		{
+			SequenceOperation.Kind kind =
+				getSequenceKind(readFully(channel, FIELD_SIZE_BYTE).get());
+			ByteBuffer id = readFully(channel, 2 * FIELD_SIZE_SIZE);
+			int site = id.getInt(), clock = id.getInt();
+			int length = 0, originSite = 0, originClock = 0;
+			byte[] bytes = new byte[0];
+			if (kind == SequenceOperation.Kind.KIND_INSERT)
+			{
+				ByteBuffer origin = readFully(channel, 3 * FIELD_SIZE_SIZE);
+				originSite = origin.getInt();
+				originClock = origin.getInt();
+				bytes = readFully(channel, origin.getInt()).array();
+			}
+			else
+			{ length = readFully(channel, FIELD_SIZE_SIZE).getInt(); }
+			sequence.add(new SequenceOperation(kind, site, clock, length, originSite,
+				originClock, bytes));
+		}
+		return sequence;
+	}
+
+	private static Message.MessageStatus getStatus(ByteBuffer buffer)
+	{
+		int status = buffer.get();
+		if (status < 0 || status >= Message.MessageStatus.values().length)
+		{ return Message.MessageStatus.STATUS_UNKNOWN; }
+		return Message.MessageStatus.values()[status];
+	}
+}
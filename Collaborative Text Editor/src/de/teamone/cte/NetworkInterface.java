@@ -14,6 +14,7 @@ public class NetworkInterface implements Runnable
 	private List<NetworkMessageHandler> messageHandlers;
 	
 	private SocketChannel server;
+	private int protocolVersion;
 	
 	/**
 	 * Standard constructor.
@@ -28,6 +29,7 @@ public class NetworkInterface implements Runnable
 		
 		this.messageHandlers = new LinkedList<NetworkMessageHandler>();
 		this.server = null;
+		this.protocolVersion = MessageCodec.PROTOCOL_VERSION_1;
 	}
 	
 	/**
@@ -88,6 +90,20 @@ public class NetworkInterface implements Runnable
 		}
 	}
 	
+	/**
+	 * Returns the protocol version used for sending and receiving messages.
+	 */
+	public int getProtocolVersion()
+	{ return protocolVersion; }
+	
+	/**
+	 * Sets the protocol version used for sending and receiving messages. Should be
+	 * called after the server acknowledged a TYPE_PROTOCOL_VERSION request.
+	 * @param version
+	 */
+	public void setProtocolVersion(int version)
+	{ protocolVersion = version; }
+	
 	/**
 	 * Removes a previously added NetworkMessageHandler. Removes only the first
 	 * occurrence so if the handler has been added multiple times it will still get
@@ -114,7 +130,7 @@ public class NetworkInterface implements Runnable
 		// TODO: proper exception handling?
 		Message message;
 		try
-		{ message = Message.receiveFrom(server); }
+		{ message = Message.receiveFrom(server, protocolVersion); }
 		catch (CTEException e)
 		{ return; }
 		catch (IOException e)
@@ -141,6 +157,6 @@ public class NetworkInterface implements Runnable
 			throw new CTEException("not connected",
 				CTEException.ExceptionType.NOT_CONNECTED);
 		}
-		message.sendTo(server);
+		message.sendTo(server, protocolVersion);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,44 @@
+package de.teamone.cte;
+
+public class SequenceOperation
+{
+	public static enum Kind
+	{
+		KIND_INSERT, // insert bytes identified from id on after origin (id, origin, bytes)
+		KIND_DELETE, // delete the bytes identified from id on (id, length)
+		KIND_RUN // appends bytes identified from id on, only used for snapshots (id, length)
+	};
+	
+	public final byte[] bytes;
+	public final int clock;
+	public final Kind kind;
+	public final int length;
+	public final int originClock;
+	public final int originSite;
+	public final int site;
+	
+	/**
+	 * Standard constructor. A byte is identified by the site that inserted it
+	 * and the site's clock at that time, the origin (0, 0) is the start of the
+	 * document.
+	 * @param kind
+	 * @param site - site of the first affected byte
+	 * @param clock - clock of the first affected byte
+	 * @param length - amount of affected bytes, ignored for insertions
+	 * @param originSite - site of the byte to insert after, ignored unless inserting
+	 * @param originClock - clock of the byte to insert after, ignored unless inserting
+	 * @param bytes - bytes to insert, ignored unless inserting
+	 */
+	public SequenceOperation(Kind kind, int site, int clock, int length,
+		int originSite, int originClock, byte[] bytes)
+	{
+		boolean insertion = kind == Kind.KIND_INSERT;
+		this.kind = kind;
+		this.site = site;
+		this.clock = clock;
+		this.length = insertion ? 0 : length;
+		this.originSite = insertion ? originSite : 0;
+		this.originClock = insertion ? originClock : 0;
+		this.bytes = !insertion || bytes == null ? new byte[0] : bytes;
+	}
+}
@@ -6,6 +6,7 @@
 
 #include <sys/socket.h>
 #include <unistd.h>
+#include <utility>
 
 #include "Client.h"
 #include "errno.h"
@@ -15,7 +16,9 @@
 extern UserInterface *g_user_interface;
 
 Client::Client(int listener):
-	active_document(0), cursor(0), socket(accept(listener, 0, 0)), user_id(0)
+	active_document(0), compression(0), cursor(0), protocol_version(1), sequence_site(0),
+	socket(accept(listener, 0, 0)),
+	user_id(0), viewport_length(-1), viewport_position(0), overflowed(false), unsent_offset(0)
 {
 	g_user_interface->printf("new client\n");
 	// check if a client was accepted
@@ -29,11 +32,84 @@ Client::~Client(void)
 	close(this->socket);
 }
 
-void Client::send(const std::vector<char> &bytes) const
+void Client::cancel_transfers(int32_t document_id)
+{ queue.cancel(document_id); }
+
+void Client::send(const std::vector<char> &bytes, Transfer::Priority priority,
+	int32_t document_id) const
+{
+	if (push(Transfer(bytes, priority, document_id)))
+	{ send_pending(priority == Transfer::Priority::PRIORITY_BULK ? 1 : 0); }
+}
+
+void Client::send(Transfer &&transfer) const
+{
+	if (push(std::move(transfer)))
+	{ send_pending(1); }
+}
+
+void Client::send_pending(size_t window) const
+{
+	try
+	{
+		while (flush() && queue.next(unsent, protocol_version, compression, window))
+		{}
+	}
+	catch (...)
+	{
+		queue = SendQueue();
+		unsent.clear();
+		throw;
+	}
+}
+
+void Client::overflow(void) const
+{
+	g_user_interface->printf("[client %d] not keeping up with %zu queued bytes, disconnecting\n",
+		user_id, queue.size());
+
+	queue = SendQueue();
+	unsent.clear();
+	unsent_offset = 0;
+	overflowed = true;
+
+	// the socket becomes readable, receiving from it fails then
+	::shutdown(socket, SHUT_RDWR);
+}
+
+bool Client::push(Transfer &&transfer) const
+{
+	if (overflowed)
+	{ return false; }
+
+	if (!queue.push(std::move(transfer)))
+	{
+		overflow();
+		return false;
+	}
+
+	return true;
+}
+
+bool Client::flush(void) const
 {
-	ssize_t sent = ::send(socket, bytes.data(), bytes.size(), 0);
-	if (sent == -1)
-	{ throw Exception::ErrnoError("message sending failed", "send"); }
-	else if (static_cast<size_t>(sent) < bytes.size())
-	{ throw Exception::SocketFailure("not all bytes have been sent", socket); }
+	while (unsent_offset < unsent.size())
+	{
+		ssize_t sent = ::send(socket, unsent.data() + unsent_offset, unsent.size() - unsent_offset,
+			MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (sent == -1)
+		{
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+			{ return false; }
+
+			throw Exception::ErrnoError("message sending failed", "send");
+		}
+
+		unsent_offset += sent;
+	}
+
+	unsent.clear();
+	unsent_offset = 0;
+
+	return true;
 }
@@ -10,6 +10,8 @@
 #include <cstdint>
 #include <vector>
 
+#include "SendQueue.h"
+
 /**
 	@brief The Client class wraps a connected client.
 **/
@@ -17,9 +19,17 @@ class Client
 {
 	public:
 		int32_t		active_document; ///< the client's active document's id
-		int32_t		cursor; ///< the client's current cursor position in the active document
+		uint8_t		compression; ///< the negotiated compression of bulk frames, initially none
+		int64_t		cursor; ///< the client's current cursor position in the active document
+		uint8_t		protocol_version; ///< the negotiated protocol version, initially 1
+		int32_t		sequence_site; ///< the client's site in the active document's sequence, 0
+							///< unless the client is in sequence mode
 		const int	socket; ///< the client's socket
 		int32_t		user_id; ///< the client's user id, if logged in
+		int64_t		viewport_length; ///< the length of the range of the active document the
+							///< client shows, -1 if it receives the whole document
+		int64_t		viewport_position; ///< the start of the range of the active document the
+							///< client shows
 
 		/**
 			Uses the specified listening socket to accept a new incoming client connection.
@@ -35,6 +45,19 @@ class Client
 		**/
 		~Client(void);
 
+		/**
+			Discards the queued Transfers referring to a document, e.g. when the client switches
+			to another document.
+
+			@param document_id the document id
+		**/
+		void cancel_transfers(int32_t document_id);
+		/**
+			Checks whether Transfers are queued for this client.
+
+			@return whether send_pending(size_t) has anything to send
+		**/
+		inline bool has_pending(void) const;
 		/**
 			Receives the specified amount of bytes from the client and stores them at the given
 			destination.
@@ -51,16 +74,73 @@ class Client
 		template<typename T>
 		void receive(T *destination, size_t size);
 		/**
-			Sends the given bytestream to the client.
+			Queues the given bytestream and sends as much as the socket takes without blocking,
+			see SendQueue for the order. The rest is sent by the NetworkInterface event loop.
+			If the client doesn't read fast enough for the bytestream to fit into the queue, the
+			connection is shut down and nothing is sent anymore.
 
 			@param bytes a reference to a vector containing the bytes to send
+			@param priority the priority class of the bytestream
+			@param document_id the document whose contents the bytestream refers to positions in,
+				0 if none
+
+			@note Calls send_pending(size_t) without catching any exceptions.
+			@see send_pending(size_t)
+		**/
+		void send(const std::vector<char> &bytes,
+			Transfer::Priority priority = Transfer::Priority::PRIORITY_INTERACTIVE,
+			int32_t document_id = 0) const;
+		/**
+			Queues a Transfer and sends as much as the socket takes without blocking. If nothing
+			else is queued, the first frame is sent right away, so the client can show the start
+			of a document immediately. A Transfer that doesn't fit into the queue shuts the
+			connection down like send(const std::vector<char>&, Transfer::Priority, int32_t).
+
+			@param transfer the Transfer to queue
+
+			@note Calls send_pending(size_t) without catching any exceptions.
+			@see send_pending(size_t)
+		**/
+		void send(Transfer &&transfer) const;
+		/**
+			Sends queued frames until the socket doesn't take more data without blocking. A frame
+			sent partially is completed first.
+
+			@param window the maximum amount of bulk frames to send
+
+			@exception Exception::ErrnoError if send (sys/socket.h) failed; the queue is discarded
+		**/
+		void send_pending(size_t window) const;
+
+	private:
+		mutable bool				overflowed; ///< whether the queue overflowed, nothing is sent
+		mutable SendQueue			queue; ///< frames not yet sent
+		mutable std::vector<char>	unsent; ///< frame sent partially
+		mutable size_t				unsent_offset; ///< amount of bytes of unsent already sent
+
+		/**
+			Sends the rest of the frame sent partially.
 
-			@exception Exception::ErrnoError if send (sys/socket.h) failed
-			@exception Exception::SocketFailure if less bytes than required were sent
+			@return whether the frame has been sent completely
 		**/
-		void send(const std::vector<char> &bytes) const;
+		bool flush(void) const;
+		/**
+			Discards everything queued and shuts the socket down since the client doesn't keep
+			up. The NetworkInterface event loop notices the disconnection and removes the client.
+		**/
+		void overflow(void) const;
+		/**
+			Queues a Transfer, or overflows if it doesn't fit.
+
+			@param transfer the Transfer to queue
+			@return whether the Transfer has been queued
+		**/
+		bool push(Transfer &&transfer) const;
 };
 
+bool Client::has_pending(void) const
+{ return !queue.empty() || !unsent.empty(); }
+
 #include "Client.tcc"
 
 #endif
@@ -4,11 +4,14 @@
  * @author Daniel Mierswa <daniel.mierswa@student.hs-rm.de>
  */
 
+#include <algorithm>
+
 #include <sys/select.h>
 
 #include "exceptions.h"
 #include "Client.h"
 #include "ClientCollection.h"
+#include "Message.h"
 #include "UserInterface.h"
 
 extern UserInterface *g_user_interface;
@@ -35,6 +38,32 @@ void ClientCollection::broadcast(const std::vector<char> &bytestream, int32_t do
 	}
 }
 
+void ClientCollection::broadcast(const Message &message, int32_t document_id,
+	ClientFilter filter) const
+{
+	// one bytestream per protocol version, generated on demand
+	std::vector<char> bytestreams[Message::PROTOCOL_VERSION_LATEST];
+
+	for (const std::pair<const int, ClientSptr> &client: clients)
+	{
+		if ((document_id == 0 || client.second->active_document == document_id) &&
+			(!filter || filter(*client.second)))
+		{
+			std::vector<char> &bytestream = bytestreams[client.second->protocol_version - 1];
+			if (bytestream.empty())
+			{ message.generate_bytestream(bytestream, client.second->protocol_version); }
+
+			try
+			{
+				client.second->send(bytestream, message.get_priority(),
+					message.refers_to_contents() ? client.second->active_document : 0);
+			}
+			catch (...)
+			{}
+		}
+	}
+}
+
 void ClientCollection::disconnect_client(Client &client)
 {
 	g_user_interface->printf("[client %d] disconnecting\n", client.user_id);
@@ -54,6 +83,37 @@ int ClientCollection::fill_fd_set(fd_set *set) const
 	return end;
 }
 
+int ClientCollection::fill_pending_fd_set(fd_set *set) const
+{
+	int end = 0;
+
+	for (const std::pair<const int, ClientSptr> &client: this->clients)
+	{
+		if (client.second->has_pending())
+		{
+			FD_SET(client.first, set);
+			end = std::max(end, client.first);
+		}
+	}
+
+	return end;
+}
+
+uint8_t ClientCollection::get_min_protocol_version(int32_t document_id) const
+{
+	uint8_t version = Message::PROTOCOL_VERSION_LATEST;
+
+	for (const std::pair<const int, ClientSptr> &pair: clients)
+	{
+		const Client &client = *pair.second;
+
+		if (client.active_document == document_id)
+		{ version = std::min(version, client.protocol_version); }
+	}
+
+	return version;
+}
+
 MessageList &ClientCollection::get_messages_by_fd_set(fd_set *set, int fd_max, MessageList &list)
 {
 	MessageList::iterator message = list.begin();
@@ -74,11 +134,16 @@ MessageList &ClientCollection::get_messages_by_fd_set(fd_set *set, int fd_max, M
 		}
 		catch (Exception::SocketDisconnected const &ex)
 		{
+			// the handlers are told, the message keeps the client alive until then
+			message->type = Message::MessageType::TYPE_CLIENT_DISCONNECT;
+			message->source = clients[fd];
 			disconnect_client(*clients[fd]);
 		}
 		catch (std::runtime_error const &ex)
 		{
 			// everything else, kick client, no gentle disconnect
+			message->type = Message::MessageType::TYPE_CLIENT_DISCONNECT;
+			message->source = clients[fd];
 			clients.erase(fd);
 		}
 
@@ -90,7 +155,30 @@ MessageList &ClientCollection::get_messages_by_fd_set(fd_set *set, int fd_max, M
 	return list;
 }
 
-void ClientCollection::update_cursors(int32_t start, int32_t addend, int32_t document_id)
+int ClientCollection::send_pending_by_fd_set(fd_set *set, int fd_max)
+{
+	int handled = 0;
+
+	for (int fd = 0; fd < fd_max; ++fd)
+	{
+		if (!FD_ISSET(fd, set))
+		{ continue; }
+
+		++handled;
+		auto client = clients.find(fd);
+		if (client == clients.end())
+		{ continue; }
+
+		try
+		{ client->second->send_pending(Transfer::WINDOW); }
+		catch (...)
+		{}
+	}
+
+	return handled;
+}
+
+void ClientCollection::update_cursors(int64_t start, int64_t addend, int32_t document_id)
 {
 	// iterate through all clients
 	for (std::pair<int, ClientSptr> pair: clients)
@@ -98,10 +186,43 @@ void ClientCollection::update_cursors(int32_t start, int32_t addend, int32_t doc
 		ClientSptr &client = pair.second;
 
 		// continue if client is not affected
-		if (client->active_document != document_id || client->cursor < start)
+		if (client->active_document != document_id)
 		{ continue; }
 
+		// update viewport, positions within a deleted range are moved to its start
+		if (client->viewport_length >= 0)
+		{
+			int64_t end = client->viewport_position + client->viewport_length;
+			if (client->viewport_position >= start)
+			{ client->viewport_position = std::max(start, client->viewport_position + addend); }
+			if (end >= start)
+			{ end = std::max(start, end + addend); }
+			client->viewport_length = end - client->viewport_position;
+		}
+
 		// update cursor
-		client->cursor += addend;
+		if (client->cursor >= start)
+		{ client->cursor += addend; }
+	}
+}
+
+void ClientCollection::update_cursors(const EditOperations &operations, int32_t document_id)
+{
+	for (const std::pair<const int, ClientSptr> &pair: clients)
+	{
+		Client &client = *pair.second;
+
+		if (client.active_document != document_id)
+		{ continue; }
+
+		client.cursor = map_position(client.cursor, operations);
+
+		if (client.viewport_length >= 0)
+		{
+			int64_t end = map_position(client.viewport_position + client.viewport_length,
+				operations);
+			client.viewport_position = map_position(client.viewport_position, operations);
+			client.viewport_length = end - client.viewport_position;
+		}
 	}
 }
@@ -1,14 +1,9 @@
 #include "Document.h"
+#include "FileDocumentStore.h"
 
-#include <cassert>
-#include <cerrno>
-#include <sstream>
+#include <limits>
 
-#include <dirent.h>
-#include <fcntl.h>
-#include <sys/stat.h>
-#include <sys/types.h>
-#include <unistd.h>
+#include <zlib.h>
 
 /**
  * @file server/Document.cpp
@@ -22,12 +17,20 @@
  */
 std::string const Document::directory_ = "./documents/";
 
+/**
+ * Global variable storing the store documents are created in and opened from.
+ */
+std::shared_ptr<DocumentStore> Document::default_store_ =
+	std::make_shared<FileDocumentStore>(Document::directory_);
+
 /**
  * A global variable for the current document id. Wraps after
  * 2147483647
  */
 std::int32_t Document::global_document_id_ = 1;
 
+std::size_t const Document::MAX_INDEXED_OPERATIONS;
+
 namespace document_errors
 {
 	DocumentError::DocumentError(std::string const &message)
@@ -60,11 +63,18 @@ using namespace document_errors;
 
 Document::Document(Document &&other)
 	: contents_(std::move(other.contents_)),
-	  fd_(other.fd_),
+	  store_(std::move(other.store_)),
+	  handle_(std::move(other.handle_)),
 	  name_(std::move(other.name_)),
 	  id_(other.id_),
 	  document_closed_(other.document_closed_),
-	  contents_fetched_(other.contents_fetched_)
+	  contents_fetched_(other.contents_fetched_),
+	  compressed_(std::move(other.compressed_)),
+	  contents_compressed_(other.contents_compressed_),
+	  uncompressed_size_(other.uncompressed_size_),
+	  line_index_(std::move(other.line_index_)),
+	  statistics_(other.statistics_),
+	  statistics_current_(other.statistics_current_)
 {
 	// prevent the other destructor to call close
 	other.document_closed_ = true;
@@ -77,75 +87,26 @@ Document::~Document()
 
 Document Document::create(std::string const &name, bool overwrite)
 {
+	std::shared_ptr<DocumentStore> const store = default_store_;
 
-	int const fd = open_writable(name, overwrite);
-
-	return Document(fd, name);
+	return Document(store, store->create(name, overwrite), name);
 }
 
 Document Document::open(std::string const &name)
 {
-	int const fd = open_readable(name);
+	std::shared_ptr<DocumentStore> const store = default_store_;
 
-	return Document(fd, name);
+	return Document(store, store->open(name), name);
 }
 
 bool Document::is_empty(std::string const &name)
 {
-	int const fd = open_readable(name);
-
-	off_t const now = ::lseek(fd, 0, SEEK_CUR);
-	off_t const begin = ::lseek(fd, 0, SEEK_SET);
-	off_t const end = ::lseek(fd, 0, SEEK_END);
-	off_t const now_again = ::lseek(fd, now, SEEK_SET);
-
-	::close(fd);
-
-	// should never fail
-	assert(now != static_cast<off_t>(-1));
-	assert(begin != static_cast<off_t>(-1));
-	assert(now_again != static_cast<off_t>(-1));
-
-	if (end == static_cast<off_t>(-1))
-	{
-		// should only fail if file too large
-		if (errno == EOVERFLOW)
-		{
-			throw DocumentError("file too big");
-		}
-	}
-
-	return end == 0;
+	return default_store_->size(name) == 0;
 }
 
 void Document::remove()
 {
-	int const result = ::unlink(name_.c_str());
-
-	if (result)
-	{
-		std::ostringstream strm;
-
-		strm << "while removing document <" << name_ << ">: ";
-
-		if (errno == ENOENT)
-		{
-			strm << "document does not exist";
-
-			throw DocumentDoesntExistError(strm.str());
-		}
-
-		if (errno == EACCES || errno == EROFS)
-		{
-			strm << "insufficient permissions to delete document";
-
-			throw DocumentPermissionsError(strm.str());
-		}
-
-		strm << std::strerror(errno);
-
-		throw DocumentError(strm.str());
-	}
+	store_->remove(name_);
 }
 
 void Document::save()
@@ -155,40 +116,43 @@ void Document::save()
 		throw DocumentClosedError("trying to write contents from document that got closed");
 	}
 
-	ssize_t const write_result = ::write(fd_, &contents_[0], contents_.size());
-
-	if (static_cast<std::vector<char>::size_type>(write_result) != contents_.size())
-	{
-		throw DocumentError("unable to write all data to file");
-	}
+	handle_->write(get_contents());
 }
 
 void Document::close()
 {
 	if (!document_closed_)
 	{
-		::close(fd_);
+		handle_.reset();
 		document_closed_ = true;
 	}
 }
 
 Hash::hash_t Document::hash()
 {
-	if (!contents_fetched_)
-	{
-		get_contents();
-	}
-
-	if (contents_.size() >= std::numeric_limits<unsigned long>::max())
-	{
-		throw std::runtime_error("unable to create hash because document is too big");
-	}
-
-	return Hash::hash_bytes(contents_);
+	// loads or decompresses the contents if necessary
+	return Hash::hash_bytes(get_contents());
 }
 
 std::vector<char> &Document::get_contents()
 {
+	if (contents_compressed_)
+	{
+		uLongf length = uncompressed_size_;
+		std::vector<char> inflated(length);
+
+		if (::uncompress(reinterpret_cast<Bytef *>(inflated.data()), &length,
+		                 reinterpret_cast<Bytef const *>(compressed_.data()),
+		                 compressed_.size()) != Z_OK || length != inflated.size())
+		{
+			throw DocumentError("unable to decompress contents");
+		}
+
+		contents_.swap(inflated);
+		std::vector<char>().swap(compressed_);
+		contents_compressed_ = false;
+	}
+
 	if (contents_fetched_)
 	{
 		return contents_;
@@ -199,157 +163,107 @@ std::vector<char> &Document::get_contents()
 		throw DocumentClosedError("trying to read contents in document that got closed");
 	}
 
-	off_t const end = ::lseek(fd_, 0, SEEK_END);
-
-	if (end == static_cast<off_t>(-1))
-	{
-		// should only fail if file too large
-		if (errno == EOVERFLOW)
-		{
-			throw DocumentError("file too big");
-		}
-	}
-
-	// reserve space
-	contents_.resize(end);
-
-	ssize_t const read_result = ::read(fd_, &contents_[0], end);
-
-	if (read_result != end)
-	{
-		throw DocumentError("unable to read all data from file");
-	}
+	handle_->read(contents_);
+	statistics_ = TextStatistics::scan(contents_.data(), contents_.data() + contents_.size());
+	statistics_current_ = true;
 
 	contents_fetched_ = true;
 	return contents_;
 }
 
-std::vector<std::string> Document::list_documents()
+void Document::compress()
 {
-	DIR *dir = ::opendir(Document::directory_.c_str());
-	std::vector<std::string> list;
-
-	if (!dir)
+	if (!is_resident() || contents_.empty())
 	{
-		std::ostringstream strm;
-
-		strm << "while listing documents <" << Document::directory_ << ">: ";
-
-		if (errno == ENOENT || errno == ENOTDIR)
-		{
-			strm << "document directory does not exist";
-
-			throw DocumentDoesntExistError(strm.str());
-		}
-
-		if (errno == EACCES)
-		{
-			strm << "insufficient permissions to open document directory";
-
-			throw DocumentPermissionsError(strm.str());
-		}
-
-		strm << std::strerror(errno);
-
-		throw DocumentError(strm.str());
+		return;
 	}
 
-	::dirent *entry;
+	uLongf length = ::compressBound(contents_.size());
+	std::vector<char> deflated(length);
 
-	try
+	if (::compress2(reinterpret_cast<Bytef *>(deflated.data()), &length,
+	                reinterpret_cast<Bytef const *>(contents_.data()), contents_.size(),
+	                Z_BEST_SPEED) != Z_OK || length >= contents_.size())
 	{
-		while ((entry = ::readdir(dir)))
-		{
-			std::string const name = entry->d_name;
+		return;
+	}
 
-			if (name != "." && name != "..")
-			{
-				list.push_back(name);
-			}
-		}
+	deflated.resize(length);
+	compressed_.assign(deflated.begin(), deflated.end());
+	uncompressed_size_ = contents_.size();
 
-		::closedir(dir);
-	}
-	catch (...)
+	// release the memory, clear() would keep it allocated
+	std::vector<char>().swap(contents_);
+	contents_compressed_ = true;
+}
+
+void Document::unload()
+{
+	if (document_closed_)
 	{
-		::closedir(dir);
-		throw;
+		return;
 	}
 
-	return list;
+	std::vector<char>().swap(contents_);
+	std::vector<char>().swap(compressed_);
+	line_index_.reset();
+	contents_fetched_ = false;
+	contents_compressed_ = false;
 }
 
-int Document::open_readable(std::string const &name)
+void Document::apply(EditOperations const &operations)
 {
-	// using Linux API here because of error checking functionality
-	int const fd = ::open(name.c_str(), O_RDONLY);
+	std::vector<char> &contents = get_contents();
 
-	if (fd < 0)
+	if (operations.size() > MAX_INDEXED_OPERATIONS)
 	{
-		std::ostringstream strm;
-
-		strm << "while opening document <" << name << ">: ";
-
-		if (errno == ENOENT)
-		{
-			strm << "document does not exist";
-
-			throw DocumentDoesntExistError(strm.str());
-		}
-
-		if (errno == EACCES)
+		line_index_.reset();
+	}
+	else if (line_index_)
+	{
+		for (EditOperation const &operation: operations)
 		{
-			strm << "insufficient permissions to open document";
-
-			throw DocumentPermissionsError(strm.str());
+			line_index_->apply(operation);
 		}
-
-		strm << std::strerror(errno);
-
-		throw DocumentError(strm.str());
 	}
 
-	return fd;
+	apply_edit_operations(contents, operations);
+	statistics_current_ = false;
 }
 
-int Document::open_writable(std::string const &name, bool overwrite)
+LineIndex const &Document::get_line_index()
 {
-	// using Linux API here because of error checking functionality
-	int flags = O_CREAT | O_WRONLY | O_TRUNC;
+	std::vector<char> const &contents = get_contents();
 
-	if (!overwrite)
+	if (!line_index_)
 	{
-		flags |= O_EXCL;
+		line_index_.reset(new LineIndex(contents));
 	}
 
-	int const fd = ::open(name.c_str(), flags, 0644);
-
-	if (fd < 0)
-	{
-		std::ostringstream strm;
-
-		strm << "while creating document <" << name << ">: ";
-
-		if (errno == EEXIST)
-		{
-			strm << "document already exists";
-
-			throw DocumentAlreadyExistsError(strm.str());
-		}
+	return *line_index_;
+}
 
-		if (errno == EACCES || errno == EROFS)
-		{
-			strm << "insufficient permissions to create document";
+TextStatistics const &Document::get_statistics()
+{
+	std::vector<char> const &contents = get_contents();
 
-			throw DocumentPermissionsError(strm.str());
-		}
+	if (!statistics_current_)
+	{
+		statistics_ = TextStatistics::scan(contents.data(), contents.data() + contents.size());
+		statistics_current_ = true;
+	}
 
-		strm << std::strerror(errno);
+	return statistics_;
+}
 
-		throw DocumentError(strm.str());
-	}
+std::vector<std::string> Document::list_documents(std::string const &directory)
+{
+	return FileDocumentStore::list_directory(directory);
+}
 
-	return fd;
+void Document::set_store(std::shared_ptr<DocumentStore> const &store)
+{
+	default_store_ = store;
 }
 
 void Document::increment_global_document_id()
@@ -364,12 +278,17 @@ void Document::increment_global_document_id()
 	}
 }
 
-Document::Document(int fd, std::string const &name)
-	: fd_(fd),
+Document::Document(std::shared_ptr<DocumentStore> const &store,
+                   std::unique_ptr<DocumentStore::Handle> handle, std::string const &name)
+	: store_(store),
+	  handle_(std::move(handle)),
 	  name_(name),
 	  id_(global_document_id_),
 	  document_closed_(false),
-	  contents_fetched_(false)
+	  contents_fetched_(false),
+	  contents_compressed_(false),
+	  uncompressed_size_(0),
+	  statistics_current_(false)
 {
 	get_contents();
 	increment_global_document_id();
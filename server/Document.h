@@ -1,10 +1,16 @@
 #ifndef DOCUMENT_H_INCLUDED
 #define DOCUMENT_H_INCLUDED
 
+#include "DocumentStore.h"
+#include "EditOperation.h"
 #include "Hash.h"
+#include "LineIndex.h"
+#include "TextStatistics.h"
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -108,13 +114,19 @@ namespace document_errors
  * modifying the byte container returned by Document::get_contents().
  * The resulting document can then be saved to the disk by calling
  * Document::save().
+ * Edits made by Document::apply() also keep the index of line starts
+ * returned by Document::get_line_index() up to date.
+ * The line and word counts of the contents are taken whenever they're
+ * read from the store and retaken after edits once they're requested.
+ * Documents are kept in the store set by Document::set_store(),
+ * files in the working directory by default.
  *
  * @startuml{Document_Class.svg}
  * class Document {
  * .. Construction ..
  * + Document(Document &&)
  * + ~Document()
- * - Document(fd: int, name: string const &)
+ * - Document(store: shared_ptr<DocumentStore>, handle: unique_ptr<Handle>, name: string const &)
  * .. Deleted ..
  * + Document(Document const &)
  * + operator=(Document const &): Document &
@@ -122,27 +134,44 @@ namespace document_errors
  * + {static} create(name: string, overwrite: bool): Document
  * + {static} open(name: string): Document
  * + {static} is_empty(name: string): bool
- * + {static} list_documents(): vector<string>
+ * + {static} list_documents(directory: string): vector<string>
+ * + {static} get_directory(): string
+ * + {static} set_store(store: shared_ptr<DocumentStore> const &)
+ * + {static} get_store(): shared_ptr<DocumentStore>
  * + remove()
  * + save()
  * + close()
  * + hash(): array<char, 20>
  * + get_contents(): vector<char>
+ * + apply(operations: EditOperations const &)
+ * + get_line_index(): LineIndex const &
+ * + get_statistics(): TextStatistics const &
+ * + compress()
+ * + unload()
+ * + get_memory_usage(): size_t
+ * + is_resident(): bool
  * + get_name(): string
  * + get_id(): int32_t
  * .. helpers ..
- * - {static} open_readable(name: string): int
- * - {static} open_writable(name: string, overwrite: bool): int
  * - {static} increment_global_document_id()
  * __ attributes __
+ * + {static} MAX_INDEXED_OPERATIONS: size_t const
  * - contents_: vector<char>
- * - fd_: int
+ * - store_: shared_ptr<DocumentStore>
+ * - handle_: unique_ptr<DocumentStore::Handle>
  * - name_: string const
  * - {static} directory_: string const
+ * - {static} default_store_: shared_ptr<DocumentStore>
  * - {static} global_document_id_: int32_t
  * - id_: int32_t
  * - document_closed_: bool
  * - contents_fetched_: bool
+ * - compressed_: vector<char>
+ * - contents_compressed_: bool
+ * - uncompressed_size_: size_t
+ * - line_index_: unique_ptr<LineIndex>
+ * - statistics_: TextStatistics
+ * - statistics_current_: bool
  * }
  * @enduml
  */
@@ -178,7 +207,7 @@ public:
 	/**
 	 * Create a document by name.
 	 *
-	 * Refer to open_writable() and Document() to see possible Exceptions.
+	 * Refer to DocumentStore::create() and Document() to see possible Exceptions.
 	 *
 	 * @param name The name the document is referenced by.
 	 * @param overwrite Allow overwriting if the document exists.
@@ -189,7 +218,7 @@ public:
 	/**
 	 * Open a document by name.
 	 *
-	 * Refer to open_readable() and Document() to see possible Exceptions.
+	 * Refer to DocumentStore::open() and Document() to see possible Exceptions.
 	 *
 	 * @param name The name the document is referenced by.
 	 * @return The Document instance.
@@ -199,11 +228,8 @@ public:
 	/**
 	 * Check if a document is empty.
 	 *
-	 * Refer to open_readable() which additional exceptions can occur.
+	 * Refer to DocumentStore::size() which exceptions can occur.
 	 *
-	 * @throws document_errors::DocumentError If the document size exceeds
-	 *                                        the upper limit of the size of
-	 *                                        the local off_t type.
 	 * @return true if empty, false otherwise.
 	 */
 	static bool is_empty(std::string const &name);
@@ -215,7 +241,7 @@ public:
 	 *                                                   situation where 2 instances of this document
 	 *                                                   are present and one is already removed.
 	 * @throws document_errors::DocumentPermissionsError If the remover lacks sufficient permissions to
-	 *                                                   remove the file.
+	 *                                                   remove the document.
 	 * @throws document_errors::DocumentError If removing fails for other reasons.
 	 */
 	void remove();
@@ -244,8 +270,6 @@ public:
 	 * Refer to get_contents() to see other possible exceptions that can get thrown.
 	 * Those are thrown if get_contents() wasn't called prior to this call.
 	 *
-	 * @throws std::runtime_error If the document size exceeds the upper limit of the
-	 *                            size of the local unsigned long type.
 	 * @return The SHA-1 hash (20 bytes) of the contents.
 	 */
 	Hash::hash_t hash();
@@ -255,15 +279,86 @@ public:
 	 *
 	 * @throws document_errors::DocumentClosedError If the document was closed by a
 	 *                                              call to close() prior to this call.
-	 * @throws document_errors::DocumentError If the document size exceeds
-	 *                                        the upper limit of the size of
-	 *                                        the local off_t type.
-	 * @throws document_errors::DocumentError If reading the internal file descriptor
-	 *                                        fails.
+	 * @throws document_errors::DocumentError If reading the document from the
+	 *                                        store fails.
 	 * @return A reference to the vector with all the bytes of the document.
 	 */
 	std::vector<char> &get_contents();
 
+	/**
+	 * Apply edit operations to the contents.
+	 * Unlike editing the contents returned by get_contents() directly, this
+	 * keeps the line index up to date. Batches of more than
+	 * MAX_INDEXED_OPERATIONS operations, e.g. replacing all occurrences of a
+	 * word, drop it instead, get_line_index() rebuilds it in one pass.
+	 *
+	 * Refer to get_contents() to see possible exceptions.
+	 *
+	 * @param operations The operations, in their order, positions within bounds.
+	 */
+	void apply(EditOperations const &operations);
+
+	//! the size of batches apply() updates the line index for one by one
+	static std::size_t const MAX_INDEXED_OPERATIONS = 64;
+
+	/**
+	 * Obtain the index of line starts, building it on first use.
+	 * It stays valid as long as all edits are made by apply().
+	 *
+	 * Refer to get_contents() to see possible exceptions.
+	 *
+	 * @return A reference to the index, valid until unload() is called.
+	 */
+	LineIndex const &get_line_index();
+
+	/**
+	 * Obtain the line and word counts of the contents and whether they are
+	 * valid UTF-8. They're taken when the contents are read from the store
+	 * and retaken on the first call after apply().
+	 *
+	 * Refer to get_contents() to see possible exceptions.
+	 *
+	 * @return A reference to the statistics, valid until the next edit.
+	 */
+	TextStatistics const &get_statistics();
+
+	/**
+	 * Compress the contents in memory to save space while the document is idle.
+	 * The next call to get_contents() decompresses them again.
+	 * Does nothing if the contents aren't loaded or don't get smaller.
+	 */
+	void compress();
+
+	/**
+	 * Release the contents and the line index to save space while the
+	 * document is idle.
+	 * The next call to get_contents() reads them from the store again, so
+	 * this must only be used if the contents match the stored ones.
+	 * Does nothing if the document was closed.
+	 */
+	void unload();
+
+	/**
+	 * Obtain the amount of memory allocated for the contents.
+	 *
+	 * @return The allocated bytes, compressed or not, and those of the line index.
+	 */
+	std::size_t get_memory_usage() const
+	{
+		return contents_.capacity() + compressed_.capacity() +
+		       (line_index_ ? line_index_->get_memory_usage() : 0);
+	}
+
+	/**
+	 * Check if the contents are loaded and neither compressed nor released.
+	 *
+	 * @return 'true' if get_contents() is served from memory as is.
+	 */
+	bool is_resident() const
+	{
+		return contents_fetched_ && !contents_compressed_;
+	}
+
 	/**
 	 * Obtain a list of documents that can be opened.
 	 *
@@ -274,10 +369,39 @@ public:
 	 *                                                   directory entries.
 	 * @throws document_errors::DocumentError If any other error occured during
 	 *                                        directory listing.
+	 * @param directory The directory to list, the documents directory by default.
 	 * @return A list of documents that can be opened. This does not include the
 	 *         standard unix directories (links) '.' and '..'.
 	 */
-	static std::vector<std::string> list_documents();
+	static std::vector<std::string> list_documents(std::string const &directory = directory_);
+
+	/**
+	 * Get the directory in which all server documents can be found.
+	 *
+	 * @return The path of the documents directory.
+	 */
+	static std::string const &get_directory()
+	{
+		return directory_;
+	}
+
+	/**
+	 * Set the store documents are created in and opened from.
+	 * Documents opened before keep using the store they came from.
+	 *
+	 * @param store The store for all following create(), open() and is_empty() calls.
+	 */
+	static void set_store(std::shared_ptr<DocumentStore> const &store);
+
+	/**
+	 * Get the store documents are created in and opened from.
+	 *
+	 * @return The store, files in the working directory unless set_store() was called.
+	 */
+	static std::shared_ptr<DocumentStore> const &get_store()
+	{
+		return default_store_;
+	}
 
 	/**
 	 * Get the name the document was created with.
@@ -303,58 +427,36 @@ public:
 	}
 
 private:
-	/**
-	 * Open a document by name and return the file descriptor.
-	 *
-	 * @param name The name the document is referenced by.
-	 * @return The UNIX file descriptor.
-	 * @throws document_errors::DocumentDoesntExistError If the document doesn't exist.
-	 * @throws document_errors::DocumentPermissionsError If the opener lacks sufficient permissions to
-	 *                                                   open the file.
-	 * @throws document_errors::DocumentError If opening fails for other reasons.
-	 */
-	static int open_readable(std::string const &name);
-
-	/**
-	 * Open a document by name and return the file descriptor.
-	 *
-	 * @param name The name the document is referenced by.
-	 * @param overwrite Use to determine if a file can be overwritten if it does
-	 *                  already exist.
-	 * @return The UNIX file descriptor.
-	 * @throws document_errors::DocumentAlreadyExistsError If the document doesn't exist.
-	 * @throws document_errors::DocumentPermissionsError If the opener lacks sufficient permissions to
-	 *                                                   open the file.
-	 * @throws document_errors::DocumentError If opening fails for other reasons.
-	 */
-	static int open_writable(std::string const &name, bool overwrite);
-
 	/**
 	 * Increment the global document id and consider wrap around.
 	 */
 	static void increment_global_document_id();
 
 	/**
-	 * Create a document with a linux specific file descriptor.
+	 * Create a document with a handle of its store.
 	 *
 	 * See get_contents() to see which exceptions can occur.
 	 * The constructor initially reads all the contents.
 	 *
-	 * @param fd The descriptor for this document. The descriptor must
-	 *           be a valid descriptor as returned by open(2). Otherwise
-	 *           the behaviour is undefined.
+	 * @param store The store the document is kept in.
+	 * @param handle The handle obtained from the store.
 	 * @param name The name the document is referenced by.
 	 */
-	explicit Document(int fd, std::string const &name);
+	Document(std::shared_ptr<DocumentStore> const &store,
+	         std::unique_ptr<DocumentStore::Handle> handle, std::string const &name);
 
 	//! byte container for the document
 	std::vector<char> contents_;
-	//! unix file descriptor valid until close() was called
-	int fd_;
+	//! the store the document is kept in
+	std::shared_ptr<DocumentStore> store_;
+	//! access to the stored document, valid until close() was called
+	std::unique_ptr<DocumentStore::Handle> handle_;
 	//! the name which was passed from create() or open()
 	std::string const name_;
 	//! the directory in which all server documents can be found
 	static std::string const directory_;
+	//! the store for newly created or opened documents
+	static std::shared_ptr<DocumentStore> default_store_;
 	//! the global document id, wraps after 2147483647
 	static std::int32_t global_document_id_;
 	//! the id for this particular document instance
@@ -363,6 +465,18 @@ private:
 	bool document_closed_;
 	//! indicator for fetched contents, true after get_contents()
 	bool contents_fetched_;
+	//! the zlib compressed contents, empty unless compressed
+	std::vector<char> compressed_;
+	//! indicator for compressed contents, true between compress() and get_contents()
+	bool contents_compressed_;
+	//! the size of the contents while they're compressed
+	std::size_t uncompressed_size_;
+	//! the line starts of the contents, null until get_line_index()
+	std::unique_ptr<LineIndex> line_index_;
+	//! the statistics of the contents, outdated by apply()
+	TextStatistics statistics_;
+	//! indicator for current statistics, false between apply() and get_statistics()
+	bool statistics_current_;
 };
 
 #endif
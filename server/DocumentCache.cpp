@@ -0,0 +1,105 @@
+/**
+ * @file DocumentCache.cpp
+ */
+
+#include "DocumentCache.h"
+
+namespace
+{
+	/**
+		Gets the size and modification time of a document from the document store.
+
+		@return false if the document can't be accessed
+	**/
+	bool stat_document(const std::string &name, int64_t &size, int64_t &modified)
+	{
+		try
+		{
+			DocumentStore::Status status = Document::get_store()->status(name);
+			size = status.size;
+			modified = status.modified;
+			return true;
+		}
+		catch (const document_errors::DocumentError &)
+		{ return false; }
+	}
+}
+
+DocumentCache::DocumentCache(size_t capacity):
+	capacity(capacity), size(0)
+{}
+
+DocumentCache::~DocumentCache(void)
+{
+	while (!entries.empty())
+	{ evict(entries.begin()); }
+}
+
+void DocumentCache::erase(const std::string &name)
+{
+	auto cached = entry_by_name.find(name);
+	if (cached != entry_by_name.end())
+	{ evict(cached->second); }
+}
+
+void DocumentCache::evict(Entries::iterator entry)
+{
+	size -= entry->doc->get_contents().size();
+	entry->doc->close();
+	entry_by_name.erase(entry->doc->get_name());
+	entries.erase(entry);
+}
+
+void DocumentCache::insert(std::shared_ptr<Document> doc, const Hash::hash_t *hash)
+{
+	// a document of that name can only be cached once, the newer one wins
+	auto cached = entry_by_name.find(doc->get_name());
+	if (cached != entry_by_name.end())
+	{ evict(cached->second); }
+
+	Entry entry;
+	size_t doc_size = doc->get_contents().size();
+	if (doc_size > capacity || !stat_document(doc->get_name(), entry.size, entry.modified))
+	{
+		doc->close();
+		return;
+	}
+
+	entry.doc = doc;
+	entry.hashed = hash != NULL;
+	if (hash)
+	{ entry.hash = *hash; }
+
+	while (size + doc_size > capacity)
+	{ evict(entries.begin()); }
+
+	entry_by_name[doc->get_name()] = entries.insert(entries.end(), entry);
+	size += doc_size;
+}
+
+std::shared_ptr<Document> DocumentCache::take(const std::string &name, Hash::hash_t &hash,
+	bool &hashed)
+{
+	auto cached = entry_by_name.find(name);
+	if (cached == entry_by_name.end())
+	{ return std::shared_ptr<Document>(); }
+
+	Entries::iterator entry = cached->second;
+	int64_t file_size, modified;
+	if (!stat_document(name, file_size, modified) || file_size != entry->size ||
+		modified != entry->modified)
+	{
+		evict(entry);
+		return std::shared_ptr<Document>();
+	}
+
+	std::shared_ptr<Document> doc = entry->doc;
+	hash = entry->hash;
+	hashed = entry->hashed;
+
+	size -= doc->get_contents().size();
+	entry_by_name.erase(cached);
+	entries.erase(entry);
+
+	return doc;
+}
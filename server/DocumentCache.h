@@ -0,0 +1,104 @@
+/**	@file DocumentCache.h
+**/
+
+#ifndef _DOCUMENTCACHE_H_
+#define _DOCUMENTCACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "Document.h"
+
+/**
+	@brief Recently closed documents, kept loaded to serve reopening them from memory.
+
+	The cache is bounded by the size of the contents it holds. Inserting a document evicts the
+	least recently closed ones until the contents fit, evicted documents are closed. A document
+	is only handed out again if the size and modification time the document store reports still
+	match the ones it was closed with, along with the hash of its contents if that was known.
+
+	Only documents whose contents match the stored ones may be inserted, unsaved edits would be
+	resurrected otherwise.
+**/
+class DocumentCache
+{
+	public:
+		/**
+			Creates an empty cache.
+
+			@param capacity the size of the contents the cache holds at most, in bytes
+		**/
+		explicit DocumentCache(size_t capacity);
+		DocumentCache(const DocumentCache &) = delete;
+		DocumentCache &operator=(const DocumentCache &) = delete;
+		/**
+			Destructor. Closes all cached documents.
+		**/
+		~DocumentCache(void);
+
+		/**
+			Removes a document from the cache and closes it, e.g. because it's deleted.
+
+			@param name a reference to the document name
+		**/
+		void erase(const std::string &name);
+		/**
+			Returns the size of the cached contents.
+
+			@return the size in bytes
+		**/
+		inline size_t get_size(void) const;
+		/**
+			Caches a closed document, or closes it if its file can't be checked or its contents
+			exceed the capacity.
+
+			@param doc a shared pointer to the document
+			@param hash a pointer to the hash of its contents, NULL if unknown
+		**/
+		void insert(std::shared_ptr<Document> doc, const Hash::hash_t *hash = NULL);
+		/**
+			Removes a document from the cache if it's unchanged in the store. Stale documents are closed.
+
+			@param name a reference to the document name
+			@param hash a reference to store the hash of the contents in, if known
+			@param hashed a reference to store whether the hash is known in
+			@return a shared pointer to the document, empty if it isn't cached or stale
+		**/
+		std::shared_ptr<Document> take(const std::string &name, Hash::hash_t &hash,
+			bool &hashed);
+
+	private:
+		/**
+			A cached document and its state in the store when it was closed.
+		**/
+		struct Entry
+		{
+			std::shared_ptr<Document>	doc; ///< the loaded document
+			Hash::hash_t				hash; ///< hash of the contents, if hashed
+			bool						hashed; ///< whether the hash is known
+			int64_t						modified; ///< modification time in the store, in ns
+			int64_t						size; ///< size in the store
+		};
+
+		typedef std::list<Entry> Entries; ///< entries, least recently closed first
+
+		/**
+			Removes an entry and closes its document.
+
+			@param entry the entry to remove
+		**/
+		void evict(Entries::iterator entry);
+
+		size_t						capacity; ///< size of the contents held at most
+		Entries						entries; ///< cached documents
+		std::unordered_map<std::string, Entries::iterator>	entry_by_name; ///< name -> entry
+		size_t						size; ///< size of the cached contents
+};
+
+size_t DocumentCache::get_size(void) const
+{ return size; }
+
+#endif
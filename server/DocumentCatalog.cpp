@@ -0,0 +1,195 @@
+/**
+ * @file DocumentCatalog.cpp
+ */
+
+#include <algorithm>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "Document.h"
+#include "DocumentCatalog.h"
+#include "FileDocumentStore.h"
+
+const int32_t DocumentCatalog::MAX_PAGE_SIZE;
+
+DocumentCatalog::DocumentCatalog(std::shared_ptr<DocumentStore> store):
+	inotify_fd(-1), store(store), watch_fd(-1)
+{
+	const FileDocumentStore *files = dynamic_cast<const FileDocumentStore *>(store.get());
+	if (files)
+	{
+		directory = files->get_directory();
+		inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		watch();
+	}
+
+	rescan();
+}
+
+DocumentCatalog::~DocumentCatalog(void)
+{
+	if (inotify_fd >= 0)
+	{ ::close(inotify_fd); }
+}
+
+void DocumentCatalog::add(const std::string &name)
+{
+	auto position = std::lower_bound(names.begin(), names.end(), name);
+	if (position != names.end() && *position == name)
+	{ return; }
+
+	names.insert(position, name);
+	for (std::vector<char> &frame: frames)
+	{ frame.clear(); }
+}
+
+const std::vector<char> &DocumentCatalog::get_frame(uint8_t version)
+{
+	refresh();
+
+	std::vector<char> &frame = frames[version - 1];
+	if (!frame.empty())
+	{ return frame; }
+
+	Message message;
+	message.type = Message::MessageType::TYPE_DOC_LIST;
+	message.length = 0;
+	message.bytes.reserve(names.size() * Message::FIELD_SIZE_DOC_NAME);
+
+	for (const std::string &name: names)
+	{
+		// skip if document name is empty
+		if (name.empty())
+		{ continue; }
+
+		// copy the name, truncated or padded to the field size
+		size_t length = std::min(name.length(), Message::FIELD_SIZE_DOC_NAME);
+		message.bytes.insert(message.bytes.end(), name.begin(), name.begin() + length);
+		message.bytes.insert(message.bytes.end(), Message::FIELD_SIZE_DOC_NAME - length, '\0');
+		++message.length;
+	}
+
+	return message.generate_bytestream(frame, version);
+}
+
+const std::vector<std::string> &DocumentCatalog::get_names(void)
+{
+	refresh();
+	return names;
+}
+
+int32_t DocumentCatalog::get_page(const std::string &prefix, int32_t offset, int32_t limit,
+	DocumentEntries &dest)
+{
+	refresh();
+
+	// the matching names form a range, it ends before the first greater name without the prefix
+	auto begin = std::lower_bound(names.begin(), names.end(), prefix);
+	auto end = std::partition_point(begin, names.end(), [&prefix](const std::string &name)
+		{ return name.compare(0, prefix.length(), prefix) == 0; });
+	int32_t matches = end - begin;
+
+	offset = std::min(std::max(offset, 0), matches);
+	limit = std::min(std::max(limit, 0), std::min(MAX_PAGE_SIZE, matches - offset));
+
+	dest.clear();
+	dest.reserve(limit);
+	for (auto name = begin + offset; name != begin + offset + limit; ++name)
+	{
+		DocumentEntry entry;
+		entry.name.assign(name->begin(), name->end());
+
+		try
+		{
+			DocumentStore::Status status = store->status(*name);
+			entry.modified = status.modified / 1000000000;
+			entry.size = status.size;
+		}
+		catch (const document_errors::DocumentError &)
+		{}
+
+		dest.push_back(std::move(entry));
+	}
+
+	return matches;
+}
+
+void DocumentCatalog::remove(const std::string &name)
+{
+	auto position = std::lower_bound(names.begin(), names.end(), name);
+	if (position == names.end() || *position != name)
+	{ return; }
+
+	names.erase(position);
+	for (std::vector<char> &frame: frames)
+	{ frame.clear(); }
+}
+
+void DocumentCatalog::refresh(void)
+{
+	if (directory.empty())
+	{ return; }
+
+	bool stale = false;
+
+	// apply the queued events, the watch of a removed or moved directory is useless
+	alignas(inotify_event) char buffer[4096];
+	ssize_t amount;
+	while (watch_fd >= 0 && (amount = ::read(inotify_fd, buffer, sizeof(buffer))) > 0)
+	{
+		for (char *position = buffer; position < buffer + amount;)
+		{
+			const inotify_event *event = reinterpret_cast<const inotify_event *>(position);
+			position += sizeof(inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW)
+			{ stale = true; }
+			else if (event->wd != watch_fd)
+			{ continue; }
+			else if (event->mask & (IN_IGNORED | IN_MOVE_SELF))
+			{
+				inotify_rm_watch(inotify_fd, watch_fd);
+				watch_fd = -1;
+			}
+			else if (event->len == 0)
+			{ continue; }
+			else if (event->mask & (IN_CREATE | IN_MOVED_TO))
+			{ add(event->name); }
+			else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+			{ remove(event->name); }
+		}
+	}
+
+	if (watch_fd < 0)
+	{
+		watch();
+		stale = true;
+	}
+
+	if (stale)
+	{ rescan(); }
+}
+
+void DocumentCatalog::rescan(void)
+{
+	names.clear();
+	for (std::vector<char> &frame: frames)
+	{ frame.clear(); }
+
+	try
+	{
+		names = store->list();
+		std::sort(names.begin(), names.end());
+	}
+	catch (const document_errors::DocumentError &)
+	{}
+}
+
+void DocumentCatalog::watch(void)
+{
+	if (inotify_fd < 0)
+	{ return; }
+
+	watch_fd = inotify_add_watch(inotify_fd, directory.c_str(),
+		IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MOVE_SELF | IN_ONLYDIR);
+}
@@ -0,0 +1,113 @@
+/**	@file DocumentCatalog.h
+**/
+
+#ifndef _DOCUMENTCATALOG_H_
+#define _DOCUMENTCATALOG_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DocumentEntry.h"
+#include "DocumentStore.h"
+#include "Message.h"
+
+/**
+	@brief The names of all documents, kept in memory to answer TYPE_DOC_LIST without listing the
+	document store.
+
+	The names are kept sorted, so a TYPE_DOC_LIST_PAGE request is answered by a binary search for
+	its name prefix and the entries of the requested page.
+
+	The store is listed once on construction. Afterwards the catalog is updated by add() and
+	remove() for documents the server creates or deletes itself. The encoded TYPE_DOC_LIST frame is
+	cached per protocol version until the names change, so answering a listing request just sends
+	the cached bytestream.
+
+	Only files can be changed by others, so the directory of a FileDocumentStore is watched by
+	inotify as well. If it can't be watched, e.g. because it doesn't exist yet, the catalog is
+	rescanned whenever a frame is requested.
+**/
+class DocumentCatalog
+{
+	public:
+		static const int32_t MAX_PAGE_SIZE = 256; ///< entries of a listing page at most
+
+		/**
+			Creates a catalog of the documents within a store and starts watching its directory, if
+			it keeps the documents as files.
+
+			@param store the document store to list
+		**/
+		explicit DocumentCatalog(std::shared_ptr<DocumentStore> store);
+		DocumentCatalog(const DocumentCatalog &) = delete;
+		DocumentCatalog &operator=(const DocumentCatalog &) = delete;
+		/**
+			Destructor. Stops watching the directory.
+		**/
+		~DocumentCatalog(void);
+
+		/**
+			Adds a document to the catalog.
+
+			@param name a reference to the document name
+		**/
+		void add(const std::string &name);
+		/**
+			Returns the encoded TYPE_DOC_LIST frame, applying pending changes of the directory first.
+
+			@param version the protocol version to encode the frame for
+			@return a reference to the cached bytestream
+		**/
+		const std::vector<char> &get_frame(uint8_t version);
+		/**
+			Returns the names of all documents, applying pending changes of the directory first.
+
+			@return a reference to the sorted names
+		**/
+		const std::vector<std::string> &get_names(void);
+		/**
+			Looks up a page of the documents whose names start with a prefix, applying pending
+			changes of the directory first. The entries carry the size and modification time of
+			their documents, but no editors.
+
+			@param prefix a reference to the name prefix, empty to list all documents
+			@param offset the index of the first matching document to return
+			@param limit the amount of entries to return at most, capped at MAX_PAGE_SIZE
+			@param dest a reference to the DocumentEntries to store the page in
+			@return the amount of matching documents
+		**/
+		int32_t get_page(const std::string &prefix, int32_t offset, int32_t limit,
+			DocumentEntries &dest);
+		/**
+			Removes a document from the catalog.
+
+			@param name a reference to the document name
+		**/
+		void remove(const std::string &name);
+
+	private:
+		/**
+			Applies the pending inotify events of the directory, or rescans the store if the
+			directory isn't watched or events have been lost. Does nothing without a directory.
+		**/
+		void refresh(void);
+		/**
+			Replaces the names by the current contents of the store.
+		**/
+		void rescan(void);
+		/**
+			Tries to watch the directory, if it isn't watched yet.
+		**/
+		void watch(void);
+
+		std::string						directory; ///< path of the watched directory, empty if none
+		std::vector<char>				frames[Message::PROTOCOL_VERSION_LATEST]; ///< empty if stale
+		int								inotify_fd; ///< inotify instance, -1 if unavailable
+		std::vector<std::string>		names; ///< sorted names of all documents
+		std::shared_ptr<DocumentStore>	store; ///< store the documents are listed from
+		int								watch_fd; ///< watch of the directory, -1 if not watched
+};
+
+#endif
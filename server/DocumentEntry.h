@@ -0,0 +1,32 @@
+/**	@file DocumentEntry.h
+**/
+
+#ifndef _DOCUMENTENTRY_H_
+#define _DOCUMENTENTRY_H_
+
+#include <cstdint>
+#include <vector>
+
+/**
+	@brief A single document of a listing page, as carried by TYPE_DOC_LIST_PAGE.
+**/
+struct DocumentEntry
+{
+	int32_t				editors; ///< amount of clients having the document opened
+	int64_t				lines; ///< amount of lines, 0 unless the document is opened
+	int32_t				modified; ///< time of the last modification, seconds since the epoch
+	std::vector<char>	name; ///< document name
+	int64_t				size; ///< size of the document in bytes
+	int64_t				words; ///< amount of words, see TextStatistics
+
+	/**
+		Default constructor. Creates an entry without name and metadata.
+	**/
+	DocumentEntry(void):
+		editors(0), lines(0), modified(0), size(0), words(0)
+	{}
+};
+
+typedef std::vector<DocumentEntry> DocumentEntries; ///< entries of a listing page
+
+#endif
@@ -0,0 +1,123 @@
+#include "DocumentIndex.h"
+#include "Document.h"
+
+/**
+ * @file server/DocumentIndex.cpp
+ *
+ * Implementation file for the document metadata index.
+ */
+
+DocumentIndex *DocumentIndex::instance_;
+
+namespace
+{
+	//! A global variable which holds the used SQL queries (for easier access).
+	std::string const g_sql_queries[] = {
+		"CREATE TABLE IF NOT EXISTS DocumentIndex ("
+			"d_path VARCHAR(255) NOT NULL PRIMARY KEY,"
+			"d_size INTEGER NOT NULL,"
+			"d_mtime INTEGER NOT NULL,"
+			"d_hash VARCHAR(40) NOT NULL"
+		");",
+		"SELECT * FROM DocumentIndex WHERE d_path = %Q;",
+		"INSERT OR REPLACE INTO DocumentIndex (d_path, d_size, d_mtime, d_hash) "
+			"VALUES (%Q, %lld, %lld, %Q);",
+		"DELETE FROM DocumentIndex WHERE d_path = %Q;",
+	};
+
+	/**
+	 * Obtain the size and modification time of a document from the document store.
+	 *
+	 * @param path The name of the document.
+	 * @param entry The entry to store size and modification time in.
+	 * @return 'true' on success, 'false' if the document can't be accessed.
+	 */
+	bool stat_document(std::string const &path, DocumentIndex::Entry &entry)
+	{
+		DocumentStore::Status status;
+
+		try
+		{
+			status = Document::get_store()->status(path);
+		}
+		catch (document_errors::DocumentError const &)
+		{
+			return false;
+		}
+
+		entry.size = status.size;
+		entry.modified = status.modified;
+
+		return true;
+	}
+}
+
+DocumentIndex::DocumentIndex(std::shared_ptr<Database> database)
+	: database_(database)
+{
+	database_->execute_sql(g_sql_queries[0]);
+
+	instance_ = this;
+}
+
+DocumentIndex::~DocumentIndex()
+{
+	if (instance_ == this)
+	{
+		instance_ = nullptr;
+	}
+}
+
+bool DocumentIndex::lookup(std::string const &path, Entry &entry)
+{
+	Entry current;
+
+	if (!stat_document(path, current))
+	{
+		return false;
+	}
+
+	Database::results_t result = database_->execute_sql(g_sql_queries[1], path);
+
+	if (result.size() != 1 || std::stoll(result[0]["d_size"]) != current.size ||
+	    std::stoll(result[0]["d_mtime"]) != current.modified)
+	{
+		return false;
+	}
+
+	entry = current;
+	entry.hash = Hash::string_to_hash(result[0]["d_hash"]);
+
+	return true;
+}
+
+void DocumentIndex::update(std::string const &path, Hash::hash_t const &hash)
+{
+	Entry entry;
+
+	// without a modification time the entry could never be validated
+	if (!stat_document(path, entry))
+	{
+		return;
+	}
+
+	database_->execute_sql(g_sql_queries[2], path, static_cast<long long>(entry.size),
+	                       static_cast<long long>(entry.modified),
+	                       Hash::hash_to_string(hash));
+}
+
+void DocumentIndex::remove(std::string const &path)
+{
+	database_->execute_sql(g_sql_queries[3], path);
+}
+
+DocumentIndex &DocumentIndex::get_instance()
+{
+	if (!instance_)
+	{
+		throw database_errors::Failure(
+			"a reference to the document index was requested but it wasn't constructed yet");
+	}
+
+	return *instance_;
+}
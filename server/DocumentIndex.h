@@ -0,0 +1,131 @@
+#ifndef DOCUMENTINDEX_H_INCLUDED
+#define DOCUMENTINDEX_H_INCLUDED
+
+#include "Database.h"
+#include "Hash.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @file server/DocumentIndex.h
+ *
+ * Interface for the persistent document metadata index.
+ */
+
+/**
+ * A table of size, modification time and content hash of every document
+ * that was hashed or saved, kept in the server database.
+ *
+ * An entry is only used while the size and modification time reported by
+ * the document store still match, which takes a single stat(2) call for
+ * files and a single query for the SQLite store. Hash comparisons of
+ * unchanged documents can thus be answered without reading or hashing
+ * the document body.
+ *
+ * This is a singleton like the UserDatabase, because all documents share
+ * one index. Although this implementation cannot be default constructed,
+ * hence make sure to call the constructor first.
+ *
+ * @startuml{DocumentIndex_Class.svg}
+ * class DocumentIndex << singleton >> {
+ * .. Construction ..
+ * + DocumentIndex(db: shared_ptr<Database>)
+ * + ~DocumentIndex()
+ * __
+ * + lookup(path: string const &, entry: Entry &): bool
+ * + update(path: string const &, hash: array<char, 20> const &)
+ * + remove(path: string const &)
+ * + get_instance(): DocumentIndex &
+ * __ attributes __
+ * - database_: shared_ptr<Database>
+ * - {static} instance_: DocumentIndex *
+ * }
+ * @enduml
+ */
+class DocumentIndex
+{
+public:
+	/**
+	 * The metadata of a single document.
+	 */
+	struct Entry
+	{
+		//! the size of the document in bytes
+		std::int64_t size;
+		//! the modification time in nanoseconds since the epoch
+		std::int64_t modified;
+		//! the SHA-1 hash of the contents
+		Hash::hash_t hash;
+	};
+
+	/**
+	 * Construct the document index, creating its table if necessary.
+	 *
+	 * Refer to Database::execute_sql() to see which additional
+	 * constraints apply.
+	 *
+	 * @param database A shared database handle.
+	 */
+	explicit DocumentIndex(std::shared_ptr<Database> database);
+
+	/**
+	 * Deconstruct the document index. get_instance() fails afterwards.
+	 */
+	~DocumentIndex();
+
+	/**
+	 * Delete the default copy constructor, there's only one index.
+	 */
+	DocumentIndex(DocumentIndex const &) = delete;
+
+	/**
+	 * Delete the default assignment operator, there's only one index.
+	 */
+	DocumentIndex &operator=(DocumentIndex const &) = delete;
+
+	/**
+	 * Look up the metadata of a document.
+	 *
+	 * @param path The name of the document.
+	 * @param entry The entry to store the metadata in.
+	 * @throws database_errors::Failure If the query fails.
+	 * @return 'true' if the document is indexed and hasn't changed in the
+	 *         document store since, 'false' otherwise.
+	 */
+	bool lookup(std::string const &path, Entry &entry);
+
+	/**
+	 * Index the contents of a document, e.g. after saving it.
+	 *
+	 * @param path The name of the document.
+	 * @param hash The SHA-1 hash of the contents the store currently holds.
+	 * @throws database_errors::Failure If the query fails.
+	 */
+	void update(std::string const &path, Hash::hash_t const &hash);
+
+	/**
+	 * Forget the metadata of a document, e.g. after removing it.
+	 *
+	 * @param path The name of the document.
+	 * @throws database_errors::Failure If the query fails.
+	 */
+	void remove(std::string const &path);
+
+	/**
+	 * Obtain a reference to the one and only instance of this singleton.
+	 *
+	 * @throws database_errors::Failure If the constructor wasn't called yet.
+	 * @return A reference to the implementation.
+	 */
+	static DocumentIndex &get_instance();
+
+private:
+	//! A pointer to the underlying database.
+	std::shared_ptr<Database> database_;
+	//! Store a pointer to this implementation.
+	static DocumentIndex *instance_;
+};
+
+#endif
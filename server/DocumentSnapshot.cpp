@@ -0,0 +1,114 @@
+/**
+ * @file DocumentSnapshot.cpp
+ */
+
+#include <algorithm>
+#include <zlib.h>
+
+#include "Document.h"
+#include "DocumentSnapshot.h"
+#include "Transfer.h"
+
+namespace
+{
+	/**
+		Returns the amount of chunks contents are sent in.
+
+		@param length the size of the contents
+		@return the amount of chunks of at most Transfer::CHUNK_SIZE bytes
+	**/
+	size_t count_chunks(size_t length)
+	{ return (length + Transfer::CHUNK_SIZE - 1) / Transfer::CHUNK_SIZE; }
+}
+
+DocumentSnapshot::DocumentSnapshot(std::shared_ptr<Document> doc):
+	doc(doc), size(0)
+{
+	size_t count = count_chunks(doc->get_contents().size());
+	for (VersionChunks &version_chunks: chunks)
+	{
+		for (Chunks &compression_chunks: version_chunks)
+		{ compression_chunks.resize(count); }
+	}
+}
+
+DocumentSnapshot::DocumentSnapshot(const std::vector<char> &contents):
+	size(0)
+{
+	copy(contents);
+
+	for (VersionChunks &version_chunks: chunks)
+	{
+		for (Chunks &compression_chunks: version_chunks)
+		{ compression_chunks.resize(pieces.size()); }
+	}
+}
+
+void DocumentSnapshot::copy(const std::vector<char> &contents)
+{
+	pieces.reserve(count_chunks(contents.size()));
+	for (size_t position = 0; position < contents.size(); position += Transfer::CHUNK_SIZE)
+	{
+		size_t length = std::min(contents.size() - position,
+			static_cast<size_t>(Transfer::CHUNK_SIZE));
+		pieces.emplace_back(contents.begin() + position, contents.begin() + position + length);
+	}
+
+	size += contents.size();
+}
+
+void DocumentSnapshot::detach(void)
+{
+	if (!doc)
+	{ return; }
+
+	copy(doc->get_contents());
+	doc.reset();
+}
+
+const std::vector<char> &DocumentSnapshot::get_chunk(size_t index, uint8_t version,
+	uint8_t compression)
+{
+	std::vector<char> &chunk = chunks[version - 1][compression][index];
+	if (!chunk.empty())
+	{ return chunk; }
+
+	Message message;
+	message.type = Message::MessageType::TYPE_SYNC_MULTIBYTE;
+	message.position = static_cast<int64_t>(index) * Transfer::CHUNK_SIZE;
+	if (doc)
+	{
+		const std::vector<char> &contents = doc->get_contents();
+		size_t length = std::min(contents.size() - message.position,
+			static_cast<size_t>(Transfer::CHUNK_SIZE));
+		message.bytes.assign(contents.begin() + message.position,
+			contents.begin() + message.position + length);
+	}
+	else
+	{ message.bytes = pieces[index]; }
+
+	size_t length = message.bytes.size();
+	message.length = length;
+
+	// deflate the chunk if that makes it smaller
+	if (compression == Message::COMPRESSION_ZLIB)
+	{
+		uLongf deflated_length = compressBound(length);
+		std::vector<char> deflated(deflated_length);
+
+		int result = compress2(reinterpret_cast<Bytef *>(deflated.data()), &deflated_length,
+			reinterpret_cast<const Bytef *>(message.bytes.data()), length, Z_BEST_SPEED);
+
+		if (result == Z_OK && deflated_length < length)
+		{
+			deflated.resize(deflated_length);
+			message.type = Message::MessageType::TYPE_SYNC_COMPRESSED;
+			message.length = deflated_length;
+			message.bytes.swap(deflated);
+		}
+	}
+
+	message.generate_bytestream(chunk, version);
+	size += chunk.size();
+	return chunk;
+}
@@ -0,0 +1,98 @@
+/**	@file DocumentSnapshot.h
+**/
+
+#ifndef _DOCUMENTSNAPSHOT_H_
+#define _DOCUMENTSNAPSHOT_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Message.h"
+
+class Document;
+
+/**
+	@brief The contents of a document at one revision, serialized as TYPE_SYNC_MULTIBYTE chunks.
+
+	Every chunk is encoded at most once per protocol version and compression, when the first
+	Transfer needs it, and kept for all later Transfers. Clients opening a document that hasn't
+	been edited since thus share one copy of the encoded frames.
+
+	With Message::COMPRESSION_ZLIB, chunks are sent as TYPE_SYNC_COMPRESSED if deflating them
+	saves space.
+
+	A snapshot of a Document encodes its chunks straight from the contents of the Document, which
+	therefore must neither change nor be compressed or unloaded while the snapshot refers to it.
+	Before that, detach(void) copies the contents into the snapshot, so Transfers still sending it
+	can finish. The contents are copied in pieces of Transfer::CHUNK_SIZE bytes, so a large
+	document doesn't need a second contiguous allocation of its size.
+**/
+class DocumentSnapshot
+{
+	public:
+		/**
+			Creates a snapshot of a document, referring to its current contents.
+
+			@param doc a shared pointer to the document, its contents must be loaded
+		**/
+		explicit DocumentSnapshot(std::shared_ptr<Document> doc);
+		/**
+			Creates a detached snapshot of contents.
+
+			@param contents a reference to the contents to copy
+		**/
+		explicit DocumentSnapshot(const std::vector<char> &contents);
+
+		/**
+			Copies the contents of the document into the snapshot and stops referring to it, so
+			the document may change afterwards. Does nothing if the snapshot is detached already.
+		**/
+		void detach(void);
+		/**
+			Returns an encoded chunk of the contents, encoding it if it hasn't been yet.
+
+			@param index the index of the chunk, less than get_chunk_count(void)
+			@param version the protocol version to encode the chunk for
+			@param compression the compression negotiated by the client
+			@return a reference to the bytestream of the chunk
+		**/
+		const std::vector<char> &get_chunk(size_t index, uint8_t version, uint8_t compression);
+		/**
+			Returns the amount of chunks the contents are sent in.
+
+			@return the amount of chunks, 0 if the contents are empty
+		**/
+		inline size_t get_chunk_count(void) const;
+		/**
+			Returns the amount of bytes the snapshot holds on its own: the encoded chunks and the
+			contents copied by detaching, but not the contents of the document it refers to.
+
+			@return the size in bytes
+		**/
+		inline size_t get_size(void) const;
+
+	private:
+		typedef std::vector<std::vector<char>> Chunks; ///< encoded chunks, empty until needed
+		typedef Chunks VersionChunks[Message::COMPRESSION_LATEST + 1]; ///< chunks per compression
+
+		/**
+			Copies contents in pieces of Transfer::CHUNK_SIZE bytes.
+
+			@param contents a reference to the contents to copy
+		**/
+		void copy(const std::vector<char> &contents);
+
+		VersionChunks				chunks[Message::PROTOCOL_VERSION_LATEST]; ///< chunks per version
+		std::shared_ptr<Document>	doc; ///< document at the revision of the snapshot, if attached
+		Chunks						pieces; ///< contents per chunk, once detached
+		size_t						size; ///< bytes of the encoded chunks and the pieces
+};
+
+size_t DocumentSnapshot::get_chunk_count(void) const
+{ return chunks[0][0].size(); }
+
+size_t DocumentSnapshot::get_size(void) const
+{ return size; }
+
+#endif
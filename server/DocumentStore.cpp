@@ -0,0 +1,24 @@
+#include "DocumentStore.h"
+
+#include <chrono>
+
+/**
+ * @file server/DocumentStore.cpp
+ * @author Daniel Mierswa <daniel.mierswa@student.hs-rm.de>
+ *
+ * Implementation file for common abstractions of document stores.
+ */
+
+DocumentStore::Handle::~Handle()
+{
+}
+
+DocumentStore::~DocumentStore()
+{
+}
+
+std::int64_t DocumentStore::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
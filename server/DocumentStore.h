@@ -0,0 +1,197 @@
+#ifndef DOCUMENTSTORE_H_INCLUDED
+#define DOCUMENTSTORE_H_INCLUDED
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @file server/DocumentStore.h
+ * @author Daniel Mierswa <daniel.mierswa@student.hs-rm.de>
+ *
+ * Interface for the storage backends of documents.
+ */
+
+/**
+ * An interface for the place the documents are kept in.
+ * Documents are referenced by name, an opened document is accessed
+ * through a handle.
+ *
+ * Errors are reported with the exceptions of the document_errors
+ * namespace (see Document.h).
+ *
+ * @startuml{DocumentStore_Class.svg}
+ * class DocumentStore << abstract >> {
+ * .. Construction ..
+ * + DocumentStore()
+ * + ~DocumentStore()
+ * .. Deleted ..
+ * + DocumentStore(DocumentStore const &)
+ * + operator=(DocumentStore const &): DocumentStore &
+ * __ abstract __
+ * + create(name: string const &, overwrite: bool): unique_ptr<Handle>
+ * + open(name: string const &): unique_ptr<Handle>
+ * + remove(name: string const &)
+ * + size(name: string const &): uint64_t
+ * + status(name: string const &): Status
+ * + list(): vector<string>
+ * __
+ * + {static} now(): int64_t
+ * }
+ * class DocumentStore::Status {
+ * + size: uint64_t
+ * + modified: int64_t
+ * }
+ * class DocumentStore::Handle << abstract >> {
+ * + ~Handle()
+ * __ abstract __
+ * + read(contents: vector<char> &)
+ * + write(contents: vector<char> const &)
+ * }
+ * DocumentStore +-- DocumentStore::Status
+ * DocumentStore +-- DocumentStore::Handle
+ * @enduml
+ */
+class DocumentStore
+{
+public:
+	/**
+	 * The size and modification time of a document, as far as the store knows them
+	 * without reading it. The modification time changes whenever the document is
+	 * created or written, so it tells whether metadata kept elsewhere is still valid.
+	 */
+	struct Status
+	{
+		//! the size of the contents in bytes
+		std::uint64_t size;
+		//! the time of the last modification in nanoseconds since the epoch
+		std::int64_t modified;
+	};
+
+	/**
+	 * Access to the contents of one opened document.
+	 * Destroying the handle closes the document.
+	 */
+	class Handle
+	{
+	public:
+		/**
+		 * Close the document.
+		 */
+		virtual ~Handle();
+
+		/**
+		 * Read all contents of the document.
+		 *
+		 * @param contents The container to replace with the contents.
+		 * @throws document_errors::DocumentError If reading fails.
+		 */
+		virtual void read(std::vector<char> &contents) = 0;
+
+		/**
+		 * Replace all contents of the document.
+		 *
+		 * @param contents The new contents.
+		 * @throws document_errors::DocumentError If writing fails.
+		 */
+		virtual void write(std::vector<char> const &contents) = 0;
+	};
+
+	/**
+	 * Construct a document store.
+	 * Provide a default constructor, because this is just an interface.
+	 */
+	DocumentStore() = default;
+
+	/**
+	 * Deconstruct a document store, freeing all its resources.
+	 * Handles obtained from the store must not outlive it.
+	 */
+	virtual ~DocumentStore();
+
+	/**
+	 * Delete the default copy constructor, making copying a document store
+	 * impossible.
+	 */
+	DocumentStore(DocumentStore const &) = delete;
+
+	/**
+	 * Delete the default assignment operator, making assigning a document store
+	 * impossible.
+	 */
+	DocumentStore &operator=(DocumentStore const &) = delete;
+
+	/**
+	 * Create an empty document.
+	 *
+	 * @param name The name the document is referenced by.
+	 * @param overwrite Allow overwriting if the document exists.
+	 * @throws document_errors::DocumentAlreadyExistsError If the document exists and
+	 *                                                     overwrite is 'false'.
+	 * @throws document_errors::DocumentPermissionsError If the store denies creating it.
+	 * @throws document_errors::DocumentError If creating fails for other reasons.
+	 * @return The handle of the new document.
+	 */
+	virtual std::unique_ptr<Handle> create(std::string const &name, bool overwrite) = 0;
+
+	/**
+	 * Open an existing document.
+	 *
+	 * @param name The name the document is referenced by.
+	 * @throws document_errors::DocumentDoesntExistError If the document doesn't exist.
+	 * @throws document_errors::DocumentPermissionsError If the store denies opening it.
+	 * @throws document_errors::DocumentError If opening fails for other reasons.
+	 * @return The handle of the document.
+	 */
+	virtual std::unique_ptr<Handle> open(std::string const &name) = 0;
+
+	/**
+	 * Remove a document.
+	 * Whether opened handles of it stay usable depends on the store.
+	 *
+	 * @param name The name the document is referenced by.
+	 * @throws document_errors::DocumentDoesntExistError If the document doesn't exist.
+	 * @throws document_errors::DocumentPermissionsError If the store denies removing it.
+	 * @throws document_errors::DocumentError If removing fails for other reasons.
+	 */
+	virtual void remove(std::string const &name) = 0;
+
+	/**
+	 * Obtain the size of a document without reading it.
+	 *
+	 * @param name The name the document is referenced by.
+	 * @throws document_errors::DocumentDoesntExistError If the document doesn't exist.
+	 * @throws document_errors::DocumentError If the size can't be determined.
+	 * @return The size of the contents in bytes.
+	 */
+	virtual std::uint64_t size(std::string const &name) = 0;
+
+	/**
+	 * Obtain the size and modification time of a document without reading it.
+	 *
+	 * @param name The name the document is referenced by.
+	 * @throws document_errors::DocumentDoesntExistError If the document doesn't exist.
+	 * @throws document_errors::DocumentError If the status can't be determined.
+	 * @return The status of the document.
+	 */
+	virtual Status status(std::string const &name) = 0;
+
+	/**
+	 * Obtain the names of all documents in the store.
+	 *
+	 * @throws document_errors::DocumentError If listing fails.
+	 * @return The names of the documents that can be opened.
+	 */
+	virtual std::vector<std::string> list() = 0;
+
+	/**
+	 * Obtain the current time, stores without a modification time of their own
+	 * record it when documents are written.
+	 *
+	 * @return The time in nanoseconds since the epoch, like Status::modified.
+	 */
+	static std::int64_t now();
+};
+
+#endif
@@ -0,0 +1,312 @@
+#include "DocumentVersions.h"
+
+#include <algorithm>
+#include <array>
+#include <ctime>
+
+/**
+ * @file server/DocumentVersions.cpp
+ *
+ * Implementation file for the versioned history of saved documents.
+ */
+
+DocumentVersions *DocumentVersions::instance_;
+
+namespace
+{
+	//! A global variable which holds the used SQL queries (for easier access).
+	std::string const g_sql_queries[] = {
+		"CREATE TABLE IF NOT EXISTS DocumentChunk ("
+			"c_hash VARCHAR(40) NOT NULL PRIMARY KEY,"
+			"c_data BLOB NOT NULL"
+		");",
+		"CREATE TABLE IF NOT EXISTS DocumentVersion ("
+			"v_path VARCHAR(255) NOT NULL,"
+			"v_version INTEGER NOT NULL,"
+			"v_time INTEGER NOT NULL,"
+			"v_size INTEGER NOT NULL,"
+			"v_hash VARCHAR(40) NOT NULL,"
+			"PRIMARY KEY (v_path, v_version)"
+		");",
+		"CREATE TABLE IF NOT EXISTS DocumentVersionChunk ("
+			"v_path VARCHAR(255) NOT NULL,"
+			"v_version INTEGER NOT NULL,"
+			"c_index INTEGER NOT NULL,"
+			"c_hash VARCHAR(40) NOT NULL,"
+			"PRIMARY KEY (v_path, v_version, c_index)"
+		");",
+		"CREATE INDEX IF NOT EXISTS DocumentVersionChunkHash ON DocumentVersionChunk (c_hash);",
+		"SELECT * FROM DocumentVersion WHERE v_path = %Q ORDER BY v_version DESC LIMIT 1;",
+		"SELECT COUNT(*) AS c_count FROM DocumentChunk WHERE c_hash = %Q;",
+		"INSERT INTO DocumentChunk (c_hash, c_data) VALUES (%Q, X'%q');",
+		"INSERT INTO DocumentVersionChunk (v_path, v_version, c_index, c_hash) "
+			"VALUES (%Q, %lld, %lld, %Q);",
+		"INSERT INTO DocumentVersion (v_path, v_version, v_time, v_size, v_hash) "
+			"VALUES (%Q, %lld, %lld, %lld, %Q);",
+		"SELECT * FROM DocumentVersion WHERE v_path = %Q AND v_version = %lld;",
+		"SELECT hex(c.c_data) AS c_data FROM DocumentVersionChunk v "
+			"JOIN DocumentChunk c ON c.c_hash = v.c_hash "
+			"WHERE v.v_path = %Q AND v.v_version = %lld ORDER BY v.c_index;",
+		"SELECT * FROM DocumentVersion WHERE v_path = %Q ORDER BY v_version;",
+		"DELETE FROM DocumentVersionChunk WHERE v_path = %Q;",
+		"DELETE FROM DocumentVersion WHERE v_path = %Q;",
+		"DELETE FROM DocumentChunk WHERE c_hash NOT IN "
+			"(SELECT c_hash FROM DocumentVersionChunk);",
+	};
+
+	//! the boundary condition, the upper 13 bits of the gear hash are cleared every 8 KiB
+	std::uint64_t const CHUNK_MASK = ~(~std::uint64_t(0) >> 13);
+
+	/**
+	 * Obtain the random values the gear hash adds per byte.
+	 * They are derived from a fixed seed, boundaries must not change
+	 * between runs or stored chunks would no longer be shared.
+	 *
+	 * @return The value for every byte.
+	 */
+	std::array<std::uint64_t, 256> const &get_gear_table()
+	{
+		static std::array<std::uint64_t, 256> const table = []()
+		{
+			std::array<std::uint64_t, 256> table;
+			std::uint64_t state = 0x6a09e667f3bcc908ull;
+
+			// splitmix64
+			for (std::uint64_t &value: table)
+			{
+				std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+				z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+				z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+				value = z ^ (z >> 31);
+			}
+
+			return table;
+		}();
+
+		return table;
+	}
+
+	/**
+	 * Convert bytes to their hexadecimal representation.
+	 *
+	 * @param begin The first byte.
+	 * @param end The end of the bytes.
+	 * @return Two hexadecimal digits per byte.
+	 */
+	std::string to_hex(char const *begin, char const *end)
+	{
+		static char const digits[] = "0123456789ABCDEF";
+		std::string hex;
+
+		hex.reserve(2 * (end - begin));
+
+		for (; begin != end; ++begin)
+		{
+			unsigned char const byte = *begin;
+			hex += digits[byte >> 4];
+			hex += digits[byte & 0xf];
+		}
+
+		return hex;
+	}
+
+	/**
+	 * Append the bytes of a hexadecimal representation.
+	 *
+	 * @param hex Two upper case hexadecimal digits per byte, as returned by hex().
+	 * @param bytes The container to append the bytes to.
+	 */
+	void append_hex(std::string const &hex, std::vector<char> &bytes)
+	{
+		auto const value = [](char digit)
+		{
+			return digit <= '9' ? digit - '0' : digit - 'A' + 10;
+		};
+
+		for (std::size_t i = 0; i + 1 < hex.size(); i += 2)
+		{
+			bytes.push_back(static_cast<char>(value(hex[i]) << 4 | value(hex[i + 1])));
+		}
+	}
+
+	/**
+	 * Convert a row of the DocumentVersion table.
+	 *
+	 * @param result The row.
+	 * @return The version it describes.
+	 */
+	DocumentVersions::Version to_version(Database::result_t &result)
+	{
+		DocumentVersions::Version version;
+
+		version.version = std::stoll(result["v_version"]);
+		version.time = std::stoll(result["v_time"]);
+		version.size = std::stoll(result["v_size"]);
+		version.hash = Hash::string_to_hash(result["v_hash"]);
+
+		return version;
+	}
+}
+
+DocumentVersions::DocumentVersions(std::shared_ptr<Database> database)
+	: database_(database)
+{
+	for (std::size_t i = 0; i < 4; i++)
+	{
+		database_->execute_sql(g_sql_queries[i]);
+	}
+
+	instance_ = this;
+}
+
+DocumentVersions::~DocumentVersions()
+{
+	if (instance_ == this)
+	{
+		instance_ = nullptr;
+	}
+}
+
+std::int64_t DocumentVersions::commit(std::string const &path,
+                                      std::vector<char> const &contents)
+{
+	std::string const hash = Hash::hash_to_string(Hash::hash_bytes(contents));
+	Database::results_t latest = database_->execute_sql(g_sql_queries[4], path);
+	long long version = 1;
+
+	if (!latest.empty())
+	{
+		if (latest[0]["v_hash"] == hash)
+		{
+			return std::stoll(latest[0]["v_version"]);
+		}
+
+		version = std::stoll(latest[0]["v_version"]) + 1;
+	}
+
+	std::vector<std::size_t> const boundaries = split(contents);
+
+	// all rows of a version are written at once, the SQLite journal is synced once as well
+	database_->execute_sql("BEGIN;");
+
+	try
+	{
+		std::size_t begin = 0;
+
+		for (std::size_t i = 0; i < boundaries.size(); i++)
+		{
+			char const *const chunk_begin = contents.data() + begin;
+			char const *const chunk_end = contents.data() + boundaries[i];
+			std::string const chunk_hash =
+				Hash::hash_to_string(Hash::hash_bytes(chunk_begin, chunk_end));
+
+			// only chunks that no version contains yet are stored
+			if (database_->execute_sql(g_sql_queries[5], chunk_hash)[0]["c_count"] == "0")
+			{
+				database_->execute_sql(g_sql_queries[6], chunk_hash,
+				                       to_hex(chunk_begin, chunk_end));
+			}
+
+			database_->execute_sql(g_sql_queries[7], path, version, static_cast<long long>(i),
+			                       chunk_hash);
+			begin = boundaries[i];
+		}
+
+		database_->execute_sql(g_sql_queries[8], path, version,
+		                       static_cast<long long>(std::time(nullptr)),
+		                       static_cast<long long>(contents.size()), hash);
+		database_->execute_sql("COMMIT;");
+	}
+	catch (...)
+	{
+		database_->execute_sql("ROLLBACK;");
+		throw;
+	}
+
+	return version;
+}
+
+bool DocumentVersions::checkout(std::string const &path, std::int64_t version,
+                                std::vector<char> &contents)
+{
+	long long const number = version;
+	Database::results_t versions = database_->execute_sql(g_sql_queries[9], path, number);
+
+	if (versions.size() != 1)
+	{
+		return false;
+	}
+
+	Database::results_t const chunks = database_->execute_sql(g_sql_queries[10], path, number);
+
+	contents.clear();
+	contents.reserve(std::stoll(versions[0]["v_size"]));
+
+	for (Database::result_t const &chunk: chunks)
+	{
+		append_hex(chunk.at("c_data"), contents);
+	}
+
+	return true;
+}
+
+std::vector<DocumentVersions::Version> DocumentVersions::list(std::string const &path)
+{
+	Database::results_t results = database_->execute_sql(g_sql_queries[11], path);
+	std::vector<Version> versions;
+
+	for (Database::result_t &result: results)
+	{
+		versions.push_back(to_version(result));
+	}
+
+	return versions;
+}
+
+void DocumentVersions::remove(std::string const &path)
+{
+	database_->execute_sql(g_sql_queries[12], path);
+	database_->execute_sql(g_sql_queries[13], path);
+	database_->execute_sql(g_sql_queries[14]);
+}
+
+std::vector<std::size_t> DocumentVersions::split(std::vector<char> const &bytes)
+{
+	std::array<std::uint64_t, 256> const &gear = get_gear_table();
+	std::vector<std::size_t> boundaries;
+	std::size_t begin = 0;
+
+	while (begin < bytes.size())
+	{
+		std::size_t const end = std::min(bytes.size(), begin + MAX_CHUNK_SIZE);
+		std::size_t i = std::min(end, begin + MIN_CHUNK_SIZE);
+		std::uint64_t hash = 0;
+
+		// the hash only depends on the last 64 bytes, which starts it in time for the minimum
+		for (std::size_t j = i - std::min<std::size_t>(i - begin, 64); j < i; j++)
+		{
+			hash = (hash << 1) + gear[static_cast<unsigned char>(bytes[j])];
+		}
+
+		for (; i < end && (hash & CHUNK_MASK) != 0; i++)
+		{
+			hash = (hash << 1) + gear[static_cast<unsigned char>(bytes[i])];
+		}
+
+		boundaries.push_back(i);
+		begin = i;
+	}
+
+	return boundaries;
+}
+
+DocumentVersions &DocumentVersions::get_instance()
+{
+	if (!instance_)
+	{
+		throw database_errors::Failure(
+			"a reference to the document history was requested but it wasn't constructed yet");
+	}
+
+	return *instance_;
+}
@@ -0,0 +1,166 @@
+#ifndef DOCUMENTVERSIONS_H_INCLUDED
+#define DOCUMENTVERSIONS_H_INCLUDED
+
+#include "Database.h"
+#include "Hash.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @file server/DocumentVersions.h
+ *
+ * Interface for the versioned history of saved documents.
+ */
+
+/**
+ * The saved versions of every document, kept in the server database.
+ *
+ * The contents of a version are split into chunks whose boundaries depend
+ * on the contents only (content-defined chunking with a gear hash), so an
+ * edit moves at most the boundaries next to it. Chunks are stored once by
+ * their SHA-1 hash and shared by all versions containing them, a new
+ * version thus stores the chunks touched by the edits and one reference
+ * per chunk.
+ *
+ * This is a singleton like the DocumentIndex, because all documents share
+ * one history. Although this implementation cannot be default constructed,
+ * hence make sure to call the constructor first.
+ *
+ * @startuml{DocumentVersions_Class.svg}
+ * class DocumentVersions << singleton >> {
+ * .. Construction ..
+ * + DocumentVersions(db: shared_ptr<Database>)
+ * + ~DocumentVersions()
+ * __
+ * + commit(path: string const &, contents: vector<char> const &): int64_t
+ * + checkout(path: string const &, version: int64_t, contents: vector<char> &): bool
+ * + list(path: string const &): vector<Version>
+ * + remove(path: string const &)
+ * + {static} split(bytes: vector<char> const &): vector<size_t>
+ * + get_instance(): DocumentVersions &
+ * __ attributes __
+ * - database_: shared_ptr<Database>
+ * - {static} instance_: DocumentVersions *
+ * }
+ * @enduml
+ */
+class DocumentVersions
+{
+public:
+	/**
+	 * The metadata of a single version.
+	 */
+	struct Version
+	{
+		//! the number of the version, starting at 1 for each document
+		std::int64_t version;
+		//! the time of the save in seconds since the epoch
+		std::int64_t time;
+		//! the size of the contents in bytes
+		std::int64_t size;
+		//! the SHA-1 hash of the contents
+		Hash::hash_t hash;
+	};
+
+	//! the minimum size of a chunk, except for the last one
+	static std::size_t const MIN_CHUNK_SIZE = 2 << 10;
+	//! the maximum size of a chunk
+	static std::size_t const MAX_CHUNK_SIZE = 64 << 10;
+
+	/**
+	 * Construct the document history, creating its tables if necessary.
+	 *
+	 * Refer to Database::execute_sql() to see which additional
+	 * constraints apply.
+	 *
+	 * @param database A shared database handle.
+	 */
+	explicit DocumentVersions(std::shared_ptr<Database> database);
+
+	/**
+	 * Deconstruct the document history. get_instance() fails afterwards.
+	 */
+	~DocumentVersions();
+
+	/**
+	 * Delete the default copy constructor, there's only one history.
+	 */
+	DocumentVersions(DocumentVersions const &) = delete;
+
+	/**
+	 * Delete the default assignment operator, there's only one history.
+	 */
+	DocumentVersions &operator=(DocumentVersions const &) = delete;
+
+	/**
+	 * Store the contents of a document as its next version.
+	 * Contents equal to the latest version don't create a new one.
+	 *
+	 * @param path The path of the document.
+	 * @param contents The contents that were saved.
+	 * @throws database_errors::Failure If a query fails, no version is stored then.
+	 * @return The number of the version holding the contents.
+	 */
+	std::int64_t commit(std::string const &path, std::vector<char> const &contents);
+
+	/**
+	 * Restore the contents of a version.
+	 *
+	 * @param path The path of the document.
+	 * @param version The number of the version.
+	 * @param contents The container to replace with the contents.
+	 * @throws database_errors::Failure If a query fails.
+	 * @return 'true' if the version exists, 'false' otherwise.
+	 */
+	bool checkout(std::string const &path, std::int64_t version, std::vector<char> &contents);
+
+	/**
+	 * Obtain the versions of a document.
+	 *
+	 * @param path The path of the document.
+	 * @throws database_errors::Failure If the query fails.
+	 * @return The versions, oldest first.
+	 */
+	std::vector<Version> list(std::string const &path);
+
+	/**
+	 * Forget all versions of a document, e.g. after removing it.
+	 * Chunks no other version refers to are dropped as well.
+	 *
+	 * @param path The path of the document.
+	 * @throws database_errors::Failure If a query fails.
+	 */
+	void remove(std::string const &path);
+
+	/**
+	 * Find the content-defined chunk boundaries of some bytes.
+	 *
+	 * A boundary is placed where the gear hash of the preceding bytes has
+	 * its upper 13 bits cleared, which happens every 8 KiB on average.
+	 * Chunks are kept between MIN_CHUNK_SIZE and MAX_CHUNK_SIZE bytes.
+	 *
+	 * @param bytes The bytes to split.
+	 * @return The end offset of every chunk, the last one is bytes.size().
+	 */
+	static std::vector<std::size_t> split(std::vector<char> const &bytes);
+
+	/**
+	 * Obtain a reference to the one and only instance of this singleton.
+	 *
+	 * @throws database_errors::Failure If the constructor wasn't called yet.
+	 * @return A reference to the implementation.
+	 */
+	static DocumentVersions &get_instance();
+
+private:
+	//! A pointer to the underlying database.
+	std::shared_ptr<Database> database_;
+	//! Store a pointer to this implementation.
+	static DocumentVersions *instance_;
+};
+
+#endif
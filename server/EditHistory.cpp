@@ -0,0 +1,103 @@
+/**
+ * @file EditHistory.cpp
+ */
+
+#include "EditHistory.h"
+
+const size_t EditHistory::MAX_PENDING_EDITS;
+const size_t EditHistory::MAX_RETAINED_EDITS;
+
+EditHistory::EditHistory(void):
+	revision(0)
+{}
+
+void EditHistory::add_client(int client)
+{
+	ClientState &state = clients[client];
+	state.oldest_base = revision;
+	state.pending.clear();
+}
+
+int32_t EditHistory::commit(int client, const EditOperations &operations)
+{
+	++revision;
+
+	retained.push_back(std::make_pair(revision, operations));
+	if (retained.size() > MAX_RETAINED_EDITS)
+	{ retained.pop_front(); }
+
+	for (std::pair<const int, ClientState> &pair: clients)
+	{
+		ClientState &state = pair.second;
+
+		// the sender applied the edit before the server, so it has nothing to catch up on
+		if (pair.first == client)
+		{
+			state.oldest_base = revision;
+			state.pending.clear();
+			continue;
+		}
+
+		state.pending.push_back(std::make_pair(revision, operations));
+
+		// forget the oldest edit if the client doesn't acknowledge anything
+		if (state.pending.size() > MAX_PENDING_EDITS)
+		{
+			state.oldest_base = state.pending.front().first;
+			state.pending.pop_front();
+		}
+	}
+
+	return revision;
+}
+
+int32_t EditHistory::commit(int client, const EditOperations &operations, PendingEdits &pending)
+{
+	auto iter = clients.find(client);
+	int32_t oldest_base = iter == clients.end() ? revision : iter->second.oldest_base;
+
+	commit(client, operations);
+
+	if (iter != clients.end())
+	{
+		iter->second.oldest_base = oldest_base;
+		iter->second.pending.swap(pending);
+	}
+
+	return revision;
+}
+
+bool EditHistory::get_edits_since(int32_t revision, PendingEdits &dest) const
+{
+	int32_t oldest = this->revision - static_cast<int32_t>(retained.size());
+	if (revision < oldest || revision > this->revision)
+	{ return false; }
+
+	dest.insert(dest.end(), retained.begin() + (revision - oldest), retained.end());
+
+	return true;
+}
+
+void EditHistory::remove_client(int client)
+{ clients.erase(client); }
+
+bool EditHistory::transform(int client, int32_t base_revision, EditOperations &operations,
+	PendingEdits &pending) const
+{
+	auto iter = clients.find(client);
+	if (iter == clients.end() || base_revision > revision ||
+		base_revision < iter->second.oldest_base)
+	{ return false; }
+
+	// drop the edits the client has acknowledged
+	pending = iter->second.pending;
+	while (!pending.empty() && pending.front().first <= base_revision)
+	{ pending.pop_front(); }
+
+	// the client's operations come after the edits it hasn't seen; these in turn are moved behind
+	// the client's operations, as the client will do when it receives them
+	for (std::pair<int32_t, EditOperations> &edit: pending)
+	{ transform_edit_operations(operations, edit.second); }
+
+	return true;
+}
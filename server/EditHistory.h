@@ -0,0 +1,125 @@
+/**	@file EditHistory.h
+**/
+
+#ifndef _EDITHISTORY_H_
+#define _EDITHISTORY_H_
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+
+#include "EditOperation.h"
+
+/**
+	@brief Revision counter of an open document and the edits its clients haven't seen yet.
+
+	Every edit applied to the document increments its revision. Clients send TYPE_SYNC_BATCH with
+	the last revision they received (the base revision) and operations relative to that revision
+	followed by their own edits the server hasn't acknowledged yet, so they can keep sending without
+	waiting for acknowledgements.
+
+	For every client the history keeps the edits of other clients applied after the client's
+	last acknowledged revision, transformed past the client's own later edits (Jupiter-style
+	operational transformation). An incoming edit is transformed against those, which yields it
+	relative to the current revision.
+
+	Additionally the latest edits of all clients are retained, so a client resuming its session
+	after a dropped connection only receives the edits it missed.
+**/
+class EditHistory
+{
+	public:
+		/**
+			Unacknowledged edits of other clients and the revisions they resulted in.
+		**/
+		typedef std::deque<std::pair<int32_t, EditOperations>> PendingEdits;
+
+		static const size_t MAX_PENDING_EDITS = 1024; ///< pending edits kept per client
+		static const size_t MAX_RETAINED_EDITS = 256; ///< edits kept for resumed sessions
+
+		/**
+			Default constructor. Starts at revision 0.
+		**/
+		EditHistory(void);
+
+		/**
+			Registers a client, e.g. when it activates the document. Its base revision is the
+			current revision.
+
+			@param client the client's socket
+		**/
+		void add_client(int client);
+		/**
+			Records an edit that has been applied to the document. Increments the revision and
+			adds the edit to the pending edits of all other clients.
+
+			@param client the socket of the client that sent the edit
+			@param operations the operations as they have been applied
+			@return the new revision
+		**/
+		int32_t commit(int client, const EditOperations &operations);
+		/**
+			Like commit(int, const EditOperations&), but additionally replaces the client's pending
+			edits by those returned from transform(int, int32_t, EditOperations&, PendingEdits&).
+
+			@param pending the client's new pending edits
+		**/
+		int32_t commit(int client, const EditOperations &operations, PendingEdits &pending);
+		/**
+			Returns the retained edits applied after a revision.
+
+			@param revision the last revision the client received
+			@param dest a reference to append the edits and the revisions they resulted in to
+			@return false if the revision is newer than the current one or edits after it aren't
+				retained anymore
+		**/
+		bool get_edits_since(int32_t revision, PendingEdits &dest) const;
+		/**
+			Returns the current revision.
+
+			@return the amount of edits applied since the document has been opened
+		**/
+		inline int32_t get_revision(void) const;
+		/**
+			Unregisters a client, e.g. when it activates another document or disconnects.
+
+			@param client the client's socket
+		**/
+		void remove_client(int client);
+		/**
+			Transforms operations of a client against all edits of other clients it hasn't seen.
+			The history isn't modified until the result is committed, so the operations can still be
+			rejected.
+
+			@param client the socket of the client that sent the operations
+			@param base_revision the last revision the client received
+			@param operations a reference to the operations, afterwards relative to the current
+				revision
+			@param pending a reference to store the client's new pending edits in
+
+			@return false if the client isn't registered, or the base revision is newer than the
+				current one or older than the oldest pending edit kept
+		**/
+		bool transform(int client, int32_t base_revision, EditOperations &operations,
+			PendingEdits &pending) const;
+
+	private:
+		/**
+			@brief Transformation state of a single client.
+		**/
+		struct ClientState
+		{
+			int32_t			oldest_base; ///< oldest base revision that can still be transformed
+			PendingEdits	pending; ///< edits of others after the acknowledged revision
+		};
+
+		std::unordered_map<int, ClientState>	clients; ///< maps sockets onto their state
+		PendingEdits							retained; ///< latest edits of all clients
+		int32_t									revision; ///< current revision
+};
+
+int32_t EditHistory::get_revision(void) const
+{ return revision; }
+
+#endif
@@ -0,0 +1,273 @@
+/**
+ * @file EditOperation.cpp
+ */
+
+#include <algorithm>
+
+#include "EditOperation.h"
+
+// transformation auxiliary functions
+namespace
+{
+	/**
+		Appends a deletion unless it is empty.
+	**/
+	void append_deletion(EditOperations &dest, int64_t position, int64_t length)
+	{
+		if (length > 0)
+		{ dest.push_back(EditOperation(EditOperation::Kind::KIND_DELETE, position, length)); }
+	}
+
+	/**
+		Appends an insertion of the bytes of source at the given position.
+	**/
+	void append_insertion(EditOperations &dest, int64_t position, const EditOperation &source)
+	{ dest.push_back(EditOperation(EditOperation::Kind::KIND_INSERT, position, 0, source.bytes)); }
+
+	/**
+		Maps a position through a deletion of [start, start + length).
+	**/
+	int64_t shift_past_deletion(int64_t position, int64_t start, int64_t length)
+	{
+		if (position <= start)
+		{ return position; }
+
+		return position >= start + length ? position - length : start;
+	}
+
+	/**
+		Transforms an insertion and a deletion applying to the same contents against each other.
+		An insertion within the deleted range splits the deletion around the inserted bytes.
+	**/
+	void transform_insertion_deletion(const EditOperation &insertion,
+		const EditOperation &deletion, EditOperations &insertion_out,
+		EditOperations &deletion_out)
+	{
+		int64_t size = insertion.bytes.size();
+		int64_t end = deletion.position + deletion.length;
+
+		if (insertion.position <= deletion.position)
+		{
+			append_insertion(insertion_out, insertion.position, insertion);
+			append_deletion(deletion_out, deletion.position + size, deletion.length);
+		}
+		else if (insertion.position >= end)
+		{
+			append_insertion(insertion_out, insertion.position - deletion.length, insertion);
+			append_deletion(deletion_out, deletion.position, deletion.length);
+		}
+		else
+		{
+			append_insertion(insertion_out, deletion.position, insertion);
+			append_deletion(deletion_out, deletion.position,
+				insertion.position - deletion.position);
+			append_deletion(deletion_out, deletion.position + size, end - insertion.position);
+		}
+	}
+
+	/**
+		Transforms two normalised operations applying to the same contents against each other.
+		Appends the transformation of a past b to a_out and vice versa.
+	**/
+	void transform_operation(const EditOperation &a, const EditOperation &b,
+		EditOperations &a_out, EditOperations &b_out)
+	{
+		bool a_inserts = a.kind == EditOperation::Kind::KIND_INSERT;
+		bool b_inserts = b.kind == EditOperation::Kind::KIND_INSERT;
+
+		if (a_inserts && b_inserts)
+		{
+			// b comes first at the same position
+			if (a.position < b.position)
+			{
+				append_insertion(a_out, a.position, a);
+				append_insertion(b_out, b.position + a.bytes.size(), b);
+			}
+			else
+			{
+				append_insertion(a_out, a.position + b.bytes.size(), a);
+				append_insertion(b_out, b.position, b);
+			}
+		}
+		else if (a_inserts)
+		{ transform_insertion_deletion(a, b, a_out, b_out); }
+		else if (b_inserts)
+		{ transform_insertion_deletion(b, a, b_out, a_out); }
+		else
+		{
+			// both delete, the overlap is only deleted once
+			int64_t a_start = shift_past_deletion(a.position, b.position, b.length);
+			int64_t a_end = shift_past_deletion(a.position + a.length, b.position, b.length);
+			int64_t b_start = shift_past_deletion(b.position, a.position, a.length);
+			int64_t b_end = shift_past_deletion(b.position + b.length, a.position, a.length);
+
+			append_deletion(a_out, a_start, a_end - a_start);
+			append_deletion(b_out, b_start, b_end - b_start);
+		}
+	}
+
+	/**
+		Transforms two normalised sequences against each other by splitting them until single
+		operations are left.
+	**/
+	void transform_sequences(EditOperations &a, EditOperations &b)
+	{
+		if (a.empty() || b.empty())
+		{ return; }
+
+		if (a.size() == 1 && b.size() == 1)
+		{
+			EditOperations a_out, b_out;
+			transform_operation(a.front(), b.front(), a_out, b_out);
+			a.swap(a_out);
+			b.swap(b_out);
+			return;
+		}
+
+		// the second half applies to the result of the first half
+		EditOperations &longer = a.size() > 1 ? a : b;
+		EditOperations first(longer.begin(), longer.begin() + longer.size() / 2);
+		EditOperations second(longer.begin() + longer.size() / 2, longer.end());
+
+		if (&longer == &a)
+		{
+			transform_sequences(first, b);
+			transform_sequences(second, b);
+		}
+		else
+		{
+			transform_sequences(a, first);
+			transform_sequences(a, second);
+		}
+
+		first.insert(first.end(), second.begin(), second.end());
+		longer.swap(first);
+	}
+};
+
+EditOperation::EditOperation(void):
+	kind(Kind::KIND_INSERT), length(0), position(0)
+{}
+
+EditOperation::EditOperation(Kind kind, int64_t position, int64_t length,
+	const std::vector<char> &bytes):
+	bytes(kind == Kind::KIND_DELETE ? std::vector<char>() : bytes), kind(kind),
+	length(kind == Kind::KIND_INSERT ? 0 : length), position(position)
+{}
+
+int64_t EditOperation::map_position(int64_t position) const
+{
+	// in front of the operation
+	if (position <= this->position)
+	{ return position; }
+
+	// within the deleted range
+	if (position < this->position + length)
+	{ return this->position; }
+
+	return position + get_delta();
+}
+
+void apply_edit_operations(std::vector<char> &contents, const EditOperations &operations)
+{
+	// check whether every operation starts behind the bytes its predecessor inserted
+	bool ascending = true;
+	size_t result_size = contents.size();
+	int64_t end = 0;
+	for (const EditOperation &operation: operations)
+	{
+		ascending = ascending && operation.position >= end;
+		end = operation.position + operation.bytes.size();
+		result_size += operation.get_delta();
+	}
+
+	if (!ascending)
+	{
+		for (const EditOperation &operation: operations)
+		{
+			auto start = contents.begin() + operation.position;
+			start = contents.erase(start, start + operation.length);
+			contents.insert(start, operation.bytes.begin(), operation.bytes.end());
+		}
+
+		return;
+	}
+
+	// build the result in one pass, tracking the offset between old and new positions
+	std::vector<char> result;
+	result.reserve(result_size);
+
+	auto source = contents.begin();
+	int64_t offset = 0;
+	for (const EditOperation &operation: operations)
+	{
+		auto start = contents.begin() + (operation.position - offset);
+		result.insert(result.end(), source, start);
+		result.insert(result.end(), operation.bytes.begin(), operation.bytes.end());
+
+		source = start + operation.length;
+		offset += operation.get_delta();
+	}
+	result.insert(result.end(), source, contents.end());
+
+	contents.swap(result);
+}
+
+EditOperations normalize_edit_operations(const EditOperations &operations)
+{
+	EditOperations result;
+	result.reserve(operations.size());
+
+	for (const EditOperation &operation: operations)
+	{
+		append_deletion(result, operation.position, operation.length);
+		if (!operation.bytes.empty())
+		{ append_insertion(result, operation.position, operation); }
+	}
+
+	return result;
+}
+
+void transform_edit_operations(EditOperations &a, EditOperations &b)
+{
+	if (a.empty() || b.empty())
+	{ return; }
+
+	a = normalize_edit_operations(a);
+	b = normalize_edit_operations(b);
+	transform_sequences(a, b);
+}
+
+int64_t map_position(int64_t position, const EditOperations &operations)
+{
+	for (const EditOperation &operation: operations)
+	{ position = operation.map_position(position); }
+
+	return position;
+}
+
+void get_edit_range(const EditOperations &operations, int64_t &position, int64_t &length,
+	int64_t &inserted)
+{
+	position = 0;
+	length = 0;
+	inserted = 0;
+
+	// the range is kept in the coordinates of the contents as left by each operation
+	int64_t end = 0, delta = 0;
+	for (size_t i = 0; i < operations.size(); i++)
+	{
+		const EditOperation &operation = operations[i];
+		int64_t operation_end = operation.position + operation.length;
+
+		position = i == 0 ? operation.position : std::min(position, operation.position);
+		end = (i == 0 ? operation_end : std::max(end, operation_end)) + operation.get_delta();
+		delta += operation.get_delta();
+	}
+
+	if (!operations.empty())
+	{
+		length = end - delta - position;
+		inserted = end - position;
+	}
+}
@@ -0,0 +1,124 @@
+/**	@file EditOperation.h
+**/
+
+#ifndef _EDITOPERATION_H_
+#define _EDITOPERATION_H_
+
+#include <cstdint>
+#include <vector>
+
+/**
+	@brief A single edit of a document, as carried by TYPE_SYNC_BATCH.
+
+	Every operation removes length bytes at position and inserts bytes there afterwards. The kind
+	determines which of both parts are sent over the network: an insertion has no length, a
+	deletion has no bytes, a replacement has both.
+**/
+class EditOperation
+{
+	public:
+		/**
+			The kind of an operation.
+		**/
+		enum class Kind : uint8_t
+		{
+			KIND_INSERT, ///< insert bytes (position, bytes)
+			KIND_DELETE, ///< delete a range (position, length)
+			KIND_REPLACE ///< replace a range by bytes (position, length, bytes)
+		};
+
+		std::vector<char>	bytes; ///< bytes to insert
+		Kind				kind; ///< kind of the operation
+		int64_t				length; ///< amount of bytes to delete
+		int64_t				position; ///< start of the operation
+
+		/**
+			Default constructor. Creates an empty insertion at position 0.
+		**/
+		EditOperation(void);
+		/**
+			Creates an operation of the given kind.
+
+			@param kind the kind of the operation
+			@param position the start of the operation
+			@param length the amount of bytes to delete, ignored for insertions
+			@param bytes the bytes to insert, ignored for deletions
+		**/
+		EditOperation(Kind kind, int64_t position, int64_t length,
+			const std::vector<char> &bytes = std::vector<char>());
+
+		/**
+			Returns the amount by which this operation changes the document size.
+
+			@return the amount of inserted minus the amount of deleted bytes
+		**/
+		inline int64_t get_delta(void) const;
+		/**
+			Maps a position in the document before this operation onto the respective position
+			afterwards. Positions behind the affected range are shifted, positions within a deleted
+			range are moved to its start.
+
+			@param position the position before the operation
+			@return the position after the operation
+		**/
+		int64_t map_position(int64_t position) const;
+};
+
+typedef std::vector<EditOperation> EditOperations; ///< operations in the order they are applied
+
+/**
+	Applies the operations in their order to the given contents. Every operation's position refers
+	to the contents as left by the preceding operation. The operations must have been checked to be
+	in bounds.
+
+	If every operation starts behind the bytes inserted by its predecessor, as produced by editors
+	and find-and-replace, the result is built in one pass; otherwise the operations are applied one
+	after another.
+
+	@param contents a reference to the contents to modify
+	@param operations the operations to apply
+**/
+void apply_edit_operations(std::vector<char> &contents, const EditOperations &operations);
+/**
+	Splits replacements into a deletion followed by an insertion and drops operations that don't
+	change anything.
+
+	@param operations the operations to split
+	@return equivalent operations consisting of insertions and deletions only
+**/
+EditOperations normalize_edit_operations(const EditOperations &operations);
+/**
+	Transforms two sequences of operations that apply to the same contents against each other
+	(operational transformation), so that applying a followed by the transformed b gives the same
+	result as applying b followed by the transformed a. Insertions of b come first if both insert
+	at the same position. Both sequences are normalised if neither of them is empty.
+
+	@param a a reference to the first sequence, replaced by its transformation past b
+	@param b a reference to the second sequence, replaced by its transformation past a
+**/
+void transform_edit_operations(EditOperations &a, EditOperations &b);
+/**
+	Maps a position through all operations, as EditOperation::map_position(int64_t) does for one.
+
+	@param position the position before the operations
+	@param operations the operations
+	@return the position after all operations
+**/
+int64_t map_position(int64_t position, const EditOperations &operations);
+/**
+	Determines the smallest range the operations change, so that they can be summarised as a
+	single replacement of that range. Bytes outside the range are left as they are, bytes in
+	between changed ranges are counted as replaced.
+
+	@param operations the operations
+	@param position a reference to store the start of the range in
+	@param length a reference to store the length of the range before the operations in
+	@param inserted a reference to store the length of the range after the operations in
+**/
+void get_edit_range(const EditOperations &operations, int64_t &position, int64_t &length,
+	int64_t &inserted);
+
+int64_t EditOperation::get_delta(void) const
+{ return static_cast<int64_t>(bytes.size()) - length; }
+
+#endif
@@ -0,0 +1,356 @@
+#include "FileDocumentStore.h"
+#include "Document.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/**
+ * @file server/FileDocumentStore.cpp
+ * @author Daniel Mierswa <daniel.mierswa@student.hs-rm.de>
+ *
+ * Implementation file for the POSIX file implementation for the DocumentStore interface.
+ */
+
+using namespace document_errors;
+
+namespace
+{
+	//! the most bytes passed to a single pread(2) or pwrite(2), Linux transfers less than 2 GiB
+	std::size_t const IO_CHUNK_SIZE = 1 << 30;
+
+	/**
+	 * A document opened as file.
+	 * Contents are transferred in pieces of IO_CHUNK_SIZE bytes, so documents
+	 * beyond 2 GiB are read and written completely.
+	 */
+	class FileHandle
+		: public DocumentStore::Handle
+	{
+	public:
+		/**
+		 * Take ownership of a file descriptor.
+		 *
+		 * @param fd The descriptor as returned by open(2).
+		 */
+		explicit FileHandle(int fd)
+			: fd_(fd)
+		{
+		}
+
+		/**
+		 * Close the file descriptor.
+		 */
+		~FileHandle()
+		{
+			::close(fd_);
+		}
+
+		void read(std::vector<char> &contents)
+		{
+			off_t const end = ::lseek(fd_, 0, SEEK_END);
+
+			if (end == static_cast<off_t>(-1))
+			{
+				// should only fail if file too large
+				throw DocumentError(errno == EOVERFLOW ? "file too big" :
+				                    "unable to determine the file size");
+			}
+
+			// reserve space
+			contents.resize(end);
+
+			// read from the start, the offset is at the end now
+			std::size_t done = 0;
+
+			while (done < contents.size())
+			{
+				std::size_t const count = std::min(contents.size() - done, IO_CHUNK_SIZE);
+				ssize_t const read_result = ::pread(fd_, contents.data() + done, count, done);
+
+				if (read_result < 0 && errno == EINTR)
+				{
+					continue;
+				}
+
+				if (read_result <= 0)
+				{
+					throw DocumentError("unable to read all data from file");
+				}
+
+				done += read_result;
+			}
+		}
+
+		void write(std::vector<char> const &contents)
+		{
+			std::size_t done = 0;
+
+			while (done < contents.size())
+			{
+				std::size_t const count = std::min(contents.size() - done, IO_CHUNK_SIZE);
+				ssize_t const write_result = ::pwrite(fd_, contents.data() + done, count, done);
+
+				if (write_result < 0 && errno == EINTR)
+				{
+					continue;
+				}
+
+				if (write_result <= 0)
+				{
+					throw DocumentError("unable to write all data to file");
+				}
+
+				done += write_result;
+			}
+
+			if (::ftruncate(fd_, contents.size()))
+			{
+				throw DocumentError("unable to write all data to file");
+			}
+		}
+
+	private:
+		//! unix file descriptor, closed on destruction
+		int const fd_;
+	};
+}
+
+FileDocumentStore::FileDocumentStore(std::string const &directory)
+	: directory_(directory)
+{
+}
+
+std::unique_ptr<DocumentStore::Handle> FileDocumentStore::create(std::string const &name,
+                                                                 bool overwrite)
+{
+	return std::unique_ptr<Handle>(new FileHandle(open_writable(name, overwrite)));
+}
+
+std::unique_ptr<DocumentStore::Handle> FileDocumentStore::open(std::string const &name)
+{
+	return std::unique_ptr<Handle>(new FileHandle(open_readable(name)));
+}
+
+void FileDocumentStore::remove(std::string const &name)
+{
+	int const result = ::unlink(name.c_str());
+
+	if (result)
+	{
+		std::ostringstream strm;
+
+		strm << "while removing document <" << name << ">: ";
+
+		if (errno == ENOENT)
+		{
+			strm << "document does not exist";
+
+			throw DocumentDoesntExistError(strm.str());
+		}
+
+		if (errno == EACCES || errno == EROFS)
+		{
+			strm << "insufficient permissions to delete document";
+
+			throw DocumentPermissionsError(strm.str());
+		}
+
+		strm << std::strerror(errno);
+
+		throw DocumentError(strm.str());
+	}
+}
+
+std::uint64_t FileDocumentStore::size(std::string const &name)
+{
+	int const fd = open_readable(name);
+	struct ::stat status;
+	int const result = ::fstat(fd, &status);
+
+	::close(fd);
+
+	if (result)
+	{
+		// should only fail if file too large
+		throw DocumentError(errno == EOVERFLOW ? "file too big" : std::strerror(errno));
+	}
+
+	return status.st_size;
+}
+
+DocumentStore::Status FileDocumentStore::status(std::string const &name)
+{
+	struct ::stat status;
+
+	if (::stat(name.c_str(), &status))
+	{
+		std::ostringstream strm;
+
+		strm << "while accessing document <" << name << ">: ";
+
+		if (errno == ENOENT)
+		{
+			strm << "document does not exist";
+
+			throw DocumentDoesntExistError(strm.str());
+		}
+
+		strm << std::strerror(errno);
+
+		throw DocumentError(strm.str());
+	}
+
+	Status result;
+	result.size = status.st_size;
+	result.modified = static_cast<std::int64_t>(status.st_mtim.tv_sec) * 1000000000 +
+	                  status.st_mtim.tv_nsec;
+
+	return result;
+}
+
+std::vector<std::string> FileDocumentStore::list()
+{
+	return list_directory(directory_);
+}
+
+std::vector<std::string> FileDocumentStore::list_directory(std::string const &directory)
+{
+	DIR *dir = ::opendir(directory.c_str());
+	std::vector<std::string> list;
+
+	if (!dir)
+	{
+		std::ostringstream strm;
+
+		strm << "while listing documents <" << directory << ">: ";
+
+		if (errno == ENOENT || errno == ENOTDIR)
+		{
+			strm << "document directory does not exist";
+
+			throw DocumentDoesntExistError(strm.str());
+		}
+
+		if (errno == EACCES)
+		{
+			strm << "insufficient permissions to open document directory";
+
+			throw DocumentPermissionsError(strm.str());
+		}
+
+		strm << std::strerror(errno);
+
+		throw DocumentError(strm.str());
+	}
+
+	::dirent *entry;
+
+	try
+	{
+		while ((entry = ::readdir(dir)))
+		{
+			std::string const name = entry->d_name;
+
+			if (name != "." && name != "..")
+			{
+				list.push_back(name);
+			}
+		}
+
+		::closedir(dir);
+	}
+	catch (...)
+	{
+		::closedir(dir);
+		throw;
+	}
+
+	return list;
+}
+
+int FileDocumentStore::open_readable(std::string const &name)
+{
+	// using Linux API here because of error checking functionality
+	int fd = ::open(name.c_str(), O_RDWR);
+
+	// documents without write permission can still be read
+	if (fd < 0 && (errno == EACCES || errno == EROFS))
+	{
+		fd = ::open(name.c_str(), O_RDONLY);
+	}
+
+	if (fd < 0)
+	{
+		std::ostringstream strm;
+
+		strm << "while opening document <" << name << ">: ";
+
+		if (errno == ENOENT)
+		{
+			strm << "document does not exist";
+
+			throw DocumentDoesntExistError(strm.str());
+		}
+
+		if (errno == EACCES)
+		{
+			strm << "insufficient permissions to open document";
+
+			throw DocumentPermissionsError(strm.str());
+		}
+
+		strm << std::strerror(errno);
+
+		throw DocumentError(strm.str());
+	}
+
+	return fd;
+}
+
+int FileDocumentStore::open_writable(std::string const &name, bool overwrite)
+{
+	// using Linux API here because of error checking functionality
+	int flags = O_CREAT | O_RDWR | O_TRUNC;
+
+	if (!overwrite)
+	{
+		flags |= O_EXCL;
+	}
+
+	int const fd = ::open(name.c_str(), flags, 0644);
+
+	if (fd < 0)
+	{
+		std::ostringstream strm;
+
+		strm << "while creating document <" << name << ">: ";
+
+		if (errno == EEXIST)
+		{
+			strm << "document already exists";
+
+			throw DocumentAlreadyExistsError(strm.str());
+		}
+
+		if (errno == EACCES || errno == EROFS)
+		{
+			strm << "insufficient permissions to create document";
+
+			throw DocumentPermissionsError(strm.str());
+		}
+
+		strm << std::strerror(errno);
+
+		throw DocumentError(strm.str());
+	}
+
+	return fd;
+}
@@ -0,0 +1,141 @@
+#ifndef FILEDOCUMENTSTORE_H_INCLUDED
+#define FILEDOCUMENTSTORE_H_INCLUDED
+
+#include "DocumentStore.h"
+
+/**
+ * @file server/FileDocumentStore.h
+ * @author Daniel Mierswa <daniel.mierswa@student.hs-rm.de>
+ *
+ * POSIX file implementation for the DocumentStore interface.
+ */
+
+/**
+ * The file implementation of the document store interface.
+ * Each document is a file, names are used as paths as they are.
+ * Listing the store yields the entries of one directory.
+ *
+ * @startuml{FileDocumentStore_Class.svg}
+ * abstract class DocumentStore
+ * DocumentStore <|-- FileDocumentStore
+ * class FileDocumentStore {
+ * .. Construction ..
+ * + FileDocumentStore(directory: string const &)
+ * __
+ * + create(name: string const &, overwrite: bool): unique_ptr<Handle>
+ * + open(name: string const &): unique_ptr<Handle>
+ * + remove(name: string const &)
+ * + size(name: string const &): uint64_t
+ * + status(name: string const &): Status
+ * + list(): vector<string>
+ * + get_directory(): string const &
+ * + {static} list_directory(directory: string const &): vector<string>
+ * .. helpers ..
+ * - {static} open_readable(name: string const &): int
+ * - {static} open_writable(name: string const &, overwrite: bool): int
+ * __ attributes __
+ * - directory_: string const
+ * }
+ * @enduml
+ */
+class FileDocumentStore
+	: public DocumentStore
+{
+public:
+	/**
+	 * Construct a file document store.
+	 *
+	 * @param directory The directory whose entries list() returns.
+	 */
+	explicit FileDocumentStore(std::string const &directory);
+
+	std::unique_ptr<Handle> create(std::string const &name, bool overwrite);
+
+	std::unique_ptr<Handle> open(std::string const &name);
+
+	void remove(std::string const &name);
+
+	/**
+	 * Obtain the size of a document without reading it.
+	 *
+	 * @param name The name the document is referenced by.
+	 * @throws document_errors::DocumentDoesntExistError If the document doesn't exist.
+	 * @throws document_errors::DocumentError If the document size exceeds
+	 *                                        the upper limit of the size of
+	 *                                        the local off_t type.
+	 * @return The size of the file in bytes.
+	 */
+	std::uint64_t size(std::string const &name);
+
+	/**
+	 * Obtain the size and modification time of a document by a single stat(2) call.
+	 *
+	 * @param name The name the document is referenced by.
+	 * @throws document_errors::DocumentDoesntExistError If the document doesn't exist.
+	 * @throws document_errors::DocumentError If the file can't be accessed otherwise.
+	 * @return The size and the mtime of the file.
+	 */
+	Status status(std::string const &name);
+
+	std::vector<std::string> list();
+
+	/**
+	 * Obtain the directory whose entries are listed.
+	 *
+	 * @return The path of the directory.
+	 */
+	std::string const &get_directory() const
+	{
+		return directory_;
+	}
+
+	/**
+	 * Obtain the entries of a directory.
+	 *
+	 * @throws document_errors::DocumentDoesntExistError If the directory cannot
+	 *                                                   be accessed.
+	 * @throws document_errors::DocumentPermissionsError If the caller lacks
+	 *                                                   permissions to obtain
+	 *                                                   directory entries.
+	 * @throws document_errors::DocumentError If any other error occured during
+	 *                                        directory listing.
+	 * @param directory The directory to list.
+	 * @return The names of the entries. This does not include the
+	 *         standard unix directories (links) '.' and '..'.
+	 */
+	static std::vector<std::string> list_directory(std::string const &directory);
+
+private:
+	/**
+	 * Open a document by name and return the file descriptor.
+	 * The document is opened for reading and writing if permitted,
+	 * for reading only otherwise.
+	 *
+	 * @param name The name the document is referenced by.
+	 * @return The UNIX file descriptor.
+	 * @throws document_errors::DocumentDoesntExistError If the document doesn't exist.
+	 * @throws document_errors::DocumentPermissionsError If the opener lacks sufficient permissions to
+	 *                                                   open the file.
+	 * @throws document_errors::DocumentError If opening fails for other reasons.
+	 */
+	static int open_readable(std::string const &name);
+
+	/**
+	 * Open a document by name and return the file descriptor.
+	 *
+	 * @param name The name the document is referenced by.
+	 * @param overwrite Use to determine if a file can be overwritten if it does
+	 *                  already exist.
+	 * @return The UNIX file descriptor.
+	 * @throws document_errors::DocumentAlreadyExistsError If the document doesn't exist.
+	 * @throws document_errors::DocumentPermissionsError If the opener lacks sufficient permissions to
+	 *                                                   open the file.
+	 * @throws document_errors::DocumentError If opening fails for other reasons.
+	 */
+	static int open_writable(std::string const &name, bool overwrite);
+
+	//! the directory whose entries are listed
+	std::string const directory_;
+};
+
+#endif
@@ -13,13 +13,18 @@ namespace hash_errors
 }
 
 Hash::hash_t Hash::hash_bytes(std::vector<char> const &bytes)
+{
+	return hash_bytes(bytes.data(), bytes.data() + bytes.size());
+}
+
+Hash::hash_t Hash::hash_bytes(char const *begin, char const *end)
 {
 	hash_t sha1_hash;
 
 	// should never fail
 	::SHA1(
-		reinterpret_cast<unsigned char const *>(&bytes[0]),
-		bytes.size(),
+		reinterpret_cast<unsigned char const *>(begin),
+		end - begin,
 		reinterpret_cast<unsigned char *>(&sha1_hash[0]));
 
 	return sha1_hash;
@@ -44,6 +44,7 @@ namespace hash_errors
  * @startuml{Hash_Class.svg}
  * class Hash {
  * + {static} hash_bytes(bytes: vector<char> const &): array<char, 20>
+ * + {static} hash_bytes(begin: char const *, end: char const *): array<char, 20>
  * + {static} hash_to_string(hash: array<char, 20>): string
  * + {static} string_to_hash(hash_string: string const &): array<char, 20>
  * }
@@ -63,6 +64,16 @@ public:
 	 */
 	static hash_t hash_bytes(std::vector<char> const &bytes);
 
+	/**
+	 * Create a hash for a range of bytes, e.g. a part of a larger buffer
+	 * which doesn't have to be copied first.
+	 *
+	 * @param begin The first byte.
+	 * @param end The end of the bytes.
+	 * @return The hash sequence for the specified bytes.
+	 */
+	static hash_t hash_bytes(char const *begin, char const *end);
+
 	/**
 	 * Convert a raw hash bytestream to hexadecimal represented string.
 	 *
@@ -0,0 +1,367 @@
+#include "LineIndex.h"
+
+#include <algorithm>
+
+/**
+ * @file server/LineIndex.cpp
+ *
+ * Implementation file for the index of line starts within a document.
+ */
+
+namespace
+{
+	/**
+	 * Split bytes into the lengths of their lines.
+	 *
+	 * @param begin The first byte.
+	 * @param end The end of the bytes.
+	 * @return The length of every line including its newline, the last one
+	 *         is the length of the bytes behind the last newline.
+	 */
+	std::vector<std::int64_t> split_lines(char const *begin, char const *end)
+	{
+		std::vector<std::int64_t> lengths;
+		char const *line = begin;
+
+		for (char const *newline; (newline = std::find(line, end, '\n')) != end;
+		     line = newline + 1)
+		{
+			lengths.push_back(newline + 1 - line);
+		}
+
+		lengths.push_back(end - line);
+
+		return lengths;
+	}
+}
+
+LineIndex::LineIndex(std::vector<char> const &contents)
+	: nodes_(1, Node()), root_(0), seed_(2463534242u)
+{
+	root_ = build(split_lines(contents.data(), contents.data() + contents.size()));
+}
+
+std::int64_t LineIndex::get_line_start(std::int64_t line) const
+{
+	std::int64_t start = 0;
+	std::size_t lines = line;
+
+	// the lines of left subtrees passed on the way down precede the line
+	for (std::size_t node = root_; node != 0;)
+	{
+		Node const &current = nodes_[node];
+		std::size_t const preceding = nodes_[current.left].lines;
+
+		if (lines < preceding)
+		{
+			node = current.left;
+			continue;
+		}
+
+		start += nodes_[current.left].bytes;
+
+		if (lines == preceding)
+		{
+			break;
+		}
+
+		start += current.length;
+		lines -= preceding + 1;
+		node = current.right;
+	}
+
+	return start;
+}
+
+std::int64_t LineIndex::get_line(std::int64_t position) const
+{
+	std::size_t line = 0;
+
+	for (std::size_t node = root_; node != 0;)
+	{
+		Node const &current = nodes_[node];
+		Node const &left = nodes_[current.left];
+
+		if (position < left.bytes)
+		{
+			node = current.left;
+			continue;
+		}
+
+		position -= left.bytes;
+
+		if (position < current.length)
+		{
+			return line + left.lines;
+		}
+
+		position -= current.length;
+		line += left.lines + 1;
+		node = current.right;
+	}
+
+	// only the last line can be empty, so it is the only one ending at the end
+	return get_line_count() - 1;
+}
+void LineIndex::insert(std::int64_t position, std::vector<char> const &bytes)
+{
+	if (bytes.empty())
+	{
+		return;
+	}
+
+	std::size_t const line = get_line(position);
+
+	if (std::find(bytes.begin(), bytes.end(), '\n') == bytes.end())
+	{
+		add(line, bytes.size());
+		return;
+	}
+
+	// the line is split where the bytes are inserted
+	std::int64_t const offset = position - get_line_start(line);
+	std::vector<std::int64_t> lengths = split_lines(bytes.data(), bytes.data() + bytes.size());
+
+	lengths.front() += offset;
+	lengths.back() += get_line_length(line) - offset;
+	splice(line, line, lengths);
+}
+
+void LineIndex::erase(std::int64_t position, std::int64_t length)
+{
+	if (length == 0)
+	{
+		return;
+	}
+
+	std::size_t const first = get_line(position);
+	std::size_t const last = get_line(position + length);
+
+	if (first == last)
+	{
+		add(first, -length);
+		return;
+	}
+
+	// the lines the erased newlines ended are merged
+	std::int64_t const end = get_line_start(last) + get_line_length(last);
+	splice(first, last, { end - get_line_start(first) - length });
+}
+
+void LineIndex::apply(EditOperation const &operation)
+{
+	erase(operation.position, operation.length);
+	insert(operation.position, operation.bytes);
+}
+
+std::size_t LineIndex::find(std::size_t line) const
+{
+	std::size_t node = root_;
+
+	for (;;)
+	{
+		Node const &current = nodes_[node];
+		std::size_t const preceding = nodes_[current.left].lines;
+
+		if (line < preceding)
+		{
+			node = current.left;
+		}
+		else if (line == preceding)
+		{
+			return node;
+		}
+		else
+		{
+			line -= preceding + 1;
+			node = current.right;
+		}
+	}
+}
+
+void LineIndex::add(std::size_t line, std::int64_t delta)
+{
+	std::size_t node = root_;
+
+	// every subtree on the way down contains the line
+	for (;;)
+	{
+		Node &current = nodes_[node];
+		std::size_t const preceding = nodes_[current.left].lines;
+
+		current.bytes += delta;
+
+		if (line < preceding)
+		{
+			node = current.left;
+		}
+		else if (line == preceding)
+		{
+			current.length += delta;
+			return;
+		}
+		else
+		{
+			line -= preceding + 1;
+			node = current.right;
+		}
+	}
+}
+
+void LineIndex::splice(std::size_t first, std::size_t last,
+                       std::vector<std::int64_t> const &lengths)
+{
+	std::size_t before, replaced, after;
+
+	split(root_, first, before, after);
+	split(after, last + 1 - first, replaced, after);
+	release(replaced);
+
+	root_ = merge(merge(before, build(lengths)), after);
+}
+
+std::size_t LineIndex::create(std::int64_t length)
+{
+	// xorshift, the priorities only have to be independent of the edits
+	seed_ ^= seed_ << 13;
+	seed_ ^= seed_ >> 17;
+	seed_ ^= seed_ << 5;
+
+	Node const node = { length, length, 1, 0, 0, seed_ };
+
+	if (free_.empty())
+	{
+		nodes_.push_back(node);
+		return nodes_.size() - 1;
+	}
+
+	std::size_t const index = free_.back();
+	free_.pop_back();
+	nodes_[index] = node;
+
+	return index;
+}
+
+void LineIndex::release(std::size_t node)
+{
+	std::size_t const first = free_.size();
+
+	if (node != 0)
+	{
+		free_.push_back(node);
+	}
+
+	// the released nodes double as the stack of the traversal
+	for (std::size_t i = first; i < free_.size(); i++)
+	{
+		Node const &current = nodes_[free_[i]];
+
+		if (current.left != 0)
+		{
+			free_.push_back(current.left);
+		}
+
+		if (current.right != 0)
+		{
+			free_.push_back(current.right);
+		}
+	}
+}
+
+void LineIndex::update(std::size_t node)
+{
+	Node &current = nodes_[node];
+
+	current.bytes = nodes_[current.left].bytes + current.length + nodes_[current.right].bytes;
+	current.lines = nodes_[current.left].lines + 1 + nodes_[current.right].lines;
+}
+
+std::size_t LineIndex::build(std::vector<std::int64_t> const &lengths)
+{
+	// the rightmost path of the tree built so far, its priorities descend
+	std::vector<std::size_t> path;
+
+	for (std::int64_t const length: lengths)
+	{
+		std::size_t const node = create(length);
+		std::size_t left = 0;
+
+		while (!path.empty() && nodes_[path.back()].priority < nodes_[node].priority)
+		{
+			left = path.back();
+			path.pop_back();
+			update(left);
+		}
+
+		nodes_[node].left = left;
+
+		if (!path.empty())
+		{
+			nodes_[path.back()].right = node;
+		}
+
+		path.push_back(node);
+	}
+
+	while (path.size() > 1)
+	{
+		update(path.back());
+		path.pop_back();
+	}
+
+	if (path.empty())
+	{
+		return 0;
+	}
+
+	update(path.front());
+
+	return path.front();
+}
+
+std::size_t LineIndex::merge(std::size_t left, std::size_t right)
+{
+	// the depth of the tree is logarithmic, so is the recursion
+	if (left == 0 || right == 0)
+	{
+		return left + right;
+	}
+
+	if (nodes_[left].priority >= nodes_[right].priority)
+	{
+		nodes_[left].right = merge(nodes_[left].right, right);
+		update(left);
+
+		return left;
+	}
+
+	nodes_[right].left = merge(left, nodes_[right].left);
+	update(right);
+
+	return right;
+}
+
+void LineIndex::split(std::size_t node, std::size_t lines, std::size_t &left,
+                      std::size_t &right)
+{
+	if (node == 0)
+	{
+		left = right = 0;
+		return;
+	}
+
+	std::size_t const preceding = nodes_[nodes_[node].left].lines;
+
+	if (lines <= preceding)
+	{
+		split(nodes_[node].left, lines, left, nodes_[node].left);
+		update(node);
+		right = node;
+	}
+	else
+	{
+		split(nodes_[node].right, lines - preceding - 1, nodes_[node].right, right);
+		update(node);
+		left = node;
+	}
+}
@@ -0,0 +1,249 @@
+#ifndef LINEINDEX_H_INCLUDED
+#define LINEINDEX_H_INCLUDED
+
+#include "EditOperation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file server/LineIndex.h
+ *
+ * Interface for the index of line starts within a document.
+ */
+
+/**
+ * The lengths of all lines of a document, to convert between byte positions
+ * and line numbers without scanning the contents.
+ *
+ * A line includes its trailing newline, the last line has none and may be
+ * empty, hence a document with n newlines has n + 1 lines. Lines and columns
+ * are counted in bytes starting at 0.
+ *
+ * The lines are kept in a treap, a binary tree ordered by line number and
+ * balanced by random priorities. Every node knows the amount of lines and
+ * bytes of its subtree, so the start of a line and the line of a position
+ * are found in O(log n) and edits within a line update the tree in O(log n)
+ * as well. Edits inserting or removing k newlines split the tree around the
+ * changed lines and merge it again with the new ones in O(k + log n), the
+ * numbering of the following lines follows from the subtrees' line counts.
+ *
+ * @startuml{LineIndex_Class.svg}
+ * class LineIndex {
+ * .. Construction ..
+ * + LineIndex(contents: vector<char> const &)
+ * __
+ * + get_line_count(): int64_t
+ * + get_line_start(line: int64_t): int64_t
+ * + get_line_length(line: int64_t): int64_t
+ * + get_line(position: int64_t): int64_t
+ * + insert(position: int64_t, bytes: vector<char> const &)
+ * + erase(position: int64_t, length: int64_t)
+ * + apply(operation: EditOperation const &)
+ * + get_memory_usage(): size_t
+ * .. helpers ..
+ * - find(line: size_t): size_t
+ * - add(line: size_t, delta: int64_t)
+ * - splice(first: size_t, last: size_t, lengths: vector<int64_t> const &)
+ * - create(length: int64_t): size_t
+ * - release(node: size_t)
+ * - update(node: size_t)
+ * - build(lengths: vector<int64_t> const &): size_t
+ * - merge(left: size_t, right: size_t): size_t
+ * - split(node: size_t, lines: size_t, left: size_t &, right: size_t &)
+ * __ attributes __
+ * - nodes_: vector<Node>
+ * - free_: vector<size_t>
+ * - root_: size_t
+ * - seed_: uint32_t
+ * }
+ * @enduml
+ */
+class LineIndex
+{
+public:
+	/**
+	 * Index the lines of some contents.
+	 *
+	 * @param contents The contents of the document.
+	 */
+	explicit LineIndex(std::vector<char> const &contents);
+
+	/**
+	 * Obtain the amount of lines.
+	 *
+	 * @return The amount of newlines plus one.
+	 */
+	std::int64_t get_line_count() const
+	{
+		return nodes_[root_].lines;
+	}
+
+	/**
+	 * Obtain the position a line starts at.
+	 *
+	 * @param line The line, less than get_line_count().
+	 * @return The position of the first byte of the line.
+	 */
+	std::int64_t get_line_start(std::int64_t line) const;
+
+	/**
+	 * Obtain the length of a line.
+	 *
+	 * @param line The line, less than get_line_count().
+	 * @return The amount of bytes of the line, including its newline.
+	 */
+	std::int64_t get_line_length(std::int64_t line) const
+	{
+		return nodes_[find(line)].length;
+	}
+
+	/**
+	 * Find the line containing a position.
+	 *
+	 * @param position The position, not beyond the end of the contents.
+	 * @return The line containing the byte at the position, the last line
+	 *         for the end of the contents.
+	 */
+	std::int64_t get_line(std::int64_t position) const;
+
+	/**
+	 * Update the index for bytes inserted into the contents.
+	 *
+	 * @param position The position the bytes were inserted at.
+	 * @param bytes The inserted bytes.
+	 */
+	void insert(std::int64_t position, std::vector<char> const &bytes);
+
+	/**
+	 * Update the index for bytes erased from the contents.
+	 *
+	 * @param position The position of the first erased byte.
+	 * @param length The amount of erased bytes.
+	 */
+	void erase(std::int64_t position, std::int64_t length);
+
+	/**
+	 * Update the index for an edit of the contents.
+	 * Operations of a sequence have to be passed in their order.
+	 *
+	 * @param operation The applied operation.
+	 */
+	void apply(EditOperation const &operation);
+
+	/**
+	 * Obtain the amount of memory allocated for the index.
+	 *
+	 * @return The allocated bytes.
+	 */
+	std::size_t get_memory_usage() const
+	{
+		return nodes_.capacity() * sizeof(Node) + free_.capacity() * sizeof(std::size_t);
+	}
+
+private:
+	/**
+	 * A line within the tree.
+	 */
+	struct Node
+	{
+		//! the length of the line, including its newline
+		std::int64_t length;
+		//! the length of all lines of the subtree
+		std::int64_t bytes;
+		//! the amount of lines of the subtree
+		std::size_t lines;
+		//! the preceding lines, 0 if there are none
+		std::size_t left;
+		//! the following lines, 0 if there are none
+		std::size_t right;
+		//! not less than the priorities of the children
+		std::uint32_t priority;
+	};
+
+	/**
+	 * Find the node of a line.
+	 *
+	 * @param line The line, less than get_line_count().
+	 * @return The index of its node.
+	 */
+	std::size_t find(std::size_t line) const;
+
+	/**
+	 * Change the length of a line in the tree.
+	 *
+	 * @param line The line.
+	 * @param delta The amount to add to its length, may be negative.
+	 */
+	void add(std::size_t line, std::int64_t delta);
+
+	/**
+	 * Replace a range of lines.
+	 *
+	 * @param first The first line to replace.
+	 * @param last The last line to replace.
+	 * @param lengths The lengths of the lines replacing them.
+	 */
+	void splice(std::size_t first, std::size_t last, std::vector<std::int64_t> const &lengths);
+
+	/**
+	 * Create a node without children, reusing a released one if possible.
+	 *
+	 * @param length The length of its line.
+	 * @return The index of the node.
+	 */
+	std::size_t create(std::int64_t length);
+
+	/**
+	 * Release the nodes of a subtree for reuse.
+	 *
+	 * @param node The root of the subtree.
+	 */
+	void release(std::size_t node);
+
+	/**
+	 * Recompute the sums of a node from its children.
+	 *
+	 * @param node The node.
+	 */
+	void update(std::size_t node);
+
+	/**
+	 * Build a tree of lines.
+	 *
+	 * @param lengths The lengths of the lines in their order.
+	 * @return The root of the tree.
+	 */
+	std::size_t build(std::vector<std::int64_t> const &lengths);
+
+	/**
+	 * Join two trees.
+	 *
+	 * @param left The root of the tree of the preceding lines.
+	 * @param right The root of the tree of the following lines.
+	 * @return The root of the joined tree.
+	 */
+	std::size_t merge(std::size_t left, std::size_t right);
+
+	/**
+	 * Split a tree after some of its lines.
+	 *
+	 * @param node The root of the tree.
+	 * @param lines The amount of lines of the left tree.
+	 * @param left Set to the root of the tree of the first lines.
+	 * @param right Set to the root of the tree of the remaining lines.
+	 */
+	void split(std::size_t node, std::size_t lines, std::size_t &left, std::size_t &right);
+
+	//! the nodes, the first one stands for the empty tree and has no lines
+	std::vector<Node> nodes_;
+	//! the nodes released for reuse
+	std::vector<std::size_t> free_;
+	//! the root of the tree
+	std::size_t root_;
+	//! the state of the generator of priorities
+	std::uint32_t seed_;
+};
+
+#endif
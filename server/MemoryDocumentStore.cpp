@@ -0,0 +1,140 @@
+#include "MemoryDocumentStore.h"
+#include "Document.h"
+
+#include <algorithm>
+
+/**
+ * @file server/MemoryDocumentStore.cpp
+ * @author Daniel Mierswa <daniel.mierswa@student.hs-rm.de>
+ *
+ * Implementation file for the in-memory implementation for the DocumentStore interface.
+ */
+
+using namespace document_errors;
+
+namespace
+{
+	/**
+	 * A document opened in memory.
+	 * It shares the contents with the store, so they outlive remove().
+	 */
+	class MemoryHandle
+		: public DocumentStore::Handle
+	{
+	public:
+		/**
+		 * Refer to the contents of a document.
+		 *
+		 * @param contents The contents as kept by the store.
+		 */
+		explicit MemoryHandle(std::shared_ptr<MemoryDocumentStore::Contents> const &contents)
+			: contents_(contents)
+		{
+		}
+
+		void read(std::vector<char> &contents)
+		{
+			contents = contents_->bytes;
+		}
+
+		void write(std::vector<char> const &contents)
+		{
+			contents_->bytes = contents;
+			// writes within the resolution of the clock are told apart as well
+			contents_->modified = std::max(DocumentStore::now(), contents_->modified + 1);
+		}
+
+	private:
+		//! the contents of the document
+		std::shared_ptr<MemoryDocumentStore::Contents> const contents_;
+	};
+
+	/**
+	 * Create the error message for a document that doesn't exist.
+	 *
+	 * @param name The name of the document.
+	 * @return The error message.
+	 */
+	std::string missing_document(std::string const &name)
+	{
+		return "while opening document <" + name + ">: document does not exist";
+	}
+}
+
+std::unique_ptr<DocumentStore::Handle> MemoryDocumentStore::create(std::string const &name,
+                                                                   bool overwrite)
+{
+	std::shared_ptr<Contents> &contents = documents_[name];
+
+	if (contents && !overwrite)
+	{
+		throw DocumentAlreadyExistsError("while creating document <" + name + ">: "
+		                                 "document already exists");
+	}
+
+	// handles of the previous document keep its contents, like an unlinked file
+	contents = std::make_shared<Contents>();
+	contents->modified = now();
+
+	return std::unique_ptr<Handle>(new MemoryHandle(contents));
+}
+
+std::unique_ptr<DocumentStore::Handle> MemoryDocumentStore::open(std::string const &name)
+{
+	auto const document = documents_.find(name);
+
+	if (document == documents_.end())
+	{
+		throw DocumentDoesntExistError(missing_document(name));
+	}
+
+	return std::unique_ptr<Handle>(new MemoryHandle(document->second));
+}
+
+void MemoryDocumentStore::remove(std::string const &name)
+{
+	if (!documents_.erase(name))
+	{
+		throw DocumentDoesntExistError(missing_document(name));
+	}
+}
+
+std::uint64_t MemoryDocumentStore::size(std::string const &name)
+{
+	auto const document = documents_.find(name);
+
+	if (document == documents_.end())
+	{
+		throw DocumentDoesntExistError(missing_document(name));
+	}
+
+	return document->second->bytes.size();
+}
+
+DocumentStore::Status MemoryDocumentStore::status(std::string const &name)
+{
+	auto const document = documents_.find(name);
+
+	if (document == documents_.end())
+	{
+		throw DocumentDoesntExistError(missing_document(name));
+	}
+
+	Status result;
+	result.size = document->second->bytes.size();
+	result.modified = document->second->modified;
+
+	return result;
+}
+
+std::vector<std::string> MemoryDocumentStore::list()
+{
+	std::vector<std::string> list;
+
+	for (auto const &document: documents_)
+	{
+		list.push_back(document.first);
+	}
+
+	return list;
+}
@@ -0,0 +1,81 @@
+#ifndef MEMORYDOCUMENTSTORE_H_INCLUDED
+#define MEMORYDOCUMENTSTORE_H_INCLUDED
+
+#include "DocumentStore.h"
+
+#include <map>
+
+/**
+ * @file server/MemoryDocumentStore.h
+ * @author Daniel Mierswa <daniel.mierswa@student.hs-rm.de>
+ *
+ * In-memory implementation for the DocumentStore interface.
+ */
+
+/**
+ * The in-memory implementation of the document store interface.
+ * The documents are lost once the store is destroyed, which makes
+ * it suitable for tests and benchmarks that shouldn't depend on
+ * the filesystem.
+ *
+ * @startuml{MemoryDocumentStore_Class.svg}
+ * abstract class DocumentStore
+ * DocumentStore <|-- MemoryDocumentStore
+ * class MemoryDocumentStore {
+ * .. Construction ..
+ * + MemoryDocumentStore()
+ * __
+ * + create(name: string const &, overwrite: bool): unique_ptr<Handle>
+ * + open(name: string const &): unique_ptr<Handle>
+ * + remove(name: string const &)
+ * + size(name: string const &): uint64_t
+ * + status(name: string const &): Status
+ * + list(): vector<string>
+ * __ attributes __
+ * - documents_: map<string, shared_ptr<Contents>>
+ * }
+ * class MemoryDocumentStore::Contents {
+ * + bytes: vector<char>
+ * + modified: int64_t
+ * }
+ * MemoryDocumentStore +-- MemoryDocumentStore::Contents
+ * @enduml
+ */
+class MemoryDocumentStore
+	: public DocumentStore
+{
+public:
+	/**
+	 * Construct an empty in-memory document store.
+	 */
+	MemoryDocumentStore() = default;
+
+	std::unique_ptr<Handle> create(std::string const &name, bool overwrite);
+
+	std::unique_ptr<Handle> open(std::string const &name);
+
+	void remove(std::string const &name);
+
+	std::uint64_t size(std::string const &name);
+
+	Status status(std::string const &name);
+
+	std::vector<std::string> list();
+
+	/**
+	 * The contents of a document and the time they were last written.
+	 */
+	struct Contents
+	{
+		//! the bytes of the document
+		std::vector<char> bytes;
+		//! the modification time in nanoseconds since the epoch
+		std::int64_t modified;
+	};
+
+private:
+	//! the contents by document name, shared with the handles of the documents
+	std::map<std::string, std::shared_ptr<Contents>> documents_;
+};
+
+#endif
@@ -7,9 +7,29 @@
 #include "Client.h"
 #include "exceptions.h"
 #include "Message.h"
+#include "MessageCodec.h"
+
+const size_t
+	Message::FIELD_SIZE_BYTE,
+	Message::FIELD_SIZE_ID,
+	Message::FIELD_SIZE_DOC_NAME,
+	Message::FIELD_SIZE_HASH,
+	Message::FIELD_SIZE_SIZE,
+	Message::FIELD_SIZE_STATUS,
+	Message::FIELD_SIZE_TYPE,
+	Message::FIELD_SIZE_USER_NAME;
+
+const uint8_t
+	Message::PROTOCOL_VERSION_1,
+	Message::PROTOCOL_VERSION_2,
+	Message::PROTOCOL_VERSION_3,
+	Message::PROTOCOL_VERSION_LATEST,
+	Message::COMPRESSION_NONE,
+	Message::COMPRESSION_ZLIB,
+	Message::COMPRESSION_LATEST;
 
 Message::Message(void):
-	length(0), id(0), position(0), source(NULL), status(MessageStatus::STATUS_NOT_OK), type(MessageType::TYPE_INVALID)
+	column(0), inserted(0), length(0), line(0), id(0), position(0), revision(0), site(0), source(NULL), status(MessageStatus::STATUS_NOT_OK), type(MessageType::TYPE_INVALID)
 {}
 
 void Message::receive_from(ClientSptr client)
@@ -19,7 +39,7 @@ void Message::receive_from(ClientSptr client)
 	// save source
 	source = client;
 
-	// get message type
+	// get message type (v1) or first frame length byte (v2)
 	// added by Daniel: graceful client disconnects
 	try
 	{
@@ -32,164 +52,121 @@ void Message::receive_from(ClientSptr client)
 		throw;
 	}
 
+	using namespace MessageSchema;
+
+	if (client->protocol_version == PROTOCOL_VERSION_1)
+	{
+		type = static_cast<MessageType>(buffer);
+
+		switch (type)
+		{
+#define LAYOUT(TYPE, ...) \
+			case MessageType::TYPE_##TYPE: \
+				MessageSchema::receive_v1<Fields<__VA_ARGS__>>(*client, *this); \
+				return;
+			MESSAGE_LAYOUTS_TO_SERVER(LAYOUT)
+#undef LAYOUT
+			default:
+				throw Exception::InvalidMessageType("invalid message type", type, client->socket);
+		}
+	}
+
+	// receive frame length
+	uint32_t frame_length = buffer & 0x7f;
+	for (unsigned shift = 7; buffer & 0x80; shift += 7)
+	{
+		if (shift >= 35)
+		{ throw Exception::MalformedMessage("frame length too long", client->socket); }
+
+		client->receive(&buffer, 1);
+		if (shift == 28 && (buffer & 0x70) != 0)
+		{ throw Exception::MalformedMessage("frame length exceeds 32 bits", client->socket); }
+
+		frame_length |= static_cast<uint32_t>(buffer & 0x7f) << shift;
+	}
+
+	if (frame_length < FIELD_SIZE_TYPE)
+	{ throw Exception::MalformedMessage("empty frame", client->socket); }
+
+	// checked before allocating, the length is sent by a possibly not yet logged in client
+	if (frame_length > MAX_FRAME_SIZE)
+	{ throw Exception::MalformedMessage("frame too long", client->socket); }
+
+	// receive and parse the whole frame at once
+	std::vector<char> frame(frame_length);
+	client->receive(&frame[0], frame_length);
+
+	FrameReader reader(frame.data(), frame.data() + frame.size(), client->socket);
+	reader.read(&buffer, FIELD_SIZE_TYPE);
 	type = static_cast<MessageType>(buffer);
-	
-	// get first data
+
 	switch (type)
 	{
-		case MessageType::TYPE_DOC_ACTIVATE:
-		case MessageType::TYPE_DOC_SAVE:
-			client->receive(&id, FIELD_SIZE_ID);
-			id = ntohl(id);
-			break;
-		case MessageType::TYPE_DOC_CREATE:
-		case MessageType::TYPE_DOC_DELETE:
-		case MessageType::TYPE_DOC_OPEN:
-			name.resize(FIELD_SIZE_DOC_NAME);
-			client->receive(&name[0], FIELD_SIZE_DOC_NAME);
-			break;
-		case MessageType::TYPE_SYNC_BYTE:
-			bytes.resize(FIELD_SIZE_BYTE);
-			client->receive(&bytes, FIELD_SIZE_BYTE);
-			break;
-		case MessageType::TYPE_SYNC_CURSOR:
-		case MessageType::TYPE_SYNC_DELETION:
-			client->receive(&position, FIELD_SIZE_SIZE);
-			position = ntohl(position);
-			break;
-		case MessageType::TYPE_SYNC_MULTIBYTE:
-			client->receive(&length, FIELD_SIZE_SIZE);
-			length = ntohl(length);
-			break;
-		case MessageType::TYPE_USER_LOGIN:
-			name.resize(FIELD_SIZE_USER_NAME);
-			client->receive(&name[0], FIELD_SIZE_USER_NAME);
-			break;
-		case MessageType::TYPE_DOC_LIST:
-		case MessageType::TYPE_USER_LOGOUT:
-			break;
+#define LAYOUT(TYPE, ...) \
+		case MessageType::TYPE_##TYPE: \
+			decode_v2<Fields<__VA_ARGS__>>(reader, *this, client->protocol_version); \
+			return;
+		MESSAGE_LAYOUTS_TO_SERVER(LAYOUT)
+#undef LAYOUT
 		default:
 			throw Exception::InvalidMessageType("invalid message type", type, client->socket);
 	}
-	
-	// get second data
-	switch (type)
-	{
-		case MessageType::TYPE_DOC_ACTIVATE:
-		case MessageType::TYPE_USER_LOGIN:
-			client->receive(&hash[0], FIELD_SIZE_HASH);
-			break;
-		case MessageType::TYPE_SYNC_DELETION:
-			client->receive(&length, FIELD_SIZE_SIZE);
-			length = ntohl(length);
-			break;
-		case MessageType::TYPE_SYNC_MULTIBYTE:
-			bytes.resize(length);
-			client->receive(&bytes, length);
-			break;
-		default: break;
-	}
 }
 
-std::vector<char> &Message::generate_bytestream(std::vector<char> &dest) const
+std::vector<char> &Message::generate_bytestream(std::vector<char> &dest, uint8_t version) const
 {
-	// append message type
-	append_bytes(dest, static_cast<char>(type));
+	using namespace MessageSchema;
 
-	// append first data
 	switch (type)
 	{
-		case MessageType::TYPE_DOC_ACTIVATE:
-		case MessageType::TYPE_DOC_CREATE:
-		case MessageType::TYPE_DOC_DELETE:
-		case MessageType::TYPE_DOC_OPEN:
-		case MessageType::TYPE_DOC_SAVE:
-		case MessageType::TYPE_USER_LOGIN:
-		case MessageType::TYPE_STATUS:
-			append_bytes(dest, static_cast<char>(status));
-			break;
-		case MessageType::TYPE_DOC_LIST:
-			append_bytes(dest, htonl(length));
-			break;
-		case MessageType::TYPE_SYNC_BYTE:
-		case MessageType::TYPE_SYNC_DELETION:
-		case MessageType::TYPE_SYNC_MULTIBYTE:
-			append_bytes(dest, htonl(position));
-			break;
-		case MessageType::TYPE_USER_JOIN:
-		case MessageType::TYPE_USER_QUIT:
-			append_bytes(dest, htonl(id));
+#define LAYOUT(TYPE, ...) \
+		case MessageType::TYPE_##TYPE: \
+			encode<Fields<__VA_ARGS__>>(dest, *this, version); \
 			break;
+		MESSAGE_LAYOUTS_TO_CLIENT(LAYOUT)
+#undef LAYOUT
 		default:
 			throw Exception::InvalidMessageType("invalid message type", type, 0);
 	}
 
-	// append second data
-	switch (type)
-	{
-		case MessageType::TYPE_DOC_ACTIVATE:
-		case MessageType::TYPE_DOC_OPEN:
-		case MessageType::TYPE_DOC_SAVE:
-			append_bytes(dest, htonl(id));
-			break;
-		case MessageType::TYPE_DOC_CREATE:
-		case MessageType::TYPE_DOC_DELETE:
-			append_bytes(dest, &name, FIELD_SIZE_DOC_NAME);
-			break;
-		case MessageType::TYPE_DOC_LIST:
-		{
-			std::vector<char> buffer = bytes;
-			size_t target_size = FIELD_SIZE_DOC_NAME * length;
-			if (buffer.size() < target_size)
-			{ buffer.resize(target_size, '\0'); }
+	return dest;
+}
 
-			append_bytes(dest, &buffer, target_size);
-			break;
-		}
-		case MessageType::TYPE_SYNC_BYTE:
-			append_bytes(dest, &bytes, FIELD_SIZE_BYTE);
-			break;
-		case MessageType::TYPE_SYNC_DELETION:
-		case MessageType::TYPE_SYNC_MULTIBYTE:
-			append_bytes(dest, htonl(length));
-			break;
-		case MessageType::TYPE_USER_JOIN:
-			append_bytes(dest, &name, FIELD_SIZE_USER_NAME);
-			break;
-		default: break;
-	}
+Transfer::Priority Message::get_priority(void) const
+{
+	return type == MessageType::TYPE_DOC_LIST || type == MessageType::TYPE_DOC_LIST_PAGE ||
+		type == MessageType::TYPE_DOC_SEARCH ? Transfer::Priority::PRIORITY_BULK :
+		Transfer::Priority::PRIORITY_INTERACTIVE;
+}
 
-	// append third data
+bool Message::refers_to_contents(void) const
+{
 	switch (type)
 	{
-		case MessageType::TYPE_DOC_OPEN:
-			append_bytes(dest, &name, FIELD_SIZE_DOC_NAME);
-			break;
+		case MessageType::TYPE_DOC_VIEWPORT:
+		case MessageType::TYPE_SYNC_BATCH:
+		case MessageType::TYPE_SYNC_BYTE:
+		case MessageType::TYPE_SYNC_DELETION:
+		case MessageType::TYPE_SYNC_MERGE:
 		case MessageType::TYPE_SYNC_MULTIBYTE:
-			append_bytes(dest, &bytes, length);
-			break;
-		default: break;
+		case MessageType::TYPE_SYNC_RESIZE:
+		case MessageType::TYPE_SYNC_SEQUENCE:
+			return true;
+		default:
+			return false;
 	}
-
-	return dest;
 }
 
 void Message::send_to(const Client &client) const
 {
 	// generate bytestream to send
 	std::vector<char> bytestream;
-	generate_bytestream(bytestream);
+	generate_bytestream(bytestream, client.protocol_version);
 
 	// send
-	client.send(bytestream);
+	client.send(bytestream, get_priority(), refers_to_contents() ? client.active_document : 0);
 }
 
-void Message::send_to(const ClientCollection &clients, int32_t document_id) const
-{
-	// generate bytestream to send
-	std::vector<char> bytestream;
-	generate_bytestream(bytestream);
-
-	// send
-	clients.broadcast(bytestream, document_id);
-}
+void Message::send_to(const ClientCollection &clients, int32_t document_id,
+	ClientFilter filter) const
+{ clients.broadcast(*this, document_id, filter); }
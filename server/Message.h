@@ -1,196 +1,289 @@
-/**	@file Message.h
-	
-	@author Maximilian Lasser <max.lasser@online.de>
-	@date Tuesday, 22nd May 2012
-**/
-
-#ifndef _MESSAGE_H_
-#define _MESSAGE_H_
-
-#include <array>
-#include <cstdint>
-#include <string>
-#include <vector>
-
-#include "ClientCollection.h"
-
-class Client;
-
-/**
-	@brief Encapsulates a network message.
-
-	The Message class is an abstraction of a simple network message that may be sent from client
-	to server or vice versa.
-**/
-class Message
-{
-	public:
-		/**
-			The MessageStatus is mainly used for messages from server to client that report the
-			status of a requested action, such as success or failure, the latter often described
-			more detailed.
-		**/
-		enum class MessageStatus
-		{
-			STATUS_OK, ///< success
-			STATUS_OK_CONTENTS_FOLLOWING, ///< multibyte message with doc contents following
-			STATUS_DOC_ALREADY_EXIST, ///< doc does already exist
-			STATUS_DOC_NOT_EXIST, ///< doc does not exist
-			STATUS_DOC_SAVED, ///< doc was saved by another user
-			STATUS_DB_ERROR, ///< a DB error occurred
-			STATUS_IO_ERROR, ///< an IO error occurred
-			STATUS_USER_NOT_EXIST, ///< username does not exist
-			STATUS_USER_WRONG_PASSWORD, ///< password is wrong
-			STATUS_USER_NO_ACTIVE_DOC, ///< user has no active doc
-			STATUS_USER_CURSOR_UNKNOWN, ///< user cursor position is unknown
-			STATUS_USER_CURSOR_OUT_OF_BOUNDS, ///< user cursor position is out of bounds
-			STATUS_USER_LENGTH_TOO_LONG, ///< specified length is too long
-			STATUS_NOT_OK ///< anything but success
-		};
-		/**
-			The MessageType specifies what kind of action is required or to what kind of action the
-			Message is the answer.
-		**/
-		enum class MessageType
-		{
-			TYPE_INVALID, ///< invalid message type
-			TYPE_DOC_ACTIVATE, ///< user activates/switches to doc (id, hash)
-			TYPE_DOC_CREATE, ///< user creates doc (name)
-			TYPE_DOC_DELETE, ///< user deletes doc (name)
-			TYPE_DOC_LIST, ///< document list
-			TYPE_DOC_OPEN, ///< user opens doc (name)
-			TYPE_DOC_SAVE, ///< user saves doc (id)
-			TYPE_STATUS, ///< server -> client only (general status announcement)
-			TYPE_SYNC_BYTE, ///< user sends byte to insert at current pos (byte)
-			TYPE_SYNC_CURSOR, ///< user sends new cursor position (position)
-			TYPE_SYNC_DELETION, ///< user sends deletion (position, length)
-			TYPE_SYNC_MULTIBYTE, ///< user sends byte sequence to insert (position, length, payload)
-			TYPE_USER_LOGIN, ///< user sends login credentials (name, hash)
-			TYPE_USER_LOGOUT, ///< user logs out
-			TYPE_USER_JOIN, ///< server -> client only (a new user connected)
-			TYPE_USER_QUIT, ///< server -> client only (a user disconnected)
-
-			TYPE_CLIENT_DISCONNECT, ///< pseudo-type for client disconnection
-			TYPE_INIT, ///< pseudo-type for handler initialization
-			TYPE_EXIT ///< pseudo-type on server exit/quit
-		};
-		
-		static const size_t
-			FIELD_SIZE_BYTE = 1, ///< size of a byte
-			FIELD_SIZE_ID = 4, ///< size of a document or user id
-			FIELD_SIZE_DOC_NAME = 128, ///< size of a document name
-			FIELD_SIZE_HASH = 20, ///< size of a password or document hash (sha-1)
-			FIELD_SIZE_SIZE = 4, ///< size of a position or length
-			FIELD_SIZE_STATUS = 1, ///< size of a MessageStatus
-			FIELD_SIZE_TYPE = 1, ///< size of a MessageType
-			FIELD_SIZE_USER_NAME = 64; ///< size of a user name
-		
-		std::vector<char>					bytes; ///< Message payload
-		std::array<char, FIELD_SIZE_HASH>	hash; ///< password or document hash (sha-1)
-		int32_t								length; ///< mostly payload length, depends on context
-		int32_t								id; ///< document or user id
-		std::vector<char>					name; ///< document or user name
-		int32_t								position; ///< position within a document
-		ClientSptr							source; ///< sender of the message
-		MessageStatus						status; ///< status of the respective action/request
-		MessageType	 	 					type; ///< type of the message
-
-		/**
-			Default constructor.
-		**/
-		Message(void);
-		Message(const Message &) = delete; ///< No copy constructor.
-
-		Message operator=(const Message &) = delete; ///< No copying via assignment operator.
-		
-		/**
-			Converts the stored name field to a string and returns it.
-
-			@return the stored name as string
-		**/
-		inline std::string get_name_string(void) const;
-		/**
-			Checks whether this is an empty Message.
-
-			@return whether this Message is empty
-
-			@deprecated
-			@note Use at own risk. This method is not good.
-		**/
-		inline bool is_empty() const;
-		/**
-			Attempts to parse a bytestream sent by the given client to this Message object.
-			This is kind of a named constructor, but the object has to be constructed already.
-
-			@param client a shared pointer to the Client to receive the Message from
-
-			@exception Exception::InvalidMessageType if the message has an invalid type
-
-			@note This calls Client::receive(T*, size_t) without catching any exceptions.
-			@see Client::receive(T*, size_t)
-		**/
-		void receive_from(ClientSptr client);
-		/**
-			Sends a raw byte sequence representation of this Message to the specified Client.
-			
-			@param client a reference to the Client to send this Message to
-
-			@note Calls Client::send(const std::vector<char>&) without catching any exceptions.
-			@see Client::send(const std::vector<char>&)
-		**/
-		void send_to(const Client &client) const;
-		/**
-			Like send_to(ClientSptr), but sends to all Clients in the given ClientCollection.
-			
-			@param clients a reference to the ClientCollection to broadcast the this Message in
-			@param document_id an optional constraint causing the bytestream to be sent only to all
-				clients whose active document id is equal to the valueof this argument; the default
-				is 0, which means that the bytestream should be sent to all clients
-
-			@note Calls ClientCollection::broadcast(const std::vector<char>&, int32_t) without
-				catching any exceptions.
-			@see ClientCollection::broadcast(const std::vector<char>&, int32_t)
-		**/
-		void send_to(const ClientCollection &clients, int32_t document_id = 0) const;
-	
-	private:
-		/**
-			Auxiliary function that appends a byte sequence to the given vector.
-
-			@param dest a reference to the vector<char> to append the bytes to
-			@param src a pointer to the source of the bytestream to append
-			@param length the number of bytes to append; if discarded or 0 the length will be
-				determined using the sizeof operator on *src
-
-			@return a reference to the vector<char> the bytes have been appended to
-		**/
-		template<typename T>
-		static inline std::vector<char> &append_bytes(std::vector<char> &dest, const T *src,
-			size_t length = 0);
-		/**
-			Like append_bytes(std::vector<char>&, const T*, size_t), but takes a value as src, not a
-			pointer.
-
-			@see append_bytes(std::vector<char>&, const T*, size_t)
-		**/
-		template<typename T>
-		static inline std::vector<char> &append_bytes(std::vector<char> &dest, const T src,
-			size_t length = 0);
-		// static inline uint64_t htonll(uint64_t hostlonglong);
-		// static inline uint64_t ntohll(uint64_t netlonglong);
-
-		/**
-			Auxiliary function that generates a bytesteam from this Message that can be sent to one
-			or more Clients.
-
-			@param dest a reference to a vector<char> to store the bytestream in
-			@return a referenct to the vector<char> the bytestream has been stored in
-
-			@exception Exception::InvalidMessageType if the MessageType is invalid
-		**/
-		std::vector<char> &generate_bytestream(std::vector<char> &dest) const;
-};
-
-#include "Message.tcc"
-
-#endif
+/**	@file Message.h
+	
+	@author Maximilian Lasser <max.lasser@online.de>
+	@date Tuesday, 22nd May 2012
+**/
+
+#ifndef _MESSAGE_H_
+#define _MESSAGE_H_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ClientCollection.h"
+#include "DocumentEntry.h"
+#include "EditOperation.h"
+#include "SequenceOperation.h"
+#include "Transfer.h"
+
+class Client;
+
+/**
+	@brief Encapsulates a network message.
+
+	The Message class is an abstraction of a simple network message that may be sent from client
+	to server or vice versa.
+**/
+class Message
+{
+	public:
+		/**
+			The MessageStatus is mainly used for messages from server to client that report the
+			status of a requested action, such as success or failure, the latter often described
+			more detailed.
+		**/
+		enum class MessageStatus
+		{
+			STATUS_OK, ///< success
+			STATUS_OK_CONTENTS_FOLLOWING, ///< multibyte message with doc contents following
+			STATUS_DOC_ALREADY_EXIST, ///< doc does already exist
+			STATUS_DOC_NOT_EXIST, ///< doc does not exist
+			STATUS_DOC_SAVED, ///< doc was saved by another user
+			STATUS_DB_ERROR, ///< a DB error occurred
+			STATUS_IO_ERROR, ///< an IO error occurred
+			STATUS_USER_NOT_EXIST, ///< username does not exist
+			STATUS_USER_WRONG_PASSWORD, ///< password is wrong
+			STATUS_USER_NO_ACTIVE_DOC, ///< user has no active doc
+			STATUS_USER_CURSOR_UNKNOWN, ///< user cursor position is unknown
+			STATUS_USER_CURSOR_OUT_OF_BOUNDS, ///< user cursor position is out of bounds
+			STATUS_USER_LENGTH_TOO_LONG, ///< specified length is too long
+			STATUS_REVISION_UNKNOWN, ///< base revision too old or too new, reload the doc
+			STATUS_SESSION_UNKNOWN, ///< session expired or unknown, log in again
+			STATUS_INVALID_UTF8, ///< payload is not valid UTF-8
+			STATUS_QUERY_TOO_SHORT, ///< search query is shorter than 3 bytes
+			STATUS_INVALID_PATTERN, ///< replace pattern is empty or an invalid regular expression
+			STATUS_NOT_OK ///< anything but success
+		};
+		/**
+			The MessageType specifies what kind of action is required or to what kind of action the
+			Message is the answer.
+		**/
+		enum class MessageType
+		{
+			TYPE_INVALID, ///< invalid message type
+			TYPE_DOC_ACTIVATE, ///< user activates/switches to doc (id, hash)
+			TYPE_DOC_CREATE, ///< user creates doc (name)
+			TYPE_DOC_DELETE, ///< user deletes doc (name)
+			TYPE_DOC_LIST, ///< document list
+			TYPE_DOC_OPEN, ///< user opens doc (name)
+			TYPE_DOC_SAVE, ///< user saves doc (id)
+			TYPE_STATUS, ///< server -> client only (general status announcement)
+			TYPE_SYNC_BYTE, ///< user sends byte to insert at current pos (byte)
+			TYPE_SYNC_CURSOR, ///< user sends new cursor position (position)
+			TYPE_SYNC_DELETION, ///< user sends deletion (position, length)
+			TYPE_SYNC_MULTIBYTE, ///< user sends byte sequence to insert (position, length, payload)
+			TYPE_USER_LOGIN, ///< user sends login credentials (name, hash)
+			TYPE_USER_LOGOUT, ///< user logs out
+			TYPE_USER_JOIN, ///< server -> client only (a new user connected)
+			TYPE_USER_QUIT, ///< server -> client only (a user disconnected)
+			TYPE_PROTOCOL_VERSION, ///< user requests a protocol version (version)
+			TYPE_SYNC_BATCH, ///< user sends edit operations applied atomically (revision, operations)
+			TYPE_SYNC_SEQUENCE, ///< user switches its active doc to sequence mode
+			TYPE_SYNC_MERGE, ///< user merges sequence operations (id, site, revision, sequence)
+			TYPE_SESSION_TOKEN, ///< server -> client only (token to resume the session with)
+			TYPE_SESSION_RESUME, ///< user resumes a dropped session (hash, revision)
+			TYPE_COMPRESSION, ///< user requests compressed bulk frames (compression)
+			TYPE_SYNC_COMPRESSED, ///< server -> client only (like TYPE_SYNC_MULTIBYTE, deflated)
+			TYPE_DOC_LIST_PAGE, ///< user lists a page of docs (offset, limit, name prefix)
+			TYPE_DOC_LINE, ///< user looks up where a line of its active doc starts (line)
+			TYPE_SYNC_CURSOR_LINE, ///< like TYPE_SYNC_CURSOR (line, column)
+			TYPE_SYNC_DELETION_LINE, ///< like TYPE_SYNC_DELETION (line, column, length)
+			TYPE_SYNC_MULTIBYTE_LINE, ///< like TYPE_SYNC_MULTIBYTE (line, column, length, payload)
+			TYPE_DOC_VIEWPORT, ///< user fetches and subscribes to a range of its active doc
+								///< (position, length)
+			TYPE_DOC_VIEWPORT_LINE, ///< like TYPE_DOC_VIEWPORT (line, amount of lines)
+			TYPE_SYNC_RESIZE, ///< server -> client only (revision, position, length, inserted)
+			TYPE_DOC_SEARCH, ///< user searches all docs for bytes (offset, limit, query as name)
+			TYPE_DOC_REPLACE, ///< user replaces bytes throughout its active doc
+								///< (pattern as name, length, replacement as payload)
+			TYPE_DOC_REPLACE_REGEX, ///< like TYPE_DOC_REPLACE, pattern and replacement as
+									///< regular expression (an ECMAScript subset) and format
+			TYPE_DOC_CLOSE, ///< user closes an opened doc (id)
+
+			TYPE_CLIENT_DISCONNECT, ///< pseudo-type for client disconnection
+			TYPE_INIT, ///< pseudo-type for handler initialization
+			TYPE_EXIT ///< pseudo-type on server exit/quit
+		};
+		
+		static const size_t
+			FIELD_SIZE_BYTE = 1, ///< size of a byte
+			FIELD_SIZE_ID = 4, ///< size of a document or user id
+			FIELD_SIZE_DOC_NAME = 128, ///< size of a document name
+			FIELD_SIZE_HASH = 20, ///< size of a password or document hash (sha-1)
+			FIELD_SIZE_SIZE = 4, ///< size of a position or length
+			FIELD_SIZE_STATUS = 1, ///< size of a MessageStatus
+			FIELD_SIZE_TYPE = 1, ///< size of a MessageType
+			FIELD_SIZE_USER_NAME = 64; ///< size of a user name
+
+		static const size_t
+			MAX_PAYLOAD_SIZE = 16 << 20, ///< largest payload accepted from a client
+			MAX_FRAME_SIZE = MAX_PAYLOAD_SIZE + 4096; ///< largest frame accepted from a client,
+													///< the payload and the fields around it
+
+		static const uint8_t
+			PROTOCOL_VERSION_1 = 1, ///< fixed size fields, no frame header
+			PROTOCOL_VERSION_2 = 2, ///< length-prefixed frames, varints and length-prefixed strings
+			PROTOCOL_VERSION_3 = 3, ///< like version 2, but 64 bit varints for all integers
+			PROTOCOL_VERSION_LATEST = PROTOCOL_VERSION_3; ///< highest supported protocol version
+
+		static const uint8_t
+			COMPRESSION_NONE = 0, ///< bulk frames are sent as is
+			COMPRESSION_ZLIB = 1, ///< bulk frames are deflated with zlib if that makes them smaller
+			COMPRESSION_LATEST = COMPRESSION_ZLIB; ///< highest supported compression
+		
+		std::vector<char>					bytes; ///< Message payload
+		int64_t								column; ///< byte offset within the line of the *_LINE
+																///< types
+		DocumentEntries						entries; ///< documents of TYPE_DOC_LIST_PAGE and
+																///< TYPE_DOC_SEARCH
+		std::array<char, FIELD_SIZE_HASH>	hash; ///< password/document hash (sha-1) or token
+		int64_t								inserted; ///< amount of bytes replacing length
+																///< bytes (TYPE_SYNC_RESIZE)
+		int64_t								length; ///< mostly payload length, depends on context
+																///< (protocol version for
+																///< TYPE_PROTOCOL_VERSION,
+																///< compression for
+																///< TYPE_COMPRESSION, limit for
+																///< TYPE_DOC_LIST_PAGE and
+																///< TYPE_DOC_SEARCH, amount of
+																///< replacements for
+																///< TYPE_DOC_REPLACE responses)
+		int64_t								line; ///< line within a document, counted from 0
+		int32_t								id; ///< document or user id, amount of matching
+																///< documents for
+																///< TYPE_DOC_LIST_PAGE and
+																///< TYPE_DOC_SEARCH
+		EditOperations						operations; ///< edits of TYPE_SYNC_BATCH
+		std::vector<char>					name; ///< document or user name
+		int64_t								position; ///< position within a document, offset
+																///< for TYPE_DOC_LIST_PAGE and
+																///< TYPE_DOC_SEARCH
+		int32_t								revision; ///< document or sequence revision
+		SequenceOperations					sequence; ///< sequence operations (TYPE_SYNC_MERGE)
+		int32_t								site; ///< site within a document's sequence
+		ClientSptr							source; ///< sender of the message
+		MessageStatus						status; ///< status of the respective action/request
+		MessageType	 	 					type; ///< type of the message
+
+		/**
+			Default constructor.
+		**/
+		Message(void);
+		Message(const Message &) = delete; ///< No copy constructor.
+
+		Message operator=(const Message &) = delete; ///< No copying via assignment operator.
+		
+		/**
+			Converts the stored name field to a string and returns it.
+
+			@return the stored name as string
+		**/
+		inline std::string get_name_string(void) const;
+		/**
+			Returns the priority class this Message is sent in. Document lists are bulk data,
+			everything else is interactive.
+
+			@return the priority class
+		**/
+		Transfer::Priority get_priority(void) const;
+		/**
+			Checks whether this is an empty Message.
+
+			@return whether this Message is empty
+
+			@deprecated
+			@note Use at own risk. This method is not good.
+		**/
+		inline bool is_empty() const;
+		/**
+			Auxiliary function that generates a bytesteam from this Message that can be sent to one
+			or more Clients.
+
+			@param dest a reference to a vector<char> to store the bytestream in
+			@param version the protocol version to encode the bytestream for
+			@return a referenct to the vector<char> the bytestream has been stored in
+
+			@exception Exception::InvalidMessageType if the MessageType is invalid
+		**/
+		std::vector<char> &generate_bytestream(std::vector<char> &dest,
+			uint8_t version = PROTOCOL_VERSION_1) const;
+		/**
+			Attempts to parse a bytestream sent by the given client to this Message object.
+			This is kind of a named constructor, but the object has to be constructed already.
+			The client's protocol version determines how the bytestream is decoded.
+
+			@param client a shared pointer to the Client to receive the Message from
+
+			@exception Exception::InvalidMessageType if the message has an invalid type
+			@exception Exception::MalformedMessage if a protocol version 2 or 3 frame is malformed
+
+			@note This calls Client::receive(T*, size_t) without catching any exceptions.
+			@see Client::receive(T*, size_t)
+		**/
+		void receive_from(ClientSptr client);
+		/**
+			Checks whether this Message refers to positions within the active document of the
+			recipient, thus has to be sent after the contents of that document.
+
+			@return whether this is an edit or sequence Message
+		**/
+		bool refers_to_contents(void) const;
+		/**
+			Sends a raw byte sequence representation of this Message to the specified Client.
+			
+			@param client a reference to the Client to send this Message to
+
+			@note Calls Client::send(const std::vector<char>&) without catching any exceptions.
+			@see Client::send(const std::vector<char>&)
+		**/
+		void send_to(const Client &client) const;
+		/**
+			Like send_to(ClientSptr), but sends to all Clients in the given ClientCollection.
+			
+			@param clients a reference to the ClientCollection to broadcast the this Message in
+			@param document_id an optional constraint causing the bytestream to be sent only to all
+				clients whose active document id is equal to the valueof this argument; the default
+				is 0, which means that the bytestream should be sent to all clients
+			@param filter an optional constraint, see
+				ClientCollection::broadcast(const Message&, int32_t, ClientFilter)
+
+			@note Calls ClientCollection::broadcast(const Message&, int32_t, ClientFilter) without
+				catching any exceptions.
+			@see ClientCollection::broadcast(const Message&, int32_t, ClientFilter)
+		**/
+		void send_to(const ClientCollection &clients, int32_t document_id = 0,
+			ClientFilter filter = nullptr) const;
+	
+	private:
+		/**
+			Auxiliary function that appends a byte sequence to the given vector.
+
+			@param dest a reference to the vector<char> to append the bytes to
+			@param src a pointer to the source of the bytestream to append
+			@param length the number of bytes to append; if discarded or 0 the length will be
+				determined using the sizeof operator on *src
+
+			@return a reference to the vector<char> the bytes have been appended to
+		**/
+		template<typename T>
+		static inline std::vector<char> &append_bytes(std::vector<char> &dest, const T *src,
+			size_t length = 0);
+		/**
+			Like append_bytes(std::vector<char>&, const T*, size_t), but takes a value as src, not a
+			pointer.
+
+			@see append_bytes(std::vector<char>&, const T*, size_t)
+		**/
+		template<typename T>
+		static inline std::vector<char> &append_bytes(std::vector<char> &dest, const T src,
+			size_t length = 0);
+		// static inline uint64_t htonll(uint64_t hostlonglong);
+		// static inline uint64_t ntohll(uint64_t netlonglong);
+
+};
+
+#include "Message.tcc"
+
+#endif
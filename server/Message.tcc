@@ -1,6 +1,8 @@
 #ifndef _MESSAGE_TCC_
 #define _MESSAGE_TCC_
 
+#include <algorithm>
+
 #include <arpa/inet.h>
 
 template<typename T>
@@ -22,7 +24,7 @@ std::vector<char> &Message::append_bytes(std::vector<char> &dest, const T src, s
 { return append_bytes(dest, &src, length); }
 
 std::string Message::get_name_string(void) const
-{ return std::string(name.data()); }
+{ return std::string(name.data(), std::find(name.begin(), name.end(), '\0') - name.begin()); }
 
 /*
 uint64_t Message::htonll(uint64_t hostlonglong)
@@ -0,0 +1,73 @@
+/**
+ * @file MessageBatch.cpp
+ */
+
+#include "Client.h"
+#include "Message.h"
+#include "MessageBatch.h"
+
+MessageBatch::MessageBatch(void)
+{}
+
+MessageBatch::MessageBatch(const Message &message)
+{ add(message); }
+
+void MessageBatch::add(const Message &message)
+{
+	messages.push_back(&message);
+	groups[get_target(message)].push_back(&message);
+}
+
+int32_t MessageBatch::get_target(const Message &message)
+{
+	if (!message.source)
+	{ return NO_DOCUMENT; }
+
+	const Client *sender = message.source.get();
+	auto active = active_documents.find(sender);
+	int32_t active_document = active != active_documents.end() ? active->second :
+		sender->active_document;
+
+	switch (message.type)
+	{
+		// addressed by id, these make it the active document
+		case Message::MessageType::TYPE_DOC_ACTIVATE:
+		case Message::MessageType::TYPE_SYNC_MERGE:
+			active_documents[sender] = message.id;
+			return message.id;
+
+		// addressed by id
+		case Message::MessageType::TYPE_DOC_SAVE:
+			return message.id;
+		case Message::MessageType::TYPE_DOC_CLOSE:
+			if (active_document == message.id)
+			{ active_documents[sender] = NO_DOCUMENT; }
+			return message.id;
+
+		// acting on the active document
+		case Message::MessageType::TYPE_SYNC_BYTE:
+		case Message::MessageType::TYPE_SYNC_CURSOR:
+		case Message::MessageType::TYPE_SYNC_DELETION:
+		case Message::MessageType::TYPE_SYNC_MULTIBYTE:
+		case Message::MessageType::TYPE_SYNC_BATCH:
+		case Message::MessageType::TYPE_SYNC_SEQUENCE:
+		case Message::MessageType::TYPE_DOC_LINE:
+		case Message::MessageType::TYPE_SYNC_CURSOR_LINE:
+		case Message::MessageType::TYPE_SYNC_DELETION_LINE:
+		case Message::MessageType::TYPE_SYNC_MULTIBYTE_LINE:
+		case Message::MessageType::TYPE_DOC_VIEWPORT:
+		case Message::MessageType::TYPE_DOC_VIEWPORT_LINE:
+		case Message::MessageType::TYPE_DOC_REPLACE:
+		case Message::MessageType::TYPE_DOC_REPLACE_REGEX:
+			return active_document;
+
+		// the active document is only known once these are handled
+		case Message::MessageType::TYPE_DOC_OPEN:
+		case Message::MessageType::TYPE_SESSION_RESUME:
+			active_documents[sender] = NO_DOCUMENT;
+			return NO_DOCUMENT;
+
+		default:
+			return NO_DOCUMENT;
+	}
+}
@@ -0,0 +1,103 @@
+/**	@file MessageBatch.h
+**/
+
+#ifndef _MESSAGEBATCH_H_
+#define _MESSAGEBATCH_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Client;
+class Message;
+
+/**
+	@brief All Messages received within one run of the NetworkInterface event loop.
+
+	A MessageBatch keeps the Messages of one tick in their arrival order and additionally grouped
+	by the document each of them targets. Handlers may use the groups to do per-document work
+	(lookups, broadcasts, cursor updates) once per tick instead of once per Message;
+	main_network_batch_handler only does its housekeeping that way so far.
+
+	Messages addressing a document by id target that one. Messages acting on their sender's active
+	document target the document their sender will have active when they're handled, i.e. after
+	the sender's earlier Messages of the batch: activating or merging into a document makes it the
+	active one, closing it leaves none. Once a Message of the sender opens a document by name or
+	resumes a session, its active document isn't known before handling anymore.
+
+	@note The batch only holds pointers to the Messages; it must not outlive the MessageList the
+		Messages are stored in.
+**/
+class MessageBatch
+{
+	public:
+		typedef std::vector<const Message *> MessageGroup; ///< Messages in arrival order
+		typedef std::unordered_map<int32_t, MessageGroup> MessageGroups; ///< doc id -> Messages
+
+		static const int32_t NO_DOCUMENT = 0; ///< group of Messages without a known document
+
+		/**
+			Default constructor. Creates an empty batch.
+		**/
+		MessageBatch(void);
+		/**
+			Creates a batch containing only the given Message.
+
+			@param message a reference to the Message to add
+		**/
+		explicit MessageBatch(const Message &message);
+
+		/**
+			Appends a Message to this batch. It is added to the end of the arrival order and to the
+			group of the document it targets; Messages without a sender, Messages not targeting a
+			single document and Messages whose document isn't known yet are added to group
+			NO_DOCUMENT.
+
+			@param message a reference to the Message to add
+		**/
+		void add(const Message &message);
+		/**
+			Checks whether this batch contains any Messages.
+
+			@return whether this batch is empty
+		**/
+		inline bool empty(void) const;
+		/**
+			Returns the Messages of this batch grouped by document id.
+
+			@return a reference to the map of document ids onto their Messages
+		**/
+		inline const MessageGroups &get_groups(void) const;
+		/**
+			Returns all Messages of this batch in the order they have been received.
+
+			@return a reference to the vector of Messages
+		**/
+		inline const MessageGroup &get_messages(void) const;
+
+	private:
+		/**
+			Determines the document a Message targets and, if it changes the active document of
+			its sender, records the sender's next one.
+
+			@param message a reference to the Message to look at
+			@return the document id, NO_DOCUMENT if there's none or it isn't known
+		**/
+		int32_t get_target(const Message &message);
+
+		MessageGroups	groups; ///< Messages grouped by document id
+		MessageGroup	messages; ///< Messages in arrival order
+		std::unordered_map<const Client *, int32_t>
+						active_documents; ///< sender -> active document after its Messages so far
+};
+
+bool MessageBatch::empty(void) const
+{ return messages.empty(); }
+
+const MessageBatch::MessageGroups &MessageBatch::get_groups(void) const
+{ return groups; }
+
+const MessageBatch::MessageGroup &MessageBatch::get_messages(void) const
+{ return messages; }
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file MessageCodec.cpp
+ */
+
+#include "MessageCodec.h"
+
+namespace MessageSchema
+{
+	FrameReader::FrameReader(const char *begin, const char *end, int socket):
+		position(begin), end(end), socket(socket)
+	{}
+
+	void FrameReader::read(char *dest, size_t size)
+	{
+		if (static_cast<size_t>(end - position) < size)
+		{ throw Exception::MalformedMessage("truncated field", socket); }
+
+		std::copy_n(position, size, dest);
+		position += size;
+	}
+
+	void FrameReader::read_string(std::vector<char> &dest, size_t field_size)
+	{
+		uint32_t length = read_varint();
+		if (length > field_size)
+		{ throw Exception::MalformedMessage("string too long", socket); }
+
+		dest.assign(field_size, '\0');
+		read(dest.data(), length);
+	}
+
+	uint32_t FrameReader::read_uint32(void)
+	{
+		uint32_t value;
+		read(reinterpret_cast<char *>(&value), sizeof(value));
+
+		return ntohl(value);
+	}
+
+	uint32_t FrameReader::read_varint(void)
+	{
+		uint32_t value = 0;
+
+		for (unsigned shift = 0; shift < 35; shift += 7)
+		{
+			if (position == end)
+			{ throw Exception::MalformedMessage("truncated varint", socket); }
+
+			uint8_t byte = *position++;
+			if (shift == 28 && (byte & 0x70) != 0)
+			{ throw Exception::MalformedMessage("varint exceeds 32 bits", socket); }
+
+			value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+
+			if ((byte & 0x80) == 0)
+			{ return value; }
+		}
+
+		throw Exception::MalformedMessage("varint too long", socket);
+	}
+
+	uint64_t FrameReader::read_varint64(void)
+	{
+		uint64_t value = 0;
+
+		for (unsigned shift = 0; shift < 70; shift += 7)
+		{
+			if (position == end)
+			{ throw Exception::MalformedMessage("truncated varint", socket); }
+
+			uint8_t byte = *position++;
+			if (shift == 63 && (byte & 0x7e) != 0)
+			{ throw Exception::MalformedMessage("varint exceeds 64 bits", socket); }
+
+			value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+			if ((byte & 0x80) == 0)
+			{ return value; }
+		}
+
+		throw Exception::MalformedMessage("varint too long", socket);
+	}
+};
@@ -0,0 +1,241 @@
+/**	@file MessageCodec.h
+
+	Encoders and decoders specialised at compile time for each layout in MessageSchema.h.
+**/
+
+#ifndef _MESSAGECODEC_H_
+#define _MESSAGECODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MessageSchema.h"
+
+class Client;
+
+namespace MessageSchema
+{
+	/**
+		@brief Bounds checked reader over a received frame.
+	**/
+	class FrameReader
+	{
+		public:
+			/**
+				Standard constructor.
+
+				@param begin pointer to the first byte of the frame
+				@param end pointer behind the last byte of the frame
+				@param socket socket of the sender, for error reporting
+			**/
+			FrameReader(const char *begin, const char *end, int socket);
+
+			/**
+				Checks whether all bytes of the frame have been read.
+
+				@return whether the end of the frame has been reached
+			**/
+			inline bool at_end(void) const;
+			/**
+				Returns the socket of the sender.
+
+				@return the socket passed to the constructor
+			**/
+			inline int get_socket(void) const;
+			/**
+				Returns the amount of bytes not read yet.
+
+				@return the distance to the end of the frame
+			**/
+			inline size_t get_remaining(void) const;
+			/**
+				Reads raw bytes.
+
+				@param dest pointer to at least size bytes
+				@param size amount of bytes to read
+
+				@exception Exception::MalformedMessage if the frame is too short
+			**/
+			void read(char *dest, size_t size);
+			/**
+				Reads a varint-prefixed string into a field of the given size, padding it with '\0'.
+
+				@param dest a reference to the vector to store the string in
+				@param field_size size of the respective protocol version 1 field
+
+				@exception Exception::MalformedMessage if the frame is too short or the string is
+					longer than field_size
+			**/
+			void read_string(std::vector<char> &dest, size_t field_size);
+			/**
+				Reads a 4 byte integer in network byte order.
+
+				@exception Exception::MalformedMessage if the frame is too short
+			**/
+			uint32_t read_uint32(void);
+			/**
+				Reads an unsigned LEB128 varint of at most 5 bytes.
+
+				@exception Exception::MalformedMessage if the frame is too short or the varint too
+					long or beyond 32 bits
+			**/
+			uint32_t read_varint(void);
+			/**
+				Reads an unsigned LEB128 varint of at most 10 bytes.
+
+				@exception Exception::MalformedMessage if the frame is too short or the varint too
+					long or beyond 64 bits
+			**/
+			uint64_t read_varint64(void);
+
+		private:
+			const char	*position; ///< next byte to read
+			const char	*end; ///< end of the frame
+			int			 socket; ///< socket of the sender
+	};
+
+	/**
+		@brief Encoding of a single Field.
+
+		Every specialisation provides:
+		- V1_SIZE: the protocol version 1 size, or 0 if it depends on the Message
+		- size(const Message&, uint8_t): the encoded size in the given version
+		- write(char*, const Message&, uint8_t): encodes the field, returns the end pointer
+		- read(FrameReader&, Message&, uint8_t): decodes the field
+		- receive_v1(Client&, Message&): receives and decodes the field in version 1
+	**/
+	template<Field F>
+	struct FieldCodec;
+
+	/**
+		@brief Encoding of a list of Fields, i.e. of a whole Message layout.
+	**/
+	template<typename F>
+	struct Codec;
+
+	template<>
+	struct Codec<Fields<>>
+	{
+		static const size_t V1_FIXED_PREFIX = 0; ///< size of the leading fixed size fields
+
+		static size_t size(const Message &, uint8_t)
+		{ return 0; }
+		static char *write(char *dest, const Message &, uint8_t)
+		{ return dest; }
+		static void read(FrameReader &, Message &, uint8_t)
+		{}
+		static void read_v1_prefix(FrameReader &, Message &)
+		{}
+		static void receive_v1_rest(Client &, Message &, bool)
+		{}
+	};
+
+	template<Field Head, Field... Tail>
+	struct Codec<Fields<Head, Tail...>>
+	{
+		typedef FieldCodec<Head> head; ///< codec of the first field
+		typedef Codec<Fields<Tail...>> tail; ///< codec of the remaining fields
+
+		/**
+			Size of the fixed size fields at the beginning of the layout in protocol version 1.
+			These are received with one call.
+		**/
+		static const size_t V1_FIXED_PREFIX =
+			head::V1_SIZE == 0 ? 0 : head::V1_SIZE + tail::V1_FIXED_PREFIX;
+
+		/**
+			Computes the encoded size of all fields.
+		**/
+		static size_t size(const Message &message, uint8_t version)
+		{ return head::size(message, version) + tail::size(message, version); }
+		/**
+			Encodes all fields.
+
+			@return pointer behind the last written byte
+		**/
+		static char *write(char *dest, const Message &message, uint8_t version)
+		{ return tail::write(head::write(dest, message, version), message, version); }
+		/**
+			Decodes all fields from a frame.
+		**/
+		static void read(FrameReader &reader, Message &message, uint8_t version)
+		{
+			head::read(reader, message, version);
+			tail::read(reader, message, version);
+		}
+		/**
+			Decodes the leading fixed size fields in protocol version 1.
+		**/
+		static void read_v1_prefix(FrameReader &reader, Message &message)
+		{
+			if (head::V1_SIZE == 0)
+			{ return; }
+
+			head::read(reader, message, Message::PROTOCOL_VERSION_1);
+			tail::read_v1_prefix(reader, message);
+		}
+		/**
+			Receives and decodes the fields after the fixed size prefix in protocol version 1.
+
+			@param in_prefix whether the fields up to here belong to the fixed size prefix
+		**/
+		static void receive_v1_rest(Client &client, Message &message, bool in_prefix)
+		{
+			in_prefix = in_prefix && head::V1_SIZE != 0;
+			if (!in_prefix)
+			{ head::receive_v1(client, message); }
+
+			tail::receive_v1_rest(client, message, in_prefix);
+		}
+	};
+
+	/**
+		Computes the encoded size of an unsigned LEB128 varint.
+
+		@param value the value to encode
+		@return the size in bytes, between 1 and 10
+	**/
+	inline size_t varint_size(uint64_t value);
+	/**
+		Encodes an unsigned LEB128 varint (7 bits per byte, least significant group first, high bit
+		set on all but the last byte).
+
+		@param dest pointer to at least varint_size(value) bytes
+		@param value the value to encode
+		@return pointer behind the last written byte
+	**/
+	inline char *write_varint(char *dest, uint64_t value);
+
+	/**
+		Encodes a Message in a frame of the given layout, appending it to dest with a single
+		allocation.
+
+		@param dest a reference to the vector to append the frame to
+		@param message the Message to encode
+		@param version the protocol version to encode for
+	**/
+	template<typename F>
+	void encode(std::vector<char> &dest, const Message &message, uint8_t version);
+	/**
+		Decodes the body of a protocol version 2 or 3 frame of the given layout. The type has
+		already been read from the reader.
+
+		@exception Exception::MalformedMessage if the frame doesn't match the layout
+	**/
+	template<typename F>
+	void decode_v2(FrameReader &reader, Message &message,
+		uint8_t version = Message::PROTOCOL_VERSION_2);
+	/**
+		Receives and decodes a protocol version 1 Message of the given layout whose type has
+		already been received.
+
+		@note Calls Client::receive(T*, size_t) without catching any exceptions.
+	**/
+	template<typename F>
+	void receive_v1(Client &client, Message &message);
+};
+
+#include "MessageCodec.tcc"
+
+#endif
@@ -0,0 +1,899 @@
+#ifndef _MESSAGECODEC_TCC_
+#define _MESSAGECODEC_TCC_
+
+/**
+ * @file MessageCodec.tcc
+ */
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <limits>
+
+#include <arpa/inet.h>
+
+#include "Client.h"
+#include "exceptions.h"
+
+namespace MessageSchema
+{
+	bool FrameReader::at_end(void) const
+	{ return position == end; }
+
+	int FrameReader::get_socket(void) const
+	{ return socket; }
+
+	size_t FrameReader::get_remaining(void) const
+	{ return end - position; }
+
+	size_t varint_size(uint64_t value)
+	{
+		size_t size = 1;
+		for (; value >= 0x80; value >>= 7)
+		{ ++size; }
+
+		return size;
+	}
+
+	char *write_varint(char *dest, uint64_t value)
+	{
+		for (; value >= 0x80; value >>= 7)
+		{ *dest++ = static_cast<char>((value & 0x7f) | 0x80); }
+
+		*dest++ = static_cast<char>(value);
+		return dest;
+	}
+
+	/**
+		Computes the encoded size of an integer: 4 bytes in version 1, a varint of its lower 32
+		bits in version 2 and a varint of all 64 bits in version 3.
+	**/
+	inline size_t integer_size(int64_t value, uint8_t version)
+	{
+		switch (version)
+		{
+			case Message::PROTOCOL_VERSION_1:
+				return 4;
+			case Message::PROTOCOL_VERSION_2:
+				return varint_size(static_cast<uint32_t>(value));
+			default:
+				return varint_size(static_cast<uint64_t>(value));
+		}
+	}
+
+	/**
+		Encodes an integer: 4 bytes in network byte order in version 1, a varint of its lower 32
+		bits in version 2 and a varint of all 64 bits in version 3. Values beyond 32 bits have to
+		be kept from clients below version 3 by the caller.
+
+		@return pointer behind the last written byte
+	**/
+	inline char *write_integer(char *dest, int64_t value, uint8_t version)
+	{
+		switch (version)
+		{
+			case Message::PROTOCOL_VERSION_1:
+				break;
+			case Message::PROTOCOL_VERSION_2:
+				return write_varint(dest, static_cast<uint32_t>(value));
+			default:
+				return write_varint(dest, static_cast<uint64_t>(value));
+		}
+
+		uint32_t network_value = htonl(static_cast<uint32_t>(value));
+		return std::copy_n(reinterpret_cast<const char *>(&network_value), 4, dest);
+	}
+
+	/**
+		Decodes an integer encoded by write_integer(char*, int64_t, uint8_t).
+	**/
+	inline int64_t read_integer(FrameReader &reader, uint8_t version)
+	{
+		switch (version)
+		{
+			case Message::PROTOCOL_VERSION_1:
+				return static_cast<int32_t>(reader.read_uint32());
+			case Message::PROTOCOL_VERSION_2:
+				return static_cast<int32_t>(reader.read_varint());
+			default:
+				return static_cast<int64_t>(reader.read_varint64());
+		}
+	}
+
+	/**
+		Converts a decoded integer to the type of the member it is stored in.
+
+		@exception Exception::MalformedMessage if the value doesn't fit
+	**/
+	template<typename T>
+	inline T narrow_integer(int64_t value, int socket)
+	{
+		if (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max())
+		{ throw Exception::MalformedMessage("integer out of range", socket); }
+
+		return static_cast<T>(value);
+	}
+
+	/**
+		Decodes an integer of the given type, see read_integer(FrameReader&, uint8_t).
+
+		@exception Exception::MalformedMessage if the value doesn't fit
+	**/
+	template<typename T>
+	inline T read_integer(FrameReader &reader, uint8_t version)
+	{ return narrow_integer<T>(read_integer(reader, version), reader.get_socket()); }
+
+	/**
+		Checks that a decoded byte count is covered by the rest of the frame, before anything is
+		allocated for it.
+
+		@exception Exception::MalformedMessage if the count is negative or the frame too short
+	**/
+	inline size_t check_byte_count(const FrameReader &reader, int64_t count)
+	{
+		if (count < 0)
+		{ throw Exception::MalformedMessage("negative byte count", reader.get_socket()); }
+
+		if (static_cast<uint64_t>(count) > reader.get_remaining())
+		{ throw Exception::MalformedMessage("truncated field", reader.get_socket()); }
+
+		return static_cast<size_t>(count);
+	}
+
+	const size_t V1_MIN_OPERATION_SIZE = 5; ///< kind and position, the least an operation takes
+
+	/**
+		Checks an operation count received in protocol version 1, before anything is received for
+		the operations. Every operation takes at least V1_MIN_OPERATION_SIZE bytes, more of them
+		can't be part of a message within Message::MAX_PAYLOAD_SIZE.
+
+		@exception Exception::MalformedMessage if the count is negative or too large
+	**/
+	inline int32_t check_operation_count(int32_t count, int socket)
+	{
+		if (count < 0)
+		{ throw Exception::MalformedMessage("negative operation count", socket); }
+
+		if (static_cast<size_t>(count) > Message::MAX_PAYLOAD_SIZE / V1_MIN_OPERATION_SIZE)
+		{ throw Exception::MalformedMessage("too many operations", socket); }
+
+		return count;
+	}
+
+	/**
+		Checks the byte count of an operation received in protocol version 1, before anything is
+		allocated for it. The bytes of all operations of a message may not exceed
+		Message::MAX_PAYLOAD_SIZE together.
+
+		@param count the byte count of the operation
+		@param total a reference to the bytes of the operations before, the count is added
+		@param socket the socket the message is received from
+		@return the byte count
+
+		@exception Exception::MalformedMessage if the count is negative or too large
+	**/
+	inline size_t check_operation_bytes(int32_t count, size_t &total, int socket)
+	{
+		if (count < 0)
+		{ throw Exception::MalformedMessage("negative byte count", socket); }
+
+		if (static_cast<size_t>(count) > Message::MAX_PAYLOAD_SIZE - total)
+		{ throw Exception::MalformedMessage("operations too long", socket); }
+
+		total += count;
+		return static_cast<size_t>(count);
+	}
+
+	/**
+		@brief Common part of all fields with a fixed protocol version 1 size.
+	**/
+	template<Field F, size_t SIZE>
+	struct FixedFieldCodec
+	{
+		static const size_t V1_SIZE = SIZE; ///< protocol version 1 size
+
+		static void receive_v1(Client &client, Message &message)
+		{
+			char buffer[SIZE];
+			client.receive(buffer, SIZE);
+
+			FrameReader reader(buffer, buffer + SIZE, client.socket);
+			FieldCodec<F>::read(reader, message, Message::PROTOCOL_VERSION_1);
+		}
+	};
+
+	/**
+		@brief Single byte fields.
+	**/
+	template<Field F>
+	struct ByteFieldCodec : FixedFieldCodec<F, 1>
+	{
+		static size_t size(const Message &, uint8_t)
+		{ return 1; }
+		static char *write(char *dest, const Message &message, uint8_t)
+		{
+			*dest++ = FieldCodec<F>::get(message);
+			return dest;
+		}
+		static void read(FrameReader &reader, Message &message, uint8_t)
+		{
+			char value;
+			reader.read(&value, 1);
+			FieldCodec<F>::set(message, value);
+		}
+	};
+
+	/**
+		@brief Integer fields, 4 bytes in version 1 and varints in version 2 and 3.
+	**/
+	template<Field F, typename T, T Message::*MEMBER>
+	struct IntegerFieldCodec : FixedFieldCodec<F, 4>
+	{
+		static size_t size(const Message &message, uint8_t version)
+		{ return integer_size(message.*MEMBER, version); }
+		static char *write(char *dest, const Message &message, uint8_t version)
+		{ return write_integer(dest, message.*MEMBER, version); }
+		static void read(FrameReader &reader, Message &message, uint8_t version)
+		{ message.*MEMBER = read_integer<T>(reader, version); }
+	};
+
+	/**
+		@brief Name fields, padded in version 1 and length-prefixed in version 2.
+	**/
+	template<Field F, size_t SIZE>
+	struct NameFieldCodec : FixedFieldCodec<F, SIZE>
+	{
+		static size_t length(const Message &message)
+		{
+			auto end = message.name.begin() + std::min(message.name.size(), SIZE);
+			return std::find(message.name.begin(), end, '\0') - message.name.begin();
+		}
+		static size_t size(const Message &message, uint8_t version)
+		{
+			if (version == Message::PROTOCOL_VERSION_1)
+			{ return SIZE; }
+
+			size_t name_length = length(message);
+			return varint_size(name_length) + name_length;
+		}
+		static char *write(char *dest, const Message &message, uint8_t version)
+		{
+			size_t name_length = length(message);
+
+			if (version != Message::PROTOCOL_VERSION_1)
+			{ dest = write_varint(dest, name_length); }
+
+			dest = std::copy_n(message.name.begin(), name_length, dest);
+
+			if (version == Message::PROTOCOL_VERSION_1)
+			{ dest = std::fill_n(dest, SIZE - name_length, '\0'); }
+
+			return dest;
+		}
+		static void read(FrameReader &reader, Message &message, uint8_t version)
+		{
+			if (version != Message::PROTOCOL_VERSION_1)
+			{
+				reader.read_string(message.name, SIZE);
+				return;
+			}
+
+			message.name.resize(SIZE);
+			reader.read(&message.name[0], SIZE);
+		}
+	};
+
+	template<>
+	struct FieldCodec<FIELD_BYTE> : ByteFieldCodec<FIELD_BYTE>
+	{
+		static char get(const Message &message)
+		{ return message.bytes.empty() ? '\0' : message.bytes[0]; }
+		static void set(Message &message, char value)
+		{ message.bytes.assign(1, value); }
+	};
+
+	template<>
+	struct FieldCodec<FIELD_STATUS> : ByteFieldCodec<FIELD_STATUS>
+	{
+		static char get(const Message &message)
+		{ return static_cast<char>(message.status); }
+		static void set(Message &message, char value)
+		{ message.status = static_cast<Message::MessageStatus>(value); }
+	};
+
+	template<>
+	struct FieldCodec<FIELD_COMPRESSION> : ByteFieldCodec<FIELD_COMPRESSION>
+	{
+		static char get(const Message &message)
+		{ return static_cast<char>(message.length); }
+		static void set(Message &message, char value)
+		{ message.length = static_cast<uint8_t>(value); }
+	};
+
+	template<>
+	struct FieldCodec<FIELD_VERSION> : ByteFieldCodec<FIELD_VERSION>
+	{
+		static char get(const Message &message)
+		{ return static_cast<char>(message.length); }
+		static void set(Message &message, char value)
+		{ message.length = static_cast<uint8_t>(value); }
+	};
+
+	template<>
+	struct FieldCodec<FIELD_HASH> : FixedFieldCodec<FIELD_HASH, Message::FIELD_SIZE_HASH>
+	{
+		static size_t size(const Message &, uint8_t)
+		{ return Message::FIELD_SIZE_HASH; }
+		static char *write(char *dest, const Message &message, uint8_t)
+		{ return std::copy(message.hash.begin(), message.hash.end(), dest); }
+		static void read(FrameReader &reader, Message &message, uint8_t)
+		{ reader.read(&message.hash[0], Message::FIELD_SIZE_HASH); }
+	};
+
+	template<>
+	struct FieldCodec<FIELD_ID> : IntegerFieldCodec<FIELD_ID, int32_t, &Message::id>
+	{};
+
+	template<>
+	struct FieldCodec<FIELD_COLUMN> : IntegerFieldCodec<FIELD_COLUMN, int64_t, &Message::column>
+	{};
+
+	template<>
+	struct FieldCodec<FIELD_INSERTED> :
+		IntegerFieldCodec<FIELD_INSERTED, int64_t, &Message::inserted>
+	{};
+
+	template<>
+	struct FieldCodec<FIELD_LENGTH> : IntegerFieldCodec<FIELD_LENGTH, int64_t, &Message::length>
+	{};
+
+	template<>
+	struct FieldCodec<FIELD_LINE> : IntegerFieldCodec<FIELD_LINE, int64_t, &Message::line>
+	{};
+
+	template<>
+	struct FieldCodec<FIELD_POSITION> :
+		IntegerFieldCodec<FIELD_POSITION, int64_t, &Message::position>
+	{};
+
+	template<>
+	struct FieldCodec<FIELD_REVISION> :
+		IntegerFieldCodec<FIELD_REVISION, int32_t, &Message::revision>
+	{};
+
+	template<>
+	struct FieldCodec<FIELD_SITE> : IntegerFieldCodec<FIELD_SITE, int32_t, &Message::site>
+	{};
+
+	template<>
+	struct FieldCodec<FIELD_DOC_NAME> : NameFieldCodec<FIELD_DOC_NAME, Message::FIELD_SIZE_DOC_NAME>
+	{};
+
+	template<>
+	struct FieldCodec<FIELD_USER_NAME> :
+		NameFieldCodec<FIELD_USER_NAME, Message::FIELD_SIZE_USER_NAME>
+	{};
+
+	template<>
+	struct FieldCodec<FIELD_PAYLOAD>
+	{
+		static const size_t V1_SIZE = 0; ///< depends on the length field
+
+		static size_t size(const Message &message, uint8_t)
+		{ return std::max<int64_t>(message.length, 0); }
+		static char *write(char *dest, const Message &message, uint8_t version)
+		{
+			size_t payload_size = size(message, version);
+			size_t copied = std::min(message.bytes.size(), payload_size);
+
+			dest = std::copy_n(message.bytes.begin(), copied, dest);
+			return std::fill_n(dest, payload_size - copied, '\0');
+		}
+		static void read(FrameReader &reader, Message &message, uint8_t)
+		{
+			if (message.length < 0)
+			{ throw Exception::MalformedMessage("negative payload length", reader.get_socket()); }
+
+			message.bytes.resize(check_byte_count(reader, message.length));
+			reader.read(message.bytes.data(), message.bytes.size());
+		}
+		static void receive_v1(Client &client, Message &message)
+		{
+			if (message.length < 0)
+			{ throw Exception::MalformedMessage("negative payload length", client.socket); }
+			if (message.length > static_cast<int64_t>(Message::MAX_PAYLOAD_SIZE))
+			{ throw Exception::MalformedMessage("payload too long", client.socket); }
+
+			message.bytes.resize(message.length);
+			if (message.length > 0)
+			{ client.receive(&message.bytes[0], message.length); }
+		}
+	};
+
+	template<>
+	struct FieldCodec<FIELD_DOC_LIST>
+	{
+		static const size_t V1_SIZE = 0; ///< depends on the length field
+
+		static size_t count(const Message &message)
+		{ return std::max<int64_t>(message.length, 0); }
+		static size_t entry_length(const Message &message, size_t index)
+		{
+			size_t offset = index * Message::FIELD_SIZE_DOC_NAME;
+			if (offset >= message.bytes.size())
+			{ return 0; }
+
+			auto begin = message.bytes.begin() + offset;
+			auto end = begin + std::min(message.bytes.size() - offset, Message::FIELD_SIZE_DOC_NAME);
+			return std::find(begin, end, '\0') - begin;
+		}
+		static size_t size(const Message &message, uint8_t version)
+		{
+			if (version == Message::PROTOCOL_VERSION_1)
+			{ return count(message) * Message::FIELD_SIZE_DOC_NAME; }
+
+			size_t result = 0;
+			for (size_t i = 0; i < count(message); ++i)
+			{
+				size_t name_length = entry_length(message, i);
+				result += varint_size(name_length) + name_length;
+			}
+
+			return result;
+		}
+		static char *write(char *dest, const Message &message, uint8_t version)
+		{
+			for (size_t i = 0; i < count(message); ++i)
+			{
+				size_t name_length = entry_length(message, i);
+
+				if (version != Message::PROTOCOL_VERSION_1)
+				{ dest = write_varint(dest, name_length); }
+
+				dest = std::copy_n(message.bytes.begin() + i * Message::FIELD_SIZE_DOC_NAME,
+					name_length, dest);
+
+				if (version == Message::PROTOCOL_VERSION_1)
+				{ dest = std::fill_n(dest, Message::FIELD_SIZE_DOC_NAME - name_length, '\0'); }
+			}
+
+			return dest;
+		}
+		static void read(FrameReader &reader, Message &message, uint8_t version)
+		{
+			if (message.length < 0 || static_cast<size_t>(message.length) >
+				std::numeric_limits<int32_t>::max() / Message::FIELD_SIZE_DOC_NAME)
+			{ throw Exception::MalformedMessage("invalid document list length", reader.get_socket()); }
+
+			message.bytes.assign(count(message) * Message::FIELD_SIZE_DOC_NAME, '\0');
+
+			if (version == Message::PROTOCOL_VERSION_1)
+			{
+				reader.read(message.bytes.data(), message.bytes.size());
+				return;
+			}
+
+			std::vector<char> name;
+			for (size_t i = 0; i < count(message); ++i)
+			{
+				reader.read_string(name, Message::FIELD_SIZE_DOC_NAME);
+				std::copy(name.begin(), name.end(),
+					message.bytes.begin() + i * Message::FIELD_SIZE_DOC_NAME);
+			}
+		}
+		static void receive_v1(Client &client, Message &message)
+		{
+			if (message.length < 0 || static_cast<size_t>(message.length) >
+				std::numeric_limits<int32_t>::max() / Message::FIELD_SIZE_DOC_NAME)
+			{ throw Exception::MalformedMessage("invalid document list length", client.socket); }
+
+			message.bytes.resize(count(message) * Message::FIELD_SIZE_DOC_NAME);
+			if (!message.bytes.empty())
+			{ client.receive(&message.bytes[0], message.bytes.size()); }
+		}
+	};
+
+	template<>
+	struct FieldCodec<FIELD_DOC_ENTRIES>
+	{
+		static const size_t V1_SIZE = 0; ///< depends on the length field
+
+		static size_t count(const Message &message)
+		{ return std::min<size_t>(std::max<int64_t>(message.length, 0), message.entries.size()); }
+		static size_t name_length(const DocumentEntry &entry)
+		{
+			size_t length = std::min(entry.name.size(), Message::FIELD_SIZE_DOC_NAME);
+			return std::find(entry.name.begin(), entry.name.begin() + length, '\0') -
+				entry.name.begin();
+		}
+		static size_t size(const Message &message, uint8_t version)
+		{
+			size_t result = 0;
+			for (size_t i = 0; i < count(message); ++i)
+			{
+				const DocumentEntry &entry = message.entries[i];
+
+				if (version == Message::PROTOCOL_VERSION_1)
+				{ result += Message::FIELD_SIZE_DOC_NAME; }
+				else
+				{ result += varint_size(name_length(entry)) + name_length(entry); }
+
+				result += integer_size(entry.size, version) +
+					integer_size(entry.modified, version) + integer_size(entry.editors, version);
+
+				if (version >= Message::PROTOCOL_VERSION_3)
+				{
+					result += integer_size(entry.lines, version) +
+					          integer_size(entry.words, version);
+				}
+			}
+
+			return result;
+		}
+		static char *write(char *dest, const Message &message, uint8_t version)
+		{
+			for (size_t i = 0; i < count(message); ++i)
+			{
+				const DocumentEntry &entry = message.entries[i];
+				size_t length = name_length(entry);
+
+				if (version != Message::PROTOCOL_VERSION_1)
+				{ dest = write_varint(dest, length); }
+
+				dest = std::copy_n(entry.name.begin(), length, dest);
+
+				if (version == Message::PROTOCOL_VERSION_1)
+				{ dest = std::fill_n(dest, Message::FIELD_SIZE_DOC_NAME - length, '\0'); }
+
+				dest = write_integer(dest, entry.size, version);
+				dest = write_integer(dest, entry.modified, version);
+				dest = write_integer(dest, entry.editors, version);
+
+				if (version >= Message::PROTOCOL_VERSION_3)
+				{
+					dest = write_integer(dest, entry.lines, version);
+					dest = write_integer(dest, entry.words, version);
+				}
+			}
+
+			return dest;
+		}
+		static void read(FrameReader &reader, Message &message, uint8_t version)
+		{
+			if (message.length < 0)
+			{ throw Exception::MalformedMessage("negative entry count", reader.get_socket()); }
+
+			// every entry takes at least four bytes, so the frame bounds the allocation
+			message.entries.clear();
+			for (int64_t i = 0; i < message.length; ++i)
+			{
+				DocumentEntry entry;
+
+				if (version == Message::PROTOCOL_VERSION_1)
+				{
+					entry.name.resize(Message::FIELD_SIZE_DOC_NAME);
+					reader.read(entry.name.data(), Message::FIELD_SIZE_DOC_NAME);
+				}
+				else
+				{ reader.read_string(entry.name, Message::FIELD_SIZE_DOC_NAME); }
+				entry.name.resize(name_length(entry));
+
+				entry.size = read_integer(reader, version);
+				entry.modified = read_integer<int32_t>(reader, version);
+				entry.editors = read_integer<int32_t>(reader, version);
+
+				if (version >= Message::PROTOCOL_VERSION_3)
+				{
+					entry.lines = read_integer(reader, version);
+					entry.words = read_integer(reader, version);
+				}
+
+				message.entries.push_back(std::move(entry));
+			}
+		}
+	};
+
+	template<>
+	struct FieldCodec<FIELD_OPERATIONS>
+	{
+		static const size_t V1_SIZE = 0; ///< depends on the operations
+
+		static bool has_length(EditOperation::Kind kind)
+		{ return kind != EditOperation::Kind::KIND_INSERT; }
+		static bool has_bytes(EditOperation::Kind kind)
+		{ return kind != EditOperation::Kind::KIND_DELETE; }
+
+		static size_t size(const Message &message, uint8_t version)
+		{
+			size_t result = integer_size(message.operations.size(), version);
+
+			for (const EditOperation &operation: message.operations)
+			{
+				result += 1 + integer_size(operation.position, version);
+				if (has_length(operation.kind))
+				{ result += integer_size(operation.length, version); }
+				if (has_bytes(operation.kind))
+				{
+					result += integer_size(operation.bytes.size(), version) +
+						operation.bytes.size();
+				}
+			}
+
+			return result;
+		}
+		static char *write(char *dest, const Message &message, uint8_t version)
+		{
+			dest = write_integer(dest, message.operations.size(), version);
+
+			for (const EditOperation &operation: message.operations)
+			{
+				*dest++ = static_cast<char>(operation.kind);
+				dest = write_integer(dest, operation.position, version);
+				if (has_length(operation.kind))
+				{ dest = write_integer(dest, operation.length, version); }
+				if (has_bytes(operation.kind))
+				{
+					dest = write_integer(dest, operation.bytes.size(), version);
+					dest = std::copy(operation.bytes.begin(), operation.bytes.end(), dest);
+				}
+			}
+
+			return dest;
+		}
+		/**
+			Checks the kind and the sizes of an operation.
+
+			@exception Exception::MalformedMessage if the operation is invalid
+		**/
+		static void check(const EditOperation &operation, int64_t byte_count, int socket)
+		{
+			if (operation.kind > EditOperation::Kind::KIND_REPLACE)
+			{ throw Exception::MalformedMessage("invalid edit operation", socket); }
+
+			if (operation.length < 0 || byte_count < 0)
+			{ throw Exception::MalformedMessage("negative edit operation length", socket); }
+		}
+		static void read(FrameReader &reader, Message &message, uint8_t version)
+		{
+			int64_t count = read_integer(reader, version);
+			if (count < 0)
+			{ throw Exception::MalformedMessage("negative operation count", reader.get_socket()); }
+
+			// every operation takes at least two bytes, so the frame bounds the allocation
+			message.operations.clear();
+			for (int64_t i = 0; i < count; ++i)
+			{
+				EditOperation operation;
+				int64_t byte_count = 0;
+				char kind;
+
+				reader.read(&kind, 1);
+				operation.kind = static_cast<EditOperation::Kind>(kind);
+				operation.position = read_integer(reader, version);
+				if (has_length(operation.kind))
+				{ operation.length = read_integer(reader, version); }
+				if (has_bytes(operation.kind))
+				{ byte_count = read_integer(reader, version); }
+				check(operation, byte_count, reader.get_socket());
+
+				operation.bytes.resize(check_byte_count(reader, byte_count));
+				reader.read(operation.bytes.data(), operation.bytes.size());
+
+				message.operations.push_back(std::move(operation));
+			}
+		}
+		static int32_t receive_integer(Client &client)
+		{
+			int32_t value;
+			client.receive(&value, 4);
+			return ntohl(value);
+		}
+		static void receive_v1(Client &client, Message &message)
+		{
+			int32_t count = check_operation_count(receive_integer(client), client.socket);
+			size_t total = 0;
+
+			message.operations.clear();
+			for (int32_t i = 0; i < count; ++i)
+			{
+				EditOperation operation;
+				int32_t byte_count = 0;
+				char kind;
+
+				client.receive(&kind, 1);
+				operation.kind = static_cast<EditOperation::Kind>(kind);
+				operation.position = receive_integer(client);
+				if (has_length(operation.kind))
+				{ operation.length = receive_integer(client); }
+				if (has_bytes(operation.kind))
+				{ byte_count = receive_integer(client); }
+				check(operation, byte_count, client.socket);
+
+				operation.bytes.resize(check_operation_bytes(byte_count, total, client.socket));
+				if (byte_count > 0)
+				{ client.receive(&operation.bytes[0], byte_count); }
+
+				message.operations.push_back(std::move(operation));
+			}
+		}
+	};
+
+	template<>
+	struct FieldCodec<FIELD_SEQUENCE>
+	{
+		static const size_t V1_SIZE = 0; ///< depends on the operations
+
+		static bool is_insertion(SequenceOperation::Kind kind)
+		{ return kind == SequenceOperation::Kind::KIND_INSERT; }
+
+		static size_t size(const Message &message, uint8_t version)
+		{
+			size_t result = integer_size(message.sequence.size(), version);
+
+			for (const SequenceOperation &operation: message.sequence)
+			{
+				result += 1 + integer_size(operation.id.site, version) +
+					integer_size(operation.id.clock, version);
+				if (is_insertion(operation.kind))
+				{
+					result += integer_size(operation.origin.site, version) +
+						integer_size(operation.origin.clock, version) +
+						integer_size(operation.bytes.size(), version) + operation.bytes.size();
+				}
+				else
+				{ result += integer_size(operation.length, version); }
+			}
+
+			return result;
+		}
+		static char *write(char *dest, const Message &message, uint8_t version)
+		{
+			dest = write_integer(dest, message.sequence.size(), version);
+
+			for (const SequenceOperation &operation: message.sequence)
+			{
+				*dest++ = static_cast<char>(operation.kind);
+				dest = write_integer(dest, operation.id.site, version);
+				dest = write_integer(dest, operation.id.clock, version);
+				if (is_insertion(operation.kind))
+				{
+					dest = write_integer(dest, operation.origin.site, version);
+					dest = write_integer(dest, operation.origin.clock, version);
+					dest = write_integer(dest, operation.bytes.size(), version);
+					dest = std::copy(operation.bytes.begin(), operation.bytes.end(), dest);
+				}
+				else
+				{ dest = write_integer(dest, operation.length, version); }
+			}
+
+			return dest;
+		}
+		/**
+			Checks the kind and the sizes of an operation.
+
+			@exception Exception::MalformedMessage if the operation is invalid
+		**/
+		static void check(const SequenceOperation &operation, int64_t byte_count, int socket)
+		{
+			if (operation.kind > SequenceOperation::Kind::KIND_RUN)
+			{ throw Exception::MalformedMessage("invalid sequence operation", socket); }
+
+			if (operation.length < 0 || byte_count < 0)
+			{ throw Exception::MalformedMessage("negative sequence operation length", socket); }
+		}
+		static void read(FrameReader &reader, Message &message, uint8_t version)
+		{
+			int64_t count = read_integer(reader, version);
+			if (count < 0)
+			{ throw Exception::MalformedMessage("negative operation count", reader.get_socket()); }
+
+			// every operation takes at least four bytes, so the frame bounds the allocation
+			message.sequence.clear();
+			for (int64_t i = 0; i < count; ++i)
+			{
+				SequenceOperation operation;
+				int64_t byte_count = 0;
+				char kind;
+
+				reader.read(&kind, 1);
+				operation.kind = static_cast<SequenceOperation::Kind>(kind);
+				operation.id.site = read_integer<int32_t>(reader, version);
+				operation.id.clock = read_integer<int32_t>(reader, version);
+				if (is_insertion(operation.kind))
+				{
+					operation.origin.site = read_integer<int32_t>(reader, version);
+					operation.origin.clock = read_integer<int32_t>(reader, version);
+					byte_count = read_integer(reader, version);
+				}
+				else
+				{ operation.length = read_integer<int32_t>(reader, version); }
+				check(operation, byte_count, reader.get_socket());
+
+				operation.bytes.resize(check_byte_count(reader, byte_count));
+				reader.read(operation.bytes.data(), operation.bytes.size());
+
+				message.sequence.push_back(std::move(operation));
+			}
+		}
+		static void receive_v1(Client &client, Message &message)
+		{
+			typedef FieldCodec<FIELD_OPERATIONS> Operations;
+
+			int32_t count = check_operation_count(Operations::receive_integer(client),
+				client.socket);
+			size_t total = 0;
+
+			message.sequence.clear();
+			for (int32_t i = 0; i < count; ++i)
+			{
+				SequenceOperation operation;
+				int32_t byte_count = 0;
+				char kind;
+
+				client.receive(&kind, 1);
+				operation.kind = static_cast<SequenceOperation::Kind>(kind);
+				operation.id.site = Operations::receive_integer(client);
+				operation.id.clock = Operations::receive_integer(client);
+				if (is_insertion(operation.kind))
+				{
+					operation.origin.site = Operations::receive_integer(client);
+					operation.origin.clock = Operations::receive_integer(client);
+					byte_count = Operations::receive_integer(client);
+				}
+				else
+				{ operation.length = Operations::receive_integer(client); }
+				check(operation, byte_count, client.socket);
+
+				operation.bytes.resize(check_operation_bytes(byte_count, total, client.socket));
+				if (byte_count > 0)
+				{ client.receive(&operation.bytes[0], byte_count); }
+
+				message.sequence.push_back(std::move(operation));
+			}
+		}
+	};
+
+	template<typename F>
+	void encode(std::vector<char> &dest, const Message &message, uint8_t version)
+	{
+		size_t body_size = Message::FIELD_SIZE_TYPE + Codec<F>::size(message, version);
+		size_t header_size = version == Message::PROTOCOL_VERSION_1 ? 0 : varint_size(body_size);
+
+		// one allocation for the whole frame
+		size_t offset = dest.size();
+		dest.resize(offset + header_size + body_size);
+
+		char *position = &dest[offset];
+		if (header_size != 0)
+		{ position = write_varint(position, body_size); }
+
+		*position++ = static_cast<char>(message.type);
+		position = Codec<F>::write(position, message, version);
+
+		assert(position == dest.data() + dest.size());
+	}
+
+	template<typename F>
+	void decode_v2(FrameReader &reader, Message &message, uint8_t version)
+	{
+		Codec<F>::read(reader, message, version);
+
+		if (!reader.at_end())
+		{ throw Exception::MalformedMessage("trailing bytes in frame", reader.get_socket()); }
+	}
+
+	template<typename F>
+	void receive_v1(Client &client, Message &message)
+	{
+		// receive all leading fixed size fields at once
+		std::array<char, Codec<F>::V1_FIXED_PREFIX> buffer;
+		if (!buffer.empty())
+		{ client.receive(buffer.data(), buffer.size()); }
+
+		FrameReader reader(buffer.data(), buffer.data() + buffer.size(), client.socket);
+		Codec<F>::read_v1_prefix(reader, message);
+		Codec<F>::receive_v1_rest(client, message, true);
+	}
+};
+
+#endif
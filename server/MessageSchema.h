@@ -0,0 +1,171 @@
+/**	@file MessageSchema.h
+
+	The wire layout of every Message, declared once for both directions and all protocol versions.
+	MessageCodec.h derives the C++ encoders and decoders from these tables, tools/
+	generate_java_codec.cpp derives the Java client's MessageCodec.java from them.
+**/
+
+#ifndef _MESSAGESCHEMA_H_
+#define _MESSAGESCHEMA_H_
+
+#include "Message.h"
+
+/**
+	@brief Field types and layout tables of the Message wire format.
+**/
+namespace MessageSchema
+{
+	/**
+		A single field of a Message layout and the Message member it is stored in.
+		The encoding depends on the protocol version:
+
+		field			| version 1						| version 2
+		----------------|-------------------------------|-------------------------------
+		FIELD_BYTE		| 1 byte (bytes[0])				| 1 byte
+		FIELD_COLUMN	| 4 bytes, network order		| varint
+		FIELD_COMPRESSION| 1 byte (length)				| 1 byte
+		FIELD_DOC_ENTRIES| length entries, see below	| length entries, see below
+		FIELD_DOC_LIST	| length * FIELD_SIZE_DOC_NAME	| length varint-prefixed strings
+		FIELD_DOC_NAME	| FIELD_SIZE_DOC_NAME, padded	| varint-prefixed string
+		FIELD_HASH		| FIELD_SIZE_HASH				| FIELD_SIZE_HASH
+		FIELD_ID		| 4 bytes, network order		| varint
+		FIELD_INSERTED	| 4 bytes, network order		| varint
+		FIELD_LENGTH	| 4 bytes, network order		| varint
+		FIELD_LINE		| 4 bytes, network order		| varint
+		FIELD_OPERATIONS| 4 byte count, operations		| varint count, operations
+		FIELD_PAYLOAD	| length bytes (bytes)			| length bytes
+		FIELD_POSITION	| 4 bytes, network order		| varint
+		FIELD_REVISION	| 4 bytes, network order		| varint
+		FIELD_SEQUENCE	| 4 byte count, operations		| varint count, operations
+		FIELD_SITE		| 4 bytes, network order		| varint
+		FIELD_STATUS	| 1 byte						| 1 byte
+		FIELD_USER_NAME	| FIELD_SIZE_USER_NAME, padded	| varint-prefixed string
+		FIELD_VERSION	| 1 byte (length)				| 1 byte
+
+		Version 3 is encoded like version 2, except that every varint integer carries 64 bits, so
+		positions and lengths beyond 2 GiB can be addressed. Version 2 varints carry the lower 32
+		bits of the value, which the server keeps within the signed 32 bit range for such clients.
+
+		FIELD_PAYLOAD, FIELD_DOC_ENTRIES and FIELD_DOC_LIST use the length field, which thus has to
+		precede them. The payload of TYPE_SYNC_COMPRESSED is a zlib stream of the bytes to insert.
+
+		Each of the document entries is encoded as its name like FIELD_DOC_NAME followed by its
+		size, modification time and editors, integers encoded like FIELD_POSITION. Version 3 adds
+		its lines and words.
+
+		Each of the operations is encoded as its kind (1 byte) followed by the fields the kind
+		uses, integers encoded like FIELD_POSITION:
+		- EditOperation::Kind::KIND_INSERT: position, byte count, bytes
+		- EditOperation::Kind::KIND_DELETE: position, length
+		- EditOperation::Kind::KIND_REPLACE: position, length, byte count, bytes
+
+		The sequence operations are encoded alike, an identifier as its site followed by its clock:
+		- SequenceOperation::Kind::KIND_INSERT: id, origin, byte count, bytes
+		- SequenceOperation::Kind::KIND_DELETE: id, length
+		- SequenceOperation::Kind::KIND_RUN: id, length
+	**/
+	enum Field
+	{
+		FIELD_BYTE,
+		FIELD_COLUMN,
+		FIELD_COMPRESSION,
+		FIELD_DOC_ENTRIES,
+		FIELD_DOC_LIST,
+		FIELD_DOC_NAME,
+		FIELD_HASH,
+		FIELD_ID,
+		FIELD_INSERTED,
+		FIELD_LENGTH,
+		FIELD_LINE,
+		FIELD_OPERATIONS,
+		FIELD_PAYLOAD,
+		FIELD_POSITION,
+		FIELD_REVISION,
+		FIELD_SEQUENCE,
+		FIELD_SITE,
+		FIELD_STATUS,
+		FIELD_USER_NAME,
+		FIELD_VERSION
+	};
+
+	/**
+		A compile time list of Fields, in wire order.
+	**/
+	template<Field... F>
+	struct Fields
+	{};
+};
+
+/**
+	Layouts of Messages sent from clients to the server. Each entry is
+	LAYOUT(type without TYPE_ prefix, fields...).
+**/
+#define MESSAGE_LAYOUTS_TO_SERVER(LAYOUT) \
+	LAYOUT(DOC_ACTIVATE, FIELD_ID, FIELD_HASH) \
+	LAYOUT(DOC_CREATE, FIELD_DOC_NAME) \
+	LAYOUT(DOC_DELETE, FIELD_DOC_NAME) \
+	LAYOUT(DOC_LIST) \
+	LAYOUT(DOC_OPEN, FIELD_DOC_NAME) \
+	LAYOUT(DOC_SAVE, FIELD_ID) \
+	LAYOUT(SYNC_BYTE, FIELD_BYTE) \
+	LAYOUT(SYNC_CURSOR, FIELD_POSITION) \
+	LAYOUT(SYNC_DELETION, FIELD_POSITION, FIELD_LENGTH) \
+	LAYOUT(SYNC_MULTIBYTE, FIELD_LENGTH, FIELD_PAYLOAD) \
+	LAYOUT(USER_LOGIN, FIELD_USER_NAME, FIELD_HASH) \
+	LAYOUT(USER_LOGOUT) \
+	LAYOUT(PROTOCOL_VERSION, FIELD_VERSION) \
+	LAYOUT(SYNC_BATCH, FIELD_REVISION, FIELD_OPERATIONS) \
+	LAYOUT(SYNC_SEQUENCE) \
+	LAYOUT(SYNC_MERGE, FIELD_ID, FIELD_SITE, FIELD_REVISION, FIELD_SEQUENCE) \
+	LAYOUT(SESSION_RESUME, FIELD_HASH, FIELD_REVISION) \
+	LAYOUT(COMPRESSION, FIELD_COMPRESSION) \
+	LAYOUT(DOC_LIST_PAGE, FIELD_POSITION, FIELD_LENGTH, FIELD_DOC_NAME) \
+	LAYOUT(DOC_LINE, FIELD_LINE) \
+	LAYOUT(SYNC_CURSOR_LINE, FIELD_LINE, FIELD_COLUMN) \
+	LAYOUT(SYNC_DELETION_LINE, FIELD_LINE, FIELD_COLUMN, FIELD_LENGTH) \
+	LAYOUT(SYNC_MULTIBYTE_LINE, FIELD_LINE, FIELD_COLUMN, FIELD_LENGTH, FIELD_PAYLOAD) \
+	LAYOUT(DOC_VIEWPORT, FIELD_POSITION, FIELD_LENGTH) \
+	LAYOUT(DOC_VIEWPORT_LINE, FIELD_LINE, FIELD_LENGTH) \
+	LAYOUT(DOC_SEARCH, FIELD_POSITION, FIELD_LENGTH, FIELD_DOC_NAME) \
+	LAYOUT(DOC_REPLACE, FIELD_DOC_NAME, FIELD_LENGTH, FIELD_PAYLOAD) \
+	LAYOUT(DOC_REPLACE_REGEX, FIELD_DOC_NAME, FIELD_LENGTH, FIELD_PAYLOAD) \
+	LAYOUT(DOC_CLOSE, FIELD_ID)
+
+/**
+	Layouts of Messages sent from the server to clients. Each entry is
+	LAYOUT(type without TYPE_ prefix, fields...).
+**/
+#define MESSAGE_LAYOUTS_TO_CLIENT(LAYOUT) \
+	LAYOUT(DOC_ACTIVATE, FIELD_STATUS, FIELD_ID) \
+	LAYOUT(DOC_CREATE, FIELD_STATUS, FIELD_DOC_NAME) \
+	LAYOUT(DOC_DELETE, FIELD_STATUS, FIELD_DOC_NAME) \
+	LAYOUT(DOC_LIST, FIELD_LENGTH, FIELD_DOC_LIST) \
+	LAYOUT(DOC_OPEN, FIELD_STATUS, FIELD_ID, FIELD_DOC_NAME) \
+	LAYOUT(DOC_SAVE, FIELD_STATUS, FIELD_ID) \
+	LAYOUT(STATUS, FIELD_STATUS) \
+	LAYOUT(SYNC_BYTE, FIELD_POSITION, FIELD_BYTE) \
+	LAYOUT(SYNC_DELETION, FIELD_POSITION, FIELD_LENGTH) \
+	LAYOUT(SYNC_MULTIBYTE, FIELD_POSITION, FIELD_LENGTH, FIELD_PAYLOAD) \
+	LAYOUT(USER_LOGIN, FIELD_STATUS) \
+	LAYOUT(USER_LOGOUT, FIELD_STATUS) \
+	LAYOUT(USER_JOIN, FIELD_ID, FIELD_USER_NAME) \
+	LAYOUT(USER_QUIT, FIELD_ID) \
+	LAYOUT(PROTOCOL_VERSION, FIELD_STATUS, FIELD_VERSION) \
+	LAYOUT(SYNC_BATCH, FIELD_REVISION, FIELD_OPERATIONS) \
+	LAYOUT(SYNC_SEQUENCE, FIELD_STATUS, FIELD_SITE, FIELD_REVISION, FIELD_SEQUENCE) \
+	LAYOUT(SYNC_MERGE, FIELD_REVISION, FIELD_SEQUENCE) \
+	LAYOUT(SESSION_TOKEN, FIELD_HASH) \
+	LAYOUT(SESSION_RESUME, FIELD_STATUS, FIELD_ID, FIELD_REVISION) \
+	LAYOUT(COMPRESSION, FIELD_STATUS, FIELD_COMPRESSION) \
+	LAYOUT(SYNC_COMPRESSED, FIELD_POSITION, FIELD_LENGTH, FIELD_PAYLOAD) \
+	LAYOUT(DOC_LIST_PAGE, FIELD_POSITION, FIELD_ID, FIELD_LENGTH, FIELD_DOC_ENTRIES) \
+	LAYOUT(DOC_LINE, FIELD_STATUS, FIELD_LINE, FIELD_POSITION, FIELD_LENGTH) \
+	LAYOUT(DOC_VIEWPORT, FIELD_STATUS, FIELD_REVISION, FIELD_POSITION, FIELD_LENGTH, \
+		FIELD_PAYLOAD) \
+	LAYOUT(SYNC_RESIZE, FIELD_REVISION, FIELD_POSITION, FIELD_LENGTH, FIELD_INSERTED) \
+	LAYOUT(DOC_SEARCH, FIELD_STATUS, FIELD_POSITION, FIELD_ID, FIELD_LENGTH, FIELD_DOC_ENTRIES) \
+	LAYOUT(DOC_REPLACE, FIELD_STATUS, FIELD_REVISION, FIELD_LENGTH) \
+	LAYOUT(DOC_REPLACE_REGEX, FIELD_STATUS, FIELD_REVISION, FIELD_LENGTH) \
+	LAYOUT(DOC_CLOSE, FIELD_STATUS, FIELD_ID)
+
+#endif
@@ -61,9 +61,31 @@ NetworkInterface::NetworkInterface(int port, int backlog)
 NetworkInterface::~NetworkInterface(void)
 { instance = NULL; }
 
+void NetworkInterface::HandlerEntry::operator()(const MessageBatch &batch) const
+{
+	if (batch_handler != NULL)
+	{
+		batch_handler(batch);
+		return;
+	}
+
+	for (const Message *message: batch.get_messages())
+	{ message_handler(*message); }
+}
+
+void NetworkInterface::add_batch_handler(const NetworkBatchHandler handler)
+{
+	message_handlers.push_front(HandlerEntry{handler, NULL});
+
+	// send initialization message
+	Message dummy_message;
+	dummy_message.type = Message::MessageType::TYPE_INIT;
+	handler(MessageBatch(dummy_message));
+}
+
 void NetworkInterface::add_message_handler(const NetworkMessageHandler handler)
 {
-	message_handlers.push_front(handler);
+	message_handlers.push_front(HandlerEntry{NULL, handler});
 
 	// send initialization message
 	Message dummy_message;
@@ -71,24 +93,43 @@ void NetworkInterface::add_message_handler(const NetworkMessageHandler handler)
 	handler(dummy_message);
 }
 
-void NetworkInterface::broadcast_message(const Message &message, int32_t document_id) const
-{ message.send_to(clients, document_id); }
+void NetworkInterface::broadcast_message(const Message &message, int32_t document_id,
+	ClientFilter filter) const
+{ message.send_to(clients, document_id, filter); }
 
 void NetworkInterface::disconnect_client(Client &client)
 {
 	Message dummy_message;
 	dummy_message.type = Message::MessageType::TYPE_CLIENT_DISCONNECT;
-	dummy_message.source = ClientSptr(&client);
+	// the client is owned by the collection, the message must not delete it
+	dummy_message.source = ClientSptr(ClientSptr(), &client);
 
-	for (NetworkMessageHandler handler: message_handlers)
-	{ handler(dummy_message); }
+	dispatch(MessageBatch(dummy_message));
 
 	clients.disconnect_client(client);
 }
 
+void NetworkInterface::dispatch(const MessageBatch &batch) const
+{
+	for (const HandlerEntry &handler: message_handlers)
+	{ handler(batch); }
+}
+
+void NetworkInterface::remove_batch_handler(const NetworkBatchHandler handler)
+{
+	message_handlers.remove_if([handler](const HandlerEntry &entry)
+		{ return entry.batch_handler == handler; });
+
+	// send exiting message
+	Message dummy_message;
+	dummy_message.type = Message::MessageType::TYPE_EXIT;
+	handler(MessageBatch(dummy_message));
+}
+
 void NetworkInterface::remove_message_handler(const NetworkMessageHandler handler)
 {
-	message_handlers.remove(handler);
+	message_handlers.remove_if([handler](const HandlerEntry &entry)
+		{ return entry.message_handler == handler; });
 
 	// send exiting message
 	Message dummy_message;
@@ -103,22 +144,27 @@ void NetworkInterface::run(int ipc_socket)
 	while (!ipc_required)
 	{
 		// generate fd_set
-		fd_set set;
+		fd_set set, pending_set;
 		FD_ZERO(&set);
+		FD_ZERO(&pending_set);
 		FD_SET(this->listener, &set);
 		FD_SET(ipc_socket, &set);
 
 		int end = std::max(this->listener, this->clients.fill_fd_set(&set));
+		end = std::max(end, this->clients.fill_pending_fd_set(&pending_set));
 		end = std::max(end, ipc_socket);
 		end += 1;
 
 		// select
-		int selected_amount = select(end, &set, 0, 0, 0);
+		int selected_amount = select(end, &set, &pending_set, 0, 0);
 		if (selected_amount == -1)
 		{
 			throw Exception::ErrnoError("select failed", "select");
 		}
 
+		// continue queued transfers of clients that can take more data
+		selected_amount -= this->clients.send_pending_by_fd_set(&pending_set, end);
+
 		// check for incoming client connections
 		if (selected_amount == 0)
 		{ continue; }
@@ -151,20 +197,30 @@ void NetworkInterface::run(int ipc_socket)
 		MessageList messages(selected_amount);
 		this->clients.get_messages_by_fd_set(&set, end, messages);
 
-		// process received messages
+		// collect received messages into one batch
+		MessageBatch batch;
 		for (const Message &message: messages)
 		{
 			// skip if message is empty or invalid
 			if (message.is_empty() || message.type == Message::MessageType::TYPE_INVALID)
 			{ continue; }
 
-			// trigger events for all event handlers
-			for (const NetworkMessageHandler &handler: message_handlers)
-			{ handler(message); }
+			batch.add(message);
 		}
+
+		// trigger events for all event handlers
+		if (!batch.empty())
+		{ dispatch(batch); }
 	}
 }
 
-void NetworkInterface::update_client_cursors(int32_t start, int32_t addend,
+void NetworkInterface::update_client_cursors(int64_t start, int64_t addend,
 	int32_t document_id)
 { clients.update_cursors(start, addend, document_id); }
+
+void NetworkInterface::update_client_cursors(const EditOperations &operations,
+	int32_t document_id)
+{ clients.update_cursors(operations, document_id); }
+
+uint8_t NetworkInterface::get_min_protocol_version(int32_t document_id) const
+{ return clients.get_min_protocol_version(document_id); }
@@ -11,8 +11,10 @@
 #include <vector>
 
 #include "ClientCollection.h"
+#include "MessageBatch.h"
 
 typedef void (*NetworkMessageHandler)(const Message &); ///< NetworkMessageHandler type
+typedef void (*NetworkBatchHandler)(const MessageBatch &); ///< NetworkBatchHandler type
 
 /**
 	@brief Main network interface class. All the fancy stuff happens here.
@@ -54,6 +56,18 @@ class NetworkInterface
 		NetworkInterface(int port, int backlog = 4);
 		~NetworkInterface(void); //< Standard destructor.
 		
+		/**
+			Adds a batch handler to this NetworkInterface. Each added handler will get called once
+			per event loop iteration with all Messages received in that iteration.
+			The given handler will be added to the list regardless of whether it's already there or
+			not. Batch handlers and message handlers share one list, thus the invocation order is
+			the same as described for add_message_handler(const NetworkMessageHandler).
+
+			@param handler the NetworkBatchHandler to add
+
+			@see add_message_handler(const NetworkMessageHandler)
+		**/
+		void add_batch_handler(const NetworkBatchHandler handler);
 		/**
 			Adds a message handler to this NetworkInterface. Each added handler will get called for
 			each received Message.
@@ -72,17 +86,26 @@ class NetworkInterface
 			@param document_id an optional constraint causing the bytestream to be sent only to all
 				clients whose active document id is equal to the valueof this argument; the default
 				is 0, which means that the bytestream should be sent to all clients
+			@param filter an optional constraint, see
+				ClientCollection::broadcast(const Message&, int32_t, ClientFilter)
 			
-			@note Calls Message::send_to(const ClientCollection&, int32_t) without catching any
-				exceptions.
-			@see Message::send_to(const ClientCollection&, int32_t)
+			@note Calls Message::send_to(const ClientCollection&, int32_t, ClientFilter) without
+				catching any exceptions.
+			@see Message::send_to(const ClientCollection&, int32_t, ClientFilter)
 		**/
-		void broadcast_message(const Message &message, int32_t document_id = 0) const;
+		void broadcast_message(const Message &message, int32_t document_id = 0,
+			ClientFilter filter = nullptr) const;
 		/**
 			Disconnects a client.
 			@param client a reference to the Client to disconnect
 		**/
 		void disconnect_client(Client &client);
+		/**
+			Removes all occurrences of the specified batch handler from this' handler list.
+
+			@param handler the handler to remove
+		**/
+		void remove_batch_handler(const NetworkBatchHandler handler);
 		/**
 			Removes all occurrences of the specified handler from this' handler list.
 			
@@ -104,17 +127,57 @@ class NetworkInterface
 		/**
 			Updates the clients' cursor positions.
 			@note This method just forwards to
-				ClientCollection::update_cursors(int32_t, int32_t, int32_t).
-			@see ClientCollection::update_cursors(int32_t, int32_t, int32_t)
+				ClientCollection::update_cursors(int64_t, int64_t, int32_t).
+			@see ClientCollection::update_cursors(int64_t, int64_t, int32_t)
+		**/
+		void update_client_cursors(int64_t start, int64_t addend, int32_t document_id);
+		/**
+			Updates the clients' cursor positions once for a sequence of operations.
+			@note This method just forwards to
+				ClientCollection::update_cursors(const EditOperations&, int32_t).
+			@see ClientCollection::update_cursors(const EditOperations&, int32_t)
 		**/
-		void update_client_cursors(int32_t start, int32_t addend, int32_t document_id);
+		void update_client_cursors(const EditOperations &operations, int32_t document_id);
+		/**
+			Determines the lowest protocol version of the clients having a document active.
+			@note This method just forwards to
+				ClientCollection::get_min_protocol_version(int32_t).
+			@see ClientCollection::get_min_protocol_version(int32_t)
+		**/
+		uint8_t get_min_protocol_version(int32_t document_id) const;
 	
 	private:
+		/**
+			@brief Adapter that lets batch handlers and per-message handlers share one list.
+
+			Exactly one of the two handler pointers is set. A per-message handler gets called once
+			for each Message of a batch in arrival order.
+		**/
+		struct HandlerEntry
+		{
+			NetworkBatchHandler		batch_handler; ///< batch handler or NULL
+			NetworkMessageHandler	message_handler; ///< per-message handler or NULL
+
+			/**
+				Invokes the wrapped handler with the given batch.
+
+				@param batch a reference to the MessageBatch to pass on
+			**/
+			void operator()(const MessageBatch &batch) const;
+		};
+
 		static NetworkInterface						*instance; ///< holds this' current instance
 
 		ClientCollection							 clients; ///< connected clients
 		int											 listener; ///< listener socket
-		std::forward_list<NetworkMessageHandler>	 message_handlers; ///< message handlers
+		std::forward_list<HandlerEntry>				 message_handlers; ///< message handlers
+
+		/**
+			Passes a batch to all handlers in this' handler list.
+
+			@param batch a reference to the MessageBatch to dispatch
+		**/
+		void dispatch(const MessageBatch &batch) const;
 };
 
 #endif
@@ -0,0 +1,1129 @@
+#include "RegexSearch.h"
+
+#include <algorithm>
+#include <limits>
+
+/**
+ * @file server/RegexSearch.cpp
+ *
+ * Implementation file for the search of regular expressions within text.
+ */
+
+namespace regexsearch_errors
+{
+	PatternError::PatternError(std::string const &message)
+		: std::runtime_error("regular expression error: " + message)
+	{
+	}
+
+	InvalidPatternError::InvalidPatternError(std::string const &message)
+		: PatternError(message)
+	{
+	}
+
+	TooComplexError::TooComplexError(std::string const &message)
+		: PatternError(message)
+	{
+	}
+}
+
+namespace
+{
+	//! the largest bound of a counted quantifier such as "{2,5}"
+	int const MAX_REPETITIONS = 1000;
+	//! the most steps of a search, however long the text is
+	std::size_t const MAX_STEPS = std::size_t(1) << 30;
+
+	/**
+	 * Check whether a byte belongs to a word, as "\w" does.
+	 *
+	 * @param byte The byte.
+	 * @return Whether it is a letter, a digit or '_'.
+	 */
+	bool is_word(char byte)
+	{
+		return (byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') ||
+		       (byte >= '0' && byte <= '9') || byte == '_';
+	}
+
+	/**
+	 * Get the value of a hexadecimal digit.
+	 *
+	 * @param digit The digit.
+	 * @return Its value, -1 if it isn't a hexadecimal digit.
+	 */
+	int hex_value(char digit)
+	{
+		if (digit >= '0' && digit <= '9')
+		{
+			return digit - '0';
+		}
+		if (digit >= 'a' && digit <= 'f')
+		{
+			return digit - 'a' + 10;
+		}
+		if (digit >= 'A' && digit <= 'F')
+		{
+			return digit - 'A' + 10;
+		}
+
+		return -1;
+	}
+}
+
+/**
+ * A parsed pattern or a part of it.
+ */
+struct RegexSearch::Node
+{
+	/**
+	 * The kinds of nodes.
+	 */
+	enum class Kind
+	{
+		KIND_SET, ///< a byte of a set
+		KIND_ASSERT, ///< a zero width assertion
+		KIND_GROUP, ///< a capturing group of the only child
+		KIND_CONCAT, ///< the children one after the other
+		KIND_ALTERNATE, ///< one of the children, the first one preferred
+		KIND_REPEAT ///< the only child repeated
+	};
+
+	//! the kind of the node
+	Kind kind;
+	//! the set, assertion or group, depending on the kind
+	std::int32_t value;
+	//! the least repetitions
+	int min;
+	//! the most repetitions, -1 for no limit
+	int max;
+	//! whether as many repetitions as possible are preferred
+	bool greedy;
+	//! the operands
+	std::vector<Node> children;
+
+	/**
+	 * Construct a node without operands.
+	 *
+	 * @param kind The kind of the node.
+	 * @param value The set, assertion or group.
+	 */
+	explicit Node(Kind kind, std::int32_t value = 0)
+		: kind(kind), value(value), min(1), max(1), greedy(true)
+	{
+	}
+};
+
+/**
+ * A recursive descent parser of patterns. The depth of the recursion is
+ * bounded by the nesting of groups, hence by MAX_PATTERN_SIZE.
+ */
+class RegexSearch::Parser
+{
+public:
+	/**
+	 * Construct a parser of a pattern.
+	 *
+	 * @param pattern The pattern.
+	 * @param search The search receiving the byte sets and groups.
+	 */
+	Parser(std::string const &pattern, RegexSearch &search)
+		: position_(pattern.data()), end_(pattern.data() + pattern.size()), search_(search)
+	{
+	}
+
+	/**
+	 * Parse the whole pattern.
+	 *
+	 * @return The parsed pattern.
+	 */
+	Node parse()
+	{
+		Node node = parse_alternate();
+
+		if (position_ != end_)
+		{
+			throw regexsearch_errors::InvalidPatternError("unmatched ')'");
+		}
+
+		return node;
+	}
+
+private:
+	/**
+	 * Parse alternatives separated by '|'.
+	 */
+	Node parse_alternate()
+	{
+		Node node = parse_concat();
+
+		if (position_ == end_ || *position_ != '|')
+		{
+			return node;
+		}
+
+		Node alternate(Node::Kind::KIND_ALTERNATE);
+		alternate.children.push_back(std::move(node));
+
+		while (position_ != end_ && *position_ == '|')
+		{
+			++position_;
+			alternate.children.push_back(parse_concat());
+		}
+
+		return alternate;
+	}
+
+	/**
+	 * Parse quantified atoms up to the end of an alternative.
+	 */
+	Node parse_concat()
+	{
+		Node concat(Node::Kind::KIND_CONCAT);
+
+		while (position_ != end_ && *position_ != '|' && *position_ != ')')
+		{
+			concat.children.push_back(parse_repeat());
+		}
+
+		return concat;
+	}
+
+	/**
+	 * Parse an atom and its quantifier, if any.
+	 */
+	Node parse_repeat()
+	{
+		Node atom = parse_atom();
+		int min, max;
+
+		if (!parse_quantifier(min, max))
+		{
+			return atom;
+		}
+
+		if (atom.kind == Node::Kind::KIND_ASSERT)
+		{
+			throw regexsearch_errors::InvalidPatternError("nothing to repeat");
+		}
+
+		Node repeat(Node::Kind::KIND_REPEAT);
+		repeat.min = min;
+		repeat.max = max;
+
+		if (position_ != end_ && *position_ == '?')
+		{
+			++position_;
+			repeat.greedy = false;
+		}
+
+		repeat.children.push_back(std::move(atom));
+
+		return repeat;
+	}
+
+	/**
+	 * Parse a quantifier.
+	 *
+	 * @param min Set to the least repetitions.
+	 * @param max Set to the most repetitions, -1 for no limit.
+	 * @return Whether there is a quantifier.
+	 */
+	bool parse_quantifier(int &min, int &max)
+	{
+		if (position_ == end_)
+		{
+			return false;
+		}
+
+		switch (*position_)
+		{
+		case '*':
+			min = 0;
+			max = -1;
+			break;
+		case '+':
+			min = 1;
+			max = -1;
+			break;
+		case '?':
+			min = 0;
+			max = 1;
+			break;
+		case '{':
+			++position_;
+			min = parse_number();
+			max = min;
+
+			if (position_ != end_ && *position_ == ',')
+			{
+				++position_;
+				max = (position_ != end_ && *position_ == '}') ? -1 : parse_number();
+			}
+
+			if (position_ == end_ || *position_ != '}' || (max != -1 && max < min))
+			{
+				throw regexsearch_errors::InvalidPatternError("invalid quantifier");
+			}
+			break;
+		default:
+			return false;
+		}
+
+		++position_;
+
+		return true;
+	}
+
+	/**
+	 * Parse the decimal bound of a counted quantifier.
+	 */
+	int parse_number()
+	{
+		if (position_ == end_ || *position_ < '0' || *position_ > '9')
+		{
+			throw regexsearch_errors::InvalidPatternError("invalid quantifier");
+		}
+
+		int number = 0;
+
+		for (; position_ != end_ && *position_ >= '0' && *position_ <= '9'; ++position_)
+		{
+			number = number * 10 + (*position_ - '0');
+
+			if (number > MAX_REPETITIONS)
+			{
+				throw regexsearch_errors::TooComplexError("too many repetitions");
+			}
+		}
+
+		return number;
+	}
+
+	/**
+	 * Parse a group, a class, an escape sequence or a literal byte.
+	 */
+	Node parse_atom()
+	{
+		char const byte = *position_++;
+
+		switch (byte)
+		{
+		case '(':
+		{
+			bool capture = true;
+
+			if (position_ != end_ && *position_ == '?')
+			{
+				if (end_ - position_ < 2 || position_[1] != ':')
+				{
+					throw regexsearch_errors::InvalidPatternError("lookarounds aren't supported");
+				}
+
+				position_ += 2;
+				capture = false;
+			}
+
+			std::int32_t const group = capture ? ++search_.groups_ : 0;
+			Node node = parse_alternate();
+
+			if (position_ == end_ || *position_ != ')')
+			{
+				throw regexsearch_errors::InvalidPatternError("unmatched '('");
+			}
+
+			++position_;
+
+			if (!capture)
+			{
+				return node;
+			}
+
+			Node group_node(Node::Kind::KIND_GROUP, group);
+			group_node.children.push_back(std::move(node));
+
+			return group_node;
+		}
+		case '[':
+			return parse_class();
+		case '.':
+		{
+			std::bitset<256> set;
+			set.set();
+			set.reset('\n');
+			set.reset('\r');
+
+			return add_set(set);
+		}
+		case '^':
+			return Node(Node::Kind::KIND_ASSERT,
+			            static_cast<std::int32_t>(Assertion::ASSERTION_BEGIN));
+		case '$':
+			return Node(Node::Kind::KIND_ASSERT, static_cast<std::int32_t>(Assertion::ASSERTION_END));
+		case '\\':
+			return parse_escape();
+		case '*':
+		case '+':
+		case '?':
+		case '{':
+			throw regexsearch_errors::InvalidPatternError("nothing to repeat");
+		default:
+		{
+			std::bitset<256> set;
+			set.set(static_cast<unsigned char>(byte));
+
+			return add_set(set);
+		}
+		}
+	}
+
+	/**
+	 * Parse an escape sequence outside of a class, the '\' already consumed.
+	 */
+	Node parse_escape()
+	{
+		if (position_ == end_)
+		{
+			throw regexsearch_errors::InvalidPatternError("trailing '\\'");
+		}
+
+		switch (*position_)
+		{
+		case 'b':
+			++position_;
+			return Node(Node::Kind::KIND_ASSERT,
+			            static_cast<std::int32_t>(Assertion::ASSERTION_WORD_BOUNDARY));
+		case 'B':
+			++position_;
+			return Node(Node::Kind::KIND_ASSERT,
+			            static_cast<std::int32_t>(Assertion::ASSERTION_NOT_WORD_BOUNDARY));
+		default:
+		{
+			std::bitset<256> set;
+			parse_class_escape(set);
+
+			return add_set(set);
+		}
+		}
+	}
+
+	/**
+	 * Parse an escape sequence standing for bytes, the '\' already consumed.
+	 *
+	 * @param set The set to add the bytes to.
+	 * @return Whether the escape sequence stands for a single byte.
+	 */
+	bool parse_class_escape(std::bitset<256> &set)
+	{
+		char const byte = *position_++;
+		std::bitset<256> escaped;
+
+		switch (byte)
+		{
+		case 'd':
+		case 'D':
+			for (char digit = '0'; digit <= '9'; digit++)
+			{
+				escaped.set(digit);
+			}
+			break;
+		case 'w':
+		case 'W':
+			for (int other = 0; other < 256; other++)
+			{
+				escaped.set(other, is_word(static_cast<char>(other)));
+			}
+			break;
+		case 's':
+		case 'S':
+			for (char space: { ' ', '\t', '\n', '\v', '\f', '\r' })
+			{
+				escaped.set(space);
+			}
+			break;
+		case 'n':
+			set.set('\n');
+			return true;
+		case 'r':
+			set.set('\r');
+			return true;
+		case 't':
+			set.set('\t');
+			return true;
+		case 'f':
+			set.set('\f');
+			return true;
+		case 'v':
+			set.set('\v');
+			return true;
+		case '0':
+			set.set(0);
+			return true;
+		case 'x':
+		{
+			int const high = end_ - position_ >= 2 ? hex_value(position_[0]) : -1;
+			int const low = high != -1 ? hex_value(position_[1]) : -1;
+
+			if (low == -1)
+			{
+				throw regexsearch_errors::InvalidPatternError("invalid '\\x' escape");
+			}
+
+			position_ += 2;
+			set.set(high * 16 + low);
+			return true;
+		}
+		default:
+			if (byte >= '1' && byte <= '9')
+			{
+				throw regexsearch_errors::InvalidPatternError("back references aren't supported");
+			}
+			if (is_word(byte))
+			{
+				throw regexsearch_errors::InvalidPatternError("invalid escape");
+			}
+
+			set.set(static_cast<unsigned char>(byte));
+			return true;
+		}
+
+		// the upper case escapes are the complement
+		set |= (byte >= 'A' && byte <= 'Z') ? ~escaped : escaped;
+
+		return false;
+	}
+
+	/**
+	 * Parse a class, the '[' already consumed.
+	 */
+	Node parse_class()
+	{
+		std::bitset<256> set;
+		bool const negated = position_ != end_ && *position_ == '^';
+
+		if (negated)
+		{
+			++position_;
+		}
+
+		while (position_ != end_ && *position_ != ']')
+		{
+			int first = parse_class_byte(set);
+
+			if (first == -1 || end_ - position_ < 2 || *position_ != '-' || position_[1] == ']')
+			{
+				if (first != -1)
+				{
+					set.set(first);
+				}
+				continue;
+			}
+
+			++position_;
+			int const last = parse_class_byte(set);
+
+			if (last == -1 || last < first)
+			{
+				throw regexsearch_errors::InvalidPatternError("invalid range");
+			}
+
+			for (; first <= last; first++)
+			{
+				set.set(first);
+			}
+		}
+
+		if (position_ == end_)
+		{
+			throw regexsearch_errors::InvalidPatternError("unmatched '['");
+		}
+
+		++position_;
+
+		return add_set(negated ? ~set : set);
+	}
+
+	/**
+	 * Parse a byte or an escape sequence within a class.
+	 *
+	 * @param set The set to add the bytes of an escape sequence like "\d" to.
+	 * @return The byte, -1 if the escape sequence stands for several bytes.
+	 */
+	int parse_class_byte(std::bitset<256> &set)
+	{
+		char const byte = *position_++;
+
+		if (byte != '\\')
+		{
+			return static_cast<unsigned char>(byte);
+		}
+
+		if (position_ == end_)
+		{
+			throw regexsearch_errors::InvalidPatternError("trailing '\\'");
+		}
+
+		// within a class "\b" is a backspace
+		if (*position_ == 'b')
+		{
+			++position_;
+			return '\b';
+		}
+
+		std::bitset<256> escaped;
+
+		if (!parse_class_escape(escaped))
+		{
+			set |= escaped;
+			return -1;
+		}
+
+		for (int byte = 0; byte < 256; byte++)
+		{
+			if (escaped[byte])
+			{
+				return byte;
+			}
+		}
+
+		return -1;
+	}
+
+	/**
+	 * Store a byte set.
+	 *
+	 * @param set The set.
+	 * @return A node of the set.
+	 */
+	Node add_set(std::bitset<256> const &set)
+	{
+		search_.sets_.push_back(set);
+
+		return Node(Node::Kind::KIND_SET, search_.sets_.size() - 1);
+	}
+
+	//! the next byte of the pattern
+	char const *position_;
+	//! the end of the pattern
+	char const *end_;
+	//! the search receiving the byte sets and groups
+	RegexSearch &search_;
+};
+
+/**
+ * The threads of the Pike VM at one position, each instruction at most
+ * once, in the order of their priority.
+ */
+class RegexSearch::ThreadList
+{
+public:
+	/**
+	 * A frame of the explicit stack of add_thread().
+	 */
+	struct Frame
+	{
+		//! the instruction to continue at, -1 to restore a capture
+		std::int32_t pc;
+		//! the capture to restore
+		std::int32_t slot;
+		//! the value to restore the capture to
+		std::int64_t value;
+	};
+
+	/**
+	 * Construct an empty list.
+	 *
+	 * @param program_size The amount of instructions.
+	 * @param slots The amount of captures of each thread.
+	 */
+	ThreadList(std::size_t program_size, std::size_t slots)
+		: captures(slots), slots_(slots), sparse_(program_size)
+	{
+	}
+
+	/**
+	 * Mark an instruction as visited at this position.
+	 *
+	 * @param pc The instruction.
+	 * @return Whether it wasn't visited yet.
+	 */
+	bool visit(std::int32_t pc)
+	{
+		std::size_t const index = sparse_[pc];
+
+		if (index < visited_.size() && visited_[index] == pc)
+		{
+			return false;
+		}
+
+		sparse_[pc] = visited_.size();
+		visited_.push_back(pc);
+
+		return true;
+	}
+
+	/**
+	 * Append a thread.
+	 *
+	 * @param pc The instruction it waits at.
+	 * @param captures Its captures.
+	 */
+	void append(std::int32_t pc, std::vector<std::int64_t> const &captures)
+	{
+		pcs_.push_back(pc);
+		captures_.insert(captures_.end(), captures.begin(), captures.end());
+	}
+
+	/**
+	 * Remove all threads.
+	 */
+	void clear()
+	{
+		visited_.clear();
+		pcs_.clear();
+		captures_.clear();
+	}
+
+	/**
+	 * Get the amount of threads.
+	 */
+	std::size_t size() const
+	{
+		return pcs_.size();
+	}
+
+	/**
+	 * Get the instruction a thread waits at.
+	 */
+	std::int32_t get_pc(std::size_t thread) const
+	{
+		return pcs_[thread];
+	}
+
+	/**
+	 * Get the first capture of a thread.
+	 */
+	std::int64_t const *get_captures(std::size_t thread) const
+	{
+		return captures_.data() + thread * slots_;
+	}
+
+	//! the stack of add_thread(), kept to reuse its memory
+	std::vector<Frame> stack;
+	//! the captures of the thread add_thread() follows, kept to reuse their memory
+	std::vector<std::int64_t> captures;
+
+private:
+	//! the amount of captures of each thread
+	std::size_t slots_;
+	//! the index within visited_ of each instruction, if it is visited
+	std::vector<std::size_t> sparse_;
+	//! the visited instructions
+	std::vector<std::int32_t> visited_;
+	//! the instructions the threads wait at
+	std::vector<std::int32_t> pcs_;
+	//! the captures of the threads, one after the other
+	std::vector<std::int64_t> captures_;
+};
+
+std::size_t const RegexSearch::MAX_PATTERN_SIZE;
+std::size_t const RegexSearch::MAX_PROGRAM_SIZE;
+std::size_t const RegexSearch::MAX_STEPS_PER_BYTE;
+
+std::int64_t RegexSearch::Match::get_position() const
+{
+	return captures[0];
+}
+
+std::int64_t RegexSearch::Match::get_length() const
+{
+	return captures[1] - captures[0];
+}
+
+RegexSearch::RegexSearch(std::string const &pattern)
+	: groups_(0), skips_(false)
+{
+	if (pattern.empty())
+	{
+		throw regexsearch_errors::InvalidPatternError("empty pattern");
+	}
+
+	if (pattern.size() > MAX_PATTERN_SIZE)
+	{
+		throw regexsearch_errors::TooComplexError("pattern too long");
+	}
+
+	Node const node = Parser(pattern, *this).parse();
+
+	append(Opcode::OPCODE_SAVE, 0);
+	emit(node);
+	append(Opcode::OPCODE_SAVE, 1);
+	append(Opcode::OPCODE_MATCH);
+
+	find_first_bytes();
+}
+
+std::vector<RegexSearch::Match> RegexSearch::find_all(char const *begin, char const *end) const
+{
+	std::int64_t const size = end - begin;
+	std::size_t steps = std::min(MAX_STEPS, MAX_STEPS_PER_BYTE * (size + 1));
+	std::size_t const slots = (groups_ + 1) * 2;
+	ThreadList first(program_.size(), slots), second(program_.size(), slots);
+	std::vector<Match> matches;
+	Match match;
+
+	for (std::int64_t start = 0;
+	     start <= size && search(begin, end, begin + start, match, steps, first, second);)
+	{
+		// continue behind an empty occurrence, it would be found again
+		start = match.captures[1] + (match.get_length() == 0 ? 1 : 0);
+		matches.push_back(std::move(match));
+	}
+
+	return matches;
+}
+
+std::vector<char> RegexSearch::format(Match const &match, char const *begin, char const *end,
+                                      std::vector<char> const &format) const
+{
+	std::vector<char> result;
+	auto append_range = [&result, begin](std::int64_t first, std::int64_t last)
+	{
+		if (first != -1)
+		{
+			result.insert(result.end(), begin + first, begin + last);
+		}
+	};
+
+	for (std::size_t i = 0; i < format.size(); i++)
+	{
+		char const next = i + 1 < format.size() ? format[i + 1] : '\0';
+
+		if (format[i] != '$' || next == '\0')
+		{
+			result.push_back(format[i]);
+			continue;
+		}
+
+		switch (next)
+		{
+		case '$':
+			result.push_back('$');
+			break;
+		case '&':
+			append_range(match.captures[0], match.captures[1]);
+			break;
+		case '`':
+			append_range(0, match.captures[0]);
+			break;
+		case '\'':
+			append_range(match.captures[1], end - begin);
+			break;
+		default:
+		{
+			std::size_t group = next >= '0' && next <= '9' ? next - '0' : 0;
+			char const second = i + 2 < format.size() ? format[i + 2] : '\0';
+
+			if (group == 0 || group > groups_)
+			{
+				result.push_back('$');
+				continue;
+			}
+
+			// two digits refer to a group if there are that many
+			if (second >= '0' && second <= '9' && group * 10 + (second - '0') <= groups_)
+			{
+				group = group * 10 + (second - '0');
+				i++;
+			}
+
+			append_range(match.captures[group * 2], match.captures[group * 2 + 1]);
+			break;
+		}
+		}
+
+		i++;
+	}
+
+	return result;
+}
+
+void RegexSearch::emit(Node const &node)
+{
+	switch (node.kind)
+	{
+	case Node::Kind::KIND_SET:
+		append(Opcode::OPCODE_SET, node.value);
+		break;
+	case Node::Kind::KIND_ASSERT:
+		append(Opcode::OPCODE_ASSERT, node.value);
+		break;
+	case Node::Kind::KIND_GROUP:
+		append(Opcode::OPCODE_SAVE, node.value * 2);
+		emit(node.children.front());
+		append(Opcode::OPCODE_SAVE, node.value * 2 + 1);
+		break;
+	case Node::Kind::KIND_CONCAT:
+		for (Node const &child: node.children)
+		{
+			emit(child);
+		}
+		break;
+	case Node::Kind::KIND_ALTERNATE:
+	{
+		std::vector<std::int32_t> jumps;
+
+		for (std::size_t i = 0; i + 1 < node.children.size(); i++)
+		{
+			std::int32_t const split = append(Opcode::OPCODE_SPLIT);
+			program_[split].x = split + 1;
+			emit(node.children[i]);
+			jumps.push_back(append(Opcode::OPCODE_JUMP));
+			program_[split].y = program_.size();
+		}
+
+		emit(node.children.back());
+
+		for (std::int32_t jump: jumps)
+		{
+			program_[jump].x = program_.size();
+		}
+		break;
+	}
+	case Node::Kind::KIND_REPEAT:
+	{
+		Node const &child = node.children.front();
+
+		for (int i = 0; i < node.min; i++)
+		{
+			emit(child);
+		}
+
+		// the preferred target of a split is x, continuing the repetition if greedy
+		std::vector<std::int32_t> splits;
+
+		for (int i = node.min; i != node.max; i++)
+		{
+			std::int32_t const split = append(Opcode::OPCODE_SPLIT);
+			emit(child);
+			splits.push_back(split);
+
+			if (node.max == -1)
+			{
+				append(Opcode::OPCODE_JUMP, split);
+				break;
+			}
+		}
+
+		for (std::int32_t split: splits)
+		{
+			std::int32_t const body = split + 1;
+			std::int32_t const out = program_.size();
+
+			program_[split].x = node.greedy ? body : out;
+			program_[split].y = node.greedy ? out : body;
+		}
+		break;
+	}
+	}
+}
+
+void RegexSearch::find_first_bytes()
+{
+	std::vector<bool> visited(program_.size());
+	std::vector<std::int32_t> stack(1, 0);
+
+	// the instructions reached without consuming a byte, assertions taken to hold
+	while (!stack.empty())
+	{
+		std::int32_t const pc = stack.back();
+		stack.pop_back();
+
+		if (visited[pc])
+		{
+			continue;
+		}
+
+		visited[pc] = true;
+		Instruction const &instruction = program_[pc];
+
+		switch (instruction.opcode)
+		{
+		case Opcode::OPCODE_SET:
+			first_bytes_ |= sets_[instruction.x];
+			break;
+		case Opcode::OPCODE_SPLIT:
+			stack.push_back(instruction.y);
+			stack.push_back(instruction.x);
+			break;
+		case Opcode::OPCODE_JUMP:
+			stack.push_back(instruction.x);
+			break;
+		case Opcode::OPCODE_SAVE:
+		case Opcode::OPCODE_ASSERT:
+			stack.push_back(pc + 1);
+			break;
+		case Opcode::OPCODE_MATCH:
+			// the empty string matches, every position has an occurrence
+			return;
+		}
+	}
+
+	skips_ = true;
+}
+
+std::int32_t RegexSearch::append(Opcode opcode, std::int32_t x, std::int32_t y)
+{
+	if (program_.size() >= MAX_PROGRAM_SIZE)
+	{
+		throw regexsearch_errors::TooComplexError("pattern compiles to too many instructions");
+	}
+
+	program_.push_back(Instruction{ opcode, x, y });
+
+	return program_.size() - 1;
+}
+
+void RegexSearch::add_thread(ThreadList &list, std::int32_t pc,
+                             std::vector<std::int64_t> &captures, char const *begin,
+                             char const *end, char const *position, std::size_t &steps) const
+{
+	std::vector<ThreadList::Frame> &stack = list.stack;
+	stack.push_back(ThreadList::Frame{ pc, 0, 0 });
+
+	while (!stack.empty())
+	{
+		ThreadList::Frame const frame = stack.back();
+		stack.pop_back();
+
+		if (frame.pc == -1)
+		{
+			captures[frame.slot] = frame.value;
+			continue;
+		}
+
+		// follow the thread, deferring the less preferred targets of splits
+		for (std::int32_t next = frame.pc; next != -1 && list.visit(next);)
+		{
+			if (steps-- == 0)
+			{
+				stack.clear();
+				throw regexsearch_errors::TooComplexError("search takes too many steps");
+			}
+
+			std::int32_t const current = next;
+			Instruction const &instruction = program_[current];
+			next = -1;
+
+			switch (instruction.opcode)
+			{
+			case Opcode::OPCODE_JUMP:
+				next = instruction.x;
+				break;
+			case Opcode::OPCODE_SPLIT:
+				stack.push_back(ThreadList::Frame{ instruction.y, 0, 0 });
+				next = instruction.x;
+				break;
+			case Opcode::OPCODE_SAVE:
+				stack.push_back(ThreadList::Frame{ -1, instruction.x, captures[instruction.x] });
+				captures[instruction.x] = position - begin;
+				next = current + 1;
+				break;
+			case Opcode::OPCODE_ASSERT:
+			{
+				bool const after_word = position != begin && is_word(position[-1]);
+				bool const before_word = position != end && is_word(position[0]);
+				bool holds = false;
+
+				switch (static_cast<Assertion>(instruction.x))
+				{
+				case Assertion::ASSERTION_BEGIN:
+					holds = position == begin;
+					break;
+				case Assertion::ASSERTION_END:
+					holds = position == end;
+					break;
+				case Assertion::ASSERTION_WORD_BOUNDARY:
+					holds = after_word != before_word;
+					break;
+				case Assertion::ASSERTION_NOT_WORD_BOUNDARY:
+					holds = after_word == before_word;
+					break;
+				}
+
+				if (holds)
+				{
+					next = current + 1;
+				}
+				break;
+			}
+			case Opcode::OPCODE_SET:
+			case Opcode::OPCODE_MATCH:
+				list.append(current, captures);
+				break;
+			}
+		}
+	}
+}
+
+bool RegexSearch::search(char const *begin, char const *end, char const *start, Match &match,
+                         std::size_t &steps, ThreadList &first, ThreadList &second) const
+{
+	std::size_t const slots = (groups_ + 1) * 2;
+	ThreadList *current = &first, *next = &second;
+	std::vector<std::int64_t> &captures = first.captures;
+	bool matched = false;
+
+	first.clear();
+	second.clear();
+
+	for (char const *position = start; ; ++position)
+	{
+		// without threads, an occurrence can't start before a byte of first_bytes_
+		if (!matched && current->size() == 0 && skips_)
+		{
+			while (position != end && !first_bytes_[static_cast<unsigned char>(*position)])
+			{
+				++position;
+			}
+		}
+
+		// a thread starting here has the least priority, none is needed after a match
+		if (!matched)
+		{
+			std::fill(captures.begin(), captures.end(), -1);
+			add_thread(*current, 0, captures, begin, end, position, steps);
+		}
+
+		for (std::size_t thread = 0; thread < current->size(); thread++)
+		{
+			std::int32_t const pc = current->get_pc(thread);
+			Instruction const &instruction = program_[pc];
+			std::int64_t const *thread_captures = current->get_captures(thread);
+
+			// the threads of less priority can't win anymore
+			if (instruction.opcode == Opcode::OPCODE_MATCH)
+			{
+				match.captures.assign(thread_captures, thread_captures + slots);
+				matched = true;
+				break;
+			}
+
+			if (position != end && sets_[instruction.x][static_cast<unsigned char>(*position)])
+			{
+				captures.assign(thread_captures, thread_captures + slots);
+				add_thread(*next, pc + 1, captures, begin, end, position + 1, steps);
+			}
+		}
+
+		if (position == end || (matched && next->size() == 0))
+		{
+			break;
+		}
+
+		std::swap(current, next);
+		next->clear();
+	}
+
+	return matched;
+}
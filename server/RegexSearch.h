@@ -0,0 +1,286 @@
+#ifndef REGEXSEARCH_H_INCLUDED
+#define REGEXSEARCH_H_INCLUDED
+
+#include <bitset>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @file server/RegexSearch.h
+ *
+ * Interface for the search of regular expressions within text.
+ */
+
+namespace regexsearch_errors
+{
+	/**
+	 * A generic regular expression exception.
+	 * Specific errors derive from this class to create
+	 * an exception hierarchy.
+	 */
+	struct PatternError
+		: std::runtime_error
+	{
+		/**
+		 * Construct a new regular expression error with a specific error message.
+		 *
+		 * @param message The error message that describes the error.
+		 */
+		PatternError(std::string const &message);
+	};
+
+	/**
+	 * This exception occurs if a pattern isn't a regular expression
+	 * or uses a feature that isn't supported.
+	 */
+	struct InvalidPatternError
+		: PatternError
+	{
+		/**
+		 * Construct a new invalid pattern error with a specific error message.
+		 *
+		 * @param message The error message that describes the error.
+		 */
+		InvalidPatternError(std::string const &message);
+	};
+
+	/**
+	 * This exception occurs if a pattern compiles to too many instructions
+	 * or a search exceeds its budget of steps.
+	 */
+	struct TooComplexError
+		: PatternError
+	{
+		/**
+		 * Construct a new too complex error with a specific error message.
+		 *
+		 * @param message The error message that describes the error.
+		 */
+		TooComplexError(std::string const &message);
+	};
+}
+
+/**
+ * The search of a regular expression within text.
+ *
+ * The pattern is a subset of ECMAScript: literals, ".", classes such as
+ * "[a-z]" and "\d", "^" and "$" at the ends of the text, "\b", groups,
+ * alternatives and greedy or lazy quantifiers. Back references and
+ * lookarounds aren't supported.
+ *
+ * The pattern is compiled to a program that is run by a Pike VM, which
+ * advances all threads of the program in lockstep over the text instead of
+ * backtracking. The search neither recurses nor takes exponential time,
+ * each byte of the text costs at most one step per instruction. Both the
+ * program and the steps of a search are limited, see MAX_PROGRAM_SIZE and
+ * MAX_STEPS_PER_BYTE, so a pattern can't make a search arbitrarily slow.
+ *
+ * @startuml{RegexSearch_Class.svg}
+ * class RegexSearch {
+ * + {static} MAX_PATTERN_SIZE: size_t
+ * + {static} MAX_PROGRAM_SIZE: size_t
+ * + {static} MAX_STEPS_PER_BYTE: size_t
+ * + RegexSearch(pattern: string const &)
+ * + find_all(begin: char const *, end: char const *): vector<Match>
+ * + format(match: Match const &, begin: char const *, end: char const *, format: vector<char> const &): vector<char>
+ * - emit(node: Node const &)
+ * - find_first_bytes()
+ * - append(opcode: Opcode, x: int32_t, y: int32_t): int32_t
+ * - add_thread(list: ThreadList &, pc: int32_t, captures: vector<int64_t> &, begin: char const *, end: char const *, position: char const *, steps: size_t &)
+ * - search(begin: char const *, end: char const *, start: char const *, match: Match &, steps: size_t &, first: ThreadList &, second: ThreadList &): bool
+ * - program_: vector<Instruction>
+ * - sets_: vector<bitset<256>>
+ * - groups_: size_t
+ * - first_bytes_: bitset<256>
+ * - skips_: bool
+ * }
+ * @enduml
+ */
+class RegexSearch
+{
+public:
+	//! the longest pattern that is compiled
+	static std::size_t const MAX_PATTERN_SIZE = 256;
+	//! the most instructions a pattern may compile to
+	static std::size_t const MAX_PROGRAM_SIZE = 2048;
+	//! the steps a search may take per byte of the text
+	static std::size_t const MAX_STEPS_PER_BYTE = 64;
+
+	/**
+	 * An occurrence of the pattern.
+	 */
+	struct Match
+	{
+		//! the start and end of the occurrence and its groups, -1 for groups that didn't match
+		std::vector<std::int64_t> captures;
+
+		/**
+		 * Get the position of the occurrence.
+		 *
+		 * @return The offset of its first byte within the text.
+		 */
+		std::int64_t get_position() const;
+
+		/**
+		 * Get the length of the occurrence.
+		 *
+		 * @return The amount of bytes matched.
+		 */
+		std::int64_t get_length() const;
+	};
+
+	/**
+	 * Compile a pattern.
+	 *
+	 * @param pattern The regular expression.
+	 *
+	 * @throws regexsearch_errors::InvalidPatternError If the pattern is empty,
+	 *                                                 invalid or unsupported.
+	 * @throws regexsearch_errors::TooComplexError If the pattern is longer than
+	 *                                             MAX_PATTERN_SIZE or compiles to
+	 *                                             more than MAX_PROGRAM_SIZE instructions.
+	 */
+	explicit RegexSearch(std::string const &pattern);
+
+	/**
+	 * Find all occurrences of the pattern which don't overlap, searching from
+	 * the front. After an empty occurrence the search continues one byte
+	 * further.
+	 *
+	 * @param begin The first byte of the text.
+	 * @param end The end of the text.
+	 * @return The occurrences in the order of their positions.
+	 *
+	 * @throws regexsearch_errors::TooComplexError If the search takes more than
+	 *                                             MAX_STEPS_PER_BYTE steps per byte.
+	 */
+	std::vector<Match> find_all(char const *begin, char const *end) const;
+
+	/**
+	 * Generate the replacement of an occurrence. Like ECMAScript, the format
+	 * may refer to the occurrence by "$&", to its groups by "$1" to "$99", to
+	 * the text before and after it by "$`" and "$'"; "$$" is a single "$".
+	 *
+	 * @param match The occurrence, found within the text.
+	 * @param begin The first byte of the text.
+	 * @param end The end of the text.
+	 * @param format The format of the replacement.
+	 * @return The replacement.
+	 */
+	std::vector<char> format(Match const &match, char const *begin, char const *end,
+	                         std::vector<char> const &format) const;
+
+private:
+	/**
+	 * The operations of the program.
+	 */
+	enum class Opcode
+	{
+		OPCODE_SET, ///< consume a byte of the set
+		OPCODE_SPLIT, ///< continue at both targets, the first one preferred
+		OPCODE_JUMP, ///< continue at the target
+		OPCODE_SAVE, ///< store the position in a capture
+		OPCODE_ASSERT, ///< continue if the assertion holds at the position
+		OPCODE_MATCH ///< the pattern matched
+	};
+
+	/**
+	 * The zero width assertions.
+	 */
+	enum class Assertion
+	{
+		ASSERTION_BEGIN, ///< the start of the text
+		ASSERTION_END, ///< the end of the text
+		ASSERTION_WORD_BOUNDARY, ///< between a word and a non word byte
+		ASSERTION_NOT_WORD_BOUNDARY ///< not between a word and a non word byte
+	};
+
+	/**
+	 * An instruction of the program.
+	 */
+	struct Instruction
+	{
+		//! the operation
+		Opcode opcode;
+		//! the set, target, capture or assertion, depending on the operation
+		std::int32_t x;
+		//! the second target of OPCODE_SPLIT
+		std::int32_t y;
+	};
+
+	struct Node;
+	class Parser;
+	class ThreadList;
+
+	/**
+	 * Emit the instructions of a parsed pattern.
+	 *
+	 * @param node The parsed pattern.
+	 *
+	 * @throws regexsearch_errors::TooComplexError If the program grows beyond MAX_PROGRAM_SIZE.
+	 */
+	void emit(Node const &node);
+
+	/**
+	 * Find the bytes an occurrence can start with, unless the pattern matches
+	 * the empty string.
+	 */
+	void find_first_bytes();
+
+	/**
+	 * Append an instruction to the program.
+	 *
+	 * @param opcode The operation.
+	 * @param x The set, target, capture or assertion.
+	 * @param y The second target.
+	 * @return The index of the instruction.
+	 *
+	 * @throws regexsearch_errors::TooComplexError If the program grows beyond MAX_PROGRAM_SIZE.
+	 */
+	std::int32_t append(Opcode opcode, std::int32_t x = 0, std::int32_t y = 0);
+
+	/**
+	 * Add a thread and the threads it forks without consuming a byte to a list.
+	 *
+	 * @param list The list.
+	 * @param pc The first instruction of the thread.
+	 * @param captures The captures of the thread, restored before returning.
+	 * @param begin The first byte of the text.
+	 * @param end The end of the text.
+	 * @param position The position of the thread.
+	 * @param steps The remaining budget of steps.
+	 */
+	void add_thread(ThreadList &list, std::int32_t pc, std::vector<std::int64_t> &captures,
+	                char const *begin, char const *end, char const *position,
+	                std::size_t &steps) const;
+
+	/**
+	 * Find the first occurrence starting at or after a position.
+	 *
+	 * @param begin The first byte of the text.
+	 * @param end The end of the text.
+	 * @param start The position to search from.
+	 * @param match Set to the occurrence.
+	 * @param steps The remaining budget of steps.
+	 * @param first A thread list, reused by the searches of a text.
+	 * @param second Another thread list.
+	 * @return Whether the pattern occurs.
+	 */
+	bool search(char const *begin, char const *end, char const *start, Match &match,
+	            std::size_t &steps, ThreadList &first, ThreadList &second) const;
+
+	//! the instructions
+	std::vector<Instruction> program_;
+	//! the byte sets of OPCODE_SET
+	std::vector<std::bitset<256>> sets_;
+	//! the amount of groups, without the whole occurrence
+	std::size_t groups_;
+	//! the bytes an occurrence can start with
+	std::bitset<256> first_bytes_;
+	//! whether the positions before a byte of first_bytes_ are skipped
+	bool skips_;
+};
+
+#endif
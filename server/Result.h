@@ -0,0 +1,72 @@
+/**	@file Result.h
+**/
+
+#ifndef _RESULT_H_
+#define _RESULT_H_
+
+#include <utility>
+
+#include "Message.h"
+
+/**
+	@brief Either a value or the MessageStatus describing why there is none.
+
+	Result is used by the message handlers to report ordinary outcomes (a document that isn't
+	opened, a cursor out of bounds, ...) without unwinding the stack. Exceptions remain reserved
+	for failures that really are exceptional, e.g. socket or file I/O errors.
+
+	Functions that don't produce a value report their outcome as plain Message::MessageStatus,
+	using Message::MessageStatus::STATUS_OK for success.
+
+	@note T has to be default constructible.
+**/
+template<typename T>
+class Result
+{
+	public:
+		/**
+			Creates a successful Result holding the given value.
+
+			@param value the value to store
+		**/
+		Result(T value);
+		/**
+			Creates a failed Result.
+
+			@param status the MessageStatus describing the failure; must not be
+				Message::MessageStatus::STATUS_OK
+		**/
+		Result(Message::MessageStatus status);
+
+		/**
+			Checks whether this Result holds a value.
+
+			@return whether this Result is successful
+		**/
+		inline bool is_ok(void) const;
+		/**
+			Returns the status of this Result.
+
+			@return Message::MessageStatus::STATUS_OK if this Result holds a value, otherwise the
+				status it has been created with
+		**/
+		inline Message::MessageStatus get_status(void) const;
+		/**
+			Returns the stored value. Must only be called on successful Results.
+
+			@return a reference to the stored value
+		**/
+		inline T &get_value(void);
+		/**
+			@see get_value(void)
+		**/
+		inline const T &get_value(void) const;
+
+	private:
+		Message::MessageStatus	status; ///< status of the Result
+		T						value; ///< the value, default constructed on failure
+};
+
+#include "Result.tcc"
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef _RESULT_TCC_
+#define _RESULT_TCC_
+
+/**
+ * @file Result.tcc
+ */
+
+#include <cassert>
+
+template<typename T>
+Result<T>::Result(T value):
+	status(Message::MessageStatus::STATUS_OK), value(std::move(value))
+{}
+
+template<typename T>
+Result<T>::Result(Message::MessageStatus status):
+	status(status), value()
+{ assert(status != Message::MessageStatus::STATUS_OK); }
+
+template<typename T>
+bool Result<T>::is_ok(void) const
+{ return status == Message::MessageStatus::STATUS_OK; }
+
+template<typename T>
+Message::MessageStatus Result<T>::get_status(void) const
+{ return status; }
+
+template<typename T>
+T &Result<T>::get_value(void)
+{ return value; }
+
+template<typename T>
+const T &Result<T>::get_value(void) const
+{ return value; }
+
+#endif
@@ -0,0 +1,514 @@
+#include "SQLiteDocumentStore.h"
+#include "Document.h"
+#include "SQLiteDatabase.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include <sqlite3.h>
+
+/**
+ * @file server/SQLiteDocumentStore.cpp
+ * @author Daniel Mierswa <daniel.mierswa@student.hs-rm.de>
+ *
+ * Implementation file for the SQLite3 implementation for the DocumentStore interface.
+ */
+
+using namespace document_errors;
+
+namespace
+{
+	/**
+	 * The bytes copied by one call of the incremental blob I/O,
+	 * the C API limits a single call to the range of int.
+	 */
+	int const BLOB_CHUNK_SIZE = 1 << 20;
+
+	/**
+	 * A prepared statement which is finalized on destruction.
+	 */
+	class Statement
+	{
+	public:
+		/**
+		 * Prepare a statement.
+		 *
+		 * @param handle The database connection.
+		 * @param sql The statement with ?1, ?2... as placeholders.
+		 * @throws document_errors::DocumentError If the statement can't be prepared.
+		 */
+		Statement(::sqlite3 *handle, char const *sql)
+			: handle_(handle),
+			  statement_(0)
+		{
+			if (sqlite3_prepare_v2(handle_, sql, -1, &statement_, NULL) != SQLITE_OK)
+			{
+				throw DocumentError(sqlite3_errmsg(handle_));
+			}
+		}
+
+		/**
+		 * Finalize the statement.
+		 */
+		~Statement()
+		{
+			sqlite3_finalize(statement_);
+		}
+
+		/**
+		 * Delete the default copy constructor, the statement is finalized only once.
+		 */
+		Statement(Statement const &) = delete;
+
+		/**
+		 * Delete the default assignment operator, the statement is finalized only once.
+		 */
+		Statement &operator=(Statement const &) = delete;
+
+		/**
+		 * Bind a text to a placeholder.
+		 *
+		 * @param index The index of the placeholder, starting at 1.
+		 * @param text The value, it must outlive the statement.
+		 */
+		void bind(int index, std::string const &text)
+		{
+			sqlite3_bind_text(statement_, index, text.data(), text.size(), SQLITE_STATIC);
+		}
+
+		/**
+		 * Bind an integer to a placeholder.
+		 *
+		 * @param index The index of the placeholder, starting at 1.
+		 * @param value The value.
+		 */
+		void bind(int index, sqlite3_int64 value)
+		{
+			sqlite3_bind_int64(statement_, index, value);
+		}
+
+		/**
+		 * Execute the statement until the next row.
+		 *
+		 * @param name The name of the document the statement is about.
+		 * @throws document_errors::DocumentAlreadyExistsError If a constraint is violated.
+		 * @throws document_errors::DocumentError If the execution fails for other reasons.
+		 * @return 'true' if a row is available, 'false' if the statement is done.
+		 */
+		bool step(std::string const &name)
+		{
+			int const result = sqlite3_step(statement_);
+
+			if (result == SQLITE_ROW || result == SQLITE_DONE)
+			{
+				return result == SQLITE_ROW;
+			}
+
+			std::string const message = "while accessing document <" + name + ">: " +
+			                            sqlite3_errmsg(handle_);
+
+			if (result == SQLITE_CONSTRAINT)
+			{
+				throw DocumentAlreadyExistsError(message);
+			}
+
+			throw DocumentError(message);
+		}
+
+		/**
+		 * Obtain an integer column of the current row.
+		 *
+		 * @param index The index of the column, starting at 0.
+		 * @return The value.
+		 */
+		sqlite3_int64 get_int64(int index)
+		{
+			return sqlite3_column_int64(statement_, index);
+		}
+
+		/**
+		 * Obtain a text column of the current row.
+		 *
+		 * @param index The index of the column, starting at 0.
+		 * @return The value.
+		 */
+		std::string get_text(int index)
+		{
+			char const *text = reinterpret_cast<char const *>(sqlite3_column_text(statement_,
+			                                                                      index));
+
+			return std::string(text, sqlite3_column_bytes(statement_, index));
+		}
+
+	private:
+		//! the connection the statement belongs to
+		::sqlite3 *const handle_;
+		//! the prepared statement
+		::sqlite3_stmt *statement_;
+	};
+
+	/**
+	 * An opened blob which is closed on destruction.
+	 */
+	class Blob
+	{
+	public:
+		/**
+		 * Open the contents of a document for incremental I/O.
+		 *
+		 * @param handle The database connection.
+		 * @param row The row of the document.
+		 * @param name The name of the document.
+		 * @param writable Open the blob for writing as well.
+		 * @throws document_errors::DocumentDoesntExistError If the row doesn't exist.
+		 * @throws document_errors::DocumentError If the blob can't be opened otherwise.
+		 */
+		Blob(::sqlite3 *handle, sqlite3_int64 row, std::string const &name, bool writable)
+			: blob_(0)
+		{
+			int const result = sqlite3_blob_open(handle, "main", "DocumentStore",
+			                                     "d_contents", row, writable, &blob_);
+
+			if (result != SQLITE_OK)
+			{
+				std::string const message = "while opening document <" + name + ">: " +
+				                            sqlite3_errmsg(handle);
+
+				// the row of a removed document is missing
+				if (result == SQLITE_ERROR)
+				{
+					throw DocumentDoesntExistError(message);
+				}
+
+				throw DocumentError(message);
+			}
+		}
+
+		/**
+		 * Close the blob.
+		 */
+		~Blob()
+		{
+			sqlite3_blob_close(blob_);
+		}
+
+		/**
+		 * Delete the default copy constructor, the blob is closed only once.
+		 */
+		Blob(Blob const &) = delete;
+
+		/**
+		 * Delete the default assignment operator, the blob is closed only once.
+		 */
+		Blob &operator=(Blob const &) = delete;
+
+		/**
+		 * Obtain the size of the blob.
+		 *
+		 * @return The size in bytes.
+		 */
+		std::size_t size() const
+		{
+			return sqlite3_blob_bytes(blob_);
+		}
+
+		/**
+		 * Read the whole blob.
+		 *
+		 * @param bytes The destination of size() bytes.
+		 * @throws document_errors::DocumentError If reading fails.
+		 */
+		void read(char *bytes)
+		{
+			for (std::size_t offset = 0; offset < size(); offset += BLOB_CHUNK_SIZE)
+			{
+				int const length = std::min<std::size_t>(size() - offset, BLOB_CHUNK_SIZE);
+
+				if (sqlite3_blob_read(blob_, bytes + offset, length, offset) != SQLITE_OK)
+				{
+					throw DocumentError("unable to read all data from blob");
+				}
+			}
+		}
+
+		/**
+		 * Overwrite the whole blob.
+		 *
+		 * @param bytes The source of size() bytes.
+		 * @throws document_errors::DocumentError If writing fails.
+		 */
+		void write(char const *bytes)
+		{
+			for (std::size_t offset = 0; offset < size(); offset += BLOB_CHUNK_SIZE)
+			{
+				int const length = std::min<std::size_t>(size() - offset, BLOB_CHUNK_SIZE);
+
+				if (sqlite3_blob_write(blob_, bytes + offset, length, offset) != SQLITE_OK)
+				{
+					throw DocumentError("unable to write all data to blob");
+				}
+			}
+		}
+
+	private:
+		//! the blob handle of the C API
+		::sqlite3_blob *blob_;
+	};
+
+	/**
+	 * A document opened as row of the DocumentStore table.
+	 */
+	class SQLiteHandle
+		: public DocumentStore::Handle
+	{
+	public:
+		/**
+		 * Refer to the row of a document.
+		 *
+		 * @param handle The database connection, it must outlive the handle.
+		 * @param row The row of the document.
+		 * @param name The name of the document.
+		 */
+		SQLiteHandle(::sqlite3 *handle, sqlite3_int64 row, std::string const &name)
+			: handle_(handle),
+			  row_(row),
+			  name_(name)
+		{
+		}
+
+		void read(std::vector<char> &contents)
+		{
+			Blob blob(handle_, row_, name_, false);
+
+			contents.resize(blob.size());
+			blob.read(contents.data());
+		}
+
+		void write(std::vector<char> const &contents)
+		{
+			execute("BEGIN");
+
+			try
+			{
+				// blobs can't be resized by incremental I/O, it has to be reallocated first
+				bool const resize = Blob(handle_, row_, name_, false).size() != contents.size();
+
+				// writes within the resolution of the clock are told apart as well
+				Statement update(handle_, resize ?
+					"UPDATE DocumentStore SET d_contents = zeroblob(?3), "
+					"d_modified = max(?1, d_modified + 1) WHERE d_id = ?2" :
+					"UPDATE DocumentStore SET d_modified = max(?1, d_modified + 1) WHERE d_id = ?2");
+				update.bind(1, static_cast<sqlite3_int64>(DocumentStore::now()));
+				update.bind(2, row_);
+
+				if (resize)
+				{
+					update.bind(3, static_cast<sqlite3_int64>(contents.size()));
+				}
+
+				update.step(name_);
+
+				Blob(handle_, row_, name_, true).write(contents.data());
+				execute("COMMIT");
+			}
+			catch (...)
+			{
+				sqlite3_exec(handle_, "ROLLBACK", NULL, NULL, NULL);
+				throw;
+			}
+		}
+
+	private:
+		/**
+		 * Execute a statement without parameters or results.
+		 *
+		 * @param sql The statement.
+		 * @throws document_errors::DocumentError If the execution fails.
+		 */
+		void execute(char const *sql)
+		{
+			if (sqlite3_exec(handle_, sql, NULL, NULL, NULL) != SQLITE_OK)
+			{
+				throw DocumentError(sqlite3_errmsg(handle_));
+			}
+		}
+
+		//! the connection of the store
+		::sqlite3 *const handle_;
+		//! the row of the document
+		sqlite3_int64 const row_;
+		//! the name of the document for error messages
+		std::string const name_;
+	};
+
+	/**
+	 * Create the error message for a document that doesn't exist.
+	 *
+	 * @param name The name of the document.
+	 * @return The error message.
+	 */
+	std::string missing_document(std::string const &name)
+	{
+		return "while opening document <" + name + ">: document does not exist";
+	}
+}
+
+SQLiteDocumentStore::SQLiteDocumentStore(SQLiteDocumentStore &&other)
+	: handle_(other.handle_)
+{
+	other.handle_ = 0;
+}
+
+SQLiteDocumentStore SQLiteDocumentStore::from_path(std::string const &path)
+{
+	if (!((path.length() >= 1 && path[0] == '/') ||
+	      (path.length() >= 2 && path[0] == '.' && path[1] == '/')))
+	{
+		throw std::runtime_error("invalid path, should begin with either '/' or './'");
+	}
+
+	return SQLiteDocumentStore(path);
+}
+
+SQLiteDocumentStore SQLiteDocumentStore::temporary()
+{
+	return SQLiteDocumentStore(":memory:");
+}
+
+SQLiteDocumentStore::~SQLiteDocumentStore()
+{
+	// all statements and blobs are closed at this point
+	int const result = sqlite3_close(handle_);
+
+	assert(result == 0);
+	(void)result;
+}
+
+std::unique_ptr<DocumentStore::Handle> SQLiteDocumentStore::create(std::string const &name,
+                                                                   bool overwrite)
+{
+	Statement insert(handle_, overwrite ?
+		"INSERT OR REPLACE INTO DocumentStore (d_name, d_contents, d_modified) "
+		"VALUES (?1, zeroblob(0), ?2)" :
+		"INSERT INTO DocumentStore (d_name, d_contents, d_modified) VALUES (?1, zeroblob(0), ?2)");
+	insert.bind(1, name);
+	insert.bind(2, static_cast<sqlite3_int64>(now()));
+	insert.step(name);
+
+	return std::unique_ptr<Handle>(new SQLiteHandle(handle_, sqlite3_last_insert_rowid(handle_),
+	                                                name));
+}
+
+std::unique_ptr<DocumentStore::Handle> SQLiteDocumentStore::open(std::string const &name)
+{
+	Statement select(handle_, "SELECT d_id FROM DocumentStore WHERE d_name = ?1");
+	select.bind(1, name);
+
+	if (!select.step(name))
+	{
+		throw DocumentDoesntExistError(missing_document(name));
+	}
+
+	return std::unique_ptr<Handle>(new SQLiteHandle(handle_, select.get_int64(0), name));
+}
+
+void SQLiteDocumentStore::remove(std::string const &name)
+{
+	Statement remove(handle_, "DELETE FROM DocumentStore WHERE d_name = ?1");
+	remove.bind(1, name);
+	remove.step(name);
+
+	if (sqlite3_changes(handle_) == 0)
+	{
+		throw DocumentDoesntExistError(missing_document(name));
+	}
+}
+
+std::uint64_t SQLiteDocumentStore::size(std::string const &name)
+{
+	// length() of a blob is taken from its header, the contents aren't read
+	Statement select(handle_, "SELECT length(d_contents) FROM DocumentStore WHERE d_name = ?1");
+	select.bind(1, name);
+
+	if (!select.step(name))
+	{
+		throw DocumentDoesntExistError(missing_document(name));
+	}
+
+	return select.get_int64(0);
+}
+
+DocumentStore::Status SQLiteDocumentStore::status(std::string const &name)
+{
+	Statement select(handle_, "SELECT length(d_contents), d_modified FROM DocumentStore "
+	                          "WHERE d_name = ?1");
+	select.bind(1, name);
+
+	if (!select.step(name))
+	{
+		throw DocumentDoesntExistError(missing_document(name));
+	}
+
+	Status result;
+	result.size = select.get_int64(0);
+	result.modified = select.get_int64(1);
+
+	return result;
+}
+
+std::vector<std::string> SQLiteDocumentStore::list()
+{
+	Statement select(handle_, "SELECT d_name FROM DocumentStore ORDER BY d_name");
+	std::vector<std::string> list;
+
+	while (select.step("*"))
+	{
+		list.push_back(select.get_text(0));
+	}
+
+	return list;
+}
+
+SQLiteDocumentStore::SQLiteDocumentStore(std::string const &path)
+{
+	int const result = sqlite3_open_v2(
+		path.c_str(), &handle_,
+		SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+		NULL);
+
+	if (result)
+	{
+		// throw an error if the connection failed
+		std::string const error = sqlite3_errmsg(handle_);
+
+		sqlite3_close(handle_);
+		throw database_errors::SQLiteConnectionError(error);
+	}
+
+	// the id stays stable for the lifetime of a row, unlike the implicit rowid
+	char const *const schema = "CREATE TABLE IF NOT EXISTS DocumentStore ("
+		"d_id INTEGER PRIMARY KEY, d_name TEXT UNIQUE NOT NULL, d_contents BLOB NOT NULL, "
+		"d_modified INTEGER NOT NULL DEFAULT 0)";
+
+	// tables created before the modification time was kept lack its column
+	char const *const columns = "SELECT name FROM pragma_table_info('DocumentStore') "
+		"WHERE name = 'd_modified'";
+	char const *const migration = "ALTER TABLE DocumentStore "
+		"ADD COLUMN d_modified INTEGER NOT NULL DEFAULT 0";
+	bool current = false;
+	auto const found = [](void *current, int, char **, char **)
+	{
+		*static_cast<bool *>(current) = true;
+		return 0;
+	};
+
+	if (sqlite3_exec(handle_, schema, NULL, NULL, NULL) != SQLITE_OK ||
+	    sqlite3_exec(handle_, columns, found, &current, NULL) != SQLITE_OK ||
+	    (!current && sqlite3_exec(handle_, migration, NULL, NULL, NULL) != SQLITE_OK))
+	{
+		std::string const error = sqlite3_errmsg(handle_);
+
+		sqlite3_close(handle_);
+		throw database_errors::SQLiteConnectionError(error);
+	}
+}
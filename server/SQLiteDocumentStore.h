@@ -0,0 +1,121 @@
+#ifndef SQLITEDOCUMENTSTORE_H_INCLUDED
+#define SQLITEDOCUMENTSTORE_H_INCLUDED
+
+#include "DocumentStore.h"
+
+/**
+ * @file server/SQLiteDocumentStore.h
+ * @author Daniel Mierswa <daniel.mierswa@student.hs-rm.de>
+ *
+ * SQLite3 implementation for the DocumentStore interface.
+ */
+
+// Forward declaration of the SQLite3 handle type.
+struct sqlite3;
+
+/**
+ * The SQLite implementation of the document store interface.
+ * Each document is a blob in the table DocumentStore, contents are
+ * read and written with the incremental blob I/O of SQLite so they
+ * are copied straight between the database pages and the document.
+ *
+ * The modification time of a document is kept in the table along with
+ * its contents, it's set by the clock of the server on every write.
+ *
+ * Removing a document invalidates its opened handles, reading or
+ * writing them throws document_errors::DocumentDoesntExistError.
+ *
+ * @startuml{SQLiteDocumentStore_Class.svg}
+ * abstract class DocumentStore
+ * DocumentStore <|-- SQLiteDocumentStore
+ * class SQLiteDocumentStore {
+ * .. Construction ..
+ * + SQLiteDocumentStore(SQLiteDocumentStore &&)
+ * + ~SQLiteDocumentStore()
+ * - SQLiteDocumentStore(path: string const &)
+ * + {static} from_path(path: string const &): SQLiteDocumentStore
+ * + {static} temporary(): SQLiteDocumentStore
+ * __
+ * + create(name: string const &, overwrite: bool): unique_ptr<Handle>
+ * + open(name: string const &): unique_ptr<Handle>
+ * + remove(name: string const &)
+ * + size(name: string const &): uint64_t
+ * + status(name: string const &): Status
+ * + list(): vector<string>
+ * __ attributes __
+ * - handle_: sqlite3 *
+ * }
+ * @enduml
+ */
+class SQLiteDocumentStore
+	: public DocumentStore
+{
+public:
+	/**
+	 * Move a SQLite document store.
+	 *
+	 * The resources are moved and you can no longer expect
+	 * any useful state of this object after moving it.
+	 */
+	SQLiteDocumentStore(SQLiteDocumentStore &&);
+
+	/**
+	 * Construct a new SQLite document store.
+	 *
+	 * The path should be accessible. If the file does not exists, it is
+	 * created.
+	 *
+	 * Valid paths either begin with '/' or './'.
+	 *
+	 * @param path The absolute or relative path to the database file.
+	 * @throws std::runtime_error Thrown if the path is invalid.
+	 * @throws database_errors::SQLiteConnectionError Thrown if an error occurs during
+	 *                                                establishing the connection.
+	 */
+	static SQLiteDocumentStore from_path(std::string const &path);
+
+	/**
+	 * Construct a new SQLite document store.
+	 *
+	 * The database is held in memory and automatically removed once the destructor
+	 * is called.
+	 *
+	 * @throws database_errors::SQLiteConnectionError Thrown if an error occurs during
+	 *                                                establishing the connection.
+	 */
+	static SQLiteDocumentStore temporary();
+
+	/**
+	 * Deconstruct a SQLite document store. Close the connection to the SQLite file.
+	 */
+	~SQLiteDocumentStore();
+
+	std::unique_ptr<Handle> create(std::string const &name, bool overwrite);
+
+	std::unique_ptr<Handle> open(std::string const &name);
+
+	void remove(std::string const &name);
+
+	std::uint64_t size(std::string const &name);
+
+	Status status(std::string const &name);
+
+	std::vector<std::string> list();
+
+private:
+	/**
+	 * Construct a new SQLite document store and create its table if necessary.
+	 *
+	 * This is basically a wrapper around the C API call and should
+	 * be used by the public constructors only.
+	 *
+	 * @throws database_errors::SQLiteConnectionError Thrown if an error occurs during
+	 *                                                establishing the connection.
+	 */
+	explicit SQLiteDocumentStore(std::string const &path);
+
+	//! A handle to the SQLite3 database used in the C API.
+	::sqlite3 *handle_;
+};
+
+#endif
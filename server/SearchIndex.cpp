@@ -0,0 +1,468 @@
+#include "SearchIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+/**
+ * @file server/SearchIndex.cpp
+ *
+ * Implementation file for the inverted trigram index over all documents.
+ */
+
+namespace
+{
+	//! the amount of bits of a trigram
+	unsigned const TRIGRAM_BITS = 24;
+	//! the amount of high bits of a scrambled trigram selecting its shard
+	unsigned const SHARD_BITS = 6;
+	//! the amount of shards of the posting lists
+	std::size_t const SHARD_COUNT = std::size_t(1) << SHARD_BITS;
+
+	/**
+	 * Scramble the bytes of a trigram.
+	 * Multiplying by an odd number is a bijection modulo 2^24, so distinct
+	 * trigrams stay distinct.
+	 *
+	 * @param bytes The three bytes in their order, the lowest one last.
+	 * @return The scrambled trigram.
+	 */
+	SearchIndex::trigram_t scramble(std::uint32_t bytes)
+	{
+		return (bytes * UINT32_C(0x9e3779b1)) & ((UINT32_C(1) << TRIGRAM_BITS) - 1);
+	}
+
+	/**
+	 * Call a function with every trigram of some bytes.
+	 *
+	 * @param begin The first byte.
+	 * @param end The end of the bytes.
+	 * @param function The function taking a scrambled trigram.
+	 */
+	template <class F>
+	void for_each_trigram(char const *begin, char const *end, F const &function)
+	{
+		std::uint32_t bytes = 0;
+
+		for (char const *byte = begin; byte != end; byte++)
+		{
+			bytes = (bytes << 8 | static_cast<unsigned char>(*byte)) & 0xffffff;
+
+			if (byte - begin >= 2)
+			{
+				function(scramble(bytes));
+			}
+		}
+	}
+
+	/**
+	 * Append the trigrams of some bytes to a list of changes.
+	 *
+	 * @param begin The first byte.
+	 * @param end The end of the bytes.
+	 * @param delta The change of every trigram.
+	 * @param changes The list to append to.
+	 */
+	void collect_trigrams(char const *begin, char const *end, std::int64_t delta,
+	                      std::vector<std::pair<SearchIndex::trigram_t, std::int64_t>> &changes)
+	{
+		for_each_trigram(begin, end, [&](SearchIndex::trigram_t trigram)
+		{
+			changes.emplace_back(trigram, delta);
+		});
+	}
+
+	/**
+	 * Sort trigrams by their bytes, least significant first, which takes
+	 * linear time unlike comparison sorts.
+	 *
+	 * @param trigrams The trigrams.
+	 */
+	void sort_trigrams(std::vector<SearchIndex::trigram_t> &trigrams)
+	{
+		std::vector<SearchIndex::trigram_t> sorted(trigrams.size());
+
+		for (unsigned shift = 0; shift < TRIGRAM_BITS; shift += 8)
+		{
+			std::size_t offsets[256] = { 0 };
+
+			for (SearchIndex::trigram_t const trigram: trigrams)
+			{
+				offsets[trigram >> shift & 0xff]++;
+			}
+
+			for (std::size_t byte = 0, offset = 0; byte < 256; byte++)
+			{
+				std::swap(offsets[byte], offset);
+				offset += offsets[byte];
+			}
+
+			for (SearchIndex::trigram_t const trigram: trigrams)
+			{
+				sorted[offsets[trigram >> shift & 0xff]++] = trigram;
+			}
+
+			trigrams.swap(sorted);
+		}
+	}
+
+	/**
+	 * Run a function on several threads, the calling one included, and wait
+	 * for all of them.
+	 *
+	 * @param threads The amount of threads, at least 1.
+	 * @param function The function.
+	 */
+	void run_parallel(unsigned threads, std::function<void()> const &function)
+	{
+		std::vector<std::thread> workers;
+
+		for (unsigned i = 1; i < threads; i++)
+		{
+			workers.emplace_back(function);
+		}
+
+		function();
+
+		for (std::thread &worker: workers)
+		{
+			worker.join();
+		}
+	}
+
+	/**
+	 * Compare a trigram count by its trigram.
+	 */
+	bool is_trigram_less(std::pair<SearchIndex::trigram_t, std::uint32_t> const &count,
+	                     SearchIndex::trigram_t trigram)
+	{
+		return count.first < trigram;
+	}
+}
+
+std::size_t const SearchIndex::TRIGRAM_SIZE;
+
+SearchIndex::SearchIndex()
+	: shards_(SHARD_COUNT)
+{
+}
+
+SearchIndex::SearchIndex(std::vector<std::string> const &names, reader_t const &read,
+                         unsigned threads)
+	: shards_(SHARD_COUNT)
+{
+	std::vector<Entry> entries(names.size());
+	std::atomic<std::size_t> next_document(0);
+
+	// count the trigrams of every document, the largest part of the work
+	run_parallel(threads, [&]()
+	{
+		std::vector<char> contents;
+
+		for (std::size_t i; (i = next_document++) < names.size();)
+		{
+			if (read(names[i], contents))
+			{
+				entries[i].name = names[i];
+				entries[i].size = contents.size();
+				entries[i].counts = count_trigrams(contents.data(),
+				                                   contents.data() + contents.size());
+			}
+		}
+	});
+
+	for (Entry &entry: entries)
+	{
+		if (!entry.name.empty())
+		{
+			ids_.emplace(entry.name, entries_.size());
+			entries_.push_back(std::move(entry));
+		}
+	}
+
+	std::atomic<std::size_t> next_shard(0);
+
+	// the counts are sorted, hence the trigrams of a shard are a range of them
+	run_parallel(threads, [&]()
+	{
+		for (std::size_t shard; (shard = next_shard++) < SHARD_COUNT;)
+		{
+			trigram_t const first = shard << (TRIGRAM_BITS - SHARD_BITS);
+			trigram_t const last = (shard + 1) << (TRIGRAM_BITS - SHARD_BITS);
+
+			for (std::uint32_t id = 0; id < entries_.size(); id++)
+			{
+				counts_t const &counts = entries_[id].counts;
+
+				for (auto count = std::lower_bound(counts.begin(), counts.end(), first,
+				                                   is_trigram_less);
+				     count != counts.end() && count->first < last; count++)
+				{
+					shards_[shard][count->first].push_back(id);
+				}
+			}
+		}
+	});
+}
+
+void SearchIndex::insert(std::string const &name, std::vector<char> const &contents)
+{
+	remove(name);
+
+	std::uint32_t const id = allocate(name, contents.size());
+
+	entries_[id].counts = count_trigrams(contents.data(), contents.data() + contents.size());
+	add_postings(id);
+}
+
+void SearchIndex::remove(std::string const &name)
+{
+	auto const id = ids_.find(name);
+
+	if (id == ids_.end())
+	{
+		return;
+	}
+
+	Entry &entry = entries_[id->second];
+
+	for (auto const &count: entry.counts)
+	{
+		auto &postings = shards_[get_postings_shard(count.first)];
+		auto const posting = postings.find(count.first);
+		std::vector<std::uint32_t> &ids = posting->second;
+
+		ids.erase(std::lower_bound(ids.begin(), ids.end(), id->second));
+
+		if (ids.empty())
+		{
+			postings.erase(posting);
+		}
+	}
+
+	entry.name.clear();
+	counts_t().swap(entry.counts);
+	free_ids_.push_back(id->second);
+	ids_.erase(id);
+}
+
+void SearchIndex::apply(std::string const &name, std::vector<char> const &contents,
+                        EditOperation const &operation)
+{
+	auto const id = ids_.find(name);
+
+	if (id == ids_.end())
+	{
+		return;
+	}
+
+	std::vector<char> const none;
+	std::vector<char> const &inserted =
+		operation.kind == EditOperation::Kind::KIND_DELETE ? none : operation.bytes;
+	std::int64_t const deleted =
+		operation.kind == EditOperation::Kind::KIND_INSERT ? 0 : operation.length;
+	std::int64_t const size = contents.size();
+
+	// the trigrams overlapping the edited range start up to two bytes before it
+	char const *const begin = contents.data() + std::max<std::int64_t>(operation.position - 2, 0);
+	char const *const position = contents.data() + operation.position;
+	char const *const end = contents.data() +
+		std::min<std::int64_t>(operation.position + deleted + 2, size);
+
+	std::vector<char> window(begin, position);
+	window.insert(window.end(), inserted.begin(), inserted.end());
+	window.insert(window.end(), position + deleted, end);
+
+	std::vector<std::pair<trigram_t, std::int64_t>> changes;
+	collect_trigrams(begin, end, -1, changes);
+	collect_trigrams(window.data(), window.data() + window.size(), 1, changes);
+
+	update(id->second, changes);
+	entries_[id->second].size += static_cast<std::int64_t>(inserted.size()) - deleted;
+}
+
+std::vector<std::string> SearchIndex::find(std::string const &query) const
+{
+	std::vector<std::string> names;
+
+	if (query.size() < TRIGRAM_SIZE)
+	{
+		for (Entry const &entry: entries_)
+		{
+			if (!entry.name.empty() && entry.size >= static_cast<std::int64_t>(query.size()))
+			{
+				names.push_back(entry.name);
+			}
+		}
+
+		std::sort(names.begin(), names.end());
+
+		return names;
+	}
+
+	counts_t const trigrams = count_trigrams(query.data(), query.data() + query.size());
+	std::vector<std::vector<std::uint32_t> const *> lists;
+
+	for (auto const &trigram: trigrams)
+	{
+		auto const &postings = shards_[get_postings_shard(trigram.first)];
+		auto const posting = postings.find(trigram.first);
+
+		if (posting == postings.end())
+		{
+			return names;
+		}
+
+		lists.push_back(&posting->second);
+	}
+
+	// start with the rarest trigram, the candidates only shrink
+	std::sort(lists.begin(), lists.end(),
+	          [](std::vector<std::uint32_t> const *a, std::vector<std::uint32_t> const *b)
+	{
+		return a->size() < b->size();
+	});
+
+	std::vector<std::uint32_t> candidates(*lists.front());
+	std::vector<std::uint32_t> intersection;
+
+	for (std::size_t i = 1; i < lists.size() && !candidates.empty(); i++)
+	{
+		intersection.clear();
+		std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(),
+		                      lists[i]->end(), std::back_inserter(intersection));
+		candidates.swap(intersection);
+	}
+
+	for (std::uint32_t const id: candidates)
+	{
+		names.push_back(entries_[id].name);
+	}
+
+	std::sort(names.begin(), names.end());
+
+	return names;
+}
+
+std::int64_t SearchIndex::get_size(std::string const &name) const
+{
+	auto const id = ids_.find(name);
+
+	return id == ids_.end() ? -1 : entries_[id->second].size;
+}
+
+std::uint32_t SearchIndex::allocate(std::string const &name, std::int64_t size)
+{
+	std::uint32_t id;
+
+	if (free_ids_.empty())
+	{
+		id = entries_.size();
+		entries_.emplace_back();
+	}
+	else
+	{
+		id = free_ids_.back();
+		free_ids_.pop_back();
+	}
+
+	entries_[id].name = name;
+	entries_[id].size = size;
+	ids_.emplace(name, id);
+
+	return id;
+}
+
+void SearchIndex::add_postings(std::uint32_t id)
+{
+	for (auto const &count: entries_[id].counts)
+	{
+		std::vector<std::uint32_t> &ids = shards_[get_postings_shard(count.first)][count.first];
+
+		ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+	}
+}
+
+void SearchIndex::update(std::uint32_t id,
+                         std::vector<std::pair<trigram_t, std::int64_t>> &changes)
+{
+	counts_t &counts = entries_[id].counts;
+
+	std::sort(changes.begin(), changes.end());
+
+	for (auto change = changes.begin(); change != changes.end();)
+	{
+		trigram_t const trigram = change->first;
+		std::int64_t delta = 0;
+
+		for (; change != changes.end() && change->first == trigram; change++)
+		{
+			delta += change->second;
+		}
+
+		if (delta == 0)
+		{
+			continue;
+		}
+
+		auto &postings = shards_[get_postings_shard(trigram)];
+		auto const count = std::lower_bound(counts.begin(), counts.end(), trigram,
+		                                    is_trigram_less);
+
+		if (count == counts.end() || count->first != trigram)
+		{
+			// a trigram that doesn't occur yet can only be added
+			std::vector<std::uint32_t> &ids = postings[trigram];
+
+			counts.emplace(count, trigram, delta);
+			ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+		}
+		else if (count->second + delta > 0)
+		{
+			count->second += delta;
+		}
+		else
+		{
+			auto const posting = postings.find(trigram);
+			std::vector<std::uint32_t> &ids = posting->second;
+
+			counts.erase(count);
+			ids.erase(std::lower_bound(ids.begin(), ids.end(), id));
+
+			if (ids.empty())
+			{
+				postings.erase(posting);
+			}
+		}
+	}
+}
+
+SearchIndex::counts_t SearchIndex::count_trigrams(char const *begin, char const *end)
+{
+	std::vector<trigram_t> trigrams;
+	counts_t counts;
+
+	trigrams.reserve(std::max<std::ptrdiff_t>(end - begin - 2, 0));
+	for_each_trigram(begin, end, [&](trigram_t trigram)
+	{
+		trigrams.push_back(trigram);
+	});
+	sort_trigrams(trigrams);
+
+	for (trigram_t const trigram: trigrams)
+	{
+		if (counts.empty() || counts.back().first != trigram)
+		{
+			counts.emplace_back(trigram, 0);
+		}
+
+		counts.back().second++;
+	}
+
+	return counts;
+}
+
+std::size_t SearchIndex::get_postings_shard(trigram_t trigram)
+{
+	return trigram >> (TRIGRAM_BITS - SHARD_BITS);
+}
@@ -0,0 +1,226 @@
+#ifndef SEARCHINDEX_H_INCLUDED
+#define SEARCHINDEX_H_INCLUDED
+
+#include "EditOperation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @file server/SearchIndex.h
+ *
+ * Interface for the inverted trigram index over all documents.
+ */
+
+/**
+ * An inverted index of the trigrams, i.e. the substrings of three bytes,
+ * of many documents, to find the documents that may contain some bytes
+ * without reading them.
+ *
+ * A document containing a query contains all trigrams of the query, hence
+ * intersecting the documents of each trigram yields a few candidates, which
+ * have to be searched for the query still. Queries shorter than a trigram
+ * can't be narrowed down. The search is byte-wise, i.e. case sensitive.
+ *
+ * Every document keeps the number of occurrences of each of its trigrams,
+ * so an edit only counts the trigrams around the edited range: the ones
+ * overlapping the removed bytes are taken away, the ones overlapping the
+ * inserted bytes are added, and a document leaves or joins the posting list
+ * of a trigram when its count drops to or rises from zero.
+ *
+ * The posting lists are split into shards by trigram. Trigrams are
+ * scrambled by a bijection first, so the shards, which are ranges of the
+ * scrambled values, are of similar size although text uses few bytes. The
+ * index is built by several threads, which count the trigrams of one
+ * document at a time and then fill the posting lists of one shard at a
+ * time.
+ *
+ * @startuml{SearchIndex_Class.svg}
+ * class SearchIndex {
+ * .. Construction ..
+ * + SearchIndex()
+ * + SearchIndex(names: vector<string> const &, read: reader_t const &, threads: unsigned)
+ * __
+ * + insert(name: string const &, contents: vector<char> const &)
+ * + remove(name: string const &)
+ * + apply(name: string const &, contents: vector<char> const &, operation: EditOperation const &)
+ * + find(query: string const &): vector<string>
+ * + get_size(name: string const &): int64_t
+ * + get_document_count(): size_t
+ * .. helpers ..
+ * - allocate(name: string const &, size: int64_t): uint32_t
+ * - add_postings(id: uint32_t)
+ * - update(id: uint32_t, changes: vector<pair<trigram_t, int64_t>> &)
+ * - {static} count_trigrams(begin: char const *, end: char const *): counts_t
+ * - {static} get_postings_shard(trigram: trigram_t): size_t
+ * __ attributes __
+ * - entries_: vector<Entry>
+ * - ids_: unordered_map<string, uint32_t>
+ * - free_ids_: vector<uint32_t>
+ * - shards_: vector<unordered_map<trigram_t, vector<uint32_t>>>
+ * }
+ * @enduml
+ */
+class SearchIndex
+{
+public:
+	//! a scrambled trigram, 24 bits
+	typedef std::uint32_t trigram_t;
+
+	/**
+	 * A function reading the contents of a document by name, returning
+	 * 'false' if the document can't be read. It is called by several
+	 * threads at once.
+	 */
+	typedef std::function<bool(std::string const &, std::vector<char> &)> reader_t;
+
+	//! the amount of bytes of a trigram, shorter queries match every document
+	static std::size_t const TRIGRAM_SIZE = 3;
+
+	/**
+	 * Construct an empty index.
+	 */
+	SearchIndex();
+
+	/**
+	 * Construct the index of some documents in parallel.
+	 * Documents that can't be read are left out.
+	 *
+	 * @param names The names of the documents.
+	 * @param read The function reading a document.
+	 * @param threads The amount of threads to use, at least 1.
+	 */
+	SearchIndex(std::vector<std::string> const &names, reader_t const &read, unsigned threads);
+
+	/**
+	 * Index a document, replacing its previous contents if it is indexed.
+	 *
+	 * @param name The name of the document.
+	 * @param contents The contents of the document.
+	 */
+	void insert(std::string const &name, std::vector<char> const &contents);
+
+	/**
+	 * Forget a document. Unknown documents are ignored.
+	 *
+	 * @param name The name of the document.
+	 */
+	void remove(std::string const &name);
+
+	/**
+	 * Update the index for an edit of a document, before it is applied.
+	 * Operations of a sequence have to be passed in their order, each one
+	 * with the contents the previous ones resulted in. Unknown documents
+	 * are ignored.
+	 *
+	 * @param name The name of the document.
+	 * @param contents The contents the operation will be applied to.
+	 * @param operation The operation, within the contents.
+	 */
+	void apply(std::string const &name, std::vector<char> const &contents,
+	           EditOperation const &operation);
+
+	/**
+	 * Find the documents that may contain some bytes.
+	 *
+	 * @param query The bytes to search for.
+	 * @return The sorted names of the documents containing all trigrams of
+	 *         the query, all documents at least as long as the query if it
+	 *         is shorter than a trigram.
+	 */
+	std::vector<std::string> find(std::string const &query) const;
+
+	/**
+	 * Obtain the size a document was indexed with, e.g. to check whether the
+	 * index is still up to date.
+	 *
+	 * @param name The name of the document.
+	 * @return The size of the document in bytes, -1 if it isn't indexed.
+	 */
+	std::int64_t get_size(std::string const &name) const;
+
+	/**
+	 * Obtain the amount of indexed documents.
+	 *
+	 * @return The amount of documents.
+	 */
+	std::size_t get_document_count() const
+	{
+		return ids_.size();
+	}
+
+private:
+	//! the trigrams of a document and how often they occur, sorted by trigram
+	typedef std::vector<std::pair<trigram_t, std::uint32_t>> counts_t;
+
+	/**
+	 * An indexed document.
+	 */
+	struct Entry
+	{
+		//! the name of the document, empty if the entry is free
+		std::string name;
+		//! the size of the document in bytes
+		std::int64_t size;
+		//! the occurrences of its trigrams
+		counts_t counts;
+	};
+
+	/**
+	 * Obtain an unused entry for a document.
+	 *
+	 * @param name The name of the document.
+	 * @param size The size of the document in bytes.
+	 * @return The id of the entry.
+	 */
+	std::uint32_t allocate(std::string const &name, std::int64_t size);
+
+	/**
+	 * Add a document to the posting lists of all its trigrams.
+	 *
+	 * @param id The id of the document.
+	 */
+	void add_postings(std::uint32_t id);
+
+	/**
+	 * Change the occurrences of trigrams within a document.
+	 *
+	 * @param id The id of the document.
+	 * @param changes The trigrams and the amounts to add to their counts,
+	 *                a trigram may be listed several times. It is sorted.
+	 */
+	void update(std::uint32_t id, std::vector<std::pair<trigram_t, std::int64_t>> &changes);
+
+	/**
+	 * Count the trigrams of some bytes.
+	 *
+	 * @param begin The first byte.
+	 * @param end The end of the bytes.
+	 * @return The occurrences of every trigram.
+	 */
+	static counts_t count_trigrams(char const *begin, char const *end);
+
+	/**
+	 * Obtain the shard holding the posting list of a trigram.
+	 *
+	 * @param trigram The trigram.
+	 * @return The index of the shard.
+	 */
+	static std::size_t get_postings_shard(trigram_t trigram);
+
+	//! the indexed documents by id, ids of removed documents are reused
+	std::vector<Entry> entries_;
+	//! the id of every indexed document by name
+	std::unordered_map<std::string, std::uint32_t> ids_;
+	//! the ids of free entries
+	std::vector<std::uint32_t> free_ids_;
+	//! the sorted ids of the documents containing a trigram, split into shards
+	std::vector<std::unordered_map<trigram_t, std::vector<std::uint32_t>>> shards_;
+};
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * @file SendQueue.cpp
+ */
+
+#include <algorithm>
+#include <utility>
+
+#include "SendQueue.h"
+
+const size_t SendQueue::INTERACTIVE_BURST;
+const size_t SendQueue::MAX_QUEUED_BYTES;
+
+SendQueue::SendQueue(size_t capacity):
+	capacity(capacity), queued(0), streak(0)
+{}
+
+void SendQueue::cancel(int32_t document_id)
+{
+	auto refers = [this, document_id](const Transfer &transfer)
+		{
+			if (transfer.get_document_id() != document_id)
+			{ return false; }
+
+			queued -= transfer.get_size();
+			return true;
+		};
+
+	bulk.erase(std::remove_if(bulk.begin(), bulk.end(), refers), bulk.end());
+	interactive.erase(std::remove_if(interactive.begin(), interactive.end(), refers),
+		interactive.end());
+}
+
+bool SendQueue::next(std::vector<char> &dest, uint8_t version, uint8_t compression,
+	size_t &window)
+{
+	bool take_bulk = window > 0 && !bulk.empty() &&
+		(interactive.empty() || streak >= INTERACTIVE_BURST);
+	if (!take_bulk && interactive.empty())
+	{ return false; }
+
+	std::deque<Transfer> &queue = take_bulk ? bulk : interactive;
+	if (take_bulk)
+	{
+		--window;
+		streak = 0;
+	}
+	else
+	{ streak = bulk.empty() ? 0 : streak + 1; }
+
+	queued -= queue.front().get_size();
+	queue.front().next(dest, version, compression);
+	queued += queue.front().get_size();
+	if (queue.front().is_done())
+	{ queue.pop_front(); }
+
+	return true;
+}
+
+bool SendQueue::push(Transfer &&transfer)
+{
+	if (transfer.is_done())
+	{ return true; }
+
+	if (transfer.get_size() > capacity - queued)
+	{ return false; }
+	queued += transfer.get_size();
+
+	// frames referring to a document wait for its contents
+	bool ordered = transfer.get_priority() == Transfer::Priority::PRIORITY_BULK ||
+		(transfer.get_document_id() != 0 && std::any_of(bulk.begin(), bulk.end(),
+			[&transfer](const Transfer &queued)
+			{ return queued.get_document_id() == transfer.get_document_id(); }));
+
+	(ordered ? bulk : interactive).push_back(std::move(transfer));
+	return true;
+}
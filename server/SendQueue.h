@@ -0,0 +1,91 @@
+/**	@file SendQueue.h
+**/
+
+#ifndef _SENDQUEUE_H_
+#define _SENDQUEUE_H_
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "Transfer.h"
+
+/**
+	@brief Transfers queued for a single Client, scheduled by priority class.
+
+	Interactive frames jump ahead of queued bulk data, so edits and status messages arrive
+	immediately while the Client downloads a large document. To keep bulk data from starving, a bulk
+	frame is sent after every INTERACTIVE_BURST interactive frames sent in a row.
+
+	Frames referring to positions within a document stay behind queued Transfers of that
+	document's contents, they would refer to bytes the Client doesn't have yet otherwise.
+
+	A Client that doesn't read would let the frames queued for it grow without bounds, so the
+	queue takes at most its capacity of frame bytes, see Transfer::get_size(void).
+**/
+class SendQueue
+{
+	public:
+		static const size_t INTERACTIVE_BURST = 8; ///< interactive frames sent before a bulk one
+		static const size_t MAX_QUEUED_BYTES = 32 << 20; ///< default capacity of a queue
+
+		/**
+			Creates an empty queue.
+
+			@param capacity the amount of frame bytes the queue takes at most
+		**/
+		explicit SendQueue(size_t capacity = MAX_QUEUED_BYTES);
+
+		/**
+			Discards all queued Transfers referring to a document.
+
+			@param document_id the document id
+		**/
+		void cancel(int32_t document_id);
+		/**
+			Checks whether no Transfers are queued.
+
+			@return whether the queue is empty
+		**/
+		inline bool empty(void) const;
+		/**
+			Generates the next frame to send.
+
+			@param dest a reference to a vector<char> to store the bytestream in
+			@param version the protocol version to encode the frame for
+			@param compression the compression of bulk frames
+			@param window a reference to the amount of bulk frames that may still be sent, it is
+				decremented if a bulk frame is generated
+			@return false if there's nothing to send
+		**/
+		bool next(std::vector<char> &dest, uint8_t version, uint8_t compression, size_t &window);
+		/**
+			Queues a Transfer behind the ones of its priority class, unless the queue would exceed
+			its capacity.
+
+			@param transfer the Transfer to queue
+			@return false if the Transfer has been dropped since the queue is full
+		**/
+		bool push(Transfer &&transfer);
+		/**
+			Returns the amount of frame bytes queued.
+
+			@return the sum of Transfer::get_size(void) of all queued Transfers
+		**/
+		inline size_t size(void) const;
+
+	private:
+		std::deque<Transfer>	bulk; ///< queued bulk Transfers and frames kept behind them
+		size_t					capacity; ///< frame bytes the queue takes at most
+		std::deque<Transfer>	interactive; ///< queued interactive frames
+		size_t					queued; ///< frame bytes queued
+		size_t					streak; ///< interactive frames sent in a row
+};
+
+bool SendQueue::empty(void) const
+{ return bulk.empty() && interactive.empty(); }
+
+size_t SendQueue::size(void) const
+{ return queued; }
+
+#endif
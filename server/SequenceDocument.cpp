@@ -0,0 +1,428 @@
+/**
+ * @file SequenceDocument.cpp
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "SequenceDocument.h"
+
+const size_t SequenceDocument::MAX_LOGGED_OPERATIONS;
+
+// sequence auxiliary functions
+namespace
+{
+	/**
+		Creates a deletion or run of length bytes identified from id on.
+	**/
+	SequenceOperation make_operation(SequenceOperation::Kind kind, const SequenceId &id,
+		int32_t length)
+	{
+		SequenceOperation operation;
+		operation.id = id;
+		operation.kind = kind;
+		operation.length = length;
+
+		return operation;
+	}
+
+	/**
+		Checks whether length bytes can be identified from clock on without overflowing.
+	**/
+	bool fits_clock(int32_t clock, int32_t length)
+	{ return length >= 0 && clock <= std::numeric_limits<int32_t>::max() - length; }
+};
+
+SequenceDocument::SequenceDocument(int32_t size):
+	clock(size), next_site(1), revision(0), root(nullptr)
+{
+	if (size > 0)
+	{ attach(nullptr, make_run(SequenceId { 0, 1 }, size, false)); }
+}
+
+int32_t SequenceDocument::add_site(void)
+{ return next_site++; }
+
+bool SequenceDocument::get_operations_since(int32_t revision, int32_t site,
+	SequenceOperations &dest) const
+{
+	int32_t oldest = this->revision - static_cast<int32_t>(logged.size());
+	if (revision < oldest || revision > this->revision)
+	{ return false; }
+
+	for (auto iter = logged.begin() + (revision - oldest); iter != logged.end(); ++iter)
+	{
+		if (iter->first != site)
+		{ dest.push_back(iter->second); }
+	}
+
+	return true;
+}
+
+SequenceOperations SequenceDocument::get_snapshot(void) const
+{
+	SequenceOperations result;
+
+	for (Run *run = successor(nullptr); run; run = successor(run))
+	{
+		result.push_back(make_operation(SequenceOperation::Kind::KIND_RUN, run->id, run->length));
+		if (run->deleted)
+		{
+			result.push_back(make_operation(SequenceOperation::Kind::KIND_DELETE, run->id,
+				run->length));
+		}
+	}
+
+	return result;
+}
+
+bool SequenceDocument::merge(int32_t site, const SequenceOperations &operations,
+	EditOperations &edits, SequenceOperations &merged)
+{
+	for (const SequenceOperation &operation: operations)
+	{
+		size_t first = merged.size();
+		bool valid = false;
+
+		switch (operation.kind)
+		{
+			case SequenceOperation::Kind::KIND_INSERT:
+				// sites only insert bytes identified by themselves
+				valid = operation.id.site == site &&
+					integrate_insertion(operation, edits, merged);
+				break;
+			case SequenceOperation::Kind::KIND_DELETE:
+				valid = integrate_deletion(operation, edits, merged);
+				break;
+			default:
+				break;
+		}
+
+		for (size_t i = first; i < merged.size(); ++i)
+		{ log(site, merged[i]); }
+
+		if (!valid)
+		{ return false; }
+	}
+
+	return true;
+}
+
+SequenceOperations SequenceDocument::record(const EditOperations &operations)
+{
+	SequenceOperations merged;
+	EditOperations edits;
+
+	for (const EditOperation &operation: normalize_edit_operations(operations))
+	{
+		size_t first = merged.size();
+
+		if (operation.kind == EditOperation::Kind::KIND_DELETE)
+		{
+			// the bytes following a deleted run move to the same position
+			for (int32_t remaining = operation.length; remaining > 0;)
+			{
+				int32_t offset;
+				Run *run = find_position(operation.position, offset);
+				if (offset > 0)
+				{ run = split(run, offset); }
+				if (run->length > remaining)
+				{ split(run, remaining); }
+
+				remaining -= run->length;
+				mark_deleted(run, edits, merged);
+			}
+		}
+		else
+		{
+			// insert behind the byte preceding the position, the new clock is the greatest one
+			SequenceOperation insertion;
+			insertion.bytes = operation.bytes;
+			insertion.id = SequenceId { 0, clock + 1 };
+
+			if (operation.position > 0)
+			{
+				int32_t offset;
+				Run *run = find_position(operation.position - 1, offset);
+				insertion.origin = SequenceId { run->id.site, run->id.clock + offset };
+			}
+
+			integrate_insertion(insertion, edits, merged);
+		}
+
+		for (size_t i = first; i < merged.size(); ++i)
+		{ log(0, merged[i]); }
+	}
+
+	return merged;
+}
+
+void SequenceDocument::attach(Run *predecessor, Run *run)
+{
+	if (!root)
+	{
+		root = run;
+		return;
+	}
+
+	// the new run becomes the left child of the following run or the right child of predecessor
+	Run *parent = predecessor;
+	bool left = false;
+	if (!parent || parent->right)
+	{
+		parent = parent ? parent->right : root;
+		while (parent->left)
+		{ parent = parent->left; }
+		left = true;
+	}
+
+	(left ? parent->left : parent->right) = run;
+	run->parent = parent;
+	update_path(parent);
+
+	while (run->parent && run->priority > run->parent->priority)
+	{ rotate_up(run); }
+}
+
+SequenceDocument::Run *SequenceDocument::find(const SequenceId &id) const
+{
+	auto site = runs.find(id.site);
+	if (site == runs.end())
+	{ return nullptr; }
+
+	auto iter = site->second.upper_bound(id.clock);
+	if (iter == site->second.begin())
+	{ return nullptr; }
+
+	Run *run = (--iter)->second.get();
+	return id.clock - run->id.clock < run->length ? run : nullptr;
+}
+
+SequenceDocument::Run *SequenceDocument::find_position(int32_t position, int32_t &offset) const
+{
+	Run *run = root;
+
+	for (;;)
+	{
+		int32_t left = run->left ? run->left->visible : 0;
+		if (position < left)
+		{
+			run = run->left;
+			continue;
+		}
+
+		position -= left;
+		if (position < run->get_visible())
+		{
+			offset = position;
+			return run;
+		}
+
+		position -= run->get_visible();
+		run = run->right;
+	}
+}
+
+bool SequenceDocument::integrate_insertion(const SequenceOperation &operation,
+	EditOperations &edits, SequenceOperations &merged)
+{
+	int32_t length = operation.bytes.size();
+	if (length == 0)
+	{ return true; }
+
+	// ids must be unused and newer than the origin, the latter is what makes the order converge
+	if (!fits_clock(operation.id.clock, length) || !(operation.origin < operation.id))
+	{ return false; }
+
+	if (find(operation.id))
+	{ return true; }
+
+	auto site = runs.find(operation.id.site);
+	if (site != runs.end())
+	{
+		auto next = site->second.lower_bound(operation.id.clock);
+		if (next != site->second.end() && next->first - operation.id.clock < length)
+		{ return false; }
+	}
+
+	// split the origin's run behind the origin
+	Run *origin = nullptr;
+	if (!(operation.origin == SequenceId()))
+	{
+		origin = find(operation.origin);
+		if (!origin)
+		{ return false; }
+
+		int32_t offset = operation.origin.clock - origin->id.clock + 1;
+		if (offset < origin->length)
+		{ split(origin, offset); }
+	}
+
+	// skip concurrent insertions at the same origin that win the tie, and their successors
+	Run *predecessor = origin;
+	for (Run *next = successor(origin); next && operation.id < next->id; next = successor(next))
+	{ predecessor = next; }
+
+	int32_t position = predecessor ? position_of(predecessor) + predecessor->get_visible() : 0;
+
+	// continue the origin's run when typing on
+	if (predecessor && predecessor == origin && !origin->deleted &&
+		origin->id.site == operation.id.site &&
+		origin->id.clock + origin->length == operation.id.clock)
+	{
+		origin->length += length;
+		update_path(origin);
+	}
+	else
+	{ attach(predecessor, make_run(operation.id, length, false)); }
+
+	clock = std::max(clock, operation.id.clock + length - 1);
+	edits.push_back(EditOperation(EditOperation::Kind::KIND_INSERT, position, 0,
+		operation.bytes));
+	merged.push_back(operation);
+
+	return true;
+}
+
+bool SequenceDocument::integrate_deletion(const SequenceOperation &operation,
+	EditOperations &edits, SequenceOperations &merged)
+{
+	if (!fits_clock(operation.id.clock, operation.length))
+	{ return false; }
+
+	// the bytes may span several runs, deleted ones are skipped
+	int32_t end = operation.id.clock + operation.length;
+	for (int32_t current = operation.id.clock; current < end;)
+	{
+		Run *run = find(SequenceId { operation.id.site, current });
+		if (!run)
+		{ return false; }
+
+		if (run->deleted)
+		{
+			current = run->id.clock + run->length;
+			continue;
+		}
+
+		if (run->id.clock < current)
+		{ run = split(run, current - run->id.clock); }
+		if (run->length > end - current)
+		{ split(run, end - current); }
+
+		mark_deleted(run, edits, merged);
+		current += run->length;
+	}
+
+	return true;
+}
+
+void SequenceDocument::log(int32_t site, const SequenceOperation &operation)
+{
+	logged.push_back(std::make_pair(site, operation));
+	++revision;
+
+	if (logged.size() > MAX_LOGGED_OPERATIONS)
+	{ logged.pop_front(); }
+}
+
+void SequenceDocument::mark_deleted(Run *run, EditOperations &edits, SequenceOperations &merged)
+{
+	edits.push_back(EditOperation(EditOperation::Kind::KIND_DELETE, position_of(run),
+		run->length));
+	merged.push_back(make_operation(SequenceOperation::Kind::KIND_DELETE, run->id, run->length));
+
+	run->deleted = true;
+	update_path(run);
+}
+
+SequenceDocument::Run *SequenceDocument::make_run(const SequenceId &id, int32_t length,
+	bool deleted)
+{
+	Run *run = new Run { id, length, deleted, static_cast<uint32_t>(random()), 0, nullptr,
+		nullptr, nullptr };
+	run->update();
+	runs[id.site][id.clock].reset(run);
+
+	return run;
+}
+
+int32_t SequenceDocument::position_of(const Run *run) const
+{
+	int32_t position = run->left ? run->left->visible : 0;
+
+	for (; run->parent; run = run->parent)
+	{
+		const Run *parent = run->parent;
+		if (parent->right == run)
+		{ position += (parent->left ? parent->left->visible : 0) + parent->get_visible(); }
+	}
+
+	return position;
+}
+
+void SequenceDocument::rotate_up(Run *run)
+{
+	Run *parent = run->parent;
+	Run *grandparent = parent->parent;
+
+	if (parent->left == run)
+	{
+		parent->left = run->right;
+		if (run->right)
+		{ run->right->parent = parent; }
+		run->right = parent;
+	}
+	else
+	{
+		parent->right = run->left;
+		if (run->left)
+		{ run->left->parent = parent; }
+		run->left = parent;
+	}
+
+	parent->parent = run;
+	run->parent = grandparent;
+	if (!grandparent)
+	{ root = run; }
+	else
+	{ (grandparent->left == parent ? grandparent->left : grandparent->right) = run; }
+
+	parent->update();
+	run->update();
+}
+
+SequenceDocument::Run *SequenceDocument::split(Run *run, int32_t offset)
+{
+	Run *second = make_run(SequenceId { run->id.site, run->id.clock + offset },
+		run->length - offset, run->deleted);
+
+	run->length = offset;
+	update_path(run);
+	attach(run, second);
+
+	return second;
+}
+
+SequenceDocument::Run *SequenceDocument::successor(Run *run) const
+{
+	// leftmost run of the right subtree, otherwise the first ancestor to the right
+	if (!run || run->right)
+	{
+		run = run ? run->right : root;
+		while (run && run->left)
+		{ run = run->left; }
+
+		return run;
+	}
+
+	while (run->parent && run->parent->right == run)
+	{ run = run->parent; }
+
+	return run->parent;
+}
+
+void SequenceDocument::update_path(Run *run)
+{
+	for (; run; run = run->parent)
+	{ run->update(); }
+}
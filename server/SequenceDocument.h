@@ -0,0 +1,222 @@
+/**	@file SequenceDocument.h
+**/
+
+#ifndef _SEQUENCEDOCUMENT_H_
+#define _SEQUENCEDOCUMENT_H_
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <utility>
+
+#include "EditOperation.h"
+#include "SequenceOperation.h"
+
+/**
+	@brief Sequence CRDT of an open document, kept beside its Document.
+
+	The document is represented as a replicated growable array (RGA): every byte ever inserted keeps
+	its SequenceId, deleted bytes stay as tombstones. An insertion is placed behind its origin,
+	skipping concurrent insertions with greater identifiers, so all sites integrating the same
+	operations end up with the same order regardless of the order they receive them in. This lets
+	clients edit offline and merge all of their edits at once when they reconnect.
+
+	Bytes with consecutive identifiers are stored as one run, the contents themselves stay in the
+	Document. The runs form a treap ordered by document position, indexed by identifier, so
+	integrating an operation and finding its position take logarithmic time in the amount of runs.
+	Merging thus costs in proportion to the operations merged, not to the document size.
+
+	All operations integrated are logged, so a client reconnecting with the revision it last saw
+	receives only the operations it missed.
+**/
+class SequenceDocument
+{
+	public:
+		static const size_t MAX_LOGGED_OPERATIONS = 16384; ///< operations kept for reconnects
+
+		/**
+			Creates the sequence of a document whose contents are inserted by the server.
+
+			@param size the size of the document contents
+		**/
+		explicit SequenceDocument(int32_t size);
+
+		/**
+			Assigns a new site to a client entering sequence mode.
+
+			@return the site, greater than 0
+		**/
+		int32_t add_site(void);
+		/**
+			Returns the operations integrated after a revision, except those inserted by a site.
+
+			@param revision the last revision the site received
+			@param site the site asking, whose own operations are left out
+			@param dest a reference to store the operations in
+			@return false if the revision is newer than the current one or operations after it
+				aren't logged anymore
+		**/
+		bool get_operations_since(int32_t revision, int32_t site, SequenceOperations &dest) const;
+		/**
+			Returns the current revision.
+
+			@return the amount of operations integrated so far
+		**/
+		inline int32_t get_revision(void) const;
+		/**
+			Returns the current state for a client entering sequence mode: a KIND_RUN for every run
+			in document order, each deleted run followed by a KIND_DELETE of its identifiers.
+
+			@return the snapshot
+		**/
+		SequenceOperations get_snapshot(void) const;
+		/**
+			Checks whether a site has been assigned by add_site(void).
+
+			@param site the site to check
+			@return whether the site is known
+		**/
+		inline bool has_site(int32_t site) const;
+		/**
+			Integrates operations of a site. Operations already integrated are skipped. Stops at
+			the first operation that can't be integrated, because it refers to unknown bytes,
+			inserts bytes of another site, or its identifiers don't follow its origin's.
+
+			@param site the site that sent the operations
+			@param operations the operations in causal order
+			@param edits a reference to append the resulting changes of the contents to
+			@param merged a reference to append the operations that changed the sequence to
+			@return whether all operations have been integrated
+		**/
+		bool merge(int32_t site, const SequenceOperations &operations, EditOperations &edits,
+			SequenceOperations &merged);
+		/**
+			Integrates edits applied by a client that isn't in sequence mode as edits of the
+			server.
+
+			@param operations the edits, each position relative to the result of the preceding one
+			@return the operations that changed the sequence
+		**/
+		SequenceOperations record(const EditOperations &operations);
+
+	private:
+		/**
+			@brief Bytes with consecutive identifiers, a node of the treap.
+		**/
+		struct Run
+		{
+			SequenceId	id; ///< identifier of the first byte
+			int32_t		length; ///< amount of bytes
+			bool		deleted; ///< whether the bytes are tombstones
+			uint32_t	priority; ///< treap heap priority
+			int32_t		visible; ///< amount of bytes not deleted in the subtree
+			Run			*left; ///< preceding runs
+			Run			*right; ///< following runs
+			Run			*parent; ///< parent node, nullptr for the root
+
+			/**
+				Returns the amount of bytes of this run that are part of the contents.
+			**/
+			int32_t get_visible(void) const
+			{ return deleted ? 0 : length; }
+			/**
+				Recomputes the visible bytes of the subtree from the children.
+			**/
+			void update(void)
+			{ visible = get_visible() + (left ? left->visible : 0) + (right ? right->visible : 0); }
+		};
+
+		typedef std::deque<std::pair<int32_t, SequenceOperation>> Log; ///< operations and sites
+		typedef std::map<int32_t, std::unique_ptr<Run>> SiteRuns; ///< runs of a site by clock
+
+		/**
+			Inserts a run into the treap directly behind another one.
+
+			@param predecessor the run to insert behind, nullptr to insert at the start
+			@param run the run to insert
+		**/
+		void attach(Run *predecessor, Run *run);
+		/**
+			Returns the run containing the byte with the given identifier.
+
+			@return the run or nullptr if the identifier is unknown
+		**/
+		Run *find(const SequenceId &id) const;
+		/**
+			Returns the run containing the byte at a position of the contents.
+
+			@param position the position, less than the contents size
+			@param offset a reference to store the offset of the byte within the run in
+		**/
+		Run *find_position(int32_t position, int32_t &offset) const;
+		/**
+			Integrates an insertion.
+
+			@return whether the insertion is valid
+		**/
+		bool integrate_insertion(const SequenceOperation &operation, EditOperations &edits,
+			SequenceOperations &merged);
+		/**
+			Integrates a deletion.
+
+			@return whether the deletion only refers to known bytes
+		**/
+		bool integrate_deletion(const SequenceOperation &operation, EditOperations &edits,
+			SequenceOperations &merged);
+		/**
+			Appends an operation to the log, forgetting the oldest one if the log is full.
+		**/
+		void log(int32_t site, const SequenceOperation &operation);
+		/**
+			Marks a run as deleted and records the deletion.
+		**/
+		void mark_deleted(Run *run, EditOperations &edits, SequenceOperations &merged);
+		/**
+			Creates a run and adds it to the identifier index.
+		**/
+		Run *make_run(const SequenceId &id, int32_t length, bool deleted);
+		/**
+			Returns the position of the first byte of a run within the contents.
+		**/
+		int32_t position_of(const Run *run) const;
+		/**
+			Rotates a run above its parent.
+		**/
+		void rotate_up(Run *run);
+		/**
+			Splits a run, the second part starts offset bytes after the first one.
+
+			@return the second part
+		**/
+		Run *split(Run *run, int32_t offset);
+		/**
+			Returns the run following another one in document order.
+
+			@param run the run, nullptr to get the first run
+			@return the following run or nullptr if there is none
+		**/
+		Run *successor(Run *run) const;
+		/**
+			Recomputes the visible bytes of a run and all its ancestors.
+		**/
+		void update_path(Run *run);
+
+		int32_t									clock; ///< highest clock seen so far
+		Log										logged; ///< operations integrated lately
+		int32_t									next_site; ///< site assigned next
+		std::minstd_rand						random; ///< source of treap priorities
+		int32_t									revision; ///< amount of operations integrated
+		Run										*root; ///< root of the treap
+		std::unordered_map<int32_t, SiteRuns>	runs; ///< owns all runs, indexed by identifier
+};
+
+int32_t SequenceDocument::get_revision(void) const
+{ return revision; }
+
+bool SequenceDocument::has_site(int32_t site) const
+{ return site > 0 && site < next_site; }
+
+#endif
@@ -0,0 +1,96 @@
+/**	@file SequenceOperation.h
+**/
+
+#ifndef _SEQUENCEOPERATION_H_
+#define _SEQUENCEOPERATION_H_
+
+#include <cstdint>
+#include <vector>
+
+/**
+	@brief Identifier of a single byte of a document in sequence mode.
+
+	Every byte ever inserted is identified by the site that inserted it and the site's Lamport clock
+	at that time. Consecutive bytes of one insertion have consecutive clocks. Site 0 is the server,
+	which inserts the initial contents and the edits of clients that aren't in sequence mode. The
+	identifier {0, 0} is never assigned, it is the origin of insertions at the start of the
+	document.
+**/
+struct SequenceId
+{
+	int32_t	site; ///< the inserting site
+	int32_t	clock; ///< Lamport clock of the inserting site
+
+	/**
+		Creates an identifier, by default the origin of insertions at the start of the document.
+
+		@param site the inserting site
+		@param clock Lamport clock of the inserting site
+	**/
+	SequenceId(int32_t site = 0, int32_t clock = 0):
+		site(site), clock(clock)
+	{}
+
+	/**
+		Compares two identifiers for equality.
+	**/
+	inline bool operator==(const SequenceId &other) const;
+	/**
+		Orders identifiers by clock, then by site, which orders concurrent insertions at the same
+		origin.
+	**/
+	inline bool operator<(const SequenceId &other) const;
+};
+
+/**
+	@brief A single edit of a document in sequence mode, as carried by TYPE_SYNC_MERGE.
+
+	Unlike EditOperation, operations refer to bytes by their SequenceId instead of their position,
+	so they can be applied in any order that respects causality and applying them twice changes
+	nothing.
+**/
+struct SequenceOperation
+{
+	/**
+		The kind of an operation.
+	**/
+	enum class Kind : uint8_t
+	{
+		KIND_INSERT, ///< insert bytes identified from id on after origin (id, origin, bytes)
+		KIND_DELETE, ///< delete the bytes identified from id on (id, length)
+		KIND_RUN ///< appends bytes identified from id on, only used for snapshots (id, length)
+	};
+
+	std::vector<char>	bytes; ///< bytes to insert
+	SequenceId			id; ///< identifier of the first affected byte
+	Kind				kind; ///< kind of the operation
+	int32_t				length; ///< amount of affected bytes, ignored for insertions
+	SequenceId			origin; ///< byte after which to insert, ignored unless inserting
+
+	/**
+		Default constructor. Creates an empty insertion at the start of the document.
+	**/
+	SequenceOperation(void):
+		kind(Kind::KIND_INSERT), length(0)
+	{}
+
+	/**
+		Returns the amount of bytes the operation identifies.
+
+		@return the amount of bytes for insertions, the length otherwise
+	**/
+	inline int32_t get_length(void) const;
+};
+
+typedef std::vector<SequenceOperation> SequenceOperations; ///< operations in causal order
+
+bool SequenceId::operator==(const SequenceId &other) const
+{ return site == other.site && clock == other.clock; }
+
+bool SequenceId::operator<(const SequenceId &other) const
+{ return clock < other.clock || (clock == other.clock && site < other.site); }
+
+int32_t SequenceOperation::get_length(void) const
+{ return kind == Kind::KIND_INSERT ? static_cast<int32_t>(bytes.size()) : length; }
+
+#endif
@@ -0,0 +1,112 @@
+#include "TextSearch.h"
+#include "TextStatistics.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+
+//! whether the AVX2 kernel is compiled, it is selected at runtime
+#define TEXT_SEARCH_AVX2
+#endif
+
+/**
+ * @file server/TextSearch.cpp
+ *
+ * Implementation file for the search of literal bytes within text.
+ */
+
+namespace
+{
+	/**
+	 * Find a pattern trying one position after the other.
+	 *
+	 * @param begin The first byte of the text.
+	 * @param end The end of the text.
+	 * @param pattern The bytes to search for, not empty.
+	 * @return The start of the first occurrence, end if there is none.
+	 */
+	char const *find_scalar(char const *begin, char const *end, std::string const &pattern)
+	{
+		return std::search(begin, end, pattern.begin(), pattern.end());
+	}
+
+#ifdef TEXT_SEARCH_AVX2
+	//! the positions compared at once by the AVX2 kernel
+	std::ptrdiff_t const BLOCK_SIZE = 32;
+
+	/**
+	 * Find a pattern comparing its first and last byte with a block of
+	 * positions at once (Muła, "SIMD-friendly algorithms for substring
+	 * searching"). Positions too close to the end for a whole block are
+	 * left to the scalar kernel.
+	 *
+	 * @param begin The first byte of the text.
+	 * @param end The end of the text.
+	 * @param pattern The bytes to search for, not empty.
+	 * @return The start of the first occurrence, end if there is none.
+	 */
+	__attribute__((target("avx2")))
+	char const *find_avx2(char const *begin, char const *end, std::string const &pattern)
+	{
+		std::ptrdiff_t const size = pattern.size();
+		__m256i const first = _mm256_set1_epi8(pattern.front());
+		__m256i const last = _mm256_set1_epi8(pattern.back());
+		char const *block = begin;
+
+		for (; end - block >= size - 1 + BLOCK_SIZE; block += BLOCK_SIZE)
+		{
+			__m256i const firsts = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(block));
+			__m256i const lasts = _mm256_loadu_si256(
+				reinterpret_cast<__m256i const *>(block + size - 1));
+			std::uint32_t candidates = _mm256_movemask_epi8(_mm256_and_si256(
+				_mm256_cmpeq_epi8(firsts, first), _mm256_cmpeq_epi8(lasts, last)));
+
+			for (; candidates != 0; candidates &= candidates - 1)
+			{
+				char const *const candidate = block + __builtin_ctz(candidates);
+
+				if (size <= 2 || std::memcmp(candidate + 1, pattern.data() + 1, size - 2) == 0)
+				{
+					return candidate;
+				}
+			}
+		}
+
+		return find_scalar(block, end, pattern);
+	}
+#endif
+}
+
+char const *TextSearch::find(char const *begin, char const *end, std::string const &pattern)
+{
+	if (pattern.empty())
+	{
+		return end;
+	}
+
+#ifdef TEXT_SEARCH_AVX2
+	if (TextStatistics::get_kernel() == TextStatistics::Kernel::KERNEL_AVX2)
+	{
+		return find_avx2(begin, end, pattern);
+	}
+#endif
+
+	return find_scalar(begin, end, pattern);
+}
+
+std::vector<std::int64_t> TextSearch::find_all(char const *begin, char const *end,
+                                               std::string const &pattern)
+{
+	std::vector<std::int64_t> positions;
+
+	for (char const *match = begin; (match = find(match, end, pattern)) != end;
+	     match += pattern.size())
+	{
+		positions.push_back(match - begin);
+	}
+
+	return positions;
+}
@@ -0,0 +1,62 @@
+#ifndef TEXTSEARCH_H_INCLUDED
+#define TEXTSEARCH_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @file server/TextSearch.h
+ *
+ * Interface for the search of literal bytes within text.
+ */
+
+/**
+ * The search of a pattern of bytes within text.
+ *
+ * The text is searched by the kernel selected for the TextStatistics, see
+ * TextStatistics::set_kernel(). The AVX2 kernel compares the first and the
+ * last byte of the pattern with 32 positions at once and only compares the
+ * rest of the pattern where both match, the scalar kernel tries one
+ * position after the other.
+ *
+ * @startuml{TextSearch_Class.svg}
+ * class TextSearch {
+ * + {static} find(begin: char const *, end: char const *, pattern: string const &): char const *
+ * + {static} find_all(begin: char const *, end: char const *, pattern: string const &): vector<int64_t>
+ * }
+ * @enduml
+ */
+class TextSearch
+{
+public:
+	/**
+	 * Delete the default constructor, there are static functions only.
+	 */
+	TextSearch() = delete;
+
+	/**
+	 * Find the first occurrence of a pattern.
+	 *
+	 * @param begin The first byte of the text.
+	 * @param end The end of the text.
+	 * @param pattern The bytes to search for.
+	 * @return The start of the first occurrence, end if the pattern doesn't
+	 *         occur or is empty.
+	 */
+	static char const *find(char const *begin, char const *end, std::string const &pattern);
+
+	/**
+	 * Find all occurrences of a pattern which don't overlap, searching from
+	 * the front, e.g. "aa" occurs at 0 and 2 within "aaaaa".
+	 *
+	 * @param begin The first byte of the text.
+	 * @param end The end of the text.
+	 * @param pattern The bytes to search for.
+	 * @return The positions of the occurrences, none if the pattern is empty.
+	 */
+	static std::vector<std::int64_t> find_all(char const *begin, char const *end,
+	                                          std::string const &pattern);
+};
+
+#endif
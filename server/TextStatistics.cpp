@@ -0,0 +1,425 @@
+#include "TextStatistics.h"
+
+#include <cstddef>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+
+//! whether the AVX2 kernel is compiled, it is selected at runtime
+#define TEXT_STATISTICS_AVX2
+#endif
+
+/**
+ * @file server/TextStatistics.cpp
+ *
+ * Implementation file for the line and word counts and the UTF-8 validation of text.
+ */
+
+TextStatistics::Kernel TextStatistics::kernel_ =
+	TextStatistics::is_supported(TextStatistics::Kernel::KERNEL_AVX2) ?
+	TextStatistics::Kernel::KERNEL_AVX2 : TextStatistics::Kernel::KERNEL_SCALAR;
+
+namespace
+{
+	/**
+	 * Check if a byte is ASCII whitespace.
+	 *
+	 * @param byte The byte.
+	 * @return 'true' for space, tab, line feed, vertical tab, form feed and
+	 *         carriage return.
+	 */
+	bool is_whitespace(unsigned char byte)
+	{
+		return byte == ' ' || (byte >= '\t' && byte <= '\r');
+	}
+
+	/**
+	 * Validate UTF-8 a character at a time.
+	 *
+	 * @param begin The first byte.
+	 * @param end The end of the bytes.
+	 * @return 'true' if the bytes are valid UTF-8.
+	 */
+	bool is_valid_utf8_scalar(unsigned char const *begin, unsigned char const *end)
+	{
+		while (begin != end)
+		{
+			unsigned char const lead = *begin++;
+			std::ptrdiff_t length;
+			// the range of the first continuation byte excludes overlong encodings,
+			// surrogates and code points beyond U+10FFFF
+			unsigned char low = 0x80;
+			unsigned char high = 0xbf;
+
+			if (lead < 0x80)
+			{
+				continue;
+			}
+			else if (lead >= 0xc2 && lead <= 0xdf)
+			{
+				length = 1;
+			}
+			else if (lead >= 0xe0 && lead <= 0xef)
+			{
+				length = 2;
+				low = lead == 0xe0 ? 0xa0 : low;
+				high = lead == 0xed ? 0x9f : high;
+			}
+			else if (lead >= 0xf0 && lead <= 0xf4)
+			{
+				length = 3;
+				low = lead == 0xf0 ? 0x90 : low;
+				high = lead == 0xf4 ? 0x8f : high;
+			}
+			else
+			{
+				return false;
+			}
+
+			if (end - begin < length || begin[0] < low || begin[0] > high)
+			{
+				return false;
+			}
+
+			for (std::ptrdiff_t i = 1; i < length; i++)
+			{
+				if ((begin[i] & 0xc0) != 0x80)
+				{
+					return false;
+				}
+			}
+
+			begin += length;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Scan text a byte at a time.
+	 *
+	 * @param begin The first byte.
+	 * @param end The end of the bytes.
+	 * @param count Whether to count lines and words or to validate only.
+	 * @return The statistics, without counts unless requested.
+	 */
+	TextStatistics scan_scalar(unsigned char const *begin, unsigned char const *end, bool count)
+	{
+		TextStatistics statistics;
+		bool in_word = false;
+
+		statistics.valid_utf8 = is_valid_utf8_scalar(begin, end);
+
+		for (; count && begin != end; ++begin)
+		{
+			bool const word = !is_whitespace(*begin);
+
+			statistics.lines += *begin == '\n';
+			statistics.words += word && !in_word;
+			in_word = word;
+		}
+
+		return statistics;
+	}
+
+#ifdef TEXT_STATISTICS_AVX2
+	//! the bytes scanned at once by the AVX2 kernel
+	std::size_t const BLOCK_SIZE = 32;
+
+	// The UTF-8 errors found by looking at two consecutive bytes, one bit each.
+	// A byte pair is invalid if the flags of the high and low nibble of the
+	// first byte and of the high nibble of the second byte have a bit in common
+	// (Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte").
+
+	//! a lead byte followed by ASCII or another lead byte
+	std::uint8_t const TOO_SHORT = 1 << 0;
+	//! ASCII followed by a continuation byte
+	std::uint8_t const TOO_LONG = 1 << 1;
+	//! 11100000 100xxxxx, a 3 byte encoding of a 2 byte character
+	std::uint8_t const OVERLONG_3 = 1 << 2;
+	//! 11110100 1001xxxx and beyond, code points beyond U+10FFFF
+	std::uint8_t const TOO_LARGE = 1 << 3;
+	//! 11101101 101xxxxx, a surrogate
+	std::uint8_t const SURROGATE = 1 << 4;
+	//! 1100000x 10xxxxxx, a 2 byte encoding of ASCII
+	std::uint8_t const OVERLONG_2 = 1 << 5;
+	//! 11110000 1000xxxx, a 4 byte encoding of a 3 byte character, or
+	//! 11110101 1000xxxx and beyond, code points beyond U+10FFFF
+	std::uint8_t const OVERLONG_4 = 1 << 6;
+	//! a continuation byte following another one, valid within 3 and 4 byte characters
+	std::uint8_t const TWO_CONTINUATIONS = 1 << 7;
+	//! the flags which don't depend on the low nibble of the first byte
+	std::uint8_t const CARRY = TOO_SHORT | TOO_LONG | TWO_CONTINUATIONS;
+
+	//! the flags by the high nibble of the first byte
+	std::uint8_t const FIRST_HIGH[16] = {
+		TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+		TWO_CONTINUATIONS, TWO_CONTINUATIONS, TWO_CONTINUATIONS, TWO_CONTINUATIONS,
+		TOO_SHORT | OVERLONG_2,
+		TOO_SHORT,
+		TOO_SHORT | OVERLONG_3 | SURROGATE,
+		TOO_SHORT | TOO_LARGE | OVERLONG_4
+	};
+
+	//! the flags by the low nibble of the first byte
+	std::uint8_t const FIRST_LOW[16] = {
+		CARRY | OVERLONG_2 | OVERLONG_3 | OVERLONG_4,
+		CARRY | OVERLONG_2,
+		CARRY,
+		CARRY,
+		CARRY | TOO_LARGE,
+		CARRY | TOO_LARGE | OVERLONG_4,
+		CARRY | TOO_LARGE | OVERLONG_4,
+		CARRY | TOO_LARGE | OVERLONG_4,
+		CARRY | TOO_LARGE | OVERLONG_4,
+		CARRY | TOO_LARGE | OVERLONG_4,
+		CARRY | TOO_LARGE | OVERLONG_4,
+		CARRY | TOO_LARGE | OVERLONG_4,
+		CARRY | TOO_LARGE | OVERLONG_4,
+		CARRY | TOO_LARGE | OVERLONG_4 | SURROGATE,
+		CARRY | TOO_LARGE | OVERLONG_4,
+		CARRY | TOO_LARGE | OVERLONG_4
+	};
+
+	//! the flags by the high nibble of the second byte
+	std::uint8_t const SECOND_HIGH[16] = {
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+		TOO_LONG | OVERLONG_2 | TWO_CONTINUATIONS | OVERLONG_3 | OVERLONG_4,
+		TOO_LONG | OVERLONG_2 | TWO_CONTINUATIONS | OVERLONG_3 | TOO_LARGE,
+		TOO_LONG | OVERLONG_2 | TWO_CONTINUATIONS | SURROGATE | TOO_LARGE,
+		TOO_LONG | OVERLONG_2 | TWO_CONTINUATIONS | SURROGATE | TOO_LARGE,
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+	};
+
+	//! the largest bytes which don't start a character exceeding the end of a block
+	std::uint8_t const LAST_COMPLETE[BLOCK_SIZE] = {
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		0xff, 0xff, 0xff, 0xff, 0xff, 0xef, 0xdf, 0xbf
+	};
+
+	/**
+	 * Look up a table of 16 bytes for every byte of a block.
+	 *
+	 * @param table The table.
+	 * @param nibbles The indices, 0 to 15.
+	 * @return The entries.
+	 */
+	__attribute__((target("avx2")))
+	__m256i lookup(std::uint8_t const (&table)[16], __m256i nibbles)
+	{
+		__m128i const entries = _mm_loadu_si128(reinterpret_cast<__m128i const *>(table));
+
+		return _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(entries), nibbles);
+	}
+
+	/**
+	 * Obtain the high nibble of every byte of a block.
+	 *
+	 * @param block The block.
+	 * @return The nibbles, 0 to 15.
+	 */
+	__attribute__((target("avx2")))
+	__m256i get_high_nibbles(__m256i block)
+	{
+		return _mm256_and_si256(_mm256_srli_epi16(block, 4), _mm256_set1_epi8(0x0f));
+	}
+
+	/**
+	 * Shift the last bytes of the previous block in front of a block.
+	 *
+	 * @tparam N The amount of bytes to shift in.
+	 * @param block The block.
+	 * @param previous The block preceding it.
+	 * @return The block, starting N bytes earlier.
+	 */
+	template <int N>
+	__attribute__((target("avx2")))
+	__m256i shift_in(__m256i block, __m256i previous)
+	{
+		// the upper half of the previous block followed by the lower half of this one
+		__m256i const joined = _mm256_permute2x128_si256(previous, block, 0x21);
+
+		return _mm256_alignr_epi8(block, joined, 16 - N);
+	}
+
+	/**
+	 * Find the UTF-8 errors within a block and at its start.
+	 *
+	 * @param block The block.
+	 * @param previous The block preceding it, zeros for the first one.
+	 * @return Bits set at every invalid byte.
+	 */
+	__attribute__((target("avx2")))
+	__m256i find_utf8_errors(__m256i block, __m256i previous)
+	{
+		__m256i const previous1 = shift_in<1>(block, previous);
+		__m256i const nibbles = _mm256_and_si256(previous1, _mm256_set1_epi8(0x0f));
+		__m256i const special = _mm256_and_si256(
+			_mm256_and_si256(lookup(FIRST_HIGH, get_high_nibbles(previous1)),
+			                 lookup(FIRST_LOW, nibbles)),
+			lookup(SECOND_HIGH, get_high_nibbles(block)));
+
+		// the third and fourth byte of a character are its only continuations following
+		// another one, they are 0x80 or above after the saturating subtractions
+		__m256i const third = _mm256_subs_epu8(shift_in<2>(block, previous),
+		                                       _mm256_set1_epi8(0xe0 - 0x80));
+		__m256i const fourth = _mm256_subs_epu8(shift_in<3>(block, previous),
+		                                        _mm256_set1_epi8(0xf0 - 0x80));
+		__m256i const expected = _mm256_and_si256(_mm256_or_si256(third, fourth),
+		                                          _mm256_set1_epi8(static_cast<char>(0x80)));
+
+		return _mm256_xor_si256(expected, special);
+	}
+
+	/**
+	 * Scan text 32 bytes at a time.
+	 *
+	 * @param begin The first byte.
+	 * @param end The end of the bytes.
+	 * @param count Whether to count lines and words or to validate only.
+	 * @return The statistics, without counts unless requested.
+	 */
+	__attribute__((target("avx2,popcnt")))
+	TextStatistics scan_avx2(unsigned char const *begin, unsigned char const *end, bool count)
+	{
+		TextStatistics statistics;
+		std::size_t const size = end - begin;
+		__m256i previous = _mm256_setzero_si256();
+		__m256i errors = _mm256_setzero_si256();
+		__m256i incomplete = _mm256_setzero_si256();
+		__m256i const last_complete =
+			_mm256_loadu_si256(reinterpret_cast<__m256i const *>(LAST_COMPLETE));
+		std::uint32_t in_word = 0;
+
+		for (std::size_t offset = 0; offset < size; offset += BLOCK_SIZE)
+		{
+			__m256i block;
+
+			// the last block is padded with spaces, they neither count nor continue characters
+			if (size - offset >= BLOCK_SIZE)
+			{
+				block = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(begin + offset));
+			}
+			else
+			{
+				unsigned char tail[BLOCK_SIZE];
+
+				std::memset(tail, ' ', BLOCK_SIZE);
+				std::memcpy(tail, begin + offset, size - offset);
+				block = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(tail));
+			}
+
+			// ASCII is valid, unless a character of the previous block is missing bytes
+			if (_mm256_movemask_epi8(block) == 0)
+			{
+				errors = _mm256_or_si256(errors, incomplete);
+				incomplete = _mm256_setzero_si256();
+			}
+			else
+			{
+				errors = _mm256_or_si256(errors, find_utf8_errors(block, previous));
+				incomplete = _mm256_subs_epu8(block, last_complete);
+			}
+
+			previous = block;
+
+			if (!count)
+			{
+				continue;
+			}
+
+			// whitespace is a space or one of the 5 bytes from a tab on
+			__m256i const control = _mm256_sub_epi8(block, _mm256_set1_epi8('\t'));
+			__m256i const space = _mm256_or_si256(
+				_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')),
+				_mm256_cmpeq_epi8(_mm256_min_epu8(control, _mm256_set1_epi8(4)), control));
+			std::uint32_t const newlines =
+				_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n')));
+			std::uint32_t const words = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(space));
+
+			// a word starts at every byte of a word not preceded by one
+			statistics.lines += __builtin_popcount(newlines);
+			statistics.words += __builtin_popcount(words & ~(words << 1 | in_word));
+			in_word = words >> 31;
+		}
+
+		errors = _mm256_or_si256(errors, incomplete);
+		statistics.valid_utf8 = _mm256_testz_si256(errors, errors);
+
+		return statistics;
+	}
+#endif
+
+	/**
+	 * Scan text with a kernel.
+	 *
+	 * @param kernel The kernel, which has to be supported.
+	 * @param begin The first byte.
+	 * @param end The end of the bytes.
+	 * @param count Whether to count lines and words or to validate only.
+	 * @return The statistics, without counts unless requested.
+	 */
+	TextStatistics scan_with(TextStatistics::Kernel kernel, char const *begin, char const *end,
+	                         bool count)
+	{
+		unsigned char const *const first = reinterpret_cast<unsigned char const *>(begin);
+		unsigned char const *const last = reinterpret_cast<unsigned char const *>(end);
+
+#ifdef TEXT_STATISTICS_AVX2
+		if (kernel == TextStatistics::Kernel::KERNEL_AVX2)
+		{
+			return scan_avx2(first, last, count);
+		}
+#else
+		static_cast<void>(kernel);
+#endif
+
+		return scan_scalar(first, last, count);
+	}
+}
+
+TextStatistics::TextStatistics()
+	: lines(1),
+	  words(0),
+	  valid_utf8(true)
+{
+}
+
+TextStatistics TextStatistics::scan(char const *begin, char const *end)
+{
+	return scan_with(kernel_, begin, end, true);
+}
+
+bool TextStatistics::is_valid_utf8(char const *begin, char const *end)
+{
+	return scan_with(kernel_, begin, end, false).valid_utf8;
+}
+
+bool TextStatistics::is_supported(Kernel kernel)
+{
+	switch (kernel)
+	{
+#ifdef TEXT_STATISTICS_AVX2
+	case Kernel::KERNEL_AVX2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+	case Kernel::KERNEL_SCALAR:
+		return true;
+	default:
+		return false;
+	}
+}
+
+TextStatistics::Kernel TextStatistics::get_kernel()
+{
+	return kernel_;
+}
+
+void TextStatistics::set_kernel(Kernel kernel)
+{
+	kernel_ = is_supported(kernel) ? kernel : Kernel::KERNEL_SCALAR;
+}
@@ -0,0 +1,117 @@
+#ifndef TEXTSTATISTICS_H_INCLUDED
+#define TEXTSTATISTICS_H_INCLUDED
+
+#include <cstdint>
+
+/**
+ * @file server/TextStatistics.h
+ *
+ * Interface for the line and word counts and the UTF-8 validation of text.
+ */
+
+/**
+ * The line and word counts of some text and whether it is valid UTF-8.
+ *
+ * A line ends with a newline, the text after the last newline is a line as
+ * well, so every text has at least one line like in the LineIndex. A word
+ * is a run of bytes other than ASCII whitespace, i.e. space, tab, line
+ * feed, vertical tab, form feed and carriage return. UTF-8 is valid as
+ * defined by RFC 3629, without overlong encodings, surrogates or code
+ * points beyond U+10FFFF.
+ *
+ * The text is scanned by vectorized kernels, 32 bytes at a time with AVX2
+ * if the processor supports it, a byte at a time otherwise. The kernel is
+ * chosen once, set_kernel() overrides the choice e.g. to compare them.
+ *
+ * @startuml{TextStatistics_Class.svg}
+ * class TextStatistics {
+ * .. Construction ..
+ * + TextStatistics()
+ * __
+ * + {static} scan(begin: char const *, end: char const *): TextStatistics
+ * + {static} is_valid_utf8(begin: char const *, end: char const *): bool
+ * + {static} is_supported(kernel: Kernel): bool
+ * + {static} get_kernel(): Kernel
+ * + {static} set_kernel(kernel: Kernel)
+ * __ attributes __
+ * + lines: int64_t
+ * + words: int64_t
+ * + valid_utf8: bool
+ * - {static} kernel_: Kernel
+ * }
+ * @enduml
+ */
+class TextStatistics
+{
+public:
+	/**
+	 * The implementations of the scans.
+	 */
+	enum class Kernel
+	{
+		//! a byte at a time, available everywhere
+		KERNEL_SCALAR,
+		//! 32 bytes at a time, x86 processors supporting AVX2 only
+		KERNEL_AVX2
+	};
+
+	/**
+	 * Construct the statistics of an empty text.
+	 */
+	TextStatistics();
+
+	/**
+	 * Count the lines and words of some text and validate it.
+	 *
+	 * @param begin The first byte.
+	 * @param end The end of the bytes.
+	 * @return The statistics of the bytes.
+	 */
+	static TextStatistics scan(char const *begin, char const *end);
+
+	/**
+	 * Validate some text without counting anything.
+	 * A character split by either end of the bytes is invalid.
+	 *
+	 * @param begin The first byte.
+	 * @param end The end of the bytes.
+	 * @return 'true' if the bytes are valid UTF-8, 'false' otherwise.
+	 */
+	static bool is_valid_utf8(char const *begin, char const *end);
+
+	/**
+	 * Check whether the processor can run a kernel.
+	 *
+	 * @param kernel The kernel.
+	 * @return 'true' if set_kernel() would select it.
+	 */
+	static bool is_supported(Kernel kernel);
+
+	/**
+	 * Obtain the kernel scans are made with.
+	 *
+	 * @return The fastest kernel supported unless set_kernel() was called.
+	 */
+	static Kernel get_kernel();
+
+	/**
+	 * Select the kernel for the following scans.
+	 * Kernels that aren't supported fall back to KERNEL_SCALAR.
+	 *
+	 * @param kernel The kernel.
+	 */
+	static void set_kernel(Kernel kernel);
+
+	//! the amount of newlines plus one
+	std::int64_t lines;
+	//! the amount of runs of bytes other than ASCII whitespace
+	std::int64_t words;
+	//! whether the text is valid UTF-8
+	bool valid_utf8;
+
+private:
+	//! the kernel scans are made with
+	static Kernel kernel_;
+};
+
+#endif
@@ -0,0 +1,33 @@
+/**
+ * @file Transfer.cpp
+ */
+
+#include "DocumentSnapshot.h"
+#include "Transfer.h"
+
+const int32_t Transfer::CHUNK_SIZE;
+const size_t Transfer::WINDOW;
+
+Transfer::Transfer(const std::vector<char> &frame, Priority priority, int32_t document_id):
+	document_id(document_id), frame(frame), position(0), priority(priority)
+{}
+
+Transfer::Transfer(std::shared_ptr<DocumentSnapshot> snapshot, int32_t document_id):
+	document_id(document_id), position(0), priority(Priority::PRIORITY_BULK), snapshot(snapshot)
+{}
+
+bool Transfer::is_done(void) const
+{ return snapshot ? position >= snapshot->get_chunk_count() : position > 0 || frame.empty(); }
+
+std::vector<char> &Transfer::next(std::vector<char> &dest, uint8_t version, uint8_t compression)
+{
+	if (!snapshot)
+	{
+		dest.swap(frame);
+		position = 1;
+		return dest;
+	}
+
+	dest = snapshot->get_chunk(position++, version, compression);
+	return dest;
+}
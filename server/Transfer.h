@@ -0,0 +1,110 @@
+/**	@file Transfer.h
+**/
+
+#ifndef _TRANSFER_H_
+#define _TRANSFER_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class DocumentSnapshot;
+
+/**
+	@brief Bytes queued for a single Client, sent piecewise by the NetworkInterface event loop.
+
+	A Transfer either holds a single encoded frame or a DocumentSnapshot, whose contents are sent as
+	TYPE_SYNC_MULTIBYTE chunks of at most CHUNK_SIZE bytes, so a large document doesn't block the
+	event loop. Chunks are deflated to TYPE_SYNC_COMPRESSED if the Client negotiated compression.
+
+	The snapshot is shared. Every Client opening the same revision of a document receives the same
+	encoded chunks.
+
+	Every Transfer belongs to a priority class, see SendQueue.
+**/
+class Transfer
+{
+	public:
+		/**
+			The priority class of a Transfer.
+		**/
+		enum class Priority
+		{
+			PRIORITY_INTERACTIVE, ///< small frames that should arrive immediately
+			PRIORITY_BULK ///< large payloads, e.g. document contents or lists
+		};
+
+		static const int32_t CHUNK_SIZE = 16384; ///< payload of a chunk, a screenful or more
+		static const size_t WINDOW = 4; ///< bulk frames sent per Client and event loop iteration
+
+		/**
+			Creates a Transfer of a single encoded frame.
+
+			@param frame a reference to the bytestream to send
+			@param priority the priority class of the frame
+			@param document_id the document whose contents the frame refers to positions in, 0
+				if none
+		**/
+		explicit Transfer(const std::vector<char> &frame,
+			Priority priority = Priority::PRIORITY_INTERACTIVE, int32_t document_id = 0);
+		/**
+			Creates a bulk Transfer of document contents, starting at position 0.
+
+			@param snapshot a shared pointer to the snapshot of the contents to send
+			@param document_id the document the contents belong to
+		**/
+		Transfer(std::shared_ptr<DocumentSnapshot> snapshot, int32_t document_id);
+
+		/**
+			Returns the document the Transfer refers to.
+
+			@return the document id, 0 if none
+		**/
+		inline int32_t get_document_id(void) const;
+		/**
+			Returns the priority class of the Transfer.
+
+			@return the priority class
+		**/
+		inline Priority get_priority(void) const;
+		/**
+			Returns the amount of bytes the Transfer holds on its own. The contents of a snapshot
+			are shared by all Transfers of that revision and don't count.
+
+			@return the size of the frame not yet sent, 0 for document contents
+		**/
+		inline size_t get_size(void) const;
+		/**
+			Checks whether everything has been sent.
+
+			@return whether nothing is left to send
+		**/
+		bool is_done(void) const;
+		/**
+			Generates the next frame to send.
+
+			@param dest a reference to a vector<char> to store the bytestream in
+			@param version the protocol version to encode chunks for
+			@param compression the compression of chunks
+			@return a reference to the vector<char> the bytestream has been stored in
+		**/
+		std::vector<char> &next(std::vector<char> &dest, uint8_t version, uint8_t compression);
+
+	private:
+		int32_t								document_id; ///< document referred to
+		std::vector<char>					frame; ///< frame to send, if no snapshot
+		size_t								position; ///< index of the next chunk
+		Priority							priority; ///< priority class
+		std::shared_ptr<DocumentSnapshot>	snapshot; ///< contents to send, if any
+};
+
+int32_t Transfer::get_document_id(void) const
+{ return document_id; }
+
+Transfer::Priority Transfer::get_priority(void) const
+{ return priority; }
+
+size_t Transfer::get_size(void) const
+{ return frame.size(); }
+
+#endif
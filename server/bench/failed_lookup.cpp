@@ -0,0 +1,199 @@
+#include "Document.h"
+#include "MemoryDocumentStore.h"
+#include "Message.h"
+#include "MessageBatch.h"
+#include "NetworkInterface.h"
+#include "Result.h"
+#include "UserInterface.h"
+#include "tests/Loopback.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @file server/bench/failed_lookup.cpp
+ *
+ * Measures requests for documents that don't exist, sent through main_network_batch_handler()
+ * like the event loop does: TYPE_DOC_ACTIVATE of an unknown id, whose lookup reports the failure
+ * through Result, and TYPE_DOC_OPEN of a missing name, which the document store still reports by
+ * throwing. Each request includes encoding and sending the response to a loopback peer.
+ *
+ * For reference, the two ways of reporting a failed lookup are also compared on their own:
+ * throwing Message::MessageStatus, as get_document() did before, against returning it through
+ * Result, each looking up an id that isn't in a map shaped like the handler's documents.
+ */
+
+extern void main_network_batch_handler(const MessageBatch &);
+
+namespace
+{
+	/**
+	 * A user interface discarding everything the handler prints.
+	 */
+	class QuietUserInterface
+		: public UserInterface
+	{
+	public:
+		void run()
+		{
+		}
+
+	private:
+		void printfv(char const *, ...)
+		{
+		}
+	};
+
+	//! the user interface of the handler
+	QuietUserInterface g_quiet_user_interface;
+}
+
+//! the handler prints through this user interface
+UserInterface *g_user_interface = &g_quiet_user_interface;
+
+namespace
+{
+	typedef std::shared_ptr<int> DocumentSptr;
+	typedef std::unordered_map<int32_t, DocumentSptr> DocumentMap;
+
+	//! number of lookups per run
+	std::size_t const g_iterations = 1000000;
+	//! number of requests per run
+	std::size_t const g_requests = 100000;
+	//! requests whose responses are read at once, they fit into the socket buffer
+	std::size_t const g_pending_responses = 64;
+
+	DocumentSptr get_document_throwing(DocumentMap const &documents, int32_t id)
+	{
+		try
+		{ return documents.at(id); }
+		catch (std::out_of_range const &)
+		{ throw Message::MessageStatus::STATUS_DOC_NOT_EXIST; }
+	}
+
+	Result<DocumentSptr> get_document_result(DocumentMap const &documents, int32_t id)
+	{
+		auto iter = documents.find(id);
+		if (iter == documents.end())
+		{ return Message::MessageStatus::STATUS_DOC_NOT_EXIST; }
+
+		return iter->second;
+	}
+
+	template <class F>
+	double measure(F const &function)
+	{
+		auto const start = std::chrono::steady_clock::now();
+		std::size_t failures = function();
+		auto const end = std::chrono::steady_clock::now();
+
+		if (failures != g_iterations)
+		{
+			std::fprintf(stderr, "unexpected number of failures: %zu\n", failures);
+		}
+
+		return std::chrono::duration<double, std::nano>(end - start).count() / g_iterations;
+	}
+
+	/**
+	 * Measure a request sent to the handler over and over.
+	 *
+	 * @param request The request, its source set.
+	 * @param peer The socket receiving the responses.
+	 * @return The time per request in nanoseconds.
+	 */
+	double measure_handler(Message const &request, int peer)
+	{
+		std::vector<char> responses(1 << 16);
+		auto const start = std::chrono::steady_clock::now();
+
+		for (std::size_t i = 0; i < g_requests; i++)
+		{
+			main_network_batch_handler(MessageBatch(request));
+
+			// the responses are discarded, a queued one would never be sent without the event loop
+			if ((i + 1) % g_pending_responses == 0)
+			{
+				while (recv(peer, responses.data(), responses.size(), MSG_DONTWAIT) > 0)
+				{
+				}
+			}
+		}
+
+		auto const end = std::chrono::steady_clock::now();
+
+		return std::chrono::duration<double, std::nano>(end - start).count() / g_requests;
+	}
+}
+
+int main()
+{
+	DocumentMap documents;
+
+	for (int32_t id = 1; id <= 64; id++)
+	{
+		documents[id] = std::make_shared<int>(id);
+	}
+
+	double const throwing = measure([&documents]()
+	{
+		std::size_t failures = 0;
+
+		for (std::size_t i = 0; i < g_iterations; i++)
+		{
+			try
+			{ get_document_throwing(documents, 100 + i % 64); }
+			catch (Message::MessageStatus)
+			{ failures++; }
+		}
+
+		return failures;
+	});
+
+	double const result = measure([&documents]()
+	{
+		std::size_t failures = 0;
+
+		for (std::size_t i = 0; i < g_iterations; i++)
+		{
+			if (!get_document_result(documents, 100 + i % 64).is_ok())
+			{ failures++; }
+		}
+
+		return failures;
+	});
+
+	// a logged in client of the handler, the documents are kept in memory
+	Document::set_store(std::make_shared<MemoryDocumentStore>());
+	NetworkInterface network(0);
+	Loopback loopback;
+	int peer;
+	ClientSptr const client = loopback.accept(peer);
+	client->protocol_version = Message::PROTOCOL_VERSION_2;
+	client->user_id = 1;
+
+	Message activate;
+	activate.type = Message::MessageType::TYPE_DOC_ACTIVATE;
+	activate.source = client;
+	activate.id = 100;
+	double const handler_activate = measure_handler(activate, peer);
+
+	Message open;
+	open.type = Message::MessageType::TYPE_DOC_OPEN;
+	open.source = client;
+	std::string const name = "missing";
+	open.name.assign(name.begin(), name.end());
+	double const handler_open = measure_handler(open, peer);
+
+	std::printf("status via exception: %8.1f ns/lookup\n", throwing);
+	std::printf("status via Result:    %8.1f ns/lookup\n", result);
+	std::printf("speedup:              %8.1fx\n", throwing / result);
+	std::printf("handler, unknown id:  %8.1f ns/request (TYPE_DOC_ACTIVATE)\n", handler_activate);
+	std::printf("handler, missing doc: %8.1f ns/request (TYPE_DOC_OPEN)\n", handler_open);
+
+	return 0;
+}
@@ -0,0 +1,147 @@
+#include "SearchIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file server/bench/search_index.cpp
+ *
+ * Measures building the SearchIndex sequentially and in parallel, and compares looking up the
+ * candidates of a query against searching all documents for it, as a TYPE_DOC_SEARCH without
+ * the index would have to.
+ */
+
+namespace
+{
+	//! number of documents
+	std::size_t const g_documents = 4000;
+	//! size of a document
+	std::size_t const g_document_size = 16 << 10;
+	//! number of distinct words of the documents
+	std::size_t const g_vocabulary = 20000;
+	//! number of queries per run
+	std::size_t const g_queries = 200;
+
+	/**
+	 * Generate the words the documents are made of.
+	 *
+	 * @param generator The random generator.
+	 * @return The words.
+	 */
+	std::vector<std::string> generate_vocabulary(std::mt19937 &generator)
+	{
+		std::vector<std::string> words(g_vocabulary);
+
+		for (std::string &word: words)
+		{
+			for (std::size_t length = 4 + generator() % 7; word.size() < length;)
+			{
+				word += static_cast<char>('a' + generator() % 26);
+			}
+		}
+
+		return words;
+	}
+
+	/**
+	 * Measure a function.
+	 *
+	 * @param function The function.
+	 * @return The time it took in milliseconds.
+	 */
+	template <class F>
+	double measure(F const &function)
+	{
+		auto const start = std::chrono::steady_clock::now();
+		function();
+		auto const end = std::chrono::steady_clock::now();
+
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+}
+
+int main()
+{
+	std::mt19937 generator(5);
+	std::vector<std::string> const words = generate_vocabulary(generator);
+	std::vector<std::string> names(g_documents);
+	std::vector<std::string> documents(g_documents);
+
+	for (std::size_t i = 0; i < g_documents; i++)
+	{
+		names[i] = "document" + std::to_string(i);
+
+		while (documents[i].size() < g_document_size)
+		{
+			documents[i] += words[generator() % words.size()];
+			documents[i] += generator() % 10 ? ' ' : '\n';
+		}
+	}
+
+	SearchIndex::reader_t const read = [&](std::string const &name, std::vector<char> &contents)
+	{
+		std::string const &document = documents[std::stoul(name.substr(8))];
+
+		contents.assign(document.begin(), document.end());
+
+		return true;
+	};
+
+	unsigned const threads = std::max(std::thread::hardware_concurrency(), 1u);
+	SearchIndex index;
+
+	double const sequential = measure([&]() { SearchIndex(names, read, 1); });
+	double const parallel = measure([&]() { index = SearchIndex(names, read, threads); });
+
+	std::printf("build of %zu documents: %.1f ms with 1 thread, %.1f ms with %u threads\n",
+	            g_documents, sequential, parallel, threads);
+
+	std::vector<std::string> queries(g_queries);
+	std::size_t candidates = 0;
+	std::size_t matches = 0;
+
+	for (std::string &query: queries)
+	{
+		query = words[generator() % words.size()];
+	}
+
+	double const lookup = measure([&]()
+	{
+		for (std::string const &query: queries)
+		{
+			for (std::string const &name: index.find(query))
+			{
+				std::string const &document = documents[std::stoul(name.substr(8))];
+
+				candidates++;
+				matches += memmem(document.data(), document.size(), query.data(),
+				                  query.size()) != NULL;
+			}
+		}
+	});
+
+	double const scan = measure([&]()
+	{
+		for (std::string const &query: queries)
+		{
+			for (std::string const &document: documents)
+			{
+				matches -= memmem(document.data(), document.size(), query.data(),
+				                  query.size()) != NULL;
+			}
+		}
+	});
+
+	std::printf("query with index: %8.3f ms (%.1f candidates)\n", lookup / g_queries,
+	            static_cast<double>(candidates) / g_queries);
+	std::printf("query by scan:    %8.3f ms%s\n", scan / g_queries,
+	            matches == 0 ? "" : ", results differ");
+
+	return 0;
+}
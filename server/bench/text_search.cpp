@@ -0,0 +1,129 @@
+#include "TextSearch.h"
+#include "TextStatistics.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @file server/bench/text_search.cpp
+ *
+ * Compares the throughput of the TextSearch kernels and memmem(), finding all occurrences of a
+ * token in a document as a literal TYPE_DOC_REPLACE does.
+ */
+
+namespace
+{
+	//! size of the searched document
+	std::size_t const g_document_size = 64 << 20;
+	//! number of searches per run
+	std::size_t const g_iterations = 16;
+	//! the searched token, occurring about once per 4 KiB
+	std::string const g_token = "identifier";
+
+	/**
+	 * Generate source-like text of words and lines containing the token now and then.
+	 *
+	 * @param size The size of the text.
+	 * @return The text.
+	 */
+	std::vector<char> generate_text(std::size_t size)
+	{
+		std::string const tokens[] = { "int", "index", "if", "(", ")", " ", " ", "\n\t", "ident" };
+		std::mt19937 generator(3);
+		std::vector<char> text;
+
+		while (text.size() < size)
+		{
+			std::string const &token = generator() % 1000 ? tokens[generator() % 9] : g_token;
+			text.insert(text.end(), token.begin(), token.end());
+		}
+
+		return text;
+	}
+
+	/**
+	 * Measure a function and print the result.
+	 *
+	 * @param name The name of the measured search.
+	 * @param document The document.
+	 * @param function The function, searching the document and returning the occurrences.
+	 * @return The throughput in GiB per second.
+	 */
+	template <class F>
+	double run(char const *name, std::vector<char> const &document, F const &function)
+	{
+		std::size_t occurrences = 0;
+		auto const start = std::chrono::steady_clock::now();
+
+		for (std::size_t i = 0; i < g_iterations; i++)
+		{
+			occurrences += function();
+		}
+
+		auto const end = std::chrono::steady_clock::now();
+		double const throughput = document.size() * g_iterations /
+		                          std::chrono::duration<double>(end - start).count() / (1 << 30);
+
+		std::printf("%-7s search: %6.2f GiB/s (%zu occurrences)\n", name, throughput,
+		            occurrences / g_iterations);
+
+		return throughput;
+	}
+
+	/**
+	 * Search the document with a TextSearch kernel.
+	 *
+	 * @param name The name of the kernel.
+	 * @param kernel The kernel.
+	 * @param document The document.
+	 * @return The throughput in GiB per second.
+	 */
+	double run(char const *name, TextStatistics::Kernel kernel, std::vector<char> const &document)
+	{
+		TextStatistics::set_kernel(kernel);
+
+		return run(name, document, [&document]()
+		{
+			return TextSearch::find_all(document.data(), document.data() + document.size(),
+			                            g_token).size();
+		});
+	}
+}
+
+int main()
+{
+	std::vector<char> const document = generate_text(g_document_size);
+	double const scalar = run("scalar", TextStatistics::Kernel::KERNEL_SCALAR, document);
+
+	run("memmem", document, [&document]()
+	{
+		char const *const end = document.data() + document.size();
+		std::size_t occurrences = 0;
+
+		for (void const *match = document.data();
+		     (match = memmem(match, end - static_cast<char const *>(match), g_token.data(),
+		                     g_token.size())) != NULL;
+		     match = static_cast<char const *>(match) + g_token.size())
+		{
+			occurrences++;
+		}
+
+		return occurrences;
+	});
+
+	if (!TextStatistics::is_supported(TextStatistics::Kernel::KERNEL_AVX2))
+	{
+		std::printf("AVX2 isn't supported by this processor\n");
+		return 0;
+	}
+
+	double const avx2 = run("AVX2", TextStatistics::Kernel::KERNEL_AVX2, document);
+
+	std::printf("speedup:        %6.1fx\n", avx2 / scalar);
+
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include "TextStatistics.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @file server/bench/text_statistics.cpp
+ *
+ * Compares the throughput of the TextStatistics kernels, counting and validating a document as
+ * on every load and validating short payloads as for every TYPE_SYNC_MULTIBYTE message.
+ */
+
+namespace
+{
+	//! size of the scanned document
+	std::size_t const g_document_size = 64 << 20;
+	//! size of a payload, a pasted paragraph
+	std::size_t const g_payload_size = 256;
+	//! number of scans per run
+	std::size_t const g_iterations = 16;
+
+	/**
+	 * Generate text of words and lines with some multibyte characters.
+	 *
+	 * @param size The size of the text.
+	 * @return The text.
+	 */
+	std::vector<char> generate_text(std::size_t size)
+	{
+		std::string const tokens[] = { "lorem", "ipsum", " ", " ", "\n", "\xc3\xa4",
+		                               "\xe2\x82\xac" };
+		std::mt19937 generator(1);
+		std::vector<char> text;
+
+		while (text.size() < size)
+		{
+			std::string const &token = tokens[generator() % 7];
+			text.insert(text.end(), token.begin(), token.end());
+		}
+
+		return text;
+	}
+
+	/**
+	 * Measure a function.
+	 *
+	 * @param bytes The amount of bytes the function scans.
+	 * @param function The function.
+	 * @return The throughput in GiB per second.
+	 */
+	template <class F>
+	double measure(std::size_t bytes, F const &function)
+	{
+		auto const start = std::chrono::steady_clock::now();
+		function();
+		auto const end = std::chrono::steady_clock::now();
+
+		return bytes * g_iterations / std::chrono::duration<double>(end - start).count() /
+		       (1 << 30);
+	}
+
+	/**
+	 * Measure both workloads with a kernel and print the results.
+	 *
+	 * @param name The name of the kernel.
+	 * @param kernel The kernel.
+	 * @param document The document.
+	 * @return The throughput of document scans in GiB per second.
+	 */
+	double run(char const *name, TextStatistics::Kernel kernel, std::vector<char> const &document)
+	{
+		std::size_t const payloads = document.size() / g_payload_size;
+		std::int64_t lines = 0;
+		std::size_t valid = 0;
+
+		TextStatistics::set_kernel(kernel);
+
+		double const scan = measure(document.size(), [&]()
+		{
+			for (std::size_t i = 0; i < g_iterations; i++)
+			{
+				lines += TextStatistics::scan(document.data(),
+				                              document.data() + document.size()).lines;
+			}
+		});
+
+		double const validate = measure(payloads * g_payload_size, [&]()
+		{
+			for (std::size_t i = 0; i < g_iterations; i++)
+			{
+				for (std::size_t j = 0; j < payloads; j++)
+				{
+					char const *const payload = document.data() + j * g_payload_size;
+					valid += TextStatistics::is_valid_utf8(payload, payload + g_payload_size);
+				}
+			}
+		});
+
+		std::printf("%-7s document scan: %6.2f GiB/s, payload validation: %6.2f GiB/s "
+		            "(%lld lines, %zu valid)\n", name, scan, validate,
+		            static_cast<long long>(lines / g_iterations), valid / g_iterations);
+
+		return scan;
+	}
+}
+
+int main()
+{
+	std::vector<char> const document = generate_text(g_document_size);
+	double const scalar = run("scalar", TextStatistics::Kernel::KERNEL_SCALAR, document);
+
+	if (!TextStatistics::is_supported(TextStatistics::Kernel::KERNEL_AVX2))
+	{
+		std::printf("AVX2 isn't supported by this processor\n");
+		return 0;
+	}
+
+	double const avx2 = run("AVX2", TextStatistics::Kernel::KERNEL_AVX2, document);
+
+	std::printf("speedup:              %6.1fx\n", avx2 / scalar);
+
+	return 0;
+}
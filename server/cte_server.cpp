@@ -1,7 +1,12 @@
 #include "CommandProcessor.h"
+#include "Document.h"
+#include "DocumentIndex.h"
+#include "DocumentVersions.h"
+#include "MemoryDocumentStore.h"
 #include "NetworkInterface.h"
 #include "NCursesUserInterface.h"
 #include "SQLiteDatabase.h"
+#include "SQLiteDocumentStore.h"
 #include "UserDatabase.h"
 
 #include <sys/socket.h>
@@ -23,7 +28,7 @@
  */
 
 class Message;
-extern void main_network_message_handler(const Message &);
+extern void main_network_batch_handler(const MessageBatch &);
 
 //! TODO: quite dirty way to share the user interface
 UserInterface *g_user_interface;
@@ -212,7 +217,7 @@ i * @enduml
  * .. Construction ..
  * + Document(Document &&)
  * + ~Document()
- * - Document(fd: int, name: string const &)
+ * - Document(store: shared_ptr<DocumentStore>, handle: unique_ptr<Handle>, name: string const &)
  * .. Deleted ..
  * + Document(Document const &)
  * + operator=(Document const &): Document &
@@ -220,33 +225,45 @@ i * @enduml
  * + {static} create(name: string, overwrite: bool): Document
  * + {static} open(name: string): Document
  * + {static} is_empty(name: string): bool
- * + {static} list_documents(): vector<string>
+ * + {static} list_documents(directory: string): vector<string>
+ * + {static} get_directory(): string
+ * + {static} set_store(store: shared_ptr<DocumentStore> const &)
+ * + {static} get_store(): shared_ptr<DocumentStore>
  * + remove()
  * + save()
  * + close()
  * + hash(): array<char, 20>
  * + get_contents(): vector<char>
+ * + compress()
+ * + unload()
+ * + get_memory_usage(): size_t
+ * + is_resident(): bool
  * + get_name(): string
  * + get_id(): int32_t
  * .. helpers ..
- * - {static} open_readable(name: string): int
- * - {static} open_writable(name: string, overwrite: bool): int
  * - {static} increment_global_document_id()
  * __ attributes __
  * - contents_: vector<char>
- * - fd_: int
+ * - store_: shared_ptr<DocumentStore>
+ * - handle_: unique_ptr<DocumentStore::Handle>
  * - name_: string const
  * - {static} directory_: string const
+ * - {static} default_store_: shared_ptr<DocumentStore>
  * - {static} global_document_id_: int32_t
  * - id_: int32_t
  * - document_closed_: bool
  * - contents_fetched_: bool
+ * - compressed_: vector<char>
+ * - contents_compressed_: bool
+ * - uncompressed_size_: size_t
  * }
  * @enduml
  *
  * @param argc The amount of arguments passed to the program + 1.
  * @param argv An array of argument strings passed to the program. The first
- *             argument is the name of the binary which was executed.
+ *             argument is the name of the binary which was executed. The
+ *             optional port follows, then the document store: "files"
+ *             (default), "memory" or the path of a SQLite database.
  * @returns 0 On success, non-zero otherwise.
  */
 int main(int argc, char **argv)
@@ -257,6 +274,8 @@ int main(int argc, char **argv)
 	g_user_interface = &ui;
 	auto db = std::make_shared<SQLiteDatabase>(SQLiteDatabase::from_path("./user.sql"));
 	UserDatabase user_db(db, ui);
+	DocumentIndex document_index(db);
+	DocumentVersions document_versions(db);
 	CommandProcessor command_processor(ui, user_db);
 	int ipc_sockets[2];
 	int port = 1337;
@@ -271,6 +290,21 @@ int main(int argc, char **argv)
 		}
 	}
 
+	if (argc > 2)
+	{
+		std::string const store = argv[2];
+
+		if (store == "memory")
+		{
+			Document::set_store(std::make_shared<MemoryDocumentStore>());
+		}
+		else if (store != "files")
+		{
+			Document::set_store(std::make_shared<SQLiteDocumentStore>(
+				SQLiteDocumentStore::from_path(store)));
+		}
+	}
+
 	if (::socketpair(AF_UNIX, SOCK_STREAM, 0, ipc_sockets) == -1)
 	{
 		throw std::runtime_error("unable to create local communication sockets");
@@ -282,7 +316,7 @@ int main(int argc, char **argv)
 		{
 			NetworkInterface network_interface(port);
 
-			network_interface.add_message_handler(&main_network_message_handler);
+			network_interface.add_batch_handler(&main_network_batch_handler);
 			network_interface.run(ipc_sockets[1]);
 			ui.printf("network thread finished\n");
 			return;
@@ -4,13 +4,31 @@
 	@date Monday, 11th June 2012
 **/
 
+#include <algorithm>
+#include <ctime>
+#include <iterator>
+#include <random>
+#include <regex>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "Client.h"
 #include "Document.h"
+#include "DocumentCache.h"
+#include "DocumentCatalog.h"
+#include "DocumentIndex.h"
+#include "DocumentSnapshot.h"
+#include "DocumentVersions.h"
+#include "EditHistory.h"
 #include "Message.h"
+#include "MessageBatch.h"
 #include "NetworkInterface.h"
+#include "RegexSearch.h"
+#include "Result.h"
+#include "SearchIndex.h"
+#include "SequenceDocument.h"
+#include "TextSearch.h"
 #include "UserDatabase.h"
 #include "UserInterface.h"
 
@@ -21,22 +39,56 @@ namespace
 {
 	typedef std::shared_ptr<Document> DocumentSptr;
 
+	/**
+		A login that can be resumed within SESSION_RETENTION seconds after the connection dropped.
+	**/
+	struct Session
+	{
+		int32_t				active_document; // active document when the connection dropped
+		uint8_t				compression; // compression negotiated by the client
+		time_t				expires; // end of the retention window, 0 while connected
+		std::vector<char>	name; // user name for the join announcement
+		int32_t				user_id; // id of the logged in user
+		std::unordered_set<int32_t>	documents; // documents kept open while disconnected
+	};
+
+	const time_t SESSION_RETENTION = 60; // seconds a dropped session can be resumed within
+	const size_t WARM_CACHE_SIZE = 64 << 20; // bytes of closed documents kept loaded
+	const size_t MEMORY_BUDGET = 256 << 20; // bytes of open documents and their snapshots
+	const size_t SNAPSHOT_CACHE_SIZE = 32 << 20; // bytes of encoded contents kept for reopening
+	const int64_t VIEWPORT_LIMIT = 1 << 20; // bytes of a viewport sent at once
+	const int64_t VIEWPORT_MARGIN = 4 << 10; // bytes around a viewport whose edits are sent
+
 	std::unordered_map<int32_t, DocumentSptr> doc_by_id; // doc_id -> doc
 	std::unordered_map<int32_t, size_t> doc_counter; // doc_id -> doc_opened_count
 	std::unordered_map<std::string, DocumentSptr> doc_by_name; // doc_name -> doc
-	std::unordered_map<int32_t, std::unordered_set<int32_t>> open_docs; // client_id -> doc_id...
-
-	void close_document(int32_t doc_id, int32_t client_id = 0);
+	std::unordered_map<int, std::unordered_set<int32_t>> open_docs; // socket -> doc_id...
+	std::unordered_map<int32_t, EditHistory> doc_history; // doc_id -> revisions
+	std::unordered_map<int32_t, int32_t> doc_saved; // doc_id -> revision the file holds
+	std::unordered_map<int32_t, time_t> doc_edited; // doc_id -> time of the last activity
+	std::unordered_map<int32_t, std::pair<int32_t, Hash::hash_t>>
+		doc_hash; // doc_id -> revision, hash of the contents
+	DocumentCache closed_docs(WARM_CACHE_SIZE); // unchanged documents closed recently
+	std::unordered_map<int32_t, SequenceDocument> doc_sequence; // doc_id -> sequence (if any)
+	std::unordered_map<int32_t, std::pair<int32_t, std::shared_ptr<DocumentSnapshot>>>
+		doc_snapshot; // doc_id -> revision, serialized contents
+	std::unordered_map<std::string, Session> sessions; // token -> session
+	std::unordered_map<int, std::string> session_by_socket; // socket -> token
+
+	void close_document(int32_t doc_id, int socket = -1);
+	SearchIndex &get_search_index(void);
+	bool read_document(const std::string &name, std::vector<char> &contents);
 
 	/**
-		Invokes document_close for all documents opened by the given client.
-		@param client_id - id of the respective client
+		Invokes document_close for all documents opened by the client on the given socket. The
+		documents are owned by the connection, not by the user, who may be logged in more than once.
+		@param socket - socket of the respective client
 	**/
-	void close_client_documents(int32_t client_id)
+	void close_client_documents(int socket)
 	{
-		g_user_interface->printf("[client %d] closing all client documents\n", client_id);
+		g_user_interface->printf("[socket %d] closing all client documents\n", socket);
 		// get the list of opened documents, if existing
-		auto docs = open_docs.find(client_id);
+		auto docs = open_docs.find(socket);
 		if (docs == open_docs.end())
 		{ return; }
 
@@ -45,24 +97,71 @@ namespace
 		for (const auto &doc_id: docs->second)
 		{ doc_list.push_front(doc_id); }
 		for (const auto &doc_id: doc_list)
-		{ close_document(doc_id, client_id); }
+		{ close_document(doc_id, socket); }
+
+		open_docs.erase(socket);
+	}
+
+	/**
+		Forgets the snapshot of a document, which has to happen before the document changes, is
+		compressed, unloaded or closed. Transfers still sending the snapshot get their own copy of
+		the contents.
+			doc_id - document id
+	**/
+	void release_snapshot(int32_t doc_id)
+	{
+		auto snapshot = doc_snapshot.find(doc_id);
+		if (snapshot == doc_snapshot.end())
+		{ return; }
+
+		if (snapshot->second.second.use_count() > 1)
+		{ snapshot->second.second->detach(); }
+		doc_snapshot.erase(snapshot);
+	}
+
+	/**
+		Evicts the snapshots no Transfer is sending, the ones of documents idle for the longest
+		time first, until the snapshots hold at most a given amount of bytes.
+			limit - bytes the snapshots may hold
+		=>	the bytes the snapshots hold afterwards
+	**/
+	size_t evict_snapshots(size_t limit)
+	{
+		size_t usage = 0;
+		std::vector<std::pair<time_t, int32_t>> idle; // last activity, doc_id
+		for (const auto &snapshot: doc_snapshot)
+		{
+			usage += snapshot.second.second->get_size();
+			if (snapshot.second.second.use_count() == 1)
+			{ idle.emplace_back(doc_edited[snapshot.first], snapshot.first); }
+		}
+
+		std::sort(idle.begin(), idle.end());
+		for (const auto &snapshot: idle)
+		{
+			if (usage <= limit)
+			{ break; }
+
+			usage -= doc_snapshot[snapshot.second].second->get_size();
+			doc_snapshot.erase(snapshot.second);
+		}
 
-		open_docs.erase(client_id);
+		return usage;
 	}
 
 	/**
 		Closes an opened document if it's not needed anymore, otherwise just decrements the document
 		counter and deassigns it from the given client.
 		@param doc_id - document id
-		@param client_id - id of the client that closed this document, 0 if no client involved
+		@param socket - socket of the client that closed this document, -1 if no client involved
 	**/
-	void close_document(int32_t doc_id, int32_t client_id)
+	void close_document(int32_t doc_id, int socket)
 	{
-		g_user_interface->printf("[client %d] closing document %d\n", client_id, doc_id);
+		g_user_interface->printf("[socket %d] closing document %d\n", socket, doc_id);
 		// remove from client opened documents
-		if (client_id != 0)
+		if (socket != -1)
 		{
-			auto docs = open_docs.find(client_id);
+			auto docs = open_docs.find(socket);
 			if (docs != open_docs.end())
 			{ docs->second.erase(doc_id); }
 		}
@@ -75,255 +174,1320 @@ namespace
 			doc_by_id.erase(doc_id);
 			doc_by_name.erase(doc->get_name());
 			doc_counter.erase(doc_id);
-			doc->close();
+			doc_sequence.erase(doc_id);
+			release_snapshot(doc_id);
+
+			// keep the document loaded in case it's reopened soon, unless it has unsaved edits
+			int32_t revision = doc_history[doc_id].get_revision();
+			if (doc_saved[doc_id] == revision)
+			{
+				auto hash = doc_hash.find(doc_id);
+				bool hashed = hash != doc_hash.end() && hash->second.first == revision;
+				closed_docs.insert(doc, hashed ? &hash->second.second : NULL);
+			}
+			else
+			{
+				// the unsaved edits are discarded, the index has to follow the file again
+				std::vector<char> contents;
+				if (read_document(doc->get_name(), contents))
+				{ get_search_index().insert(doc->get_name(), contents); }
+				else
+				{ get_search_index().remove(doc->get_name()); }
+
+				doc->close();
+			}
+
+			doc_edited.erase(doc_id);
+			doc_hash.erase(doc_id);
+			doc_history.erase(doc_id);
+			doc_saved.erase(doc_id);
+		}
+	}
+
+	/**
+		Shrinks the open documents and their snapshots while they use more memory than the budget
+		allows. Snapshots no Transfer is sending are evicted first, they're cheap to encode again.
+		Then the documents idle for the longest time are shrunk: documents the file is up to date
+		with are dropped and read again when needed, the others are compressed in memory.
+	**/
+	void enforce_memory_budget(void)
+	{
+		size_t usage = 0;
+		std::vector<std::pair<time_t, int32_t>> idle; // last activity, doc_id
+		for (const auto &doc: doc_by_id)
+		{
+			usage += doc.second->get_memory_usage();
+			if (doc.second->is_resident())
+			{ idle.emplace_back(doc_edited[doc.first], doc.first); }
+		}
+
+		usage += evict_snapshots(usage < MEMORY_BUDGET ? MEMORY_BUDGET - usage : 0);
+
+		std::sort(idle.begin(), idle.end());
+		for (const auto &doc: idle)
+		{
+			if (usage <= MEMORY_BUDGET)
+			{ break; }
+
+			// the snapshot refers to the contents, it leaves the cache
+			auto snapshot = doc_snapshot.find(doc.second);
+			if (snapshot != doc_snapshot.end())
+			{ usage -= snapshot->second.second->get_size(); }
+			release_snapshot(doc.second);
+
+			Document &document = *doc_by_id[doc.second];
+			usage -= document.get_memory_usage();
+			if (doc_saved[doc.second] == doc_history[doc.second].get_revision())
+			{ document.unload(); }
+			else
+			{ document.compress(); }
+			usage += document.get_memory_usage();
+			g_user_interface->printf("shrunk idle document %d\n", doc.second);
+		}
+	}
+
+	/**
+		Closes the documents of sessions whose retention window has passed and forgets them.
+	**/
+	void expire_sessions(void)
+	{
+		time_t now = std::time(nullptr);
+
+		for (auto iter = sessions.begin(); iter != sessions.end();)
+		{
+			if (iter->second.expires == 0 || iter->second.expires > now)
+			{
+				++iter;
+				continue;
+			}
+
+			// only the documents of this session, the user may have logged in again meanwhile
+			for (int32_t doc_id: iter->second.documents)
+			{ close_document(doc_id); }
+			iter = sessions.erase(iter);
+		}
+	}
+
+	/**
+		Starts a session for a client that just logged in and sends it the session token.
+		Clients using protocol version 1 can't resume sessions, nothing is sent to them.
+			client - client that logged in
+			name - user name
+		=#	Message::send_to
+	**/
+	void start_session(const Client &client, const std::vector<char> &name)
+	{
+		if (client.protocol_version < Message::PROTOCOL_VERSION_2)
+		{ return; }
+
+		Message announcement;
+		announcement.type = Message::MessageType::TYPE_SESSION_TOKEN;
+
+		std::random_device random;
+		for (char &byte: announcement.hash)
+		{ byte = static_cast<char>(random()); }
+
+		std::string token(announcement.hash.begin(), announcement.hash.end());
+		sessions[token] = Session { 0, client.compression, 0, name, client.user_id, {} };
+		session_by_socket[client.socket] = token;
+
+		announcement.send_to(client);
+	}
+
+	/**
+		Keeps the session of a disconnected client for SESSION_RETENTION seconds.
+			client - client that disconnected
+		=>	whether the client had a session
+	**/
+	bool detach_session(const Client &client)
+	{
+		auto token = session_by_socket.find(client.socket);
+		if (token == session_by_socket.end())
+		{ return false; }
+
+		Session &session = sessions[token->second];
+		session.active_document = client.active_document;
+		session.compression = client.compression;
+		session.expires = std::time(nullptr) + SESSION_RETENTION;
+		session_by_socket.erase(token);
+
+		// the session keeps the documents open, the socket may be reused by another connection
+		auto docs = open_docs.find(client.socket);
+		if (docs != open_docs.end())
+		{
+			session.documents = std::move(docs->second);
+			open_docs.erase(docs);
+		}
+
+		return true;
+	}
+
+	/**
+		Ends the session of a client logging out, it can't be resumed anymore.
+			client - client that logs out
+	**/
+	void end_session(const Client &client)
+	{
+		auto token = session_by_socket.find(client.socket);
+		if (token == session_by_socket.end())
+		{ return; }
+
+		sessions.erase(token->second);
+		session_by_socket.erase(token);
+	}
+
+	/**
+		Makes a document the client's active one and registers the client with its edit history.
+			client - client that activates the document
+			doc_id - document id
+	**/
+	void activate_document(Client &client, int32_t doc_id)
+	{
+		// the previous document's contents aren't needed anymore
+		if (client.active_document != 0)
+		{ client.cancel_transfers(client.active_document); }
+
+		auto history = doc_history.find(client.active_document);
+		if (history != doc_history.end())
+		{ history->second.remove_client(client.socket); }
+
+		// another document is shown from its start
+		if (client.active_document != doc_id)
+		{ client.viewport_position = 0; }
+
+		client.active_document = doc_id;
+		client.sequence_site = 0;
+		doc_history[doc_id].add_client(client.socket);
+	}
+
+	/**
+		Closes a document the client opened. If it's the client's active one, the client has no
+		active document anymore.
+			client - client that closes the document
+			doc_id - document id
+		=>	Message::MessageStatus::STATUS_OK - document closed
+		=>	Message::MessageStatus::STATUS_DOC_NOT_EXIST - the client hasn't opened the document
+	**/
+	Message::MessageStatus close_client_document(Client &client, int32_t doc_id)
+	{
+		auto docs = open_docs.find(client.socket);
+		if (docs == open_docs.end() || docs->second.count(doc_id) == 0)
+		{ return Message::MessageStatus::STATUS_DOC_NOT_EXIST; }
+
+		if (client.active_document == doc_id)
+		{
+			client.cancel_transfers(doc_id);
+			doc_history[doc_id].remove_client(client.socket);
+			client.active_document = 0;
+			client.sequence_site = 0;
+			client.viewport_position = 0;
+		}
+
+		close_document(doc_id, client.socket);
+		return Message::MessageStatus::STATUS_OK;
+	}
+
+	/**
+		Checks whether a client can address every position of a document. Clients below protocol
+		version 3 encode positions in 32 bits.
+			doc - document to check
+			client - client that wants to edit the document
+		=>	whether the document may become the client's active one
+	**/
+	bool is_addressable(Document &doc, const Client &client)
+	{
+		return client.protocol_version >= Message::PROTOCOL_VERSION_3 ||
+			doc.get_contents().size() <= static_cast<size_t>(std::numeric_limits<int32_t>::max());
+	}
+
+	/**
+		Determines how large edits may make a document. As long as a client below protocol
+		version 3 has it active, it has to stay addressable in 32 bits.
+			doc_id - document id
+		=>	the maximum size in bytes
+	**/
+	int64_t get_size_limit(int32_t doc_id)
+	{
+		if (NetworkInterface::get_current_instance().get_min_protocol_version(doc_id) <
+			Message::PROTOCOL_VERSION_3)
+		{ return std::numeric_limits<int32_t>::max(); }
+
+		return std::numeric_limits<int64_t>::max();
+	}
+
+	/**
+		Selects the clients in sequence mode.
+	**/
+	bool in_sequence_mode(const Client &client)
+	{ return client.sequence_site != 0; }
+
+	/**
+		Selects the clients not in sequence mode.
+	**/
+	bool not_in_sequence_mode(const Client &client)
+	{ return client.sequence_site == 0; }
+
+	/**
+		Checks whether a client receives an edit in full. A client showing a viewport only
+		receives the edits near it, i.e. within a viewport length or VIEWPORT_MARGIN around it.
+			client - client to check
+			position - start of the range the edit changes
+			length - length of the range before the edit
+		=>	whether the client receives the edit's operations
+	**/
+	bool sees_edit(const Client &client, int64_t position, int64_t length)
+	{
+		if (client.viewport_length < 0)
+		{ return true; }
+
+		int64_t margin = std::max(client.viewport_length, VIEWPORT_MARGIN);
+		return position + length >= client.viewport_position - margin &&
+			position <= client.viewport_position + client.viewport_length + margin;
+	}
+
+	/**
+		Broadcasts an edit of a document to the clients not in sequence mode. Clients that don't
+		see the edit, see sees_edit, merely receive the changed range as TYPE_SYNC_RESIZE.
+			sync - synchronization message
+			operations - the edit, as it will be applied
+			doc_id - document id
+		=#	Message::send_to
+	**/
+	void broadcast_to_viewports(const Message &sync, const EditOperations &operations,
+		int32_t doc_id)
+	{
+		Message resize;
+		resize.type = Message::MessageType::TYPE_SYNC_RESIZE;
+		resize.revision = sync.revision;
+		get_edit_range(operations, resize.position, resize.length, resize.inserted);
+
+		NetworkInterface &network = NetworkInterface::get_current_instance();
+		network.broadcast_message(sync, doc_id, [&resize](const Client &client)
+			{
+				return not_in_sequence_mode(client) &&
+					sees_edit(client, resize.position, resize.length);
+			});
+		network.broadcast_message(resize, doc_id, [&resize](const Client &client)
+			{
+				return not_in_sequence_mode(client) &&
+					!sees_edit(client, resize.position, resize.length);
+			});
+	}
+
+	/**
+		Broadcasts an edit of a document, see broadcast_to_viewports. If the document has a
+		sequence, the edit is recorded in it and clients in sequence mode receive the recorded
+		operations as TYPE_SYNC_MERGE instead.
+			sync - synchronization message for clients not in sequence mode
+			operations - the edit, as it will be applied
+			doc_id - document id
+		=#	Message::send_to
+	**/
+	void broadcast_edit(const Message &sync, const EditOperations &operations, int32_t doc_id)
+	{
+		// the serialized contents are outdated
+		release_snapshot(doc_id);
+
+		broadcast_to_viewports(sync, operations, doc_id);
+
+		auto sequence = doc_sequence.find(doc_id);
+		if (sequence == doc_sequence.end())
+		{ return; }
+
+		Message merge;
+		merge.type = Message::MessageType::TYPE_SYNC_MERGE;
+		merge.sequence = sequence->second.record(operations);
+		merge.revision = sequence->second.get_revision();
+
+		NetworkInterface::get_current_instance().broadcast_message(merge, doc_id,
+			in_sequence_mode);
+	}
+
+	/**
+		Tells a client the revision of its active document by sending an empty TYPE_SYNC_BATCH.
+		Clients using protocol version 1 don't know revisions, nothing is sent to them.
+			client - client to inform
+		=#	Message::send_to
+	**/
+	void announce_revision(const Client &client)
+	{
+		if (client.protocol_version < Message::PROTOCOL_VERSION_2)
+		{ return; }
+
+		Message announcement;
+		announcement.type = Message::MessageType::TYPE_SYNC_BATCH;
+		announcement.revision = doc_history[client.active_document].get_revision();
+		announcement.send_to(client);
+	}
+
+	/**
+		Returns the catalog of all documents, listing the document store on first use.
+		=>	the catalog
+	**/
+	DocumentCatalog &get_document_catalog(void)
+	{
+		static DocumentCatalog catalog(Document::get_store());
+		return catalog;
+	}
+
+	/**
+		Reads the contents of a document from the document store, see SearchIndex::reader_t.
+			name - document name
+			contents - contents to replace
+		=>	true - contents read
+		=>	false - the document can't be read
+	**/
+	bool read_document(const std::string &name, std::vector<char> &contents)
+	{
+		try
+		{
+			Document::get_store()->open(name)->read(contents);
+			return true;
+		}
+		catch (const document_errors::DocumentError &)
+		{ return false; }
+	}
+
+	/**
+		Returns the search index of all documents in the catalog, building it with a thread per
+		processor on first use, i.e. on TYPE_INIT.
+		=>	the index
+	**/
+	SearchIndex &get_search_index(void)
+	{
+		static SearchIndex index(get_document_catalog().get_names(), &read_document,
+			std::max(std::thread::hardware_concurrency(), 1u));
+		return index;
+	}
+
+	/**
+		Applies edit operations to a document and updates the search index along, which has to
+		see the contents every operation is applied to. Batches too large to follow one operation
+		at a time, see Document::MAX_INDEXED_OPERATIONS, are applied in one pass and the document
+		is indexed anew.
+			doc - document to edit
+			operations - operations to apply, see apply_edit_operations
+	**/
+	void apply_edits(Document &doc, const EditOperations &operations)
+	{
+		SearchIndex &index = get_search_index();
+		if (operations.size() > Document::MAX_INDEXED_OPERATIONS)
+		{
+			doc.apply(operations);
+			index.insert(doc.get_name(), doc.get_contents());
+			return;
+		}
+
+		for (const EditOperation &operation: operations)
+		{
+			index.apply(doc.get_name(), doc.get_contents(), operation);
+			doc.apply(EditOperations(1, operation));
+		}
+	}
+
+	/**
+		Searches all documents for some bytes. The search index narrows them down to the ones
+		containing all trigrams of the query, only these are searched: opened documents in memory,
+		the others are read from the document store.
+			query - bytes to search for, at least SearchIndex::TRIGRAM_SIZE of them
+			offset - index of the first matching document to return
+			limit - amount of entries to return at most, capped at DocumentCatalog::MAX_PAGE_SIZE
+			dest - entries to store the matching documents in, sorted by name
+		=>	the amount of matching documents
+	**/
+	int32_t search_documents(const std::string &query, int32_t offset, int32_t limit,
+		DocumentEntries &dest)
+	{
+		std::vector<char> buffer;
+		int32_t matches = 0;
+
+		offset = std::max(offset, 0);
+		limit = std::min(std::max(limit, 0), DocumentCatalog::MAX_PAGE_SIZE);
+
+		dest.clear();
+		for (const std::string &name: get_search_index().find(query))
+		{
+			auto doc = doc_by_name.find(name);
+			const std::vector<char> *contents = &buffer;
+			if (doc != doc_by_name.end())
+			{ contents = &doc->second->get_contents(); }
+			else if (!read_document(name, buffer))
+			{ continue; }
+
+			const char *end = contents->data() + contents->size();
+			if (TextSearch::find(contents->data(), end, query) == end)
+			{ continue; }
+
+			if (matches >= offset && matches - offset < limit)
+			{
+				DocumentEntry entry;
+				entry.name.assign(name.begin(), name.end());
+				entry.size = contents->size();
+
+				try
+				{ entry.modified = Document::get_store()->status(name).modified / 1000000000; }
+				catch (const document_errors::DocumentError &)
+				{}
+
+				dest.push_back(std::move(entry));
+			}
+
+			++matches;
+		}
+
+		return matches;
+	}
+
+	/**
+		Completes listed entries of opened documents: editors are the clients having the document
+		opened, its statistics are known then.
+			entries - entries to complete
+	**/
+	void describe_open_documents(DocumentEntries &entries)
+	{
+		for (DocumentEntry &entry: entries)
+		{
+			auto doc = doc_by_name.find(std::string(entry.name.begin(), entry.name.end()));
+			if (doc == doc_by_name.end())
+			{ continue; }
+
+			const TextStatistics &statistics = doc->second->get_statistics();
+			entry.editors = doc_counter[doc->second->get_id()];
+			entry.lines = statistics.lines;
+			entry.words = statistics.words;
 		}
 	}
 
 	/**
 		Creates a new document, if it doesn't exist yet.
 			name - document name
-		=#	Message::MessageStatus::STATUS_DOC_NOT_EXIST - document doesn't exist
-		=#	Message::MessageStatus::STATUS_IO_ERROR - an IO error occured
+		=>	Message::MessageStatus::STATUS_OK - document created
+		=>	Message::MessageStatus::STATUS_DOC_NOT_EXIST - document doesn't exist
+		=>	Message::MessageStatus::STATUS_IO_ERROR - an IO error occured
 	**/
-	void create_document(const std::string &name)
+	Message::MessageStatus create_document(const std::string &name)
 	{
 		g_user_interface->printf("creating document: %s\n", name);
 		try
 		{
 			Document doc = Document::create(name);
 			doc.close();
+			get_document_catalog().add(name);
+			get_search_index().insert(name, std::vector<char>());
+		}
+		catch (document_errors::DocumentDoesntExistError)
+		{ return Message::MessageStatus::STATUS_DOC_NOT_EXIST; }
+		catch (document_errors::DocumentError)
+		{ return Message::MessageStatus::STATUS_IO_ERROR; }
+
+		return Message::MessageStatus::STATUS_OK;
+	}
+
+	/**
+		Deletes an existing document.
+			name - document name
+		=>	Message::MessageStatus::STATUS_OK - document deleted
+		=>	Message::MessageStatus::STATUS_DOC_NOT_EXIST - document doesn't exist
+		=>	Message::MessageStatus::STATUS_IO_ERROR - an IO error occured
+	**/
+	Message::MessageStatus delete_document(const std::string &name)
+	{
+		g_user_interface->printf("deleting document: %s\n", name);
+		try
+		{
+			Document doc = Document::open(name);
+			doc.remove();
+			doc.close();
+			get_document_catalog().remove(name);
+			get_search_index().remove(name);
+			closed_docs.erase(name);
 		}
 		catch (document_errors::DocumentDoesntExistError)
-		{ throw Message::MessageStatus::STATUS_DOC_NOT_EXIST; }
+		{ return Message::MessageStatus::STATUS_DOC_NOT_EXIST; }
 		catch (document_errors::DocumentError)
-		{ throw Message::MessageStatus::STATUS_IO_ERROR; }
+		{ return Message::MessageStatus::STATUS_IO_ERROR; }
+
+		// a stale entry would never match again, forgetting it just keeps the index small
+		try
+		{ DocumentIndex::get_instance().remove(name); }
+		catch (const database_errors::Failure &)
+		{}
+
+		// a document created with the same name later starts a new history
+		try
+		{ DocumentVersions::get_instance().remove(name); }
+		catch (const database_errors::Failure &)
+		{}
+
+		return Message::MessageStatus::STATUS_OK;
+	}
+
+	/**
+		Gets the document with the specified id from the auxiliary cache. It must already have been
+		opened to make this action succeed.
+			id - document id
+		=>	#
+		=>	Message::MessageStatus::STATUS_DOC_NOT_EXIST - document isn't opened
+	**/
+	Result<DocumentSptr> get_document(int32_t id)
+	{
+		g_user_interface->printf("getting document: %d\n", id);
+		auto iter = doc_by_id.find(id);
+		if (iter == doc_by_id.end())
+		{ return Message::MessageStatus::STATUS_DOC_NOT_EXIST; }
+
+		return iter->second;
+	}
+
+	/**
+		Attempts to open a document by name or get it from the auxiliary cache. If it's opened it
+		automatically gets added to the auxiliary cache for further use.
+		The document stays open until every client that opened it closed it.
+			name - document name
+			socket - socket of the client opening the document
+		=>	#
+		=>	Message::MessageStatus::STATUS_DOC_NOT_EXIST - document doesn't exist
+		=>	Message::MessageStatus::STATUS_IO_ERROR - an IO error occured
+	**/
+	Result<DocumentSptr> open_document(const std::string &name, int socket)
+	{
+		g_user_interface->printf("[socket %d] opening document: %s\n", socket, name);
+		DocumentSptr result;
+
+		auto iter = doc_by_name.find(name);
+		if (iter == doc_by_name.end())
+		{
+			try
+			{
+				// reuse a recently closed document if its file is unchanged, open it otherwise
+				Hash::hash_t hash;
+				bool hashed = false;
+				result = closed_docs.take(name, hash, hashed);
+				if (!result)
+				{ result = DocumentSptr(new Document(Document::open(name))); }
+				int32_t doc_id = result->get_id();
+
+				const TextStatistics &statistics = result->get_statistics();
+				g_user_interface->printf("[socket %d] document has %lld lines, %lld words%s\n",
+					socket, static_cast<long long>(statistics.lines),
+					static_cast<long long>(statistics.words),
+					statistics.valid_utf8 ? "" : ", invalid UTF-8");
+
+				// the index misses changes others made to the file, at least most of them
+				std::vector<char> &contents = result->get_contents();
+				if (get_search_index().get_size(name) != static_cast<int64_t>(contents.size()))
+				{ get_search_index().insert(name, contents); }
+
+				if (hashed)
+				{ doc_hash[doc_id] = std::make_pair(0, hash); }
+
+				// save DocumentSptr in several hashes
+				doc_by_id[doc_id] = doc_by_name[name] = result;
+				doc_counter[doc_id] = 0;
+			}
+			catch (document_errors::DocumentDoesntExistError)
+			{ return Message::MessageStatus::STATUS_DOC_NOT_EXIST; }
+			catch (document_errors::DocumentError)
+			{ return Message::MessageStatus::STATUS_IO_ERROR; }
+		}
+		else
+		{ result = iter->second; }
+
+		// the counter holds the clients having the document opened, each counts once
+		if (open_docs[socket].insert(result->get_id()).second)
+		{ ++doc_counter[result->get_id()]; }
+
+		return result;
+	}
+
+	/**
+		Computes the hash of a document's contents, once per revision. As long as the document
+		hasn't been edited since it was opened or saved, its contents match the file, so the hash
+		is taken from the DocumentIndex, or stored there once computed.
+			doc - document to hash
+		=>	the hash of the contents
+	**/
+	Hash::hash_t get_document_hash(Document &doc)
+	{
+		int32_t doc_id = doc.get_id();
+		int32_t revision = doc_history[doc_id].get_revision();
+
+		auto cached = doc_hash.find(doc_id);
+		if (cached != doc_hash.end() && cached->second.first == revision)
+		{ return cached->second.second; }
+
+		Hash::hash_t hash;
+		DocumentIndex::Entry entry;
+		try
+		{
+			// the file only matches if there are no unsaved edits
+			if (doc_saved[doc_id] != revision)
+			{ hash = doc.hash(); }
+			else if (DocumentIndex::get_instance().lookup(doc.get_name(), entry))
+			{ hash = entry.hash; }
+			else
+			{
+				hash = doc.hash();
+				DocumentIndex::get_instance().update(doc.get_name(), hash);
+			}
+		}
+		catch (const database_errors::Failure &)
+		{ hash = doc.hash(); }
+
+		doc_hash[doc_id] = std::make_pair(revision, hash);
+		return hash;
+	}
+
+	/**
+		Sends a whole document to a client, assuming that it's already cleared to 0 Bytes on the
+		clientside, thus starting at position 0. The contents are queued as a Transfer, so the
+		network event loop sends them in chunks between processing other messages; the first chunk
+		is sent right away unless other Transfers are queued for the client. The chunks are encoded
+		from the document itself and cached until it's edited, so opening an unchanged document
+		neither copies nor encodes it again. The cached chunks are bounded by SNAPSHOT_CACHE_SIZE.
+			doc - document to send
+			client - client to send the document to
+		=#	Client::send
+	**/
+	void send_document(const DocumentSptr &doc, const Client &client)
+	{
+		g_user_interface->printf("[client %d] sending document: %d\n", client.user_id, doc->get_id());
+		int32_t revision = doc_history[doc->get_id()].get_revision();
+		auto snapshot = doc_snapshot.find(doc->get_id());
+		if (snapshot == doc_snapshot.end() || snapshot->second.first != revision)
+		{
+			release_snapshot(doc->get_id());
+			snapshot = doc_snapshot.emplace(doc->get_id(), std::make_pair(revision,
+				std::make_shared<DocumentSnapshot>(doc))).first;
+		}
+
+		client.send(Transfer(snapshot->second.second, doc->get_id()));
+		evict_snapshots(SNAPSHOT_CACHE_SIZE);
+	}
+
+	/**
+		Sends the bytes within a client's viewport as TYPE_DOC_VIEWPORT, along with the revision
+		they belong to. The viewport is clamped to the document first.
+			doc - the client's active document
+			client - client showing the viewport
+		=#	Message::send_to
+	**/
+	void send_viewport(Document &doc, Client &client)
+	{
+		const std::vector<char> &contents = doc.get_contents();
+		int64_t size = contents.size();
+		client.viewport_position = std::min(client.viewport_position, size);
+		client.viewport_length = std::min(client.viewport_length,
+			size - client.viewport_position);
+
+		Message response;
+		response.type = Message::MessageType::TYPE_DOC_VIEWPORT;
+		response.status = Message::MessageStatus::STATUS_OK;
+		response.revision = doc_history[doc.get_id()].get_revision();
+		response.position = client.viewport_position;
+		response.length = client.viewport_length;
+		response.bytes.assign(contents.begin() + response.position,
+			contents.begin() + response.position + response.length);
+		response.send_to(client);
+	}
+
+	/**
+		Sends the contents of a client's active document, either the bytes within its viewport
+		or the whole document if it hasn't set one.
+			doc - the client's active document
+			client - client to send the contents to
+		=#	Client::send
+	**/
+	void send_contents(const DocumentSptr &doc, Client &client)
+	{
+		if (client.viewport_length < 0)
+		{ send_document(doc, client); }
+		else
+		{ send_viewport(*doc, client); }
+	}
+
+	/**
+		Resumes a session whose connection dropped. The client receives the TYPE_SESSION_RESUME
+		response with the id and revision of its active document, followed by the edits it missed
+		since the given revision as TYPE_SYNC_BATCH, or by the whole document if they aren't
+		retained anymore. The other clients receive TYPE_USER_JOIN.
+			client - client on the new connection
+			token - session token received at login
+			revision - last revision of the active document the client received
+		=>	Message::MessageStatus::STATUS_OK - session resumed, missed edits following
+		=>	Message::MessageStatus::STATUS_OK_CONTENTS_FOLLOWING - session resumed, document
+			contents following
+		=>	Message::MessageStatus::STATUS_SESSION_UNKNOWN - session expired, unknown or still
+			connected
+		=#	Message::send_to
+	**/
+	Message::MessageStatus resume_session(Client &client,
+		const std::array<char, Message::FIELD_SIZE_HASH> &token, int32_t revision)
+	{
+		expire_sessions();
+
+		Message response;
+		response.type = Message::MessageType::TYPE_SESSION_RESUME;
+		response.status = Message::MessageStatus::STATUS_SESSION_UNKNOWN;
+
+		std::string key(token.begin(), token.end());
+		auto session = sessions.find(key);
+		if (session == sessions.end() || session->second.expires == 0)
+		{
+			response.send_to(client);
+			return response.status;
+		}
+
+		g_user_interface->printf("[client %d] resuming session at revision %d\n",
+			session->second.user_id, revision);
+		client.compression = session->second.compression;
+		client.user_id = session->second.user_id;
+		session->second.expires = 0;
+		session_by_socket[client.socket] = key;
+
+		// the documents kept open for the session belong to the new connection
+		open_docs[client.socket] = std::move(session->second.documents);
+		session->second.documents.clear();
+
+		// the active document may have been closed meanwhile
+		response.status = Message::MessageStatus::STATUS_OK;
+		Result<DocumentSptr> doc = get_document(session->second.active_document);
+		EditHistory::PendingEdits missed;
+		if (doc.is_ok())
+		{
+			activate_document(client, session->second.active_document);
+			response.id = client.active_document;
+			response.revision = doc_history[client.active_document].get_revision();
+
+			if (!doc_history[client.active_document].get_edits_since(revision, missed))
+			{ response.status = Message::MessageStatus::STATUS_OK_CONTENTS_FOLLOWING; }
+		}
+
+		response.send_to(client);
+
+		if (response.status == Message::MessageStatus::STATUS_OK_CONTENTS_FOLLOWING)
+		{ send_contents(doc.get_value(), client); }
+
+		for (const std::pair<int32_t, EditOperations> &edit: missed)
+		{
+			Message sync;
+			sync.type = Message::MessageType::TYPE_SYNC_BATCH;
+			sync.revision = edit.first;
+			sync.operations = edit.second;
+			sync.send_to(client);
+		}
+
+		Message announcement;
+		announcement.type = Message::MessageType::TYPE_USER_JOIN;
+		announcement.id = client.user_id;
+		announcement.name = session->second.name;
+		NetworkInterface::get_current_instance().broadcast_message(announcement);
+
+		return response.status;
+	}
+
+	/**
+		Converts a line and column of the client's active document to a position, using the
+		document's line index instead of scanning the contents.
+			client - client whose active document is addressed
+			line - line, counted from 0
+			column - byte offset within the line, at most the length of the line without its
+				newline
+		=>	the position
+		=>	Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC - client has no opened active doc
+		=>	Message::MessageStatus::STATUS_USER_CURSOR_OUT_OF_BOUNDS - line or column is out of
+			bounds
+	**/
+	Result<int64_t> get_line_position(const Client &client, int64_t line, int64_t column)
+	{
+		Result<DocumentSptr> doc = get_document(client.active_document);
+		if (!doc.is_ok())
+		{ return Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC; }
+
+		const LineIndex &index = doc.get_value()->get_line_index();
+		if (line < 0 || line >= index.get_line_count() || column < 0)
+		{ return Message::MessageStatus::STATUS_USER_CURSOR_OUT_OF_BOUNDS; }
+
+		// all lines but the last one end with a newline
+		int64_t length = index.get_line_length(line);
+		if (line + 1 < index.get_line_count())
+		{ --length; }
+
+		if (column > length)
+		{ return Message::MessageStatus::STATUS_USER_CURSOR_OUT_OF_BOUNDS; }
+
+		return index.get_line_start(line) + column;
+	}
+
+	/**
+		Sets the range of its active document a client shows. From now on the client receives only
+		the edits near it in full, see broadcast_to_viewports. Viewports are limited to
+		VIEWPORT_LIMIT bytes. A client without an active document sets the viewport of the next
+		document it opens, starting at its beginning.
+			client - client that sets its viewport
+			position - start of the viewport
+			length - length of the viewport, -1 to receive the whole document
+		=>	Message::MessageStatus::STATUS_OK - viewport set
+		=>	Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC - viewport set for the next
+			document the client opens
+		=>	Message::MessageStatus::STATUS_USER_CURSOR_OUT_OF_BOUNDS - position is out of bounds
+		=>	Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG - length is negative
+	**/
+	Message::MessageStatus set_viewport(Client &client, int64_t position, int64_t length)
+	{
+		g_user_interface->printf("[client %d] showing %lld bytes at %lld\n", client.user_id,
+			static_cast<long long>(length), static_cast<long long>(position));
+
+		if (length < -1)
+		{ return Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG; }
+
+		if (position < 0)
+		{ return Message::MessageStatus::STATUS_USER_CURSOR_OUT_OF_BOUNDS; }
+
+		Result<DocumentSptr> doc = get_document(client.active_document);
+		if (doc.is_ok() && static_cast<size_t>(position) > doc.get_value()->get_contents().size())
+		{ return Message::MessageStatus::STATUS_USER_CURSOR_OUT_OF_BOUNDS; }
+
+		client.viewport_position = doc.is_ok() && length >= 0 ? position : 0;
+		client.viewport_length = std::min(length, VIEWPORT_LIMIT);
+
+		return doc.is_ok() ? Message::MessageStatus::STATUS_OK :
+			Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC;
+	}
+
+	/**
+		Checks whether the bytes inserted by operations are valid UTF-8, each insertion on its
+		own.
+			operations - EditOperations or SequenceOperations to check
+		=>	whether all insertions are valid
+	**/
+	template<typename Operations>
+	bool inserts_valid_utf8(const Operations &operations)
+	{
+		for (const typename Operations::value_type &operation: operations)
+		{
+			const std::vector<char> &bytes = operation.bytes;
+			if (!TextStatistics::is_valid_utf8(bytes.data(), bytes.data() + bytes.size()))
+			{ return false; }
+		}
+
+		return true;
+	}
+
+	/**
+		Inserts bytes into the client's active document and broadcasts the change.
+			client - client that sent the bytes
+			position - insert position
+			bytes - bytes to insert
+			multibyte - whether to broadcast TYPE_SYNC_MULTIBYTE or TYPE_SYNC_BYTE
+		=>	Message::MessageStatus::STATUS_OK - bytes inserted
+		=>	Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC - client has no opened active doc
+		=>	Message::MessageStatus::STATUS_USER_CURSOR_UNKNOWN - position is negative
+		=>	Message::MessageStatus::STATUS_USER_CURSOR_OUT_OF_BOUNDS - position is out of bounds
+		=>	Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG - the document would grow beyond
+			get_size_limit
+		=>	Message::MessageStatus::STATUS_INVALID_UTF8 - multibyte and the bytes aren't valid
+			UTF-8
+		=#	Message::send_to
+	**/
+	Message::MessageStatus sync_bytes(const Client &client, int64_t position,
+		const std::vector<char> &bytes, bool multibyte = true)
+	{
+		g_user_interface->printf("[client %d] syncing bytes at %lld\n", client.user_id,
+			static_cast<long long>(position));
+
+		// check if client has an active document at all and it's opened
+		if (client.active_document < 1)
+		{ return Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC; }
+
+		// check if cursor position is known
+		if (position < 0)
+		{ return Message::MessageStatus::STATUS_USER_CURSOR_UNKNOWN; }
+
+		// get document
+		Result<DocumentSptr> doc = get_document(client.active_document);
+		if (!doc.is_ok())
+		{ return Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC; }
+
+		// get contents and check if cursor position is in bounds
+		std::vector<char> &contents = doc.get_value()->get_contents();
+		if (static_cast<size_t>(position) >= contents.size())
+		{ return Message::MessageStatus::STATUS_USER_CURSOR_OUT_OF_BOUNDS; }
+
+		// check if the document stays addressable by all clients
+		size_t added = multibyte ? bytes.size() : 1;
+		if (static_cast<int64_t>(contents.size() + added) > get_size_limit(client.active_document))
+		{ return Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG; }
+
+		// single bytes may be parts of a character
+		if (multibyte && !TextStatistics::is_valid_utf8(bytes.data(), bytes.data() + bytes.size()))
+		{ return Message::MessageStatus::STATUS_INVALID_UTF8; }
+
+		// create synchronization message
+		Message sync;
+		sync.type = multibyte ? Message::MessageType::TYPE_SYNC_MULTIBYTE :
+			Message::MessageType::TYPE_SYNC_BYTE;
+		sync.bytes = multibyte ? bytes : std::vector<char>(bytes.begin(),
+			bytes.begin() + 1);
+		sync.length = multibyte ? bytes.size() : 1;
+		sync.position = position;
+
+		// broadcast synchronization message
+		EditOperations operations { EditOperation(EditOperation::Kind::KIND_INSERT,
+			sync.position, 0, sync.bytes) };
+		broadcast_edit(sync, operations, client.active_document);
+
+		// apply change to document
+		apply_edits(*doc.get_value(), operations);
+		doc_history[client.active_document].commit(client.socket, operations);
+
+		return Message::MessageStatus::STATUS_OK;
+	}
+
+	/**
+		Deletes a range of the client's active document and broadcasts the change.
+			client - client that sent the deletion
+			position - start of the range
+			length - length of the range
+		=>	Message::MessageStatus::STATUS_OK - range deleted
+		=>	Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC - client has no opened active doc
+		=>	Message::MessageStatus::STATUS_USER_CURSOR_OUT_OF_BOUNDS - position is out of bounds
+		=>	Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG - range exceeds the document
+		=#	Message::send_to
+	**/
+	Message::MessageStatus sync_deletion(const Client &client, int64_t position, int64_t length)
+	{
+		g_user_interface->printf("[client %d] syncing deletion at %lld\n", client.user_id,
+			static_cast<long long>(position));
+
+		Result<DocumentSptr> doc = get_document(client.active_document);
+		if (!doc.is_ok())
+		{ return Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC; }
+
+		std::vector<char> &contents = doc.get_value()->get_contents();
+
+		// check if start position is out of bounds
+		if (position < 0 || static_cast<size_t>(position) >= contents.size())
+		{ return Message::MessageStatus::STATUS_USER_CURSOR_OUT_OF_BOUNDS; }
+
+		// check if length too big
+		if (length < 0 || static_cast<uint64_t>(length) > contents.size() - position)
+		{ return Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG; }
+
+		// sync deletion
+		Message sync;
+		sync.type = Message::MessageType::TYPE_SYNC_DELETION;
+		sync.position = position;
+		sync.length = length;
+
+		EditOperations operations { EditOperation(EditOperation::Kind::KIND_DELETE,
+			sync.position, sync.length) };
+		broadcast_edit(sync, operations, client.active_document);
+		NetworkInterface::get_current_instance().update_client_cursors(sync.position,
+			-sync.length, client.active_document);
+
+		// perform deletion
+		apply_edits(*doc.get_value(), operations);
+		doc_history[client.active_document].commit(client.socket, operations);
+
+		return Message::MessageStatus::STATUS_OK;
 	}
 
 	/**
-		Deletes an existing document.
-			name - document name
-		=#	Message::MessageStatus::STATUS_DOC_NOT_EXIST - document doesn't exist
-		=#	Message::MessageStatus::STATUS_IO_ERROR - an IO error occured
+		Applies edit operations to the client's active document and broadcasts them as one
+		TYPE_SYNC_BATCH carrying the new revision. The operations are transformed against the edits
+		of other clients the sender hasn't seen yet. Either all operations are applied or none of
+		them.
+			client - client that sent the operations
+			base_revision - last revision the client received
+			operations - operations to apply, each position relative to the result of the
+				preceding operation
+		=>	Message::MessageStatus::STATUS_OK - operations applied
+		=>	Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC - client has no opened active doc
+		=>	Message::MessageStatus::STATUS_REVISION_UNKNOWN - base revision can't be transformed
+		=>	Message::MessageStatus::STATUS_USER_CURSOR_UNKNOWN - a position is negative
+		=>	Message::MessageStatus::STATUS_USER_CURSOR_OUT_OF_BOUNDS - a position is out of bounds
+		=>	Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG - a range exceeds the document or
+			the document would grow beyond get_size_limit
+		=>	Message::MessageStatus::STATUS_INVALID_UTF8 - inserted bytes aren't valid UTF-8
+		=#	Message::send_to
 	**/
-	void delete_document(const std::string &name)
+	Message::MessageStatus sync_batch(const Client &client, int32_t base_revision,
+		EditOperations operations)
 	{
-		g_user_interface->printf("deleting document: %s\n", name);
-		try
+		g_user_interface->printf("[client %d] syncing %zu operations based on revision %d\n",
+			client.user_id, operations.size(), base_revision);
+
+		Result<DocumentSptr> doc = get_document(client.active_document);
+		if (!doc.is_ok())
+		{ return Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC; }
+
+		if (!inserts_valid_utf8(operations))
+		{ return Message::MessageStatus::STATUS_INVALID_UTF8; }
+
+		std::vector<char> &contents = doc.get_value()->get_contents();
+		EditHistory &history = doc_history[client.active_document];
+
+		// transform against concurrent edits
+		EditHistory::PendingEdits pending;
+		if (!history.transform(client.socket, base_revision, operations, pending))
+		{ return Message::MessageStatus::STATUS_REVISION_UNKNOWN; }
+
+		// check all operations against the size the document will have at their turn
+		int64_t size = contents.size();
+		int64_t limit = get_size_limit(client.active_document);
+		for (const EditOperation &operation: operations)
 		{
-			Document doc = Document::open(name);
-			doc.remove();
-			doc.close();
+			if (operation.position < 0)
+			{ return Message::MessageStatus::STATUS_USER_CURSOR_UNKNOWN; }
+
+			if (operation.position > size)
+			{ return Message::MessageStatus::STATUS_USER_CURSOR_OUT_OF_BOUNDS; }
+
+			if (operation.length > size - operation.position)
+			{ return Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG; }
+
+			size += operation.get_delta();
+			if (size > limit)
+			{ return Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG; }
 		}
-		catch (document_errors::DocumentDoesntExistError)
-		{ throw Message::MessageStatus::STATUS_DOC_NOT_EXIST; }
-		catch (document_errors::DocumentError)
-		{ throw Message::MessageStatus::STATUS_IO_ERROR; }
+
+		// broadcast all operations at once, the sender takes it as acknowledgement
+		Message sync;
+		sync.type = Message::MessageType::TYPE_SYNC_BATCH;
+		sync.revision = history.commit(client.socket, operations, pending);
+		sync.operations = operations;
+
+		broadcast_edit(sync, operations, client.active_document);
+		NetworkInterface::get_current_instance().update_client_cursors(operations,
+			client.active_document);
+
+		apply_edits(*doc.get_value(), operations);
+
+		return Message::MessageStatus::STATUS_OK;
 	}
 
 	/**
-		Gets the document with the specified id from the auxiliary cache. It must already have been
-		opened to make this action succeed.
-			id - document id
-		=>	#
-		=#	Message::MessageStatus::STATUS_DOC_NOT_EXIST - document isn't opened
+		Replaces all occurrences of a pattern within the client's active document. The
+		replacements are applied as one edit, which all clients of the document receive as a
+		single TYPE_SYNC_BATCH, see broadcast_edit. No client made the edit, so the requesting
+		client applies the broadcast like the others. Literal patterns are found by TextSearch,
+		regular expressions by RegexSearch, whose format may refer to the groups of a match, e.g.
+		"$1". ^ and $ match at the document's ends only.
+			client - client that requested the replacement
+			pattern - bytes or regular expression to replace
+			replacement - bytes or format of the bytes to replace the occurrences with
+			regex - whether pattern and replacement are a regular expression and a format
+		=>	the amount of occurrences replaced
+		=>	Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC - client has no opened active doc
+		=>	Message::MessageStatus::STATUS_INVALID_PATTERN - pattern is empty, not a supported regular
+			expression or exceeds the limits of RegexSearch
+		=>	Message::MessageStatus::STATUS_INVALID_UTF8 - a replacement isn't valid UTF-8
+		=>	Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG - the document would grow beyond
+			get_size_limit
+		=#	Message::send_to
 	**/
-	DocumentSptr get_document(int32_t id)
+	Result<int64_t> replace_all(const Client &client, const std::string &pattern,
+		const std::vector<char> &replacement, bool regex)
 	{
-		g_user_interface->printf("getting document: %d\n", id);
-		try
-		{ return doc_by_id.at(id); }
-		catch (std::out_of_range)
-		{ throw Message::MessageStatus::STATUS_DOC_NOT_EXIST; }
-	}
+		g_user_interface->printf("[client %d] replacing all occurrences of %s\n", client.user_id,
+			pattern.c_str());
 
-	std::vector<char> get_document_list(void)
-	{
-		g_user_interface->printf("getting document list\n");
-		// variable initialization
-		const std::vector<std::string> string_list = Document::list_documents();
-		std::vector<char> result(string_list.size() * Message::FIELD_SIZE_DOC_NAME);
+		Result<DocumentSptr> doc = get_document(client.active_document);
+		if (!doc.is_ok())
+		{ return Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC; }
 
-		auto pos = result.begin();
+		if (pattern.empty())
+		{ return Message::MessageStatus::STATUS_INVALID_PATTERN; }
 
-		// iterate through document names
-		for (const std::string document_name: string_list)
+		// each operation is relative to the result of the preceding ones
+		const std::vector<char> &contents = doc.get_value()->get_contents();
+		EditOperations operations;
+		int64_t delta = 0;
+		if (!regex)
 		{
-			// skip if document name is empty
-			if (document_name.empty())
-			{ continue; }
-
-			// check if document name has to be padded
-			if (document_name.length() < Message::FIELD_SIZE_DOC_NAME)
+			for (int64_t position: TextSearch::find_all(contents.data(),
+				contents.data() + contents.size(), pattern))
 			{
-				result.insert(pos, document_name.front(), document_name.back());
-				std::fill(pos + document_name.length(), pos + Message::FIELD_SIZE_DOC_NAME, '\0');
+				operations.emplace_back(EditOperation::Kind::KIND_REPLACE, position + delta,
+					pattern.size(), replacement);
+				delta += operations.back().get_delta();
 			}
-			else
+		}
+		else
+		{
+			const char *begin = contents.data(), *end = contents.data() + contents.size();
+			try
 			{
-				result.insert(pos, document_name.front(), document_name.front() +
-					Message::FIELD_SIZE_DOC_NAME);
+				RegexSearch expression(pattern);
+				for (const RegexSearch::Match &match: expression.find_all(begin, end))
+				{
+					operations.emplace_back(EditOperation::Kind::KIND_REPLACE,
+						match.get_position() + delta, match.get_length(),
+						expression.format(match, begin, end, replacement));
+					delta += operations.back().get_delta();
+				}
 			}
-
-			pos += Message::FIELD_SIZE_DOC_NAME;
+			catch (const regexsearch_errors::PatternError &)
+			{ return Message::MessageStatus::STATUS_INVALID_PATTERN; }
 		}
 
-		return result;
-	}
+		if (operations.empty())
+		{ return 0; }
 
-	/**
-		Checks if a document is empty.
-			name - document name
-		=>	whether the document is empty
-		=#	Message::MessageStatus::STATUS_DOC_NOT_EXIST - document doesn't exist
-		=#	Message::MessageStatus::STATUS_IO_ERROR - an IO error occured
-	**/
-	bool is_document_empty(const std::string &name)
-	{
-		g_user_interface->printf("checking if %s is empty\n", name);
-		try
-		{ return Document::is_empty(name); }
-		catch (document_errors::DocumentDoesntExistError)
-		{ throw Message::MessageStatus::STATUS_DOC_NOT_EXIST; }
-		catch (document_errors::DocumentError)
-		{ throw Message::MessageStatus::STATUS_IO_ERROR; }
+		if (!inserts_valid_utf8(operations))
+		{ return Message::MessageStatus::STATUS_INVALID_UTF8; }
+
+		if (static_cast<int64_t>(contents.size()) + delta > get_size_limit(client.active_document))
+		{ return Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG; }
+
+		// commit as nobody's edit, so every client catches up on it, the requesting one included
+		Message sync;
+		sync.type = Message::MessageType::TYPE_SYNC_BATCH;
+		sync.revision = doc_history[client.active_document].commit(-1, operations);
+		sync.operations = operations;
+
+		broadcast_edit(sync, operations, client.active_document);
+		NetworkInterface::get_current_instance().update_client_cursors(operations,
+			client.active_document);
+
+		apply_edits(*doc.get_value(), operations);
+
+		return static_cast<int64_t>(operations.size());
 	}
 
 	/**
-		Attempts to open a document by name or get it from the auxiliary cache. If it's opened it
-		automatically gets added to the auxiliary cache for further use.
-			name - document name
-		=>	#
-		=#	Message::MessageStatus::STATUS_DOC_NOT_EXIST - document doesn't exist
-		=#	Message::MessageStatus::STATUS_IO_ERROR - an IO error occured
+		Switches a client to sequence mode for its active document, starting the document's
+		sequence if it hasn't got one yet. The client leaves the document's edit history, from now
+		on it receives edits as TYPE_SYNC_MERGE.
+			client - client to switch
+			response - response to store the client's site and the sequence's snapshot in
+		=>	Message::MessageStatus::STATUS_OK - client switched
+		=>	Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC - client has no opened active doc
+		=>	Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG - the document is too large for
+			the 32 bit sequence positions
 	**/
-	DocumentSptr open_document(const std::string &name, uint32_t client_id = 0)
+	Message::MessageStatus enter_sequence_mode(Client &client, Message &response)
 	{
-		g_user_interface->printf("[client %d] opening document: %s\n", client_id, name);
-		DocumentSptr result;
-
-		auto iter = doc_by_name.find(name);
-		if (iter == doc_by_name.end())
-		{
-			try
-			{
-				// open document and retrieve id
-				result = DocumentSptr(new Document(Document::open(name)));
-				int32_t doc_id = result->get_id();
+		g_user_interface->printf("[client %d] entering sequence mode\n", client.user_id);
 
-				// save DocumentSptr in several hashes
-				doc_by_id[doc_id] = doc_by_name[name] = result;
-				doc_counter[doc_id] = 0;
+		Result<DocumentSptr> doc = get_document(client.active_document);
+		if (!doc.is_ok())
+		{ return Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC; }
 
-				// add to client opened documents if a client id is provided
-				if (client_id != 0)
-				{ open_docs[client_id].insert(doc_id); }
+		std::vector<char> &contents = doc.get_value()->get_contents();
+		if (contents.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+		{ return Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG; }
 
-				return result;
-			}
-			catch (document_errors::DocumentDoesntExistError)
-			{ throw Message::MessageStatus::STATUS_DOC_NOT_EXIST; }
-			catch (document_errors::DocumentError)
-			{ throw Message::MessageStatus::STATUS_IO_ERROR; }
+		auto sequence = doc_sequence.find(client.active_document);
+		if (sequence == doc_sequence.end())
+		{
+			sequence = doc_sequence.emplace(client.active_document,
+				SequenceDocument(contents.size())).first;
 		}
-		else
-		{ result = iter->second; }
 
-		// increment document counter
-		++doc_counter[result->get_id()];
-		
-		return result;
+		doc_history[client.active_document].remove_client(client.socket);
+		client.sequence_site = sequence->second.add_site();
+
+		response.site = client.sequence_site;
+		response.revision = sequence->second.get_revision();
+		response.sequence = sequence->second.get_snapshot();
+
+		return Message::MessageStatus::STATUS_OK;
 	}
 
 	/**
-		Sends a whole document to a client, assuming that it's already cleared to 0 Bytes on the
-		clientside, thus starting at position 0.
-			doc - document to send
-			client - client to send the document to
+		Merges sequence operations of a client, e.g. all edits it made while being offline, in one
+		pass. The client first receives the operations of others it missed since the given
+		revision, then all clients of the document receive the merged operations, clients not in
+		sequence mode as TYPE_SYNC_BATCH. The document becomes the client's active one and the
+		client stays in sequence mode.
+			client - client that sent the operations
+			doc_id - document id
+			site - the client's site, as assigned when it entered sequence mode
+			revision - last sequence revision the client received
+			operations - operations to merge
+		=>	Message::MessageStatus::STATUS_OK - operations merged
+		=>	Message::MessageStatus::STATUS_DOC_NOT_EXIST - document isn't opened
+		=>	Message::MessageStatus::STATUS_REVISION_UNKNOWN - the sequence, the site or the
+			revision is unknown, or an operation couldn't be merged; the operations before it
+			have been merged
+		=>	Message::MessageStatus::STATUS_INVALID_UTF8 - inserted bytes aren't valid UTF-8,
+			nothing has been merged
 		=#	Message::send_to
 	**/
-	void send_document(Document &doc, const Client &client)
+	Message::MessageStatus sync_merge(Client &client, int32_t doc_id, int32_t site,
+		int32_t revision, const SequenceOperations &operations)
 	{
-		g_user_interface->printf("[client %d] sending document: %d\n", client.user_id, doc.get_id());
-		// initialize message
-		Message message;
-		message.type = Message::MessageType::TYPE_SYNC_MULTIBYTE;
-		message.position = 0;
+		g_user_interface->printf("[client %d] merging %zu operations based on revision %d\n",
+			client.user_id, operations.size(), revision);
 
-		std::vector<char> contents = doc.get_contents();
-		auto start = contents.begin();
-		while (start != contents.end())
-		{
-			// get remaining amount of bytes, trim to int32_t max if necessary
-			size_t rem_length = contents.end() - start;
-			if (rem_length > std::numeric_limits<int32_t>::max())
-			{ message.length = std::numeric_limits<int32_t>::max(); }
-			else
-			{ message.length = rem_length; }
+		Result<DocumentSptr> doc = get_document(doc_id);
+		if (!doc.is_ok())
+		{ return Message::MessageStatus::STATUS_DOC_NOT_EXIST; }
 
-			// prepare bytes vector of message
-			message.bytes.clear();
-			message.bytes.insert(message.bytes.begin(), start, start + message.length);
+		auto sequence = doc_sequence.find(doc_id);
+		if (sequence == doc_sequence.end() || !sequence->second.has_site(site))
+		{ return Message::MessageStatus::STATUS_REVISION_UNKNOWN; }
 
-			// send message and update variables
-			message.send_to(client);
-			start += message.length;
-			message.position += message.length;
-		}
-	}
+		if (!inserts_valid_utf8(operations))
+		{ return Message::MessageStatus::STATUS_INVALID_UTF8; }
 
-	void sync_bytes(const Client &client, int32_t position, const std::vector<char> &bytes,
-		bool multibyte = true)
-	{
-		g_user_interface->printf("[client %d] syncing bytes at %d\n", client.user_id, position);
-		DocumentSptr doc;
+		Message missed;
+		missed.type = Message::MessageType::TYPE_SYNC_MERGE;
+		missed.revision = sequence->second.get_revision();
+		if (!sequence->second.get_operations_since(revision, site, missed.sequence))
+		{ return Message::MessageStatus::STATUS_REVISION_UNKNOWN; }
 
-		// check if client has an active document at all and it's opened
-		if (client.active_document < 1)
-		{ throw Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC; }
+		// a reconnecting client resumes its site
+		if (client.active_document != doc_id)
+		{ activate_document(client, doc_id); }
+		doc_history[doc_id].remove_client(client.socket);
+		client.sequence_site = site;
 
-		try
-		{
-			// check if cursor position is known
-			if (position < 0)
-			{ throw Message::MessageStatus::STATUS_USER_CURSOR_UNKNOWN; }
+		missed.send_to(client);
 
-			// get document
-			doc = get_document(client.active_document);
+		Message merge;
+		merge.type = Message::MessageType::TYPE_SYNC_MERGE;
+		EditOperations edits;
+		bool merged = sequence->second.merge(site, operations, edits, merge.sequence);
+		merge.revision = sequence->second.get_revision();
 
-			// get contents and check if cursor position is in bounds
-			auto contents = doc->get_contents();
-			if (static_cast<size_t>(position) >= contents.size())
-			{ throw Message::MessageStatus::STATUS_USER_CURSOR_OUT_OF_BOUNDS; }
+		if (!edits.empty())
+		{
+			release_snapshot(doc_id);
 
-			// create synchronization message
 			Message sync;
-			sync.type = multibyte ? Message::MessageType::TYPE_SYNC_MULTIBYTE :
-				Message::MessageType::TYPE_SYNC_BYTE;
-			sync.bytes = multibyte ? bytes : std::vector<char>(bytes.begin(),
-				bytes.begin() + 1);
-			sync.length = multibyte ? bytes.size() : 1;
-			sync.position = position;
+			sync.type = Message::MessageType::TYPE_SYNC_BATCH;
+			sync.revision = doc_history[doc_id].commit(client.socket, edits);
+			sync.operations = edits;
 
-			// broadcast synchronization message
-			NetworkInterface::get_current_instance().broadcast_message(sync,
-				client.active_document);
+			// the sender takes its own operations as acknowledgement
+			NetworkInterface &network = NetworkInterface::get_current_instance();
+			broadcast_to_viewports(sync, edits, doc_id);
+			network.broadcast_message(merge, doc_id, in_sequence_mode);
+			network.update_client_cursors(edits, doc_id);
 
-			// apply change to document
-			contents.insert(contents.begin() + sync.position, sync.bytes.begin(),
-				sync.bytes.end());
+			apply_edits(*doc.get_value(), edits);
 		}
-		catch (Message::MessageStatus)
-		{ throw Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC; }
+
+		return merged ? Message::MessageStatus::STATUS_OK :
+			Message::MessageStatus::STATUS_REVISION_UNKNOWN;
 	}
 };
 
+/**
+	Handles a single Message received from a client. The per-tick work is left to
+	main_network_batch_handler.
+		message - message to handle
+**/
 void main_network_message_handler(const Message &message)
 {
-	if (message.type == Message::MessageType::TYPE_INIT)
-		return;
-
 	// check if user is logged in
-	if (message.source->user_id == 0 && message.type != Message::MessageType::TYPE_USER_LOGIN)
+	if (message.source->user_id == 0 && message.type != Message::MessageType::TYPE_USER_LOGIN &&
+		message.type != Message::MessageType::TYPE_PROTOCOL_VERSION &&
+		message.type != Message::MessageType::TYPE_SESSION_RESUME &&
+		message.type != Message::MessageType::TYPE_COMPRESSION)
 	{ return; }
 	
 	// initialize response Message
@@ -338,27 +1502,34 @@ void main_network_message_handler(const Message &message)
 		case Message::MessageType::TYPE_DOC_ACTIVATE:
 		{
 			print_string = "received TYPE_DOC_ACTIVATE message";
-			DocumentSptr doc;
 
-			try
+			// the document is addressed by id, the client holds it from now on if it didn't yet
+			Result<DocumentSptr> doc = get_document(message.id);
+			if (doc.is_ok())
+			{ doc = open_document(doc.get_value()->get_name(), message.source->socket); }
+			response.status = doc.get_status();
+			if (doc.is_ok() && !is_addressable(*doc.get_value(), *message.source))
+			{ response.status = Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG; }
+			else if (doc.is_ok())
 			{
-				// open document
-				doc = open_document(message.get_name_string());
-				response.id = message.source->active_document = doc->get_id();
+				response.id = doc.get_value()->get_id();
+				activate_document(*message.source, response.id);
 
 				// compare hash
-				if (doc->hash() != message.hash)
+				if (get_document_hash(*doc.get_value()) != message.hash)
 				{ response.status = Message::MessageStatus::STATUS_OK_CONTENTS_FOLLOWING; }
 			}
-			catch (Message::MessageStatus status)
-			{ response.status = status; }
 
 			// send response
 			response.send_to(*message.source);
 
 			// send contents if necessary
 			if (response.status == Message::MessageStatus::STATUS_OK_CONTENTS_FOLLOWING)
-			{ send_document(*doc, *message.source); }
+			{ send_contents(doc.get_value(), *message.source); }
+
+			if (doc.is_ok() &&
+				response.status != Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG)
+			{ announce_revision(*message.source); }
 
 			break;
 		}
@@ -368,10 +1539,7 @@ void main_network_message_handler(const Message &message)
 			response.name = message.name;
 
 			// try to create the document
-			try
-			{ create_document(message.get_name_string()); }
-			catch (Message::MessageStatus status)
-			{ response.status = status; }
+			response.status = create_document(message.get_name_string());
 
 			response.send_to(*message.source);
 
@@ -383,10 +1551,7 @@ void main_network_message_handler(const Message &message)
 			response.name = message.name;
 
 			// try to delete the document
-			try
-			{ delete_document(message.get_name_string()); }
-			catch (Message::MessageStatus status)
-			{ response.status = status; }
+			response.status = delete_document(message.get_name_string());
 
 			response.send_to(*message.source);
 
@@ -395,8 +1560,64 @@ void main_network_message_handler(const Message &message)
 		case Message::MessageType::TYPE_DOC_LIST:
 		{
 			print_string = "received TYPE_DOC_LIST message";
-			response.bytes = get_document_list();
-			response.length = response.bytes.size() / Message::FIELD_SIZE_DOC_NAME;
+
+			// the listing is encoded once until the catalog changes
+			message.source->send(get_document_catalog().get_frame(message.source->protocol_version),
+				Transfer::Priority::PRIORITY_BULK);
+
+			break;
+		}
+		case Message::MessageType::TYPE_DOC_LIST_PAGE:
+		{
+			print_string = "received TYPE_DOC_LIST_PAGE message";
+			int32_t offset = std::min<int64_t>(std::max<int64_t>(message.position, 0),
+				std::numeric_limits<int32_t>::max());
+			int32_t limit = std::min<int64_t>(message.length, std::numeric_limits<int32_t>::max());
+			response.id = get_document_catalog().get_page(message.get_name_string(), offset,
+				limit, response.entries);
+			response.length = response.entries.size();
+			response.position = std::min(offset, response.id);
+
+			describe_open_documents(response.entries);
+			response.send_to(*message.source);
+
+			break;
+		}
+		case Message::MessageType::TYPE_DOC_SEARCH:
+		{
+			print_string = "received TYPE_DOC_SEARCH message";
+			int32_t offset = std::min<int64_t>(std::max<int64_t>(message.position, 0),
+				std::numeric_limits<int32_t>::max());
+			int32_t limit = std::min<int64_t>(message.length, std::numeric_limits<int32_t>::max());
+			std::string query = message.get_name_string();
+			response.id = 0;
+
+			// shorter queries can't be narrowed down by the index, they'd read all documents
+			if (query.size() < SearchIndex::TRIGRAM_SIZE)
+			{ response.status = Message::MessageStatus::STATUS_QUERY_TOO_SHORT; }
+			else
+			{ response.id = search_documents(query, offset, limit, response.entries); }
+			response.length = response.entries.size();
+			response.position = std::min(offset, response.id);
+
+			describe_open_documents(response.entries);
+			response.send_to(*message.source);
+
+			break;
+		}
+		case Message::MessageType::TYPE_DOC_REPLACE:
+		case Message::MessageType::TYPE_DOC_REPLACE_REGEX:
+		{
+			print_string = "received TYPE_DOC_REPLACE(_REGEX) message";
+			bool regex = (message.type == Message::MessageType::TYPE_DOC_REPLACE_REGEX);
+			Result<int64_t> replaced = replace_all(*message.source, message.get_name_string(),
+				message.bytes, regex);
+			response.status = replaced.get_status();
+			if (replaced.is_ok())
+			{
+				response.length = replaced.get_value();
+				response.revision = doc_history[message.source->active_document].get_revision();
+			}
 
 			response.send_to(*message.source);
 
@@ -406,29 +1627,44 @@ void main_network_message_handler(const Message &message)
 		{
 			print_string = "received TYPE_DOC_OPEN message";
 			response.name = message.name;
-			DocumentSptr doc;
 
-			try
+			// open document and get id
+			Result<DocumentSptr> doc =
+				open_document(message.get_name_string(), message.source->socket);
+			response.status = doc.get_status();
+			if (doc.is_ok() && !is_addressable(*doc.get_value(), *message.source))
+			{ response.status = Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG; }
+			else if (doc.is_ok())
 			{
-				const std::string name = message.get_name_string();
-
-				// open document and get id
-				doc = open_document(name);
-				response.id = message.source->active_document = doc->get_id();
+				response.id = doc.get_value()->get_id();
+				activate_document(*message.source, response.id);
 
 				// check if document is empty
-				if (!doc->get_contents().empty())
+				if (!doc.get_value()->get_contents().empty())
 				{ response.status = Message::MessageStatus::STATUS_OK_CONTENTS_FOLLOWING; }
 			}
-			catch (Message::MessageStatus status)
-			{ response.status = status; }
 
 			// send response
 			response.send_to(*message.source);
 
 			// send contents if necessary
 			if (response.status == Message::MessageStatus::STATUS_OK_CONTENTS_FOLLOWING)
-			{ send_document(*doc, *message.source); }
+			{ send_contents(doc.get_value(), *message.source); }
+
+			if (doc.is_ok() &&
+				response.status != Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG)
+			{ announce_revision(*message.source); }
+
+			break;
+		}
+		case Message::MessageType::TYPE_DOC_CLOSE:
+		{
+			print_string = "received TYPE_DOC_CLOSE message";
+			response.id = message.id;
+			response.status = close_client_document(*message.source, message.id);
+
+			// send response
+			response.send_to(*message.source);
 
 			break;
 		}
@@ -438,13 +1674,34 @@ void main_network_message_handler(const Message &message)
 			response.id = message.id;
 
 			// save the document
-			try
+			Result<DocumentSptr> doc = get_document(message.id);
+			response.status = doc.get_status();
+			if (doc.is_ok())
 			{
-				DocumentSptr doc = get_document(message.id);
-				doc->save();
+				try
+				{
+					doc.get_value()->save();
+					doc_saved[message.id] = doc_history[message.id].get_revision();
+					DocumentIndex::get_instance().update(doc.get_value()->get_name(),
+						get_document_hash(*doc.get_value()));
+				}
+				catch (document_errors::DocumentError const &)
+				{ response.status = Message::MessageStatus::STATUS_IO_ERROR; }
+				catch (database_errors::Failure const &)
+				{}
+
+				// every save becomes a version, the file keeps the latest one only
+				if (response.status == Message::MessageStatus::STATUS_OK)
+				{
+					try
+					{
+						DocumentVersions::get_instance().commit(doc.get_value()->get_name(),
+							doc.get_value()->get_contents());
+					}
+					catch (database_errors::Failure const &)
+					{}
+				}
 			}
-			catch (Message::MessageStatus status)
-			{ response.status = status; }
 
 			// send response
 			response.send_to(*message.source);
@@ -466,18 +1723,17 @@ void main_network_message_handler(const Message &message)
 		{
 			print_string = "received TYPE_SYNC_(MULTI)BYTE message";
 			// sync byte(s)
-			try
+			bool multibyte = (message.type == Message::MessageType::TYPE_SYNC_MULTIBYTE);
+			int64_t position = multibyte ? message.position : message.source->cursor;
+			response.status = sync_bytes(*message.source, position, message.bytes, multibyte);
+			if (response.status == Message::MessageStatus::STATUS_OK)
 			{
-				bool multibyte = (message.type == Message::MessageType::TYPE_SYNC_MULTIBYTE);
-				int32_t position = multibyte ? message.position : message.source->cursor;
-				sync_bytes(*message.source, position, message.bytes, multibyte);
 				NetworkInterface::get_current_instance().update_client_cursors(position,
 					multibyte ? message.length : 1, message.source->active_document);
 			}
-			catch (Message::MessageStatus status)
+			else
 			{
 				response.type = Message::MessageType::TYPE_STATUS;
-				response.status = status;
 				response.send_to(*message.source);
 			}
 
@@ -492,45 +1748,173 @@ void main_network_message_handler(const Message &message)
 		case Message::MessageType::TYPE_SYNC_DELETION:
 		{
 			print_string = "received TYPE_SYNC_DELETION message";
-			try
+			response.status = sync_deletion(*message.source, message.position, message.length);
+			if (response.status != Message::MessageStatus::STATUS_OK)
+			{
+				response.type = Message::MessageType::TYPE_STATUS;
+				response.send_to(*message.source);
+			}
+
+			break;
+		}
+		case Message::MessageType::TYPE_SYNC_BATCH:
+		{
+			print_string = "received TYPE_SYNC_BATCH message";
+			response.status = sync_batch(*message.source, message.revision, message.operations);
+			if (response.status != Message::MessageStatus::STATUS_OK)
+			{
+				response.type = Message::MessageType::TYPE_STATUS;
+				response.send_to(*message.source);
+			}
+
+			break;
+		}
+		case Message::MessageType::TYPE_SYNC_SEQUENCE:
+		{
+			print_string = "received TYPE_SYNC_SEQUENCE message";
+			response.status = enter_sequence_mode(*message.source, response);
+			response.send_to(*message.source);
+
+			break;
+		}
+		case Message::MessageType::TYPE_SYNC_MERGE:
+		{
+			print_string = "received TYPE_SYNC_MERGE message";
+			response.status = sync_merge(*message.source, message.id, message.site,
+				message.revision, message.sequence);
+			if (response.status != Message::MessageStatus::STATUS_OK)
+			{
+				response.type = Message::MessageType::TYPE_STATUS;
+				response.send_to(*message.source);
+			}
+
+			break;
+		}
+		case Message::MessageType::TYPE_DOC_LINE:
+		{
+			print_string = "received TYPE_DOC_LINE message";
+			response.line = message.line;
+
+			// look up the start and length of the line
+			Result<int64_t> position = get_line_position(*message.source, message.line, 0);
+			response.status = position.get_status();
+			if (position.is_ok())
+			{
+				Document &doc = *get_document(message.source->active_document).get_value();
+				response.position = position.get_value();
+				response.length = doc.get_line_index().get_line_length(message.line);
+			}
+
+			response.send_to(*message.source);
+
+			break;
+		}
+		case Message::MessageType::TYPE_SYNC_CURSOR_LINE:
+		{
+			print_string = "received TYPE_SYNC_CURSOR_LINE message";
+			Result<int64_t> position = get_line_position(*message.source, message.line,
+				message.column);
+			if (position.is_ok())
+			{ message.source->cursor = position.get_value(); }
+			else
+			{
+				response.type = Message::MessageType::TYPE_STATUS;
+				response.status = position.get_status();
+				response.send_to(*message.source);
+			}
+
+			break;
+		}
+		case Message::MessageType::TYPE_SYNC_DELETION_LINE:
+		{
+			print_string = "received TYPE_SYNC_DELETION_LINE message";
+			Result<int64_t> position = get_line_position(*message.source, message.line,
+				message.column);
+			response.status = position.get_status();
+			if (position.is_ok())
+			{
+				response.status = sync_deletion(*message.source, position.get_value(),
+					message.length);
+			}
+
+			if (response.status != Message::MessageStatus::STATUS_OK)
+			{
+				response.type = Message::MessageType::TYPE_STATUS;
+				response.send_to(*message.source);
+			}
+
+			break;
+		}
+		case Message::MessageType::TYPE_SYNC_MULTIBYTE_LINE:
+		{
+			print_string = "received TYPE_SYNC_MULTIBYTE_LINE message";
+			Result<int64_t> position = get_line_position(*message.source, message.line,
+				message.column);
+			response.status = position.get_status();
+			if (position.is_ok())
+			{ response.status = sync_bytes(*message.source, position.get_value(), message.bytes); }
+
+			if (response.status == Message::MessageStatus::STATUS_OK)
 			{
-				DocumentSptr doc = get_document(message.source->active_document);
-				auto contents = doc->get_contents();
-				
-				// check if start position is out of bounds
-				if (message.position < 0 ||
-					static_cast<size_t>(message.position) >= contents.size())
-				{ throw Message::MessageStatus::STATUS_USER_CURSOR_OUT_OF_BOUNDS; }
-
-				// check if length too big
-				if (static_cast<size_t>(message.position + message.length) > contents.size())
-				{ throw Message::MessageStatus::STATUS_USER_LENGTH_TOO_LONG; }
-
-				// sync deletion
-				Message sync;
-				sync.type = Message::MessageType::TYPE_SYNC_DELETION;
-				sync.position = message.position;
-				sync.length = message.length;
-
-				NetworkInterface::get_current_instance().broadcast_message(sync,
-					message.source->active_document);
-				NetworkInterface::get_current_instance().update_client_cursors(sync.position,
-					-sync.length, message.source->active_document);
-
-				// perform deletion
-				auto start = contents.begin() + sync.position;
-				contents.erase(start, start + sync.length);
+				NetworkInterface::get_current_instance().update_client_cursors(
+					position.get_value(), message.length, message.source->active_document);
 			}
-			catch (Message::MessageStatus status)
+			else
 			{
 				response.type = Message::MessageType::TYPE_STATUS;
-				response.status = status == Message::MessageStatus::STATUS_DOC_NOT_EXIST ?
-					Message::MessageStatus::STATUS_USER_NO_ACTIVE_DOC : status;
 				response.send_to(*message.source);
 			}
 
 			break;
 		}
+		case Message::MessageType::TYPE_DOC_VIEWPORT:
+		case Message::MessageType::TYPE_DOC_VIEWPORT_LINE:
+		{
+			print_string = "received TYPE_DOC_VIEWPORT message";
+			response.type = Message::MessageType::TYPE_DOC_VIEWPORT;
+
+			// a length of 0 requests the whole document
+			int64_t position = message.position;
+			int64_t length = message.length == 0 ? -1 : message.length;
+			Result<DocumentSptr> doc = get_document(message.source->active_document);
+			if (message.type == Message::MessageType::TYPE_DOC_VIEWPORT_LINE)
+			{
+				print_string = "received TYPE_DOC_VIEWPORT_LINE message";
+				position = -1;
+
+				// convert the lines to bytes, the viewport ends with the document
+				const LineIndex *index = doc.is_ok() ? &doc.get_value()->get_line_index() : nullptr;
+				int64_t lines = index ? index->get_line_count() : 0;
+				if (message.line >= 0 && message.line < lines)
+				{ position = index->get_line_start(message.line); }
+
+				if (position >= 0 && length >= 0)
+				{
+					length = message.length < lines - message.line ?
+						index->get_line_start(message.line + message.length) - position :
+						doc.get_value()->get_contents().size() - position;
+				}
+			}
+
+			response.status = set_viewport(*message.source, position, length);
+			if (response.status == Message::MessageStatus::STATUS_OK &&
+				message.source->viewport_length >= 0)
+			{
+				send_viewport(*doc.get_value(), *message.source);
+				break;
+			}
+
+			// the whole document follows
+			if (response.status == Message::MessageStatus::STATUS_OK)
+			{ response.status = Message::MessageStatus::STATUS_OK_CONTENTS_FOLLOWING; }
+
+			response.send_to(*message.source);
+
+			if (response.status == Message::MessageStatus::STATUS_OK_CONTENTS_FOLLOWING)
+			{ send_document(doc.get_value(), *message.source); }
+
+			break;
+		}
 		case Message::MessageType::TYPE_USER_LOGIN:
 		{
 			print_string = "received TYPE_USER_LOGIN message";
@@ -554,6 +1938,9 @@ void main_network_message_handler(const Message &message)
 			// broadcast user join notification if login was successful
 			if (response.status == Message::MessageStatus::STATUS_OK)
 			{
+				expire_sessions();
+				start_session(*message.source, message.name);
+
 				Message announcement;
 				announcement.type = Message::MessageType::TYPE_USER_JOIN;
 				announcement.id = message.source->user_id;
@@ -567,6 +1954,8 @@ void main_network_message_handler(const Message &message)
 		case Message::MessageType::TYPE_USER_LOGOUT:
 		{
 			print_string = "received TYPE_USER_LOGOUT message";
+			end_session(*message.source);
+
 			// send simple response
 			response.send_to(*message.source);
 
@@ -575,11 +1964,67 @@ void main_network_message_handler(const Message &message)
 			
 			break;
 		}
+		case Message::MessageType::TYPE_SESSION_RESUME:
+		{
+			print_string = "received TYPE_SESSION_RESUME message";
+			if (message.source->user_id == 0)
+			{ resume_session(*message.source, message.hash, message.revision); }
+
+			break;
+		}
+		case Message::MessageType::TYPE_PROTOCOL_VERSION:
+		{
+			print_string = "received TYPE_PROTOCOL_VERSION message";
+
+			// agree on the highest version both sides support
+			if (message.length < Message::PROTOCOL_VERSION_1)
+			{
+				response.status = Message::MessageStatus::STATUS_NOT_OK;
+				response.length = message.source->protocol_version;
+			}
+			else
+			{
+				response.length = std::min<int64_t>(message.length,
+					Message::PROTOCOL_VERSION_LATEST);
+			}
+
+			// answer in the old version, everything after that uses the new one
+			response.send_to(*message.source);
+			message.source->protocol_version = response.length;
+
+			break;
+		}
+		case Message::MessageType::TYPE_COMPRESSION:
+		{
+			print_string = "received TYPE_COMPRESSION message";
+
+			// fall back to uncompressed bulk frames if the compression isn't supported
+			if (message.length < Message::COMPRESSION_NONE ||
+				message.length > Message::COMPRESSION_LATEST)
+			{
+				response.status = Message::MessageStatus::STATUS_NOT_OK;
+				response.length = Message::COMPRESSION_NONE;
+			}
+			else
+			{ response.length = message.length; }
+
+			message.source->compression = response.length;
+			response.send_to(*message.source);
+
+			break;
+		}
 		case Message::MessageType::TYPE_CLIENT_DISCONNECT:
 		{
 			print_string = "received TYPE_CLIENT_DISCONNECT message";
-			// close the user's documents
-			close_client_documents(message.source->user_id);
+			// stop tracking the revisions the client has seen
+			auto history = doc_history.find(message.source->active_document);
+			if (history != doc_history.end())
+			{ history->second.remove_client(message.source->socket); }
+
+			// close the client's documents unless the session may be resumed
+			if (!detach_session(*message.source))
+			{ close_client_documents(message.source->socket); }
+			expire_sessions();
 
 			// broadcase user quit notification
 			Message announcement;
@@ -596,3 +2041,49 @@ void main_network_message_handler(const Message &message)
 
 	g_user_interface->printf("%s\n", print_string);
 }
+
+/**
+	Handles the Messages received within one tick. Each Message is still handled on its own by
+	main_network_message_handler, in arrival order, with its own document lookup, history commit
+	and broadcast. Only the housekeeping is done once per tick: the targeted documents are marked
+	active once per group, and the memory budget is checked at most once a second.
+		batch - messages of the tick
+**/
+void main_network_batch_handler(const MessageBatch &batch)
+{
+	// build the search index before the first client connects
+	if (batch.get_messages().front()->type == Message::MessageType::TYPE_INIT)
+	{
+		get_search_index();
+		return;
+	}
+
+	for (const Message *message: batch.get_messages())
+	{ main_network_message_handler(*message); }
+
+	// the targeted documents aren't idle, the others are checked against the budget once a second
+	static time_t last_check = 0;
+	time_t now = std::time(nullptr);
+	for (const auto &group: batch.get_groups())
+	{
+		if (group.first != MessageBatch::NO_DOCUMENT)
+		{
+			if (doc_by_id.find(group.first) != doc_by_id.end())
+			{ doc_edited[group.first] = now; }
+			continue;
+		}
+
+		// the document a client opened by name is only known now
+		for (const Message *message: group.second)
+		{
+			if (message->source && doc_by_id.find(message->source->active_document) !=
+				doc_by_id.end())
+			{ doc_edited[message->source->active_document] = now; }
+		}
+	}
+	if (now != last_check)
+	{
+		last_check = now;
+		enforce_memory_budget();
+	}
+}
@@ -0,0 +1,96 @@
+#include "Document.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/Document.cpp
+ *
+ * Unit tests for the document class.
+ */
+
+//! create the document testsuite
+BOOST_AUTO_TEST_SUITE(DocumentSuite)
+
+//! test that compressed contents are restored on the next access
+BOOST_AUTO_TEST_CASE(compress)
+{
+	std::string const name = "./document_test.txt";
+	std::string const contents(4096, 'a');
+	std::ofstream(name, std::ios::trunc) << contents;
+
+	Document doc = Document::open(name);
+	BOOST_CHECK(doc.is_resident());
+	std::size_t const usage = doc.get_memory_usage();
+
+	doc.compress();
+	BOOST_CHECK(!doc.is_resident());
+	BOOST_CHECK_LT(doc.get_memory_usage(), usage);
+
+	// edits made before compressing survive, the file isn't read again
+	std::vector<char> &restored = doc.get_contents();
+	BOOST_CHECK(doc.is_resident());
+	BOOST_CHECK_EQUAL(std::string(restored.begin(), restored.end()), contents);
+	restored.push_back('b');
+	doc.compress();
+	BOOST_CHECK_EQUAL(doc.get_contents().size(), contents.size() + 1);
+
+	doc.close();
+	std::remove(name.c_str());
+}
+
+//! test that unloaded contents are read from the file again
+BOOST_AUTO_TEST_CASE(unload)
+{
+	std::string const name = "./document_test.txt";
+	std::ofstream(name, std::ios::trunc) << "contents";
+
+	Document doc = Document::open(name);
+	doc.get_contents().push_back('!');
+	doc.unload();
+	BOOST_CHECK(!doc.is_resident());
+	BOOST_CHECK_EQUAL(doc.get_memory_usage(), 0u);
+
+	std::vector<char> &contents = doc.get_contents();
+	BOOST_CHECK_EQUAL(std::string(contents.begin(), contents.end()), "contents");
+
+	doc.close();
+	std::remove(name.c_str());
+}
+
+//! test that the line index follows small and large batches of edits
+BOOST_AUTO_TEST_CASE(apply)
+{
+	std::string const name = "./document_test.txt";
+	std::ofstream(name, std::ios::trunc) << std::string(200, 'a');
+
+	Document doc = Document::open(name);
+	BOOST_CHECK_EQUAL(doc.get_line_index().get_line_count(), 1);
+
+	// replace 'a's by lines, each operation relative to the preceding result
+	for (std::size_t size: { std::size_t(2), Document::MAX_INDEXED_OPERATIONS + 1 })
+	{
+		std::int64_t const lines = doc.get_line_index().get_line_count();
+		std::int64_t const start = (lines - 1) * 2;
+		EditOperations operations;
+
+		for (std::size_t i = 0; i < size; i++)
+		{
+			operations.emplace_back(EditOperation::Kind::KIND_REPLACE, start + i * 2, 1,
+			                        std::vector<char>{ 'b', '\n' });
+		}
+
+		doc.apply(operations);
+		BOOST_CHECK_EQUAL(doc.get_line_index().get_line_count(),
+		                  lines + static_cast<std::int64_t>(size));
+		BOOST_CHECK_EQUAL(doc.get_line_index().get_line_start(lines - 1 + size),
+		                  start + 2 * static_cast<std::int64_t>(size));
+	}
+
+	doc.close();
+	std::remove(name.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
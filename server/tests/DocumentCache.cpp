@@ -0,0 +1,112 @@
+#include "DocumentCache.h"
+#include "MemoryDocumentStore.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/DocumentCache.cpp
+ *
+ * Unit tests for the cache of recently closed documents.
+ */
+
+//! create the document cache testsuite
+BOOST_AUTO_TEST_SUITE(DocumentCacheSuite)
+
+namespace
+{
+	/**
+	 * Write contents to a document file and open it.
+	 */
+	std::shared_ptr<Document> open_document(std::string const &name, std::string const &contents)
+	{
+		std::ofstream(name, std::ios::trunc) << contents;
+
+		return std::make_shared<Document>(Document::open(name));
+	}
+}
+
+//! test that unchanged documents are handed out again with their hash
+BOOST_AUTO_TEST_CASE(reopen)
+{
+	std::string const name = "./document_cache_test.txt";
+	DocumentCache cache(16);
+	Hash::hash_t hash, cached_hash;
+	bool hashed = false;
+
+	std::shared_ptr<Document> doc = open_document(name, "contents");
+	hash = doc->hash();
+	cache.insert(doc, &hash);
+	BOOST_CHECK_EQUAL(cache.get_size(), 8u);
+
+	BOOST_CHECK(cache.take(name, cached_hash, hashed) == doc);
+	BOOST_CHECK(hashed);
+	BOOST_CHECK(cached_hash == hash);
+	BOOST_CHECK_EQUAL(cache.get_size(), 0u);
+	BOOST_CHECK(!cache.take(name, cached_hash, hashed));
+
+	// a changed file makes the cached document stale
+	cache.insert(doc);
+	std::ofstream(name, std::ios::trunc) << "changed contents";
+	BOOST_CHECK(!cache.take(name, cached_hash, hashed));
+	BOOST_CHECK_EQUAL(cache.get_size(), 0u);
+
+	std::remove(name.c_str());
+}
+
+//! test that the least recently closed documents are evicted first
+BOOST_AUTO_TEST_CASE(eviction)
+{
+	std::string const names[] = { "./document_cache_a.txt", "./document_cache_b.txt",
+		"./document_cache_c.txt" };
+	DocumentCache cache(10);
+	Hash::hash_t hash;
+	bool hashed;
+
+	cache.insert(open_document(names[0], "aaaa"));
+	cache.insert(open_document(names[1], "bbbb"));
+	cache.insert(open_document(names[2], "cccc"));
+	BOOST_CHECK_EQUAL(cache.get_size(), 8u);
+
+	BOOST_CHECK(!cache.take(names[0], hash, hashed));
+	BOOST_CHECK(cache.take(names[1], hash, hashed));
+	BOOST_CHECK(cache.take(names[2], hash, hashed));
+
+	// too large to be cached at all
+	cache.insert(open_document(names[0], "aaaaaaaaaaa"));
+	BOOST_CHECK_EQUAL(cache.get_size(), 0u);
+
+	for (std::string const &name: names)
+	{
+		std::remove(name.c_str());
+	}
+}
+
+//! test that documents are validated by the selected document store
+BOOST_AUTO_TEST_CASE(store)
+{
+	std::shared_ptr<DocumentStore> const previous = Document::get_store();
+	std::shared_ptr<DocumentStore> const store = std::make_shared<MemoryDocumentStore>();
+	Document::set_store(store);
+
+	DocumentCache cache(16);
+	Hash::hash_t hash;
+	bool hashed;
+
+	store->create("document", false)->write(std::vector<char>(4, 'a'));
+	std::shared_ptr<Document> const doc = std::make_shared<Document>(Document::open("document"));
+	cache.insert(doc);
+	BOOST_CHECK(cache.take("document", hash, hashed) == doc);
+
+	// rewriting contents of the same size makes the cached document stale as well
+	cache.insert(doc);
+	store->open("document")->write(std::vector<char>(4, 'b'));
+	BOOST_CHECK(!cache.take("document", hash, hashed));
+
+	Document::set_store(previous);
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
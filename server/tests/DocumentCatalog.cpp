@@ -0,0 +1,154 @@
+#include "DocumentCatalog.h"
+#include "FileDocumentStore.h"
+#include "MemoryDocumentStore.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/DocumentCatalog.cpp
+ *
+ * Unit tests for the in-memory document catalog.
+ */
+
+//! create the document catalog testsuite
+BOOST_AUTO_TEST_SUITE(DocumentCatalogSuite)
+
+namespace
+{
+	/**
+	 * A temporary documents directory, removed with its documents on destruction.
+	 */
+	struct Directory
+	{
+		Directory()
+		{
+			char path_template[] = "/tmp/cte_catalog_XXXXXX";
+
+			BOOST_REQUIRE(::mkdtemp(path_template));
+			path = std::string(path_template) + "/";
+		}
+
+		~Directory()
+		{
+			for (std::string const &name: names)
+			{
+				std::remove((path + name).c_str());
+			}
+
+			::rmdir(path.c_str());
+		}
+
+		void create(std::string const &name)
+		{
+			std::ofstream(path + name).put('x');
+			names.push_back(name);
+		}
+
+		std::string path;
+		std::vector<std::string> names;
+	};
+
+	/**
+	 * Create documents of one byte in a store.
+	 *
+	 * @param store The store.
+	 * @param names The document names.
+	 */
+	void create(DocumentStore &store, std::vector<std::string> const &names)
+	{
+		for (std::string const &name: names)
+		{
+			store.create(name, false)->write(std::vector<char>(1, 'x'));
+		}
+	}
+
+	/**
+	 * Encode the listing of the given names.
+	 *
+	 * @param names The document names, each shorter than the field size.
+	 * @return The TYPE_DOC_LIST bytestream.
+	 */
+	std::vector<char> listing(std::vector<std::string> const &names)
+	{
+		Message message;
+		std::vector<char> bytestream;
+
+		message.type = Message::MessageType::TYPE_DOC_LIST;
+		message.length = names.size();
+
+		for (std::string const &name: names)
+		{
+			message.bytes.insert(message.bytes.end(), name.begin(), name.end());
+			message.bytes.insert(message.bytes.end(),
+				Message::FIELD_SIZE_DOC_NAME - name.length(), '\0');
+		}
+
+		return message.generate_bytestream(bytestream, Message::PROTOCOL_VERSION_2);
+	}
+}
+
+//! test that the startup listing and explicit updates are reflected in the cached frame
+BOOST_AUTO_TEST_CASE(updates)
+{
+	std::shared_ptr<DocumentStore> const store = std::make_shared<MemoryDocumentStore>();
+	create(*store, { "b", "a" });
+
+	DocumentCatalog catalog(store);
+	std::vector<char> const &frame = catalog.get_frame(Message::PROTOCOL_VERSION_2);
+
+	BOOST_CHECK(frame == listing({ "a", "b" }));
+	BOOST_CHECK(&catalog.get_frame(Message::PROTOCOL_VERSION_2) == &frame);
+
+	catalog.add("c");
+	catalog.remove("a");
+	BOOST_CHECK(catalog.get_frame(Message::PROTOCOL_VERSION_2) == listing({ "b", "c" }));
+}
+
+//! test that documents created or removed by others are picked up through inotify
+BOOST_AUTO_TEST_CASE(watched)
+{
+	Directory directory;
+	DocumentCatalog catalog(std::make_shared<FileDocumentStore>(directory.path));
+
+	BOOST_CHECK(catalog.get_names().empty());
+
+	directory.create("new");
+	BOOST_CHECK(catalog.get_names() == std::vector<std::string>({ "new" }));
+
+	std::remove((directory.path + "new").c_str());
+	BOOST_CHECK(catalog.get_frame(Message::PROTOCOL_VERSION_2) == listing({}));
+}
+
+//! test that pages are cut from the documents matching the prefix
+BOOST_AUTO_TEST_CASE(pages)
+{
+	std::shared_ptr<DocumentStore> const store = std::make_shared<MemoryDocumentStore>();
+	create(*store, { "notes-3", "todo", "notes-1", "notes-2", "note" });
+
+	DocumentCatalog catalog(store);
+	DocumentEntries entries;
+
+	BOOST_CHECK_EQUAL(catalog.get_page("notes-", 1, 5, entries), 3);
+	BOOST_REQUIRE_EQUAL(entries.size(), 2u);
+	BOOST_CHECK(std::string(entries[0].name.begin(), entries[0].name.end()) == "notes-2");
+	BOOST_CHECK(std::string(entries[1].name.begin(), entries[1].name.end()) == "notes-3");
+	BOOST_CHECK_EQUAL(entries[0].size, 1);
+	BOOST_CHECK_GT(entries[0].modified, 0);
+
+	BOOST_CHECK_EQUAL(catalog.get_page("", 4, 5, entries), 5);
+	BOOST_REQUIRE_EQUAL(entries.size(), 1u);
+	BOOST_CHECK(std::string(entries[0].name.begin(), entries[0].name.end()) == "todo");
+
+	BOOST_CHECK_EQUAL(catalog.get_page("x", 0, 5, entries), 0);
+	BOOST_CHECK(entries.empty());
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
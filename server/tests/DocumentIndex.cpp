@@ -0,0 +1,100 @@
+#include "Document.h"
+#include "DocumentIndex.h"
+#include "MemoryDocumentStore.h"
+#include "SQLiteDatabase.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/DocumentIndex.cpp
+ *
+ * Unit tests for the DocumentIndex.
+ */
+
+//! create the document index testsuite
+BOOST_AUTO_TEST_SUITE(DocumentIndexSuite)
+
+namespace
+{
+	//! the document file used by the tests
+	std::string const g_path = "./document_index_test.txt";
+
+	/**
+	 * Write contents to the document file and return their hash.
+	 */
+	Hash::hash_t write_document(std::string const &contents)
+	{
+		std::ofstream(g_path, std::ios::trunc) << contents;
+
+		return Hash::hash_bytes(std::vector<char>(contents.begin(), contents.end()));
+	}
+}
+
+//! test that entries are only used while the file is unchanged
+BOOST_AUTO_TEST_CASE(lookup)
+{
+	DocumentIndex index(std::make_shared<SQLiteDatabase>(SQLiteDatabase::temporary()));
+	DocumentIndex::Entry entry;
+
+	BOOST_CHECK(&DocumentIndex::get_instance() == &index);
+
+	Hash::hash_t const hash = write_document("contents");
+	BOOST_CHECK(!index.lookup(g_path, entry));
+
+	index.update(g_path, hash);
+	BOOST_REQUIRE(index.lookup(g_path, entry));
+	BOOST_CHECK(entry.hash == hash);
+	BOOST_CHECK_EQUAL(entry.size, 8);
+
+	// a different size invalidates the entry regardless of the timestamp resolution
+	write_document("changed contents");
+	BOOST_CHECK(!index.lookup(g_path, entry));
+
+	index.update(g_path, hash);
+	index.remove(g_path);
+	BOOST_CHECK(!index.lookup(g_path, entry));
+
+	std::remove(g_path.c_str());
+	BOOST_CHECK(!index.lookup(g_path, entry));
+}
+
+//! test that entries are validated by the selected document store
+BOOST_AUTO_TEST_CASE(store)
+{
+	std::shared_ptr<DocumentStore> const previous = Document::get_store();
+	std::shared_ptr<DocumentStore> const store = std::make_shared<MemoryDocumentStore>();
+	Document::set_store(store);
+
+	DocumentIndex index(std::make_shared<SQLiteDatabase>(SQLiteDatabase::temporary()));
+	DocumentIndex::Entry entry;
+	std::vector<char> const contents = { 'a', 'b' };
+	std::unique_ptr<DocumentStore::Handle> const handle = store->create("document", false);
+
+	// there's no file of that name, the store knows the document though
+	handle->write(contents);
+	index.update("document", Hash::hash_bytes(contents));
+	BOOST_REQUIRE(index.lookup("document", entry));
+	BOOST_CHECK_EQUAL(entry.size, 2);
+
+	// rewriting contents of the same size invalidates the entry as well
+	handle->write(std::vector<char>(2, 'c'));
+	BOOST_CHECK(!index.lookup("document", entry));
+
+	Document::set_store(previous);
+}
+
+//! test that the instance is unavailable once the index is gone
+BOOST_AUTO_TEST_CASE(instance)
+{
+	{
+		DocumentIndex index(std::make_shared<SQLiteDatabase>(SQLiteDatabase::temporary()));
+	}
+
+	BOOST_CHECK_THROW(DocumentIndex::get_instance(), database_errors::Failure);
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
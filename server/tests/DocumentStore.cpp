@@ -0,0 +1,185 @@
+#include "Document.h"
+#include "FileDocumentStore.h"
+#include "MemoryDocumentStore.h"
+#include "SQLiteDocumentStore.h"
+
+#include <cstdio>
+
+#include <sqlite3.h>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/DocumentStore.cpp
+ *
+ * Unit tests for the document store implementations.
+ */
+
+//! create the document store testsuite
+BOOST_AUTO_TEST_SUITE(DocumentStoreSuite)
+
+namespace
+{
+	/**
+	 * Check the behaviour every store shares.
+	 *
+	 * @param store The empty store to check.
+	 * @param name The name of the document to create.
+	 */
+	void check_store(DocumentStore &store, std::string const &name)
+	{
+		using namespace document_errors;
+
+		std::vector<char> const contents = { 'a', 'b', 'c' };
+		std::vector<char> read;
+
+		BOOST_CHECK_THROW(store.open(name), DocumentDoesntExistError);
+		BOOST_CHECK_THROW(store.size(name), DocumentDoesntExistError);
+		BOOST_CHECK_THROW(store.status(name), DocumentDoesntExistError);
+		BOOST_CHECK_THROW(store.remove(name), DocumentDoesntExistError);
+
+		store.create(name, false)->write(contents);
+		BOOST_CHECK_THROW(store.create(name, false), DocumentAlreadyExistsError);
+		BOOST_CHECK_EQUAL(store.size(name), 3u);
+		BOOST_CHECK_EQUAL(store.status(name).size, 3u);
+		BOOST_CHECK_GT(store.status(name).modified, 0);
+
+		// shrinking and growing replaces all contents
+		std::unique_ptr<DocumentStore::Handle> handle = store.open(name);
+		handle->read(read);
+		BOOST_CHECK(read == contents);
+		handle->write(std::vector<char>(1, 'x'));
+		store.open(name)->read(read);
+		BOOST_CHECK(read == std::vector<char>(1, 'x'));
+		handle->write(std::vector<char>(5, 'y'));
+		handle->read(read);
+		BOOST_CHECK(read == std::vector<char>(5, 'y'));
+		handle.reset();
+
+		store.create(name, true);
+		BOOST_CHECK_EQUAL(store.size(name), 0u);
+
+		store.remove(name);
+		BOOST_CHECK_THROW(store.open(name), DocumentDoesntExistError);
+	}
+
+	/**
+	 * Check that every write changes the modification time, even if the
+	 * size stays the same and the clock didn't advance.
+	 *
+	 * @param store The store to check.
+	 * @param name The name of the document to create.
+	 */
+	void check_modified(DocumentStore &store, std::string const &name)
+	{
+		std::unique_ptr<DocumentStore::Handle> const handle = store.create(name, false);
+		DocumentStore::Status const created = store.status(name);
+
+		handle->write(std::vector<char>(2, 'a'));
+		DocumentStore::Status const written = store.status(name);
+		BOOST_CHECK_EQUAL(written.size, 2u);
+		BOOST_CHECK_GT(written.modified, created.modified);
+
+		handle->write(std::vector<char>(2, 'b'));
+		BOOST_CHECK_GT(store.status(name).modified, written.modified);
+	}
+}
+
+//! test the store keeping files
+BOOST_AUTO_TEST_CASE(file)
+{
+	std::string const name = "./document_store_test.txt";
+	std::remove(name.c_str());
+
+	FileDocumentStore store("./");
+	check_store(store, name);
+}
+
+//! test the store keeping documents in memory
+BOOST_AUTO_TEST_CASE(memory)
+{
+	MemoryDocumentStore store;
+	check_store(store, "document");
+	check_modified(store, "modified");
+
+	store.create("b", false);
+	store.create("a", false);
+	BOOST_CHECK(store.list() == std::vector<std::string>({ "a", "b", "modified" }));
+}
+
+//! test the store keeping documents in a SQLite database
+BOOST_AUTO_TEST_CASE(sqlite)
+{
+	SQLiteDocumentStore store = SQLiteDocumentStore::temporary();
+	check_store(store, "document");
+	check_modified(store, "modified");
+
+	store.create("b", false);
+	store.create("a", false)->write(std::vector<char>(3 << 20, 'z'));
+	BOOST_CHECK(store.list() == std::vector<std::string>({ "a", "b", "modified" }));
+
+	// reading spans several chunks of the incremental blob I/O
+	std::vector<char> read;
+	store.open("a")->read(read);
+	BOOST_CHECK(read == std::vector<char>(3 << 20, 'z'));
+
+	// removing a document invalidates its handles
+	std::unique_ptr<DocumentStore::Handle> handle = store.open("b");
+	store.remove("b");
+	BOOST_CHECK_THROW(handle->read(read), document_errors::DocumentDoesntExistError);
+}
+
+//! test that a table created before modification times were kept gets their column
+BOOST_AUTO_TEST_CASE(sqlite_migration)
+{
+	std::string const path = "./document_store_test.sql";
+	::sqlite3 *handle;
+
+	std::remove(path.c_str());
+	BOOST_REQUIRE_EQUAL(sqlite3_open(path.c_str(), &handle), SQLITE_OK);
+	BOOST_CHECK_EQUAL(sqlite3_exec(handle, "CREATE TABLE DocumentStore (d_id INTEGER PRIMARY KEY, "
+		"d_name TEXT UNIQUE NOT NULL, d_contents BLOB NOT NULL); INSERT INTO DocumentStore "
+		"(d_name, d_contents) VALUES ('old', zeroblob(3))", NULL, NULL, NULL), SQLITE_OK);
+	sqlite3_close(handle);
+
+	{
+		SQLiteDocumentStore store = SQLiteDocumentStore::from_path(path);
+		BOOST_CHECK_EQUAL(store.status("old").size, 3u);
+		BOOST_CHECK_EQUAL(store.status("old").modified, 0);
+
+		store.open("old")->write(std::vector<char>(3, 'a'));
+		BOOST_CHECK_GT(store.status("old").modified, 0);
+	}
+
+	// the column exists once migrated
+	BOOST_CHECK_EQUAL(SQLiteDocumentStore::from_path(path).status("old").size, 3u);
+
+	std::remove(path.c_str());
+}
+
+//! test that documents are created in and opened from the selected store
+BOOST_AUTO_TEST_CASE(document)
+{
+	std::shared_ptr<DocumentStore> const previous = Document::get_store();
+	std::shared_ptr<DocumentStore> const store = std::make_shared<MemoryDocumentStore>();
+	Document::set_store(store);
+
+	{
+		Document doc = Document::create("document");
+		BOOST_CHECK(Document::is_empty("document"));
+
+		doc.get_contents().assign(4, 'a');
+		doc.save();
+		BOOST_CHECK_EQUAL(store->size("document"), 4u);
+	}
+
+	Document doc = Document::open("document");
+	BOOST_CHECK_EQUAL(std::string(doc.get_contents().begin(), doc.get_contents().end()),
+	                  "aaaa");
+	doc.remove();
+	BOOST_CHECK(store->list().empty());
+
+	Document::set_store(previous);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,120 @@
+#include "DocumentVersions.h"
+#include "SQLiteDatabase.h"
+
+#include <algorithm>
+#include <random>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/DocumentVersions.cpp
+ *
+ * Unit tests for the DocumentVersions.
+ */
+
+//! create the document versions testsuite
+BOOST_AUTO_TEST_SUITE(DocumentVersionsSuite)
+
+namespace
+{
+	/**
+	 * Create random text that doesn't repeat, like a document would.
+	 */
+	std::vector<char> random_contents(std::size_t size)
+	{
+		std::mt19937 generator(42);
+		std::uniform_int_distribution<int> letters('a', 'z');
+		std::vector<char> contents(size);
+
+		for (char &byte: contents)
+		{
+			byte = letters(generator);
+		}
+
+		return contents;
+	}
+
+	/**
+	 * Count the rows of a table.
+	 */
+	std::size_t count_rows(Database &database, std::string const &table)
+	{
+		return std::stoul(database.execute_sql("SELECT COUNT(*) AS n FROM " + table)[0]["n"]);
+	}
+}
+
+//! test that chunk boundaries only depend on the surrounding contents
+BOOST_AUTO_TEST_CASE(split)
+{
+	std::vector<char> contents = random_contents(1 << 20);
+	std::vector<std::size_t> const boundaries = DocumentVersions::split(contents);
+
+	BOOST_REQUIRE(!boundaries.empty());
+	BOOST_CHECK_EQUAL(boundaries.back(), contents.size());
+	BOOST_CHECK(boundaries.size() > 32 && boundaries.size() < 512);
+
+	std::size_t begin = 0;
+	for (std::size_t end: boundaries)
+	{
+		BOOST_CHECK(end - begin <= DocumentVersions::MAX_CHUNK_SIZE);
+		BOOST_CHECK(end - begin >= DocumentVersions::MIN_CHUNK_SIZE || end == contents.size());
+		begin = end;
+	}
+
+	// inserting at the front shifts the later boundaries instead of moving them
+	contents.insert(contents.begin(), 100, 'x');
+	std::vector<std::size_t> const shifted = DocumentVersions::split(contents);
+	std::size_t shared = 0;
+	for (std::size_t end: boundaries)
+	{
+		shared += std::count(shifted.begin(), shifted.end(), end + 100);
+	}
+	BOOST_CHECK(shared + 3 >= boundaries.size());
+
+	BOOST_CHECK(DocumentVersions::split(std::vector<char>()).empty());
+}
+
+//! test that versions share unchanged chunks and can be checked out
+BOOST_AUTO_TEST_CASE(commit)
+{
+	auto database = std::make_shared<SQLiteDatabase>(SQLiteDatabase::temporary());
+	DocumentVersions versions(database);
+	std::string const path = "./document.txt";
+	std::vector<char> contents;
+
+	BOOST_CHECK(&DocumentVersions::get_instance() == &versions);
+	BOOST_CHECK(!versions.checkout(path, 1, contents));
+
+	std::vector<char> const first = random_contents(256 << 10);
+	BOOST_CHECK_EQUAL(versions.commit(path, first), 1);
+	BOOST_CHECK_EQUAL(versions.commit(path, first), 1);
+	std::size_t const chunks = count_rows(*database, "DocumentChunk");
+
+	// a small edit stores a few chunks only
+	std::vector<char> second = first;
+	second.insert(second.begin() + 100000, 'x');
+	BOOST_CHECK_EQUAL(versions.commit(path, second), 2);
+	BOOST_CHECK(count_rows(*database, "DocumentChunk") <= chunks + 3);
+
+	BOOST_REQUIRE(versions.checkout(path, 1, contents));
+	BOOST_CHECK(contents == first);
+	BOOST_REQUIRE(versions.checkout(path, 2, contents));
+	BOOST_CHECK(contents == second);
+
+	BOOST_CHECK_EQUAL(versions.commit(path, std::vector<char>()), 3);
+	BOOST_REQUIRE(versions.checkout(path, 3, contents));
+	BOOST_CHECK(contents.empty());
+
+	std::vector<DocumentVersions::Version> const list = versions.list(path);
+	BOOST_REQUIRE_EQUAL(list.size(), 3u);
+	BOOST_CHECK_EQUAL(list[1].version, 2);
+	BOOST_CHECK_EQUAL(list[1].size, static_cast<std::int64_t>(second.size()));
+	BOOST_CHECK(list[1].hash == Hash::hash_bytes(second));
+
+	// chunks no version refers to are dropped with the history
+	versions.remove(path);
+	BOOST_CHECK(versions.list(path).empty());
+	BOOST_CHECK_EQUAL(count_rows(*database, "DocumentChunk"), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,107 @@
+#include "EditHistory.h"
+
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/EditHistory.cpp
+ *
+ * Unit tests for transforming pipelined edits against concurrent ones.
+ */
+
+//! create the edit history testsuite
+BOOST_AUTO_TEST_SUITE(EditHistorySuite)
+
+namespace
+{
+	/**
+	 * Transform, commit and apply an insertion like the server does.
+	 *
+	 * @param history The document's edit history.
+	 * @param contents The document contents.
+	 * @param client The sending client.
+	 * @param base The client's base revision.
+	 * @param position The insert position as seen by the client.
+	 * @param text The text to insert.
+	 * @return Whether the base revision was accepted.
+	 */
+	bool insert(EditHistory &history, std::vector<char> &contents, int client, int32_t base,
+		int32_t position, std::string const &text)
+	{
+		EditOperations operations { EditOperation(EditOperation::Kind::KIND_INSERT, position, 0,
+			std::vector<char>(text.begin(), text.end())) };
+		EditHistory::PendingEdits pending;
+
+		if (!history.transform(client, base, operations, pending))
+		{
+			return false;
+		}
+
+		history.commit(client, operations, pending);
+		apply_edit_operations(contents, operations);
+
+		return true;
+	}
+}
+
+//! test a client sending several edits without waiting for acknowledgements
+BOOST_AUTO_TEST_CASE(pipelined)
+{
+	EditHistory history;
+	std::vector<char> contents { 'a', 'b', 'c' };
+	history.add_client(1);
+	history.add_client(2);
+
+	BOOST_CHECK(insert(history, contents, 1, 0, 0, "X"));
+	// client 2 hasn't seen X and types at the end twice
+	BOOST_CHECK(insert(history, contents, 2, 0, 3, "Y"));
+	BOOST_CHECK(insert(history, contents, 2, 0, 4, "Z"));
+	// client 1 has seen its own X, but not Y and Z
+	BOOST_CHECK(insert(history, contents, 1, 1, 1, "W"));
+
+	BOOST_CHECK_EQUAL(std::string(contents.begin(), contents.end()), "XWabcYZ");
+	BOOST_CHECK_EQUAL(history.get_revision(), 4);
+}
+
+//! test that unknown revisions are rejected
+BOOST_AUTO_TEST_CASE(unknown_revision)
+{
+	EditHistory history;
+	std::vector<char> contents;
+	history.add_client(1);
+
+	BOOST_CHECK(!insert(history, contents, 1, 1, 0, "X"));
+	BOOST_CHECK(!insert(history, contents, 2, 0, 0, "X"));
+	BOOST_CHECK(contents.empty());
+}
+
+//! test that a resuming client receives only the retained edits it missed
+BOOST_AUTO_TEST_CASE(retained)
+{
+	EditHistory history;
+	std::vector<char> contents;
+	history.add_client(1);
+
+	for (size_t i = 0; i < EditHistory::MAX_RETAINED_EDITS + 2; ++i)
+	{ BOOST_REQUIRE(insert(history, contents, 1, history.get_revision(), 0, "X")); }
+
+	int32_t revision = history.get_revision();
+	EditHistory::PendingEdits missed;
+	BOOST_CHECK(history.get_edits_since(revision - 2, missed));
+	BOOST_REQUIRE_EQUAL(missed.size(), 2u);
+	BOOST_CHECK_EQUAL(missed.front().first, revision - 1);
+	BOOST_CHECK_EQUAL(missed.back().first, revision);
+
+	missed.clear();
+	BOOST_CHECK(history.get_edits_since(revision, missed));
+	BOOST_CHECK(missed.empty());
+
+	// the first two edits aren't retained anymore
+	BOOST_CHECK(!history.get_edits_since(1, missed));
+	BOOST_CHECK(history.get_edits_since(2, missed));
+	BOOST_CHECK(!history.get_edits_since(revision + 1, missed));
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,156 @@
+#include "EditOperation.h"
+
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/EditOperation.cpp
+ *
+ * Unit tests for applying, transforming and mapping positions through edit operations.
+ */
+
+//! create the edit operation testsuite
+BOOST_AUTO_TEST_SUITE(EditOperationSuite)
+
+namespace
+{
+	/**
+	 * Apply operations to a string.
+	 *
+	 * @param text The contents before the operations.
+	 * @param operations The operations to apply.
+	 * @return The contents after the operations.
+	 */
+	std::string apply(std::string const &text, EditOperations const &operations)
+	{
+		std::vector<char> contents(text.begin(), text.end());
+
+		apply_edit_operations(contents, operations);
+
+		return std::string(contents.begin(), contents.end());
+	}
+
+	/**
+	 * Convert a string to bytes.
+	 */
+	std::vector<char> bytes(std::string const &text)
+	{
+		return std::vector<char>(text.begin(), text.end());
+	}
+}
+
+//! test operations in document order, as produced by find-and-replace
+BOOST_AUTO_TEST_CASE(ascending)
+{
+	EditOperations const operations {
+		EditOperation(EditOperation::Kind::KIND_REPLACE, 0, 3, bytes("one")),
+		EditOperation(EditOperation::Kind::KIND_DELETE, 4, 4),
+		EditOperation(EditOperation::Kind::KIND_INSERT, 7, 0, bytes("!"))
+	};
+
+	BOOST_CHECK_EQUAL(apply("foo bar baz", operations), "one baz!");
+}
+
+//! test operations out of document order
+BOOST_AUTO_TEST_CASE(unordered)
+{
+	EditOperations const operations {
+		EditOperation(EditOperation::Kind::KIND_INSERT, 3, 0, bytes("de")),
+		EditOperation(EditOperation::Kind::KIND_REPLACE, 0, 1, bytes("A")),
+		EditOperation(EditOperation::Kind::KIND_INSERT, 4, 0, bytes("-"))
+	};
+
+	BOOST_CHECK_EQUAL(apply("abc", operations), "Abcd-e");
+}
+
+//! test that positions are mapped through all operations
+BOOST_AUTO_TEST_CASE(positions)
+{
+	EditOperations const operations {
+		EditOperation(EditOperation::Kind::KIND_INSERT, 2, 0, bytes("xyz")),
+		EditOperation(EditOperation::Kind::KIND_DELETE, 6, 4)
+	};
+
+	BOOST_CHECK_EQUAL(map_position(1, operations), 1);
+	BOOST_CHECK_EQUAL(map_position(2, operations), 2);
+	BOOST_CHECK_EQUAL(map_position(4, operations), 6);
+	BOOST_CHECK_EQUAL(map_position(10, operations), 9);
+}
+
+//! test that operations are summarised by the range they change
+BOOST_AUTO_TEST_CASE(range)
+{
+	EditOperations const operations {
+		EditOperation(EditOperation::Kind::KIND_INSERT, 6, 0, bytes("xyz")),
+		EditOperation(EditOperation::Kind::KIND_DELETE, 2, 2),
+		EditOperation(EditOperation::Kind::KIND_REPLACE, 5, 1, bytes("ab"))
+	};
+	int64_t position, length, inserted;
+
+	get_edit_range(operations, position, length, inserted);
+	BOOST_CHECK_EQUAL(position, 2);
+	BOOST_CHECK_EQUAL(length, 4);
+	BOOST_CHECK_EQUAL(inserted, 6);
+
+	// the bytes outside the range are kept
+	std::string const text = "0123456789";
+	std::string const result = apply(text, operations);
+	BOOST_CHECK_EQUAL(result.substr(0, position), text.substr(0, position));
+	BOOST_CHECK_EQUAL(result.substr(position + inserted), text.substr(position + length));
+
+	get_edit_range(EditOperations(), position, length, inserted);
+	BOOST_CHECK_EQUAL(length, 0);
+	BOOST_CHECK_EQUAL(inserted, 0);
+}
+
+//! test that concurrent operations converge after transforming them against each other
+BOOST_AUTO_TEST_CASE(transform_converges)
+{
+	typedef EditOperation::Kind Kind;
+	std::string const text = "abcdefgh";
+	std::vector<EditOperation> const operations {
+		EditOperation(Kind::KIND_INSERT, 0, 0, bytes("12")),
+		EditOperation(Kind::KIND_INSERT, 3, 0, bytes("34")),
+		EditOperation(Kind::KIND_INSERT, 8, 0, bytes("5")),
+		EditOperation(Kind::KIND_DELETE, 2, 3),
+		EditOperation(Kind::KIND_DELETE, 3, 4),
+		EditOperation(Kind::KIND_REPLACE, 1, 5, bytes("xyz")),
+		EditOperation(Kind::KIND_REPLACE, 4, 1, bytes("w"))
+	};
+
+	for (EditOperation const &first: operations)
+	{
+		for (EditOperation const &second: operations)
+		{
+			EditOperations a { first }, b { second };
+			EditOperations a_past_b = a, b_past_a = b;
+			transform_edit_operations(a_past_b, b_past_a);
+
+			BOOST_CHECK_EQUAL(apply(apply(text, a), b_past_a), apply(apply(text, b), a_past_b));
+		}
+	}
+}
+
+//! test that sequences are transformed as a whole
+BOOST_AUTO_TEST_CASE(transform_sequences)
+{
+	typedef EditOperation::Kind Kind;
+	std::string const text = "hello world";
+	EditOperations a {
+		EditOperation(Kind::KIND_REPLACE, 0, 5, bytes("howdy")),
+		EditOperation(Kind::KIND_INSERT, 11, 0, bytes("!"))
+	};
+	EditOperations b {
+		EditOperation(Kind::KIND_DELETE, 5, 6),
+		EditOperation(Kind::KIND_INSERT, 0, 0, bytes(">> "))
+	};
+	EditOperations a_past_b = a, b_past_a = b;
+	transform_edit_operations(a_past_b, b_past_a);
+
+	BOOST_CHECK_EQUAL(apply(apply(text, a), b_past_a), apply(apply(text, b), a_past_b));
+	BOOST_CHECK_EQUAL(apply(apply(text, b), a_past_b), ">> howdy!");
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,158 @@
+#include "LineIndex.h"
+
+#include <random>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/LineIndex.cpp
+ *
+ * Unit tests for the LineIndex.
+ */
+
+//! create the line index testsuite
+BOOST_AUTO_TEST_SUITE(LineIndexSuite)
+
+namespace
+{
+	/**
+	 * Convert a string to document contents.
+	 */
+	std::vector<char> to_contents(std::string const &string)
+	{
+		return std::vector<char>(string.begin(), string.end());
+	}
+
+	/**
+	 * Check that an index matches the lines of some contents, scanning them.
+	 */
+	void check_lines(LineIndex const &index, std::vector<char> const &contents)
+	{
+		std::int64_t line = 0;
+		std::int64_t start = 0;
+
+		for (std::size_t position = 0; position <= contents.size(); position++)
+		{
+			if (position < contents.size() && contents[position] != '\n')
+			{
+				continue;
+			}
+
+			std::int64_t const end = position < contents.size() ? position + 1 : position;
+
+			BOOST_REQUIRE_LT(line, index.get_line_count());
+			BOOST_CHECK_EQUAL(index.get_line_start(line), start);
+			BOOST_CHECK_EQUAL(index.get_line_length(line), end - start);
+			BOOST_CHECK_EQUAL(index.get_line(start), line);
+			line++;
+			start = end;
+		}
+
+		BOOST_CHECK_EQUAL(index.get_line_count(), line);
+	}
+
+	/**
+	 * Check that an index matches one built from scratch.
+	 */
+	void check_index(LineIndex const &index, std::vector<char> const &contents)
+	{
+		LineIndex const expected(contents);
+
+		BOOST_REQUIRE_EQUAL(index.get_line_count(), expected.get_line_count());
+
+		for (std::int64_t line = 0; line < expected.get_line_count(); line++)
+		{
+			BOOST_CHECK_EQUAL(index.get_line_start(line), expected.get_line_start(line));
+			BOOST_CHECK_EQUAL(index.get_line_length(line), expected.get_line_length(line));
+		}
+	}
+}
+
+//! test the lookups in both directions
+BOOST_AUTO_TEST_CASE(lookup)
+{
+	LineIndex const index(to_contents("ab\n\ncde\nf"));
+
+	BOOST_REQUIRE_EQUAL(index.get_line_count(), 4);
+	BOOST_CHECK_EQUAL(index.get_line_start(0), 0);
+	BOOST_CHECK_EQUAL(index.get_line_start(1), 3);
+	BOOST_CHECK_EQUAL(index.get_line_start(2), 4);
+	BOOST_CHECK_EQUAL(index.get_line_start(3), 8);
+	BOOST_CHECK_EQUAL(index.get_line_length(3), 1);
+
+	BOOST_CHECK_EQUAL(index.get_line(0), 0);
+	BOOST_CHECK_EQUAL(index.get_line(2), 0);
+	BOOST_CHECK_EQUAL(index.get_line(3), 1);
+	BOOST_CHECK_EQUAL(index.get_line(7), 2);
+	BOOST_CHECK_EQUAL(index.get_line(9), 3);
+
+	// a trailing newline starts an empty last line
+	LineIndex const trailing(to_contents("a\n"));
+
+	BOOST_REQUIRE_EQUAL(trailing.get_line_count(), 2);
+	BOOST_CHECK_EQUAL(trailing.get_line(2), 1);
+	BOOST_CHECK_EQUAL(trailing.get_line_length(1), 0);
+
+	BOOST_CHECK_EQUAL(LineIndex(std::vector<char>()).get_line_count(), 1);
+}
+
+//! test that random edits keep the index equal to a rebuilt one
+BOOST_AUTO_TEST_CASE(edits)
+{
+	std::mt19937 generator(7);
+	std::vector<char> contents = to_contents("first\nsecond\n\nfourth");
+	LineIndex index(contents);
+
+	for (int i = 0; i < 500; i++)
+	{
+		std::int64_t const position = generator() % (contents.size() + 1);
+		std::int64_t const length = generator() % (contents.size() - position + 1) % 8;
+		std::vector<char> bytes(generator() % 4);
+
+		for (char &byte: bytes)
+		{
+			byte = generator() % 3 == 0 ? '\n' : 'x';
+		}
+
+		EditOperation const operation(EditOperation::Kind::KIND_REPLACE, position, length,
+		                              bytes);
+
+		index.apply(operation);
+		apply_edit_operations(contents, { operation });
+		check_index(index, contents);
+		check_lines(index, contents);
+	}
+}
+
+//! test that many lines stay indexed while newlines are inserted and erased
+BOOST_AUTO_TEST_CASE(many_lines)
+{
+	std::mt19937 generator(11);
+	std::vector<char> contents;
+
+	for (int i = 0; i < 20000; i++)
+	{
+		contents.insert(contents.end(), generator() % 6, 'x');
+		contents.push_back('\n');
+	}
+
+	LineIndex index(contents);
+
+	for (int i = 0; i < 2000; i++)
+	{
+		std::int64_t const position = generator() % (contents.size() + 1);
+		std::int64_t const length = generator() % (contents.size() - position + 1) % 16;
+		std::vector<char> const bytes(generator() % 3, '\n');
+		EditOperation const operation(EditOperation::Kind::KIND_REPLACE, position, length,
+		                              bytes);
+
+		index.apply(operation);
+		apply_edit_operations(contents, { operation });
+	}
+
+	check_lines(index, contents);
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
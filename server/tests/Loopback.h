@@ -0,0 +1,109 @@
+#ifndef TESTS_LOOPBACK_H
+#define TESTS_LOOPBACK_H
+
+#include "Client.h"
+#include "ClientCollection.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @file server/tests/Loopback.h
+ *
+ * Connected pairs of a Client and the socket of its peer, for tests that need a real Client.
+ */
+
+/**
+ * A listening socket on the loopback device accepting Clients.
+ */
+class Loopback
+{
+public:
+	/**
+	 * Listen on a free port of the loopback device.
+	 */
+	Loopback()
+		: listener_(socket(AF_INET, SOCK_STREAM, 0))
+	{
+		sockaddr_in address = sockaddr_in();
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		socklen_t size = sizeof address;
+
+		if (listener_ == -1 ||
+		    bind(listener_, reinterpret_cast<sockaddr *>(&address), size) != 0 ||
+		    listen(listener_, 8) != 0 ||
+		    getsockname(listener_, reinterpret_cast<sockaddr *>(&address_), &size) != 0)
+		{
+			throw std::runtime_error("failed to listen on the loopback device");
+		}
+	}
+
+	/**
+	 * Close the listening socket and the peers of all accepted Clients.
+	 */
+	~Loopback()
+	{
+		for (int peer: peers_)
+		{
+			close(peer);
+		}
+
+		close(listener_);
+	}
+
+	Loopback(Loopback const &) = delete;
+	Loopback &operator=(Loopback const &) = delete;
+
+	/**
+	 * Connect a peer and accept it as a Client.
+	 *
+	 * @param peer Set to the socket of the peer, closed by the destructor.
+	 * @return The accepted Client.
+	 */
+	ClientSptr accept(int &peer)
+	{
+		peer = socket(AF_INET, SOCK_STREAM, 0);
+
+		// a test waiting for data that never comes fails instead of hanging
+		timeval const timeout = { 5, 0 };
+
+		if (peer == -1 || connect(peer, reinterpret_cast<sockaddr *>(&address_),
+		                          sizeof address_) != 0 ||
+		    setsockopt(peer, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout) != 0)
+		{
+			throw std::runtime_error("failed to connect on the loopback device");
+		}
+
+		peers_.push_back(peer);
+
+		return ClientSptr(new Client(listener_));
+	}
+
+	/**
+	 * Accept a Client whose peer isn't used.
+	 *
+	 * @return The accepted Client.
+	 */
+	ClientSptr accept()
+	{
+		int peer;
+
+		return accept(peer);
+	}
+
+private:
+	//! the listening socket
+	int listener_;
+	//! the address the listening socket is bound to
+	sockaddr_in address_;
+	//! the sockets of the connected peers
+	std::vector<int> peers_;
+};
+
+#endif
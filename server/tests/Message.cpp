@@ -0,0 +1,430 @@
+#include "Message.h"
+#include "MessageCodec.h"
+#include "exceptions.h"
+#include "Loopback.h"
+
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/Message.cpp
+ *
+ * Unit tests for the Message bytestream generation and parsing.
+ */
+
+//! create the message testsuite
+BOOST_AUTO_TEST_SUITE(MessageSuite)
+
+namespace
+{
+	/**
+	 * Generate the bytestream of a message in the given protocol version.
+	 *
+	 * @param message The message to encode.
+	 * @param version The protocol version.
+	 * @return The bytestream.
+	 */
+	std::vector<char> encode(Message const &message, uint8_t version)
+	{
+		std::vector<char> bytestream;
+
+		message.generate_bytestream(bytestream, version);
+
+		return bytestream;
+	}
+
+	/**
+	 * Append a 32 bit integer like protocol version 1 encodes it.
+	 *
+	 * @param dest The bytestream.
+	 * @param value The integer.
+	 */
+	void append_v1_integer(std::vector<char> &dest, uint32_t value)
+	{
+		for (int shift = 24; shift >= 0; shift -= 8)
+		{ dest.push_back(static_cast<char>(value >> shift)); }
+	}
+
+	/**
+	 * Send a protocol version 1 message consisting of a type and integers and receive it.
+	 *
+	 * @param type The message type.
+	 * @param integers The integers of the fields, a single byte for each negative one.
+	 * @return Whether the message was rejected as malformed.
+	 */
+	bool is_rejected_v1(Message::MessageType type, std::vector<int64_t> const &integers)
+	{
+		Loopback loopback;
+		int peer;
+		ClientSptr const client = loopback.accept(peer);
+
+		std::vector<char> bytes { static_cast<char>(type) };
+		for (int64_t integer: integers)
+		{
+			if (integer < 0)
+			{ bytes.push_back(static_cast<char>(-integer - 1)); }
+			else
+			{ append_v1_integer(bytes, integer); }
+		}
+		BOOST_REQUIRE_EQUAL(write(peer, bytes.data(), bytes.size()),
+			static_cast<ssize_t>(bytes.size()));
+
+		Message message;
+		try
+		{ message.receive_from(client); }
+		catch (Exception::MalformedMessage const &)
+		{ return true; }
+
+		return false;
+	}
+}
+
+//! test the compact encoding of a single keystroke
+BOOST_AUTO_TEST_CASE(sync_byte)
+{
+	Message message;
+	message.type = Message::MessageType::TYPE_SYNC_BYTE;
+	message.position = 300;
+	message.bytes = { 'x' };
+
+	std::vector<char> const v1 = encode(message, Message::PROTOCOL_VERSION_1);
+	std::vector<char> const v2 = encode(message, Message::PROTOCOL_VERSION_2);
+
+	BOOST_CHECK_EQUAL(v1.size(), 6u);
+
+	// frame length, type, varint 300 (2 bytes), byte
+	std::vector<char> const expected {
+		4, static_cast<char>(Message::MessageType::TYPE_SYNC_BYTE),
+		static_cast<char>(0xac), 0x02, 'x'
+	};
+	BOOST_CHECK(v2 == expected);
+}
+
+//! test that document list entries are no longer padded
+BOOST_AUTO_TEST_CASE(doc_list)
+{
+	Message message;
+	message.type = Message::MessageType::TYPE_DOC_LIST;
+	message.length = 2;
+	message.bytes.assign(2 * Message::FIELD_SIZE_DOC_NAME, '\0');
+	std::string const first = "notes", second = "todo.txt";
+	std::copy(first.begin(), first.end(), message.bytes.begin());
+	std::copy(second.begin(), second.end(), message.bytes.begin() + Message::FIELD_SIZE_DOC_NAME);
+
+	std::vector<char> const v1 = encode(message, Message::PROTOCOL_VERSION_1);
+	std::vector<char> const v2 = encode(message, Message::PROTOCOL_VERSION_2);
+
+	BOOST_CHECK_EQUAL(v1.size(), 1 + 4 + 2 * Message::FIELD_SIZE_DOC_NAME);
+	// frame length, type, count, 2 length-prefixed names
+	BOOST_CHECK_EQUAL(v2.size(), 1 + 1 + 1 + (1 + first.size()) + (1 + second.size()));
+	BOOST_CHECK_EQUAL(std::string(v2.begin() + 4, v2.begin() + 4 + first.size()), first);
+}
+
+//! test that listing pages survive encoding and decoding
+BOOST_AUTO_TEST_CASE(doc_list_page)
+{
+	using namespace MessageSchema;
+	typedef Fields<FIELD_POSITION, FIELD_ID, FIELD_LENGTH, FIELD_DOC_ENTRIES> Layout;
+
+	Message message;
+	message.type = Message::MessageType::TYPE_DOC_LIST_PAGE;
+	message.position = 10;
+	message.id = 12;
+	message.length = 1;
+	message.entries.resize(1);
+	message.entries[0].name = { 'n', 'o', 't', 'e', 's' };
+	message.entries[0].size = 300;
+	message.entries[0].modified = 7;
+	message.entries[0].editors = 2;
+
+	std::vector<char> const v1 = encode(message, Message::PROTOCOL_VERSION_1);
+	std::vector<char> const v2 = encode(message, Message::PROTOCOL_VERSION_2);
+
+	BOOST_CHECK_EQUAL(v1.size(), 1 + 3 * 4 + Message::FIELD_SIZE_DOC_NAME + 3 * 4);
+	// frame length, type, offset, total, count, name, 2 byte size, modified, editors
+	BOOST_CHECK_EQUAL(v2.size(), 1 + 1 + 1 + 1 + 1 + 6 + 2 + 1 + 1u);
+
+	Message decoded;
+	FrameReader reader(v2.data() + 2, v2.data() + v2.size(), -1);
+	decode_v2<Layout>(reader, decoded);
+
+	BOOST_CHECK_EQUAL(decoded.id, 12);
+	BOOST_REQUIRE_EQUAL(decoded.entries.size(), 1u);
+	BOOST_CHECK(decoded.entries[0].name == message.entries[0].name);
+	BOOST_CHECK_EQUAL(decoded.entries[0].size, 300);
+	BOOST_CHECK_EQUAL(decoded.entries[0].editors, 2);
+	BOOST_CHECK_EQUAL(decoded.entries[0].lines, 0);
+
+	// version 3 adds the lines and words
+	message.entries[0].lines = 4;
+	message.entries[0].words = 200;
+	std::vector<char> const v3 = encode(message, Message::PROTOCOL_VERSION_3);
+	BOOST_CHECK_EQUAL(v3.size(), v2.size() + 1 + 2);
+
+	FrameReader v3_reader(v3.data() + 2, v3.data() + v3.size(), -1);
+	decode_v2<Layout>(v3_reader, decoded, Message::PROTOCOL_VERSION_3);
+	BOOST_CHECK_EQUAL(decoded.entries[0].lines, 4);
+	BOOST_CHECK_EQUAL(decoded.entries[0].words, 200);
+}
+
+//! test that short names are padded in protocol version 1
+BOOST_AUTO_TEST_CASE(user_join)
+{
+	Message message;
+	message.type = Message::MessageType::TYPE_USER_JOIN;
+	message.id = 7;
+	message.name = { 'b', 'o', 'b' };
+
+	std::vector<char> const v1 = encode(message, Message::PROTOCOL_VERSION_1);
+	std::vector<char> const v2 = encode(message, Message::PROTOCOL_VERSION_2);
+
+	BOOST_CHECK_EQUAL(v1.size(), 1 + Message::FIELD_SIZE_ID + Message::FIELD_SIZE_USER_NAME);
+	BOOST_CHECK_EQUAL(v1[1 + Message::FIELD_SIZE_ID], 'b');
+	BOOST_CHECK_EQUAL(v1.back(), '\0');
+	BOOST_CHECK_EQUAL(v2.size(), 1 + 1 + 1 + 1 + 3u);
+}
+
+//! test that the logout response has a layout
+BOOST_AUTO_TEST_CASE(user_logout)
+{
+	Message message;
+	message.type = Message::MessageType::TYPE_USER_LOGOUT;
+	message.status = Message::MessageStatus::STATUS_OK;
+
+	BOOST_CHECK_EQUAL(encode(message, Message::PROTOCOL_VERSION_1).size(), 2u);
+	BOOST_CHECK_EQUAL(encode(message, Message::PROTOCOL_VERSION_2).size(), 3u);
+}
+
+//! test parsing a deletion frame and rejecting frames not matching the layout
+BOOST_AUTO_TEST_CASE(decode_sync_deletion)
+{
+	using namespace MessageSchema;
+	typedef Fields<FIELD_POSITION, FIELD_LENGTH> Layout;
+
+	// varint 300, varint 5
+	std::vector<char> const body { static_cast<char>(0xac), 0x02, 5 };
+	Message message;
+
+	FrameReader reader(body.data(), body.data() + body.size(), -1);
+	decode_v2<Layout>(reader, message);
+	BOOST_CHECK_EQUAL(message.position, 300);
+	BOOST_CHECK_EQUAL(message.length, 5);
+
+	FrameReader truncated(body.data(), body.data() + 2, -1);
+	BOOST_CHECK_THROW(decode_v2<Layout>(truncated, message), Exception::MalformedMessage);
+
+	std::vector<char> const trailing { 1, 2, 3 };
+	FrameReader too_long(trailing.data(), trailing.data() + trailing.size(), -1);
+	BOOST_CHECK_THROW(decode_v2<Layout>(too_long, message), Exception::MalformedMessage);
+}
+
+//! test that a batch survives encoding and decoding
+BOOST_AUTO_TEST_CASE(sync_batch)
+{
+	using namespace MessageSchema;
+	typedef Fields<FIELD_REVISION, FIELD_OPERATIONS> Layout;
+
+	Message message;
+	message.type = Message::MessageType::TYPE_SYNC_BATCH;
+	message.revision = 5;
+	message.operations = {
+		EditOperation(EditOperation::Kind::KIND_INSERT, 300, 0, { 'a', 'b' }),
+		EditOperation(EditOperation::Kind::KIND_DELETE, 2, 7),
+		EditOperation(EditOperation::Kind::KIND_REPLACE, 1, 1, { 'c' })
+	};
+
+	std::vector<char> const v2 = encode(message, Message::PROTOCOL_VERSION_2);
+	// frame length, type, revision, count, insert (kind, 2 byte position, size, 2 bytes),
+	// delete (kind, position, length), replace (kind, position, length, size, byte)
+	BOOST_CHECK_EQUAL(v2.size(), 1 + 1 + 1 + 1 + 6 + 3 + 5u);
+
+	Message decoded;
+	FrameReader reader(v2.data() + 2, v2.data() + v2.size(), -1);
+	decode_v2<Layout>(reader, decoded);
+
+	BOOST_CHECK_EQUAL(decoded.revision, 5);
+	BOOST_REQUIRE_EQUAL(decoded.operations.size(), 3u);
+	BOOST_CHECK_EQUAL(decoded.operations[0].position, 300);
+	BOOST_CHECK(decoded.operations[0].bytes == message.operations[0].bytes);
+	BOOST_CHECK_EQUAL(decoded.operations[1].length, 7);
+	BOOST_CHECK(decoded.operations[1].kind == EditOperation::Kind::KIND_DELETE);
+	BOOST_CHECK(decoded.operations[2].bytes == message.operations[2].bytes);
+
+	std::vector<char> invalid { 1, 3, 0 };
+	FrameReader invalid_reader(invalid.data(), invalid.data() + invalid.size(), -1);
+	BOOST_CHECK_THROW(decode_v2<Layout>(invalid_reader, decoded), Exception::MalformedMessage);
+}
+
+//! test that sequence operations survive encoding and decoding
+BOOST_AUTO_TEST_CASE(sync_sequence)
+{
+	using namespace MessageSchema;
+	typedef Fields<FIELD_STATUS, FIELD_SITE, FIELD_REVISION, FIELD_SEQUENCE> Layout;
+
+	Message message;
+	message.type = Message::MessageType::TYPE_SYNC_SEQUENCE;
+	message.status = Message::MessageStatus::STATUS_OK;
+	message.site = 2;
+	message.revision = 3;
+	message.sequence.resize(2);
+	message.sequence[0].bytes = { 'a', 'b' };
+	message.sequence[0].id = SequenceId(2, 200);
+	message.sequence[0].origin = SequenceId(0, 4);
+	message.sequence[1].id = SequenceId(0, 1);
+	message.sequence[1].kind = SequenceOperation::Kind::KIND_DELETE;
+	message.sequence[1].length = 4;
+
+	std::vector<char> const v2 = encode(message, Message::PROTOCOL_VERSION_2);
+	// frame length, type, status, site, revision, count, insertion (kind, site, 2 byte clock,
+	// origin, size, 2 bytes), deletion (kind, id, length)
+	BOOST_CHECK_EQUAL(v2.size(), 1 + 1 + 1 + 1 + 1 + 1 + 9 + 4u);
+
+	Message decoded;
+	FrameReader reader(v2.data() + 2, v2.data() + v2.size(), -1);
+	decode_v2<Layout>(reader, decoded);
+
+	BOOST_CHECK_EQUAL(decoded.site, 2);
+	BOOST_CHECK_EQUAL(decoded.revision, 3);
+	BOOST_REQUIRE_EQUAL(decoded.sequence.size(), 2u);
+	BOOST_CHECK(decoded.sequence[0].bytes == message.sequence[0].bytes);
+	BOOST_CHECK_EQUAL(decoded.sequence[0].id.clock, 200);
+	BOOST_CHECK_EQUAL(decoded.sequence[0].origin.clock, 4);
+	BOOST_CHECK(decoded.sequence[1].kind == SequenceOperation::Kind::KIND_DELETE);
+	BOOST_CHECK_EQUAL(decoded.sequence[1].length, 4);
+}
+
+//! test that version 3 carries positions beyond 32 bits, which version 2 keeps out
+BOOST_AUTO_TEST_CASE(sync_deletion_64_bit)
+{
+	using namespace MessageSchema;
+	typedef Fields<FIELD_POSITION, FIELD_LENGTH> Layout;
+
+	Message message;
+	message.type = Message::MessageType::TYPE_SYNC_DELETION;
+	message.position = (int64_t(1) << 32) + 300;
+	message.length = 5;
+
+	std::vector<char> const v3 = encode(message, Message::PROTOCOL_VERSION_3);
+	// frame length, type, 5 byte position, length
+	BOOST_CHECK_EQUAL(v3.size(), 1 + 1 + 5 + 1u);
+
+	Message decoded;
+	FrameReader reader(v3.data() + 2, v3.data() + v3.size(), -1);
+	decode_v2<Layout>(reader, decoded, Message::PROTOCOL_VERSION_3);
+	BOOST_CHECK_EQUAL(decoded.position, message.position);
+	BOOST_CHECK_EQUAL(decoded.length, 5);
+
+	// small values are encoded alike in both versions
+	message.position = 300;
+	std::vector<char> const v2 = encode(message, Message::PROTOCOL_VERSION_2);
+	BOOST_CHECK(encode(message, Message::PROTOCOL_VERSION_3) == v2);
+
+	// a version 2 varint beyond 32 bits is invalid, a revision beyond 32 bits as well
+	FrameReader v2_reader(v3.data() + 2, v3.data() + v3.size(), -1);
+	BOOST_CHECK_THROW(decode_v2<Layout>(v2_reader, decoded), Exception::MalformedMessage);
+
+	std::vector<char> const revision { static_cast<char>(0x80), static_cast<char>(0x80),
+		static_cast<char>(0x80), static_cast<char>(0x80), 0x10 };
+	FrameReader revision_reader(revision.data(), revision.data() + revision.size(), -1);
+	BOOST_CHECK_THROW(decode_v2<Fields<FIELD_REVISION>>(revision_reader, decoded,
+		Message::PROTOCOL_VERSION_3), Exception::MalformedMessage);
+}
+
+//! test that a payload longer than its frame is rejected before it is allocated
+BOOST_AUTO_TEST_CASE(truncated_payload)
+{
+	using namespace MessageSchema;
+	typedef Fields<FIELD_LENGTH, FIELD_PAYLOAD> Layout;
+
+	// varint 2^40, one byte
+	std::vector<char> const body { static_cast<char>(0x80), static_cast<char>(0x80),
+		static_cast<char>(0x80), static_cast<char>(0x80), static_cast<char>(0x80), 0x20, 'x' };
+	Message message;
+
+	FrameReader reader(body.data(), body.data() + body.size(), -1);
+	BOOST_CHECK_THROW(decode_v2<Layout>(reader, message, Message::PROTOCOL_VERSION_3),
+		Exception::MalformedMessage);
+}
+
+//! test the line based layouts in both directions
+BOOST_AUTO_TEST_CASE(doc_line)
+{
+	using namespace MessageSchema;
+	typedef Fields<FIELD_LINE, FIELD_COLUMN, FIELD_LENGTH, FIELD_PAYLOAD> Layout;
+
+	Message response;
+	response.type = Message::MessageType::TYPE_DOC_LINE;
+	response.status = Message::MessageStatus::STATUS_OK;
+	response.line = 3;
+	response.position = 200;
+	response.length = 17;
+
+	// frame length, type, status, line, 2 byte position, length
+	BOOST_CHECK_EQUAL(encode(response, Message::PROTOCOL_VERSION_2).size(), 1 + 1 + 1 + 1 + 2 + 1u);
+
+	std::vector<char> const body { 4, 2, 1, 'x' };
+	Message decoded;
+
+	FrameReader reader(body.data(), body.data() + body.size(), -1);
+	decode_v2<Layout>(reader, decoded);
+	BOOST_CHECK_EQUAL(decoded.line, 4);
+	BOOST_CHECK_EQUAL(decoded.column, 2);
+	BOOST_CHECK_EQUAL(decoded.length, 1);
+	BOOST_CHECK_EQUAL(std::string(decoded.bytes.begin(), decoded.bytes.end()), "x");
+}
+
+//! test that frame lengths beyond the protocol maximum are rejected before they are allocated
+BOOST_AUTO_TEST_CASE(oversized_frame)
+{
+	Loopback loopback;
+	int peer;
+	ClientSptr const client = loopback.accept(peer);
+	client->protocol_version = Message::PROTOCOL_VERSION_2;
+
+	// varint MAX_FRAME_SIZE + 1, followed by nothing
+	std::vector<char> header;
+	for (uint32_t length = Message::MAX_FRAME_SIZE + 1; length != 0; length >>= 7)
+	{ header.push_back(static_cast<char>((length & 0x7f) | (length >= 0x80 ? 0x80 : 0))); }
+	BOOST_REQUIRE_EQUAL(write(peer, header.data(), header.size()),
+		static_cast<ssize_t>(header.size()));
+
+	Message message;
+	BOOST_CHECK_THROW(message.receive_from(client), Exception::MalformedMessage);
+
+	// varint with bits beyond 32 in its fifth byte
+	std::vector<char> const overflow { static_cast<char>(0x80), static_cast<char>(0x80),
+		static_cast<char>(0x80), static_cast<char>(0x80), 0x10 };
+	BOOST_REQUIRE_EQUAL(write(peer, overflow.data(), overflow.size()),
+		static_cast<ssize_t>(overflow.size()));
+	BOOST_CHECK_THROW(message.receive_from(client), Exception::MalformedMessage);
+}
+
+//! test that operations of protocol version 1 are rejected before allocating a huge amount
+BOOST_AUTO_TEST_CASE(oversized_operations_v1)
+{
+	// a kind is a single byte, written as -(kind + 1)
+	int64_t const insert = -1;
+	int64_t const oversized = Message::MAX_PAYLOAD_SIZE + 1;
+
+	// revision, count, kind, position, byte count
+	BOOST_CHECK(is_rejected_v1(Message::MessageType::TYPE_SYNC_BATCH,
+		{ 0, 1, insert, 0, oversized }));
+	BOOST_CHECK(is_rejected_v1(Message::MessageType::TYPE_SYNC_BATCH,
+		{ 0, 1, insert, 0, 0x7fffffff }));
+	BOOST_CHECK(is_rejected_v1(Message::MessageType::TYPE_SYNC_BATCH, { 0, 0x7fffffff }));
+
+	// id, site, revision, count, kind, site, clock, origin site, origin clock, byte count
+	BOOST_CHECK(is_rejected_v1(Message::MessageType::TYPE_SYNC_MERGE,
+		{ 1, 1, 0, 1, insert, 1, 1, 0, 0, oversized }));
+	BOOST_CHECK(is_rejected_v1(Message::MessageType::TYPE_SYNC_MERGE, { 1, 1, 0, 0x7fffffff }));
+
+	// the bytes of all operations are bounded together
+	size_t total = Message::MAX_PAYLOAD_SIZE - 1;
+	BOOST_CHECK_EQUAL(MessageSchema::check_operation_bytes(1, total, -1), 1u);
+	BOOST_CHECK_THROW(MessageSchema::check_operation_bytes(1, total, -1),
+		Exception::MalformedMessage);
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,146 @@
+#include "Message.h"
+#include "MessageBatch.h"
+#include "Loopback.h"
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/MessageBatch.cpp
+ *
+ * Unit tests for grouping the messages of one tick by the document they target.
+ */
+
+//! create the message batch testsuite
+BOOST_AUTO_TEST_SUITE(MessageBatchSuite)
+
+namespace
+{
+	/**
+	 * Prepare a message of a client.
+	 *
+	 * @param message The message to prepare.
+	 * @param type Its type.
+	 * @param source The client sending it.
+	 * @param id The document id it carries.
+	 */
+	void prepare(Message &message, Message::MessageType type, ClientSptr const &source,
+		int32_t id = 0)
+	{
+		message.type = type;
+		message.source = source;
+		message.id = id;
+	}
+
+	/**
+	 * Check that a group holds exactly the given messages.
+	 *
+	 * @param batch The batch.
+	 * @param document_id The id of the group.
+	 * @param expected The messages in arrival order.
+	 */
+	void check_group(MessageBatch const &batch, int32_t document_id,
+		MessageBatch::MessageGroup const &expected)
+	{
+		auto const group = batch.get_groups().find(document_id);
+
+		if (expected.empty())
+		{
+			BOOST_CHECK(group == batch.get_groups().end());
+			return;
+		}
+
+		BOOST_REQUIRE(group != batch.get_groups().end());
+		BOOST_CHECK(group->second == expected);
+	}
+}
+
+//! test that edits are grouped by the active document of their sender
+BOOST_AUTO_TEST_CASE(active_document)
+{
+	Loopback loopback;
+	ClientSptr const first = loopback.accept();
+	ClientSptr const second = loopback.accept();
+	first->active_document = 1;
+	second->active_document = 2;
+
+	Message edit, cursor, other, listing;
+	prepare(edit, Message::MessageType::TYPE_SYNC_BATCH, first);
+	prepare(cursor, Message::MessageType::TYPE_SYNC_CURSOR, second);
+	prepare(other, Message::MessageType::TYPE_DOC_REPLACE, first);
+	prepare(listing, Message::MessageType::TYPE_DOC_LIST, first);
+
+	MessageBatch batch;
+	batch.add(edit);
+	batch.add(cursor);
+	batch.add(other);
+	batch.add(listing);
+
+	BOOST_CHECK(batch.get_messages() == MessageBatch::MessageGroup({ &edit, &cursor, &other,
+		&listing }));
+	check_group(batch, 1, { &edit, &other });
+	check_group(batch, 2, { &cursor });
+	check_group(batch, MessageBatch::NO_DOCUMENT, { &listing });
+}
+
+//! test that messages are grouped by the document they target when handled, not when received
+BOOST_AUTO_TEST_CASE(target_document)
+{
+	Loopback loopback;
+	ClientSptr const client = loopback.accept();
+	client->active_document = 1;
+
+	// switching documents within the batch moves the following edits along
+	Message activate, edit, save, close, after_close;
+	prepare(activate, Message::MessageType::TYPE_DOC_ACTIVATE, client, 3);
+	prepare(edit, Message::MessageType::TYPE_SYNC_BYTE, client);
+	prepare(save, Message::MessageType::TYPE_DOC_SAVE, client, 1);
+	prepare(close, Message::MessageType::TYPE_DOC_CLOSE, client, 3);
+	prepare(after_close, Message::MessageType::TYPE_SYNC_CURSOR, client);
+
+	MessageBatch batch;
+	batch.add(activate);
+	batch.add(edit);
+	batch.add(save);
+	batch.add(close);
+	batch.add(after_close);
+
+	check_group(batch, 3, { &activate, &edit, &close });
+	check_group(batch, 1, { &save });
+	check_group(batch, MessageBatch::NO_DOCUMENT, { &after_close });
+
+	// the sender itself isn't changed by grouping
+	BOOST_CHECK_EQUAL(client->active_document, 1);
+
+	// a document opened by name is only known once the open is handled
+	Message open, merge, opened_edit, merged_edit;
+	prepare(open, Message::MessageType::TYPE_DOC_OPEN, client);
+	prepare(opened_edit, Message::MessageType::TYPE_SYNC_DELETION, client);
+	prepare(merge, Message::MessageType::TYPE_SYNC_MERGE, client, 4);
+	prepare(merged_edit, Message::MessageType::TYPE_DOC_LINE, client);
+
+	MessageBatch opening;
+	opening.add(open);
+	opening.add(opened_edit);
+	opening.add(merge);
+	opening.add(merged_edit);
+
+	check_group(opening, MessageBatch::NO_DOCUMENT, { &open, &opened_edit });
+	check_group(opening, 1, {});
+	check_group(opening, 4, { &merge, &merged_edit });
+}
+
+//! test that messages without a sender don't target a document
+BOOST_AUTO_TEST_CASE(no_sender)
+{
+	Message init;
+	init.type = Message::MessageType::TYPE_INIT;
+
+	MessageBatch const batch(init);
+
+	BOOST_CHECK(!batch.empty());
+	check_group(batch, MessageBatch::NO_DOCUMENT, { &init });
+	BOOST_CHECK(MessageBatch().empty());
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,134 @@
+#include "RegexSearch.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/RegexSearch.cpp
+ *
+ * Unit tests for the search of regular expressions.
+ */
+
+//! create the regex search testsuite
+BOOST_AUTO_TEST_SUITE(RegexSearchSuite)
+
+namespace
+{
+	/**
+	 * Find all occurrences of a pattern within a string.
+	 *
+	 * @return The position and length of each occurrence.
+	 */
+	std::vector<std::pair<std::int64_t, std::int64_t>> find_all(std::string const &pattern,
+	                                                            std::string const &text)
+	{
+		std::vector<std::pair<std::int64_t, std::int64_t>> occurrences;
+
+		for (RegexSearch::Match const &match:
+		     RegexSearch(pattern).find_all(text.data(), text.data() + text.size()))
+		{
+			occurrences.emplace_back(match.get_position(), match.get_length());
+		}
+
+		return occurrences;
+	}
+
+	/**
+	 * Replace all occurrences of a pattern within a string.
+	 *
+	 * @return The string with the replacements.
+	 */
+	std::string replace_all(std::string const &pattern, std::string const &text,
+	                        std::string const &format)
+	{
+		RegexSearch const search(pattern);
+		char const *const begin = text.data(), *const end = text.data() + text.size();
+		std::vector<char> const format_bytes(format.begin(), format.end());
+		std::string result;
+		std::int64_t copied = 0;
+
+		for (RegexSearch::Match const &match: search.find_all(begin, end))
+		{
+			std::vector<char> const replacement = search.format(match, begin, end, format_bytes);
+
+			result.append(begin + copied, begin + match.get_position());
+			result.append(replacement.begin(), replacement.end());
+			copied = match.get_position() + match.get_length();
+		}
+
+		return result.append(begin + copied, end);
+	}
+
+	//! an occurrence at a position with a length
+	typedef std::pair<std::int64_t, std::int64_t> occurrence;
+}
+
+//! test literals, classes, anchors and the preference of alternatives and quantifiers
+BOOST_AUTO_TEST_CASE(find)
+{
+	typedef std::vector<occurrence> occurrences;
+
+	BOOST_CHECK(find_all("ab", "xabab") == (occurrences{ { 1, 2 }, { 3, 2 } }));
+	BOOST_CHECK(find_all("a|ab", "ab") == (occurrences{ { 0, 1 } }));
+	BOOST_CHECK(find_all("a+", "caaat") == (occurrences{ { 1, 3 } }));
+	BOOST_CHECK(find_all("a+?", "caa") == (occurrences{ { 1, 1 }, { 2, 1 } }));
+	BOOST_CHECK(find_all("<.*>", "<a><b>") == (occurrences{ { 0, 6 } }));
+	BOOST_CHECK(find_all("<.*?>", "<a><b>") == (occurrences{ { 0, 3 }, { 3, 3 } }));
+	BOOST_CHECK(find_all("x*", "ab") == (occurrences{ { 0, 0 }, { 1, 0 }, { 2, 0 } }));
+	BOOST_CHECK(find_all("\\d{2,3}", "1 12 12345") == (occurrences{ { 2, 2 }, { 5, 3 }, { 8, 2 } }));
+	BOOST_CHECK(find_all("[^a-c\\s]", "ab d") == (occurrences{ { 3, 1 } }));
+	BOOST_CHECK(find_all("[]a]", "a") == (occurrences{}));
+	BOOST_CHECK(find_all("\\bin\\b", "in int pin in") == (occurrences{ { 0, 2 }, { 11, 2 } }));
+	BOOST_CHECK(find_all("^a|a$", "aaa") == (occurrences{ { 0, 1 }, { 2, 1 } }));
+	BOOST_CHECK(find_all(".", "\n") == (occurrences{}));
+	BOOST_CHECK(find_all("\\x41\\.", "A.A") == (occurrences{ { 0, 2 } }));
+}
+
+//! test that the format refers to the groups and the surroundings of an occurrence
+BOOST_AUTO_TEST_CASE(format)
+{
+	BOOST_CHECK_EQUAL(replace_all("(\\w+)=(\\w+)", "a=1, b=2", "$2=$1"), "1=a, 2=b");
+	BOOST_CHECK_EQUAL(replace_all("b", "abc", "[$`|$&|$']"), "a[a|b|c]c");
+	BOOST_CHECK_EQUAL(replace_all("(a)|(b)", "ab", "<$1$2>"), "<a><b>");
+	BOOST_CHECK_EQUAL(replace_all("(a)", "a", "$$1 $3 $"), "$1 $3 $");
+	BOOST_CHECK_EQUAL(replace_all("(?:(a)(b)(c)(d)(e)(f)(g)(h)(i)(j))", "abcdefghij", "$10$1"),
+	                  "ja");
+}
+
+//! test that invalid and unsupported patterns are rejected
+BOOST_AUTO_TEST_CASE(invalid)
+{
+	for (std::string const pattern: { "", "(", "a)", "[a", "*", "a**", "a{2,1}", "a{", "\\1",
+	                                   "(?=a)", "\\q", "^*", "\\" })
+	{
+		BOOST_CHECK_THROW(RegexSearch search(pattern), regexsearch_errors::InvalidPatternError);
+	}
+}
+
+//! test that neither patterns nor texts can make a search arbitrarily expensive
+BOOST_AUTO_TEST_CASE(limits)
+{
+	BOOST_CHECK_THROW(RegexSearch search(std::string(RegexSearch::MAX_PATTERN_SIZE + 1, 'a')),
+	                  regexsearch_errors::TooComplexError);
+	BOOST_CHECK_THROW(RegexSearch search("(a{1,100}){1,100}"), regexsearch_errors::TooComplexError);
+	BOOST_CHECK_THROW(RegexSearch search("a{1001}"), regexsearch_errors::TooComplexError);
+
+	// one thread per byte, no recursion however long the occurrence is
+	std::string text;
+	for (std::size_t i = 0; i < 100 << 10; i++)
+	{
+		text += "ab";
+	}
+	BOOST_CHECK(find_all("(a|b)*", text) ==
+	            (std::vector<occurrence>{ { 0, text.size() }, { text.size(), 0 } }));
+
+	// hundreds of threads per byte
+	std::string const as(64 << 10, 'a');
+	BOOST_CHECK_THROW(find_all(".{1,500}z", as), regexsearch_errors::TooComplexError);
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,174 @@
+#include "SearchIndex.h"
+
+#include <map>
+#include <random>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/SearchIndex.cpp
+ *
+ * Unit tests for the SearchIndex.
+ */
+
+//! create the search index testsuite
+BOOST_AUTO_TEST_SUITE(SearchIndexSuite)
+
+namespace
+{
+	/**
+	 * Convert a string to document contents.
+	 */
+	std::vector<char> to_contents(std::string const &string)
+	{
+		return std::vector<char>(string.begin(), string.end());
+	}
+
+	/**
+	 * Check that an index answers all queries of up to three bytes of 'a',
+	 * 'b' and newlines like one built from scratch.
+	 */
+	void check_index(SearchIndex const &index, std::map<std::string, std::string> const &documents)
+	{
+		SearchIndex expected;
+		std::vector<std::string> queries(1);
+
+		for (auto const &document: documents)
+		{
+			expected.insert(document.first, to_contents(document.second));
+			BOOST_CHECK_EQUAL(index.get_size(document.first),
+			                  static_cast<std::int64_t>(document.second.size()));
+		}
+
+		for (std::size_t i = 0; i < queries.size(); i++)
+		{
+			if (queries[i].size() < SearchIndex::TRIGRAM_SIZE)
+			{
+				for (char const byte: std::string("ab\n"))
+				{
+					queries.push_back(queries[i] + byte);
+				}
+			}
+		}
+
+		BOOST_REQUIRE_EQUAL(index.get_document_count(), expected.get_document_count());
+
+		for (std::string const &query: queries)
+		{
+			std::vector<std::string> const found = index.find(query);
+			std::vector<std::string> const expected_found = expected.find(query);
+
+			BOOST_CHECK_EQUAL_COLLECTIONS(found.begin(), found.end(), expected_found.begin(),
+			                              expected_found.end());
+		}
+	}
+}
+
+//! test that queries find the documents containing all their trigrams
+BOOST_AUTO_TEST_CASE(find)
+{
+	SearchIndex index;
+
+	index.insert("fruits", to_contents("apple banana cherry"));
+	index.insert("colors", to_contents("red green blue cherry"));
+	index.insert("empty", to_contents(""));
+
+	BOOST_CHECK(index.find("banana") == std::vector<std::string>{ "fruits" });
+	BOOST_CHECK(index.find("green") == std::vector<std::string>{ "colors" });
+	BOOST_CHECK(index.find("cherry") == (std::vector<std::string>{ "colors", "fruits" }));
+	BOOST_CHECK(index.find("purple").empty());
+	BOOST_CHECK(index.find("Apple").empty());
+
+	// all trigrams match, the candidate has to be searched still
+	BOOST_CHECK(index.find("bananana") == std::vector<std::string>{ "fruits" });
+
+	// short queries can't be narrowed down
+	BOOST_CHECK_EQUAL(index.find("x").size(), 2u);
+	BOOST_CHECK_EQUAL(index.find("").size(), 3u);
+
+	index.insert("fruits", to_contents("kiwi"));
+	BOOST_CHECK(index.find("banana").empty());
+	BOOST_CHECK(index.find("kiwi") == std::vector<std::string>{ "fruits" });
+
+	index.remove("colors");
+	BOOST_CHECK(index.find("green").empty());
+	BOOST_CHECK_EQUAL(index.get_size("colors"), -1);
+	BOOST_CHECK_EQUAL(index.get_document_count(), 2u);
+}
+
+//! test that random edits keep the index equal to a rebuilt one
+BOOST_AUTO_TEST_CASE(edits)
+{
+	std::mt19937 generator(11);
+	std::map<std::string, std::string> documents = { { "one", "abba\nab" }, { "two", "" },
+	                                                 { "three", "baab" } };
+	SearchIndex index;
+
+	for (auto const &document: documents)
+	{
+		index.insert(document.first, to_contents(document.second));
+	}
+
+	for (int i = 0; i < 500; i++)
+	{
+		auto document = documents.begin();
+		std::advance(document, generator() % documents.size());
+
+		std::string &contents = document->second;
+		std::int64_t const position = generator() % (contents.size() + 1);
+		std::int64_t const length = generator() % (contents.size() - position + 1) % 6;
+		std::vector<char> bytes(generator() % 5);
+
+		for (char &byte: bytes)
+		{
+			byte = "ab\n"[generator() % 3];
+		}
+
+		EditOperation::Kind const kind = static_cast<EditOperation::Kind>(generator() % 3);
+		EditOperation const operation(kind, position, length, bytes);
+		std::vector<char> edited = to_contents(contents);
+
+		index.apply(document->first, edited, operation);
+		apply_edit_operations(edited, { operation });
+		contents.assign(edited.begin(), edited.end());
+
+		check_index(index, documents);
+	}
+}
+
+//! test that building in parallel leaves out unreadable documents
+BOOST_AUTO_TEST_CASE(build)
+{
+	std::map<std::string, std::string> documents;
+	std::vector<std::string> names = { "missing" };
+
+	for (int i = 0; i < 100; i++)
+	{
+		std::string const name = "document" + std::to_string(i);
+
+		documents[name] = std::string(i, 'a') + "b\nab" + std::string(i % 7, 'b');
+		names.push_back(name);
+	}
+
+	SearchIndex const index(names, [&documents](std::string const &name,
+	                                            std::vector<char> &contents)
+	{
+		auto const document = documents.find(name);
+
+		if (document == documents.end())
+		{
+			return false;
+		}
+
+		contents = to_contents(document->second);
+
+		return true;
+	}, 4);
+
+	BOOST_CHECK_EQUAL(index.get_size("missing"), -1);
+	check_index(index, documents);
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,135 @@
+#include "Client.h"
+#include "DocumentSnapshot.h"
+#include "SendQueue.h"
+#include "exceptions.h"
+#include "Loopback.h"
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/SendQueue.cpp
+ *
+ * Unit tests for scheduling frames by priority class.
+ */
+
+//! create the send queue testsuite
+BOOST_AUTO_TEST_SUITE(SendQueueSuite)
+
+namespace
+{
+	/**
+	 * Create a frame consisting of a single byte.
+	 */
+	Transfer frame(char byte, Transfer::Priority priority, int32_t document_id = 0)
+	{ return Transfer(std::vector<char> { byte }, priority, document_id); }
+
+	/**
+	 * Generate the next frames and return their first bytes.
+	 *
+	 * @param queue The queue.
+	 * @param window The amount of bulk frames allowed.
+	 * @return The first byte of each frame.
+	 */
+	std::string drain(SendQueue &queue, size_t window)
+	{
+		std::string result;
+		std::vector<char> bytes;
+
+		while (queue.next(bytes, Message::PROTOCOL_VERSION_1, Message::COMPRESSION_NONE,
+			window))
+		{ result += bytes.front(); }
+
+		return result;
+	}
+}
+
+//! test that interactive frames jump ahead of bulk frames without starving them
+BOOST_AUTO_TEST_CASE(priority)
+{
+	SendQueue queue;
+	queue.push(frame('b', Transfer::Priority::PRIORITY_BULK));
+	queue.push(frame('B', Transfer::Priority::PRIORITY_BULK));
+	for (size_t i = 0; i < SendQueue::INTERACTIVE_BURST + 1; ++i)
+	{ queue.push(frame('i', Transfer::Priority::PRIORITY_INTERACTIVE)); }
+
+	// without a window only interactive frames are sent
+	BOOST_CHECK_EQUAL(drain(queue, 0), std::string(SendQueue::INTERACTIVE_BURST + 1, 'i'));
+	BOOST_CHECK(!queue.empty());
+	BOOST_CHECK_EQUAL(drain(queue, 1), "b");
+
+	for (size_t i = 0; i < SendQueue::INTERACTIVE_BURST + 1; ++i)
+	{ queue.push(frame('i', Transfer::Priority::PRIORITY_INTERACTIVE)); }
+	BOOST_CHECK_EQUAL(drain(queue, 1), std::string(SendQueue::INTERACTIVE_BURST, 'i') + "Bi");
+	BOOST_CHECK(queue.empty());
+}
+
+//! test that frames referring to a document wait for its contents
+BOOST_AUTO_TEST_CASE(ordered)
+{
+	std::shared_ptr<DocumentSnapshot> contents(new DocumentSnapshot(std::vector<char>(10, 'c')));
+
+	SendQueue queue;
+	queue.push(Transfer(contents, 1));
+	queue.push(frame('e', Transfer::Priority::PRIORITY_INTERACTIVE, 1));
+	queue.push(frame('f', Transfer::Priority::PRIORITY_INTERACTIVE, 2));
+	queue.push(frame('s', Transfer::Priority::PRIORITY_INTERACTIVE));
+
+	std::string order = drain(queue, 2);
+	BOOST_CHECK_EQUAL(order.substr(0, 2), "fs");
+	BOOST_CHECK_EQUAL(order.back(), 'e');
+
+	// cancelled contents take the frames referring to them along
+	queue.push(Transfer(contents, 1));
+	queue.push(frame('e', Transfer::Priority::PRIORITY_INTERACTIVE, 1));
+	queue.push(frame('l', Transfer::Priority::PRIORITY_BULK));
+	queue.cancel(1);
+	BOOST_CHECK_EQUAL(drain(queue, 2), "l");
+}
+
+//! test that the queue takes no more frame bytes than its capacity
+BOOST_AUTO_TEST_CASE(capacity)
+{
+	std::shared_ptr<DocumentSnapshot> contents(new DocumentSnapshot(std::vector<char>(10, 'c')));
+
+	SendQueue queue(4);
+	BOOST_CHECK(queue.push(frame('a', Transfer::Priority::PRIORITY_INTERACTIVE)));
+	BOOST_CHECK(queue.push(frame('b', Transfer::Priority::PRIORITY_BULK, 1)));
+	BOOST_CHECK(queue.push(frame('c', Transfer::Priority::PRIORITY_INTERACTIVE, 1)));
+	BOOST_CHECK_EQUAL(queue.size(), 3u);
+
+	// a frame that doesn't fit is dropped, shared contents always fit
+	BOOST_CHECK(!queue.push(Transfer(std::vector<char>(2, 'd'))));
+	BOOST_CHECK(queue.push(Transfer(contents, 2)));
+	BOOST_CHECK_EQUAL(queue.size(), 3u);
+
+	// sent and cancelled frames make room again
+	std::vector<char> bytes;
+	size_t window = 0;
+	BOOST_CHECK(queue.next(bytes, Message::PROTOCOL_VERSION_1, Message::COMPRESSION_NONE,
+		window));
+	BOOST_CHECK_EQUAL(queue.size(), 2u);
+	queue.cancel(1);
+	BOOST_CHECK_EQUAL(queue.size(), 0u);
+	BOOST_CHECK(queue.push(Transfer(std::vector<char>(4, 'e'))));
+	BOOST_CHECK_EQUAL(queue.size(), 4u);
+}
+
+//! test that a client not reading is disconnected instead of queueing without bounds
+BOOST_AUTO_TEST_CASE(client_overflow)
+{
+	Loopback loopback;
+	ClientSptr const client = loopback.accept();
+	std::vector<char> const bulk(1 << 20, 'b');
+
+	// the peer doesn't read, the socket buffers fill up, then the queue
+	for (size_t i = 0; i < 2 * (SendQueue::MAX_QUEUED_BYTES >> 20); ++i)
+	{ client->send(bulk, Transfer::Priority::PRIORITY_BULK); }
+
+	// nothing is queued anymore and the event loop sees the disconnection
+	BOOST_REQUIRE(!client->has_pending());
+	char byte;
+	BOOST_CHECK_THROW(client->receive(&byte, 1), Exception::SocketDisconnected);
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,207 @@
+#include "SequenceDocument.h"
+
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/SequenceDocument.cpp
+ *
+ * Unit tests for merging offline edits through the sequence of a document.
+ */
+
+//! create the sequence document testsuite
+BOOST_AUTO_TEST_SUITE(SequenceDocumentSuite)
+
+namespace
+{
+	typedef SequenceOperation::Kind Kind;
+
+	/**
+	 * Create an insertion.
+	 */
+	SequenceOperation insertion(SequenceId const &id, SequenceId const &origin,
+		std::string const &text)
+	{
+		SequenceOperation operation;
+		operation.bytes.assign(text.begin(), text.end());
+		operation.id = id;
+		operation.kind = Kind::KIND_INSERT;
+		operation.origin = origin;
+
+		return operation;
+	}
+
+	/**
+	 * Create a deletion or run.
+	 */
+	SequenceOperation deletion(SequenceId const &id, std::int32_t length,
+		Kind kind = Kind::KIND_DELETE)
+	{
+		SequenceOperation operation;
+		operation.id = id;
+		operation.kind = kind;
+		operation.length = length;
+
+		return operation;
+	}
+
+	/**
+	 * Merge operations and apply the resulting edits to the contents.
+	 *
+	 * @param sequence The sequence of the document.
+	 * @param contents The document contents.
+	 * @param site The merging site.
+	 * @param operations The operations to merge.
+	 * @return Whether all operations have been merged.
+	 */
+	bool merge(SequenceDocument &sequence, std::string &contents, std::int32_t site,
+		SequenceOperations const &operations)
+	{
+		std::vector<char> bytes(contents.begin(), contents.end());
+		EditOperations edits;
+		SequenceOperations merged;
+
+		bool result = sequence.merge(site, operations, edits, merged);
+		apply_edit_operations(bytes, edits);
+		contents.assign(bytes.begin(), bytes.end());
+
+		return result;
+	}
+
+	/**
+	 * Check that two operations are equal.
+	 */
+	void check_operation(SequenceOperation const &operation, Kind kind, SequenceId const &id,
+		std::int32_t length)
+	{
+		BOOST_CHECK(operation.kind == kind);
+		BOOST_CHECK_EQUAL(operation.id.site, id.site);
+		BOOST_CHECK_EQUAL(operation.id.clock, id.clock);
+		BOOST_CHECK_EQUAL(operation.get_length(), length);
+	}
+}
+
+//! test that edits of two offline sites converge regardless of the merge order
+BOOST_AUTO_TEST_CASE(converge)
+{
+	// "hello" is identified by (0, 1) to (0, 5)
+	SequenceOperations const first {
+		insertion(SequenceId(1, 6), SequenceId(0, 5), " world"),
+		deletion(SequenceId(0, 1), 1)
+	};
+	SequenceOperations const second {
+		insertion(SequenceId(2, 6), SequenceId(0, 5), "!"),
+		deletion(SequenceId(0, 4), 2)
+	};
+
+	SequenceDocument a(5), b(5);
+	std::string contents_a = "hello", contents_b = "hello";
+
+	BOOST_CHECK(merge(a, contents_a, 1, first));
+	BOOST_CHECK(merge(a, contents_a, 2, second));
+	BOOST_CHECK(merge(b, contents_b, 2, second));
+	BOOST_CHECK(merge(b, contents_b, 1, first));
+
+	BOOST_CHECK_EQUAL(contents_a, contents_b);
+	BOOST_CHECK_EQUAL(contents_a, "el! world");
+}
+
+//! test that merging operations again changes nothing
+BOOST_AUTO_TEST_CASE(idempotent)
+{
+	SequenceOperations const operations {
+		insertion(SequenceId(1, 4), SequenceId(0, 3), "d"),
+		insertion(SequenceId(1, 5), SequenceId(1, 4), "e"),
+		deletion(SequenceId(0, 2), 1)
+	};
+
+	SequenceDocument sequence(3);
+	std::string contents = "abc";
+	sequence.add_site();
+
+	BOOST_CHECK(merge(sequence, contents, 1, operations));
+	BOOST_CHECK_EQUAL(contents, "acde");
+	BOOST_CHECK_EQUAL(sequence.get_revision(), 3);
+
+	BOOST_CHECK(merge(sequence, contents, 1, operations));
+	BOOST_CHECK_EQUAL(contents, "acde");
+	BOOST_CHECK_EQUAL(sequence.get_revision(), 3);
+
+	// typing on continues the run
+	SequenceOperations const snapshot = sequence.get_snapshot();
+	BOOST_REQUIRE_EQUAL(snapshot.size(), 5u);
+	check_operation(snapshot[0], Kind::KIND_RUN, SequenceId(0, 1), 1);
+	check_operation(snapshot[1], Kind::KIND_RUN, SequenceId(0, 2), 1);
+	check_operation(snapshot[2], Kind::KIND_DELETE, SequenceId(0, 2), 1);
+	check_operation(snapshot[3], Kind::KIND_RUN, SequenceId(0, 3), 1);
+	check_operation(snapshot[4], Kind::KIND_RUN, SequenceId(1, 4), 2);
+}
+
+//! test that edits of clients not in sequence mode are recorded and merged with
+BOOST_AUTO_TEST_CASE(record)
+{
+	SequenceDocument sequence(3);
+	std::string contents = "abc";
+	int32_t site = sequence.add_site();
+
+	// "aXbc", then "bc"
+	SequenceOperations recorded = sequence.record(EditOperations {
+		EditOperation(EditOperation::Kind::KIND_INSERT, 1, 0, std::vector<char> { 'X' }),
+		EditOperation(EditOperation::Kind::KIND_DELETE, 0, 2)
+	});
+	contents = "bc";
+
+	BOOST_REQUIRE_EQUAL(recorded.size(), 3u);
+	BOOST_CHECK_EQUAL(recorded[0].origin.clock, 1);
+	check_operation(recorded[0], Kind::KIND_INSERT, SequenceId(0, 4), 1);
+	check_operation(recorded[1], Kind::KIND_DELETE, SequenceId(0, 1), 1);
+	check_operation(recorded[2], Kind::KIND_DELETE, SequenceId(0, 4), 1);
+
+	// the offline site hasn't seen X, but inserts behind b
+	BOOST_CHECK(merge(sequence, contents, site, SequenceOperations {
+		insertion(SequenceId(site, 4), SequenceId(0, 2), "Y") }));
+	BOOST_CHECK_EQUAL(contents, "bYc");
+
+	// a site only misses the operations of others
+	SequenceOperations missed;
+	BOOST_CHECK(sequence.get_operations_since(0, site, missed));
+	BOOST_CHECK_EQUAL(missed.size(), 3u);
+
+	missed.clear();
+	BOOST_CHECK(sequence.get_operations_since(3, 0, missed));
+	BOOST_REQUIRE_EQUAL(missed.size(), 1u);
+	check_operation(missed[0], Kind::KIND_INSERT, SequenceId(site, 4), 1);
+
+	BOOST_CHECK(!sequence.get_operations_since(5, site, missed));
+}
+
+//! test that merging stops at the first invalid operation
+BOOST_AUTO_TEST_CASE(invalid)
+{
+	SequenceDocument sequence(3);
+	std::string contents = "abc";
+	int32_t site = sequence.add_site();
+
+	// unknown origin
+	BOOST_CHECK(!merge(sequence, contents, site, SequenceOperations {
+		insertion(SequenceId(site, 4), SequenceId(2, 3), "X") }));
+	// another site's identifiers
+	BOOST_CHECK(!merge(sequence, contents, site, SequenceOperations {
+		insertion(SequenceId(2, 4), SequenceId(0, 3), "X") }));
+	// identifier not newer than the origin
+	BOOST_CHECK(!merge(sequence, contents, site, SequenceOperations {
+		insertion(SequenceId(site, 2), SequenceId(0, 3), "X") }));
+	BOOST_CHECK_EQUAL(contents, "abc");
+
+	BOOST_CHECK(!merge(sequence, contents, site, SequenceOperations {
+		deletion(SequenceId(0, 3), 1),
+		deletion(SequenceId(0, 3), 2),
+		deletion(SequenceId(0, 1), 1)
+	}));
+	BOOST_CHECK_EQUAL(contents, "ab");
+	BOOST_CHECK_EQUAL(sequence.get_revision(), 1);
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,115 @@
+#include "TextSearch.h"
+#include "TextStatistics.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/TextSearch.cpp
+ *
+ * Unit tests for the TextSearch kernels.
+ */
+
+//! create the text search testsuite
+BOOST_AUTO_TEST_SUITE(TextSearchSuite)
+
+namespace
+{
+	//! all kernels, the ones the processor doesn't support are skipped
+	TextStatistics::Kernel const g_kernels[] = {
+		TextStatistics::Kernel::KERNEL_SCALAR,
+		TextStatistics::Kernel::KERNEL_AVX2
+	};
+
+	/**
+	 * Find all occurrences of a pattern within a string with a kernel.
+	 */
+	std::vector<std::int64_t> find_all(TextStatistics::Kernel kernel, std::string const &text,
+	                                   std::string const &pattern)
+	{
+		TextStatistics::Kernel const previous = TextStatistics::get_kernel();
+
+		TextStatistics::set_kernel(kernel);
+		std::vector<std::int64_t> const positions =
+			TextSearch::find_all(text.data(), text.data() + text.size(), pattern);
+		TextStatistics::set_kernel(previous);
+
+		return positions;
+	}
+
+	/**
+	 * Find all occurrences of a pattern within a string a position at a time.
+	 */
+	std::vector<std::int64_t> find_all_naive(std::string const &text, std::string const &pattern)
+	{
+		std::vector<std::int64_t> positions;
+
+		for (std::size_t position = 0; !pattern.empty() &&
+		     (position = text.find(pattern, position)) != std::string::npos;
+		     position += pattern.size())
+		{
+			positions.push_back(position);
+		}
+
+		return positions;
+	}
+}
+
+//! test the occurrences found by every kernel
+BOOST_AUTO_TEST_CASE(occurrences)
+{
+	// long enough to span several blocks, with occurrences across their boundaries
+	std::string const text = std::string(30, 'x') + "needle" + std::string(29, 'x') +
+	                         "needleneedle" + std::string(40, 'y') + "need";
+
+	for (TextStatistics::Kernel const kernel: g_kernels)
+	{
+		if (!TextStatistics::is_supported(kernel))
+		{
+			continue;
+		}
+
+		BOOST_CHECK(find_all(kernel, text, "needle") == (std::vector<std::int64_t>{ 30, 65, 71 }));
+		BOOST_CHECK(find_all(kernel, text, "need") ==
+		            (std::vector<std::int64_t>{ 30, 65, 71, 117 }));
+		BOOST_CHECK_EQUAL(find_all(kernel, text, "e").size(), 11u);
+		BOOST_CHECK(find_all(kernel, "aaaaa", "aa") == (std::vector<std::int64_t>{ 0, 2 }));
+		BOOST_CHECK(find_all(kernel, text, "needles").empty());
+		BOOST_CHECK(find_all(kernel, text, "").empty());
+		BOOST_CHECK(find_all(kernel, "", "x").empty());
+		BOOST_CHECK(find_all(kernel, text, text) == std::vector<std::int64_t>{ 0 });
+	}
+}
+
+//! test that the kernels agree with a naive search on random text
+BOOST_AUTO_TEST_CASE(kernels_agree)
+{
+	std::mt19937 generator(17);
+
+	for (std::size_t i = 0; i < 2000; i++)
+	{
+		std::string text(i % 300, 'a');
+		std::string pattern(1 + i % 9, 'a');
+
+		// few distinct bytes, so that the first and last byte often match alone
+		std::generate(text.begin(), text.end(), [&generator]() { return "ab"[generator() % 2]; });
+		std::generate(pattern.begin(), pattern.end(),
+		              [&generator]() { return "ab"[generator() % 2]; });
+
+		std::vector<std::int64_t> const expected = find_all_naive(text, pattern);
+
+		for (TextStatistics::Kernel const kernel: g_kernels)
+		{
+			if (TextStatistics::is_supported(kernel))
+			{
+				BOOST_REQUIRE(find_all(kernel, text, pattern) == expected);
+			}
+		}
+	}
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,139 @@
+#include "TextStatistics.h"
+
+#include <random>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/TextStatistics.cpp
+ *
+ * Unit tests for the TextStatistics kernels.
+ */
+
+//! create the text statistics testsuite
+BOOST_AUTO_TEST_SUITE(TextStatisticsSuite)
+
+namespace
+{
+	//! all kernels, the ones the processor doesn't support are skipped
+	TextStatistics::Kernel const g_kernels[] = {
+		TextStatistics::Kernel::KERNEL_SCALAR,
+		TextStatistics::Kernel::KERNEL_AVX2
+	};
+
+	/**
+	 * Scan a string with a kernel.
+	 */
+	TextStatistics scan(TextStatistics::Kernel kernel, std::string const &text)
+	{
+		TextStatistics::Kernel const previous = TextStatistics::get_kernel();
+
+		TextStatistics::set_kernel(kernel);
+		TextStatistics const statistics = TextStatistics::scan(text.data(),
+		                                                       text.data() + text.size());
+		TextStatistics::set_kernel(previous);
+
+		return statistics;
+	}
+}
+
+//! test the counts of every kernel
+BOOST_AUTO_TEST_CASE(counts)
+{
+	// long enough to span several blocks, with words across their boundaries
+	std::string const text = "one two\tthree\n\nfour  five\r\nsix seven eight nine ten eleven "
+	                         "twelve\vthirteen fourteen";
+
+	for (TextStatistics::Kernel const kernel: g_kernels)
+	{
+		if (!TextStatistics::is_supported(kernel))
+		{
+			continue;
+		}
+
+		TextStatistics const statistics = scan(kernel, text);
+
+		BOOST_CHECK_EQUAL(statistics.lines, 4);
+		BOOST_CHECK_EQUAL(statistics.words, 14);
+		BOOST_CHECK(statistics.valid_utf8);
+
+		BOOST_CHECK_EQUAL(scan(kernel, "").lines, 1);
+		BOOST_CHECK_EQUAL(scan(kernel, "").words, 0);
+		BOOST_CHECK_EQUAL(scan(kernel, "  \n").words, 0);
+	}
+}
+
+//! test the validation of every kernel, errors placed at every offset of a block
+BOOST_AUTO_TEST_CASE(validation)
+{
+	std::string const valid[] = { "\xc3\xa4", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xed\x9f\xbf",
+	                              "\xf4\x8f\xbf\xbf", "\xef\xbf\xbf" };
+	std::string const invalid[] = { "\x80", "\xc0\xaf", "\xc3", "\xe0\x80\xaf", "\xed\xa0\x80",
+	                                "\xf4\x90\x80\x80", "\xf8\x88\x80\x80\x80", "\xe2\x82",
+	                                "\xc3\xa4\xa4", "\xf0\x8f\xbf\xbf", "\xff" };
+
+	for (TextStatistics::Kernel const kernel: g_kernels)
+	{
+		if (!TextStatistics::is_supported(kernel))
+		{
+			continue;
+		}
+
+		for (std::size_t offset = 0; offset < 70; offset++)
+		{
+			std::string const padding(offset, 'a');
+
+			for (std::string const &sequence: valid)
+			{
+				BOOST_CHECK(scan(kernel, padding + sequence).valid_utf8);
+				BOOST_CHECK(scan(kernel, padding + sequence + padding).valid_utf8);
+			}
+
+			for (std::string const &sequence: invalid)
+			{
+				BOOST_CHECK(!scan(kernel, padding + sequence).valid_utf8);
+				BOOST_CHECK(!scan(kernel, padding + sequence + padding).valid_utf8);
+			}
+		}
+	}
+}
+
+//! test that the kernels agree on random text
+BOOST_AUTO_TEST_CASE(kernels_agree)
+{
+	if (!TextStatistics::is_supported(TextStatistics::Kernel::KERNEL_AVX2))
+	{
+		return;
+	}
+
+	std::mt19937 generator(13);
+	std::string const tokens[] = { "a", " ", "\n", "\t", "\xc3\xa4", "\xe2\x82\xac",
+	                               "\xf0\x9f\x98\x80" };
+
+	for (std::size_t i = 0; i < 2000; i++)
+	{
+		std::string text;
+
+		while (text.size() < i % 200)
+		{
+			text += tokens[generator() % 7];
+		}
+
+		// every other text gets a random byte, which is mostly invalid
+		if (i % 2 && !text.empty())
+		{
+			text[generator() % text.size()] = static_cast<char>(generator());
+		}
+
+		TextStatistics const scalar = scan(TextStatistics::Kernel::KERNEL_SCALAR, text);
+		TextStatistics const avx2 = scan(TextStatistics::Kernel::KERNEL_AVX2, text);
+
+		BOOST_REQUIRE_EQUAL(scalar.lines, avx2.lines);
+		BOOST_REQUIRE_EQUAL(scalar.words, avx2.words);
+		BOOST_REQUIRE_EQUAL(scalar.valid_utf8, avx2.valid_utf8);
+	}
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
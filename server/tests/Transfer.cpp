@@ -0,0 +1,149 @@
+#include "Document.h"
+#include "DocumentSnapshot.h"
+#include "MemoryDocumentStore.h"
+#include "Transfer.h"
+
+#include <zlib.h>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/Transfer.cpp
+ *
+ * Unit tests for sending documents in chunks.
+ */
+
+//! create the transfer testsuite
+BOOST_AUTO_TEST_SUITE(TransferSuite)
+
+//! test that contents are split into bounded chunks at consecutive positions
+BOOST_AUTO_TEST_CASE(chunks)
+{
+	std::vector<char> contents(2 * Transfer::CHUNK_SIZE + 10);
+	for (size_t i = 0; i < contents.size(); ++i)
+	{ contents[i] = static_cast<char>(i); }
+
+	Transfer transfer(std::make_shared<DocumentSnapshot>(contents), 1);
+	std::vector<char> bytes;
+
+	for (int32_t position = 0; position < static_cast<int32_t>(contents.size());
+		position += Transfer::CHUNK_SIZE)
+	{
+		BOOST_REQUIRE(!transfer.is_done());
+		transfer.next(bytes, Message::PROTOCOL_VERSION_2, Message::COMPRESSION_NONE);
+
+		Message expected;
+		expected.type = Message::MessageType::TYPE_SYNC_MULTIBYTE;
+		expected.position = position;
+		expected.length = std::min<int32_t>(Transfer::CHUNK_SIZE, contents.size() - position);
+		expected.bytes.assign(contents.begin() + position,
+			contents.begin() + position + expected.length);
+
+		std::vector<char> expected_bytes;
+		expected.generate_bytestream(expected_bytes, Message::PROTOCOL_VERSION_2);
+		BOOST_CHECK(bytes == expected_bytes);
+	}
+
+	BOOST_CHECK(transfer.is_done());
+}
+
+//! test that a single frame is sent as is
+BOOST_AUTO_TEST_CASE(frame)
+{
+	std::vector<char> const frame { 1, 2, 3 };
+	Transfer transfer(frame);
+	std::vector<char> bytes;
+
+	BOOST_REQUIRE(!transfer.is_done());
+	transfer.next(bytes, Message::PROTOCOL_VERSION_1, Message::COMPRESSION_ZLIB);
+	BOOST_CHECK(bytes == frame);
+	BOOST_CHECK(transfer.is_done());
+
+	BOOST_CHECK(Transfer(std::make_shared<DocumentSnapshot>(std::vector<char>()), 1).is_done());
+}
+
+//! test that transfers of one snapshot share the encoded chunks per protocol version
+BOOST_AUTO_TEST_CASE(shared)
+{
+	uint8_t const none = Message::COMPRESSION_NONE;
+	std::shared_ptr<DocumentSnapshot> snapshot = std::make_shared<DocumentSnapshot>(
+		std::vector<char>(Transfer::CHUNK_SIZE + 1, 'x'));
+	BOOST_REQUIRE_EQUAL(snapshot->get_chunk_count(), 2u);
+
+	const std::vector<char> &v1 = snapshot->get_chunk(1, Message::PROTOCOL_VERSION_1, none);
+	const std::vector<char> &v2 = snapshot->get_chunk(1, Message::PROTOCOL_VERSION_2, none);
+	BOOST_CHECK(&snapshot->get_chunk(1, Message::PROTOCOL_VERSION_1, none) == &v1);
+	BOOST_CHECK(v1 != v2);
+
+	Transfer first(snapshot, 1), second(snapshot, 1);
+	std::vector<char> first_bytes, second_bytes;
+	first.next(first_bytes, Message::PROTOCOL_VERSION_2, none);
+	second.next(second_bytes, Message::PROTOCOL_VERSION_2, none);
+	BOOST_CHECK(first_bytes == second_bytes);
+	BOOST_CHECK(first_bytes == snapshot->get_chunk(0, Message::PROTOCOL_VERSION_2, none));
+}
+
+//! test that compressible chunks are deflated and others are sent as is
+BOOST_AUTO_TEST_CASE(compressed)
+{
+	std::vector<char> contents;
+	for (int32_t i = 0; i < Transfer::CHUNK_SIZE; ++i)
+	{ contents.push_back("the quick brown fox "[i % 20]); }
+	// a single byte doesn't get smaller
+	contents.push_back('x');
+
+	DocumentSnapshot snapshot(contents);
+	const std::vector<char> &text = snapshot.get_chunk(0, Message::PROTOCOL_VERSION_1,
+		Message::COMPRESSION_ZLIB);
+	const std::vector<char> &rest = snapshot.get_chunk(1, Message::PROTOCOL_VERSION_1,
+		Message::COMPRESSION_ZLIB);
+
+	// type, position, length, payload
+	BOOST_REQUIRE_GT(text.size(), 9u);
+	BOOST_CHECK_EQUAL(text[0], static_cast<char>(Message::MessageType::TYPE_SYNC_COMPRESSED));
+	BOOST_CHECK_LT(text.size(), static_cast<size_t>(Transfer::CHUNK_SIZE) / 4);
+
+	std::vector<char> inflated(Transfer::CHUNK_SIZE);
+	uLongf inflated_length = inflated.size();
+	BOOST_CHECK_EQUAL(uncompress(reinterpret_cast<Bytef *>(inflated.data()), &inflated_length,
+		reinterpret_cast<const Bytef *>(text.data() + 9), text.size() - 9), Z_OK);
+	BOOST_CHECK(inflated == std::vector<char>(contents.begin(), contents.end() - 1));
+
+	BOOST_CHECK_EQUAL(rest[0], static_cast<char>(Message::MessageType::TYPE_SYNC_MULTIBYTE));
+	BOOST_CHECK(rest == snapshot.get_chunk(1, Message::PROTOCOL_VERSION_1,
+		Message::COMPRESSION_NONE));
+}
+
+//! test that a snapshot encodes from its document until it's detached
+BOOST_AUTO_TEST_CASE(detached)
+{
+	uint8_t const none = Message::COMPRESSION_NONE;
+	std::shared_ptr<DocumentStore> const previous = Document::get_store();
+	Document::set_store(std::make_shared<MemoryDocumentStore>());
+
+	std::shared_ptr<Document> doc = std::make_shared<Document>(Document::create("document"));
+	std::vector<char> const contents(Transfer::CHUNK_SIZE + 1, 'x');
+	doc->get_contents() = contents;
+
+	DocumentSnapshot snapshot(doc);
+	DocumentSnapshot copy(contents);
+	BOOST_REQUIRE_EQUAL(snapshot.get_chunk_count(), 2u);
+	BOOST_CHECK_EQUAL(snapshot.get_size(), 0u);
+
+	// the contents aren't copied, only the encoded chunks are kept
+	const std::vector<char> &first = snapshot.get_chunk(0, Message::PROTOCOL_VERSION_2, none);
+	BOOST_CHECK(first == copy.get_chunk(0, Message::PROTOCOL_VERSION_2, none));
+	BOOST_CHECK_EQUAL(snapshot.get_size(), first.size());
+
+	// the document may change once detached
+	snapshot.detach();
+	BOOST_CHECK_EQUAL(snapshot.get_size(), first.size() + contents.size());
+	doc->get_contents().assign(3, 'y');
+	BOOST_CHECK(snapshot.get_chunk(1, Message::PROTOCOL_VERSION_1, none) ==
+		copy.get_chunk(1, Message::PROTOCOL_VERSION_1, none));
+
+	Document::set_store(previous);
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,8 @@
 #define BOOST_TEST_MODULE Master Test Suite
 #include <boost/test/included/unit_test.hpp>
 
+#include "UserInterface.h"
+
 /**
  * @file server/tests/cte_server.cpp
  * @author Daniel Mierswa <daniel.mierswa@student.hs-rm.de>
@@ -9,7 +11,28 @@
  * Stub file to get a working unit test binary.
  */
 
-class UserInterface;
+namespace
+{
+	/**
+	 * A user interface discarding everything the tested code prints.
+	 */
+	class QuietUserInterface
+		: public UserInterface
+	{
+	public:
+		void run()
+		{
+		}
+
+	private:
+		void printfv(char const *, ...)
+		{
+		}
+	};
+
+	//! the user interface of the tested code
+	QuietUserInterface g_quiet_user_interface;
+}
 
 //! TODO: quite dirty way to share the user interface
-UserInterface *g_user_interface;
+UserInterface *g_user_interface = &g_quiet_user_interface;
@@ -0,0 +1,268 @@
+#include "Document.h"
+#include "MemoryDocumentStore.h"
+#include "Message.h"
+#include "MessageBatch.h"
+#include "MessageCodec.h"
+#include "NetworkInterface.h"
+#include "Loopback.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * @file server/tests/main_network_message_handler.cpp
+ *
+ * Unit tests for the handling of requests, sending them to the handler
+ * directly and decoding the responses its clients receive.
+ */
+
+extern void main_network_batch_handler(const MessageBatch &);
+
+//! create the message handler testsuite
+BOOST_AUTO_TEST_SUITE(MessageHandlerSuite)
+
+namespace
+{
+	/**
+	 * A logged in client using protocol version 2 and documents kept in memory.
+	 * The state of the handler outlives the fixture, each test uses documents
+	 * of its own.
+	 */
+	struct HandlerFixture
+	{
+		/**
+		 * Accept a client and replace the document store.
+		 */
+		HandlerFixture()
+			: network(0), store(std::make_shared<MemoryDocumentStore>()),
+			  previous_store(Document::get_store())
+		{
+			Document::set_store(store);
+			client = accept();
+		}
+
+		/**
+		 * Restore the document store.
+		 */
+		~HandlerFixture()
+		{
+			Document::set_store(previous_store);
+		}
+
+		/**
+		 * Accept another logged in client.
+		 *
+		 * @return The client, its peer is stored in peers.
+		 */
+		ClientSptr accept()
+		{
+			int peer;
+			ClientSptr const accepted = loopback.accept(peer);
+
+			accepted->protocol_version = Message::PROTOCOL_VERSION_2;
+			accepted->user_id = 1;
+			peers[accepted->socket] = peer;
+
+			return accepted;
+		}
+
+		/**
+		 * Create a document in the store.
+		 *
+		 * @param name The name of the document.
+		 * @param contents Its contents.
+		 */
+		void create(std::string const &name, std::vector<char> const &contents)
+		{
+			store->create(name, true)->write(contents);
+		}
+
+		/**
+		 * Send a request to the handler.
+		 *
+		 * @param request The request, sent by the client.
+		 * @param source The client sending it.
+		 */
+		void handle(Message &request, ClientSptr const &source)
+		{
+			request.source = source;
+			main_network_batch_handler(MessageBatch(request));
+		}
+
+		/**
+		 * Receive the next message of a type, skipping the ones before it.
+		 *
+		 * @param message Receives the message, its type set before.
+		 * @param destination The client the message is sent to.
+		 */
+		template <class Layout>
+		void receive(Message &message, ClientSptr const &destination)
+		{
+			int const peer = peers[destination->socket];
+
+			for (;;)
+			{
+				uint32_t length = 0;
+				unsigned char byte;
+
+				for (unsigned shift = 0; ; shift += 7)
+				{
+					BOOST_REQUIRE_EQUAL(recv(peer, &byte, 1, MSG_WAITALL), 1);
+					length |= static_cast<uint32_t>(byte & 0x7f) << shift;
+
+					if (!(byte & 0x80))
+					{ break; }
+				}
+
+				std::vector<char> frame(length);
+				BOOST_REQUIRE_EQUAL(recv(peer, frame.data(), length, MSG_WAITALL),
+					static_cast<ssize_t>(length));
+
+				if (static_cast<Message::MessageType>(frame[0]) != message.type)
+				{ continue; }
+
+				MessageSchema::FrameReader reader(frame.data() + 1, frame.data() + frame.size(),
+					peer);
+				MessageSchema::decode_v2<Layout>(reader, message);
+
+				return;
+			}
+		}
+
+		/**
+		 * Open a document and make it the client's active one.
+		 *
+		 * @param name The name of the document.
+		 * @param source The client opening it.
+		 * @param response Receives the response.
+		 */
+		void open(std::string const &name, ClientSptr const &source, Message &response)
+		{
+			using namespace MessageSchema;
+
+			Message request;
+			request.type = response.type = Message::MessageType::TYPE_DOC_OPEN;
+			request.name.assign(name.begin(), name.end());
+			handle(request, source);
+
+			receive<Fields<FIELD_STATUS, FIELD_ID, FIELD_DOC_NAME>>(response, source);
+		}
+
+		/**
+		 * Close a document.
+		 *
+		 * @param id The id of the document.
+		 * @param source The client closing it.
+		 * @param response Receives the response.
+		 */
+		void close(int32_t id, ClientSptr const &source, Message &response)
+		{
+			using namespace MessageSchema;
+
+			Message request;
+			request.type = response.type = Message::MessageType::TYPE_DOC_CLOSE;
+			request.id = id;
+			handle(request, source);
+
+			receive<Fields<FIELD_STATUS, FIELD_ID>>(response, source);
+		}
+
+		//! the network interface the handler broadcasts through
+		NetworkInterface network;
+		//! the documents of the tests
+		std::shared_ptr<MemoryDocumentStore> store;
+		//! the document store of other tests
+		std::shared_ptr<DocumentStore> previous_store;
+		//! the listener accepting the clients
+		Loopback loopback;
+		//! the peer of each client by its socket
+		std::map<int, int> peers;
+		//! the first client
+		ClientSptr client;
+	};
+}
+
+//! test that a pattern taking too many steps on a large document is rejected, not run
+BOOST_FIXTURE_TEST_CASE(replace_regex_limits, HandlerFixture)
+{
+	using namespace MessageSchema;
+	typedef Fields<FIELD_STATUS, FIELD_REVISION, FIELD_LENGTH> Layout;
+
+	create("handler_regex", std::vector<char>(200 << 10, 'a'));
+	Message opened;
+	open("handler_regex", client, opened);
+	BOOST_REQUIRE(opened.status == Message::MessageStatus::STATUS_OK_CONTENTS_FOLLOWING);
+
+	Message request;
+	request.type = Message::MessageType::TYPE_DOC_REPLACE_REGEX;
+	request.bytes = { 'x' };
+	request.length = request.bytes.size();
+
+	std::string const pathological = ".{1,500}z";
+	request.name.assign(pathological.begin(), pathological.end());
+	handle(request, client);
+	Message rejected;
+	rejected.type = request.type;
+	receive<Layout>(rejected, client);
+	BOOST_CHECK(rejected.status == Message::MessageStatus::STATUS_INVALID_PATTERN);
+
+	// used to exhaust the stack of std::regex, matches the document and the empty end now
+	std::string const alternation = "(a|b)*";
+	request.name.assign(alternation.begin(), alternation.end());
+	handle(request, client);
+	Message response;
+	response.type = request.type;
+	receive<Layout>(response, client);
+	BOOST_CHECK(response.status == Message::MessageStatus::STATUS_OK);
+	BOOST_CHECK_EQUAL(response.length, 2);
+}
+
+//! test that a document stays open while a client holds it and is reused from the cache
+BOOST_FIXTURE_TEST_CASE(close_reopen, HandlerFixture)
+{
+	// the cache compares the state of the file, a document in memory has none
+	Document::set_store(previous_store);
+	std::string const name = "handler_close_reopen";
+	std::ofstream(name) << "contents";
+
+	Message opened;
+	open(name, client, opened);
+	BOOST_REQUIRE(opened.status == Message::MessageStatus::STATUS_OK_CONTENTS_FOLLOWING);
+
+	// opening it twice doesn't keep it open after one close
+	open(name, client, opened);
+	ClientSptr const other = accept();
+	Message other_opened;
+	open(name, other, other_opened);
+	BOOST_CHECK_EQUAL(other_opened.id, opened.id);
+
+	Message closed;
+	close(opened.id, client, closed);
+	BOOST_CHECK(closed.status == Message::MessageStatus::STATUS_OK);
+	BOOST_CHECK_EQUAL(client->active_document, 0);
+	close(opened.id, client, closed);
+	BOOST_CHECK(closed.status == Message::MessageStatus::STATUS_DOC_NOT_EXIST);
+
+	// the other client still holds it until it disconnects
+	Message disconnect;
+	disconnect.type = Message::MessageType::TYPE_CLIENT_DISCONNECT;
+	handle(disconnect, other);
+
+	// a document opened anew would get another id
+	Message reopened;
+	open(name, client, reopened);
+	BOOST_CHECK(reopened.status == Message::MessageStatus::STATUS_OK_CONTENTS_FOLLOWING);
+	BOOST_CHECK_EQUAL(reopened.id, opened.id);
+
+	close(reopened.id, client, closed);
+	BOOST_CHECK(closed.status == Message::MessageStatus::STATUS_OK);
+	std::remove(name.c_str());
+}
+
+//! end the testsuite
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,824 @@
+/**
+ * @file generate_java_codec.cpp
+ *
+ * Generates MessageCodec.java for the Java client from the layout tables in MessageSchema.h, so
+ * both sides of the protocol are derived from the same definition. Writes to stdout.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MessageSchema.h"
+
+using namespace MessageSchema;
+
+namespace
+{
+	/**
+		A layout of MessageSchema.h in a form that can be iterated at runtime.
+	**/
+	struct Layout
+	{
+		std::string			type; ///< name of the Java MessageType constant
+		int					value; ///< wire value of the type
+		std::vector<Field>	fields; ///< fields in wire order
+	};
+
+	/**
+		Returns the Java expression for the protocol version 1 size of a field.
+	**/
+	std::string v1_size(Field field)
+	{
+		switch (field)
+		{
+			case FIELD_BYTE: return "FIELD_SIZE_BYTE";
+			case FIELD_COLUMN: return "FIELD_SIZE_SIZE";
+			case FIELD_COMPRESSION: return "FIELD_SIZE_BYTE";
+			case FIELD_DOC_ENTRIES:
+				return "message.length * (FIELD_SIZE_DOC_NAME + 3 * FIELD_SIZE_SIZE)";
+			case FIELD_DOC_LIST: return "message.length * FIELD_SIZE_DOC_NAME";
+			case FIELD_DOC_NAME: return "FIELD_SIZE_DOC_NAME";
+			case FIELD_HASH: return "FIELD_SIZE_HASH";
+			case FIELD_ID: return "FIELD_SIZE_ID";
+			case FIELD_INSERTED: return "FIELD_SIZE_SIZE";
+			case FIELD_LENGTH: return "FIELD_SIZE_SIZE";
+			case FIELD_LINE: return "FIELD_SIZE_SIZE";
+			case FIELD_OPERATIONS: break; // received by readOperations
+			case FIELD_PAYLOAD: return "message.length";
+			case FIELD_POSITION: return "FIELD_SIZE_SIZE";
+			case FIELD_REVISION: return "FIELD_SIZE_SIZE";
+			case FIELD_SEQUENCE: break; // received by readSequence
+			case FIELD_SITE: return "FIELD_SIZE_SIZE";
+			case FIELD_STATUS: return "FIELD_SIZE_STATUS";
+			case FIELD_USER_NAME: return "FIELD_SIZE_USER_NAME";
+			case FIELD_VERSION: return "FIELD_SIZE_BYTE";
+		}
+
+		std::abort();
+	}
+
+	/**
+		Returns whether the protocol version 1 size of a field depends on the Message.
+	**/
+	bool is_dynamic(Field field)
+	{
+		return field == FIELD_DOC_ENTRIES || field == FIELD_DOC_LIST || field == FIELD_OPERATIONS ||
+			field == FIELD_PAYLOAD || field == FIELD_SEQUENCE;
+	}
+
+	/**
+		Returns the Java expression for the encoded size of a field.
+	**/
+	std::string size(Field field)
+	{
+		switch (field)
+		{
+			case FIELD_COLUMN: return "integerSize(message.column, version)";
+			case FIELD_DOC_ENTRIES: return "docEntriesSize(message.entries, version)";
+			case FIELD_DOC_LIST: return "docListSize(message.bytes, message.length, version)";
+			case FIELD_DOC_NAME: return "nameSize(message.name, FIELD_SIZE_DOC_NAME, version)";
+			case FIELD_ID: return "integerSize(message.id, version)";
+			case FIELD_INSERTED: return "integerSize(message.inserted, version)";
+			case FIELD_LENGTH: return "integerSize(message.length, version)";
+			case FIELD_LINE: return "integerSize(message.line, version)";
+			case FIELD_OPERATIONS: return "operationsSize(message.operations, version)";
+			case FIELD_POSITION: return "integerSize(message.position, version)";
+			case FIELD_REVISION: return "integerSize(message.revision, version)";
+			case FIELD_SEQUENCE: return "sequenceSize(message.sequence, version)";
+			case FIELD_SITE: return "integerSize(message.site, version)";
+			case FIELD_USER_NAME: return "nameSize(message.name, FIELD_SIZE_USER_NAME, version)";
+			default: return v1_size(field);
+		}
+	}
+
+	/**
+		Returns the Java statement encoding a field into `buffer`.
+	**/
+	std::string write(Field field)
+	{
+		switch (field)
+		{
+			case FIELD_BYTE: return "buffer.put(message.bytes[0]);";
+			case FIELD_COLUMN: return "putInteger(buffer, message.column, version);";
+			case FIELD_COMPRESSION: return "buffer.put((byte)message.length);";
+			case FIELD_DOC_ENTRIES: return "putDocEntries(buffer, message.entries, version);";
+			case FIELD_DOC_LIST: return "putDocList(buffer, message.bytes, message.length, version);";
+			case FIELD_DOC_NAME: return "putName(buffer, message.name, FIELD_SIZE_DOC_NAME, version);";
+			case FIELD_HASH: return "putBytes(buffer, message.bytes, FIELD_SIZE_HASH);";
+			case FIELD_ID: return "putInteger(buffer, message.id, version);";
+			case FIELD_INSERTED: return "putInteger(buffer, message.inserted, version);";
+			case FIELD_LENGTH: return "putInteger(buffer, message.length, version);";
+			case FIELD_LINE: return "putInteger(buffer, message.line, version);";
+			case FIELD_OPERATIONS: return "putOperations(buffer, message.operations, version);";
+			case FIELD_PAYLOAD: return "putBytes(buffer, message.bytes, message.length);";
+			case FIELD_POSITION: return "putInteger(buffer, message.position, version);";
+			case FIELD_REVISION: return "putInteger(buffer, message.revision, version);";
+			case FIELD_SEQUENCE: return "putSequence(buffer, message.sequence, version);";
+			case FIELD_SITE: return "putInteger(buffer, message.site, version);";
+			case FIELD_STATUS: return "buffer.put((byte)message.status.ordinal());";
+			case FIELD_USER_NAME:
+				return "putName(buffer, message.name, FIELD_SIZE_USER_NAME, version);";
+			case FIELD_VERSION: return "buffer.put((byte)message.length);";
+		}
+
+		std::abort();
+	}
+
+	/**
+		Returns the Java statement decoding a field from `buffer`.
+	**/
+	std::string read(Field field)
+	{
+		switch (field)
+		{
+			case FIELD_BYTE: return "message.bytes = new byte[] { buffer.get() };";
+			case FIELD_COLUMN: return "message.column = getInteger(buffer, version);";
+			case FIELD_COMPRESSION: return "message.length = buffer.get() & 0xff;";
+			case FIELD_DOC_ENTRIES:
+				return "message.entries = getDocEntries(buffer, message.length, version);";
+			case FIELD_DOC_LIST: return "message.bytes = getDocList(buffer, message.length, version);";
+			case FIELD_DOC_NAME: return "message.name = getName(buffer, FIELD_SIZE_DOC_NAME, version);";
+			case FIELD_HASH: return "message.bytes = getBytes(buffer, FIELD_SIZE_HASH);";
+			case FIELD_ID: return "message.id = getInteger(buffer, version);";
+			case FIELD_INSERTED: return "message.inserted = getInteger(buffer, version);";
+			case FIELD_LENGTH: return "message.length = getInteger(buffer, version);";
+			case FIELD_LINE: return "message.line = getInteger(buffer, version);";
+			case FIELD_OPERATIONS: return "message.operations = getOperations(buffer, version);";
+			case FIELD_PAYLOAD: return "message.bytes = getBytes(buffer, message.length);";
+			case FIELD_POSITION: return "message.position = getInteger(buffer, version);";
+			case FIELD_REVISION: return "message.revision = getInteger(buffer, version);";
+			case FIELD_SEQUENCE: return "message.sequence = getSequence(buffer, version);";
+			case FIELD_SITE: return "message.site = getInteger(buffer, version);";
+			case FIELD_STATUS: return "message.status = getStatus(buffer);";
+			case FIELD_USER_NAME:
+				return "message.name = getName(buffer, FIELD_SIZE_USER_NAME, version);";
+			case FIELD_VERSION: return "message.length = buffer.get() & 0xff;";
+		}
+
+		std::abort();
+	}
+
+	/**
+		Emits the case of the encoder switch computing the body size of a layout.
+	**/
+	void emit_size_case(std::ostream &out, const Layout &layout)
+	{
+		out << "\t\tcase " << layout.type << ":\n";
+		for (Field field: layout.fields)
+		{ out << "\t\t\tsize += " << size(field) << ";\n"; }
+		out << "\t\t\tbreak;\n";
+	}
+
+	/**
+		Emits the case of the encoder switch writing the fields of a layout.
+	**/
+	void emit_write_case(std::ostream &out, const Layout &layout)
+	{
+		out << "\t\tcase " << layout.type << ":\n";
+		for (Field field: layout.fields)
+		{ out << "\t\t\t" << write(field) << "\n"; }
+		out << "\t\t\tbreak;\n";
+	}
+
+	/**
+		Emits the case of the protocol version 1 decoder switch. The leading fixed size fields are
+		read at once, every dynamically sized field with one more read.
+	**/
+	void emit_v1_case(std::ostream &out, const Layout &layout)
+	{
+		out << "\t\tcase " << layout.type << ":\n";
+
+		std::string prefix;
+		auto field = layout.fields.begin();
+		for (; field != layout.fields.end() && !is_dynamic(*field); ++field)
+		{ prefix += (prefix.empty() ? "" : " + ") + v1_size(*field); }
+
+		if (!prefix.empty())
+		{
+			out << "\t\t\tbuffer = readFully(channel, " << prefix << ");\n";
+			for (auto it = layout.fields.begin(); it != field; ++it)
+			{ out << "\t\t\t" << read(*it) << "\n"; }
+		}
+
+		for (; field != layout.fields.end(); ++field)
+		{
+			if (*field == FIELD_OPERATIONS)
+			{
+				out << "\t\t\tmessage.operations = readOperations(channel);\n";
+				continue;
+			}
+
+			if (*field == FIELD_SEQUENCE)
+			{
+				out << "\t\t\tmessage.sequence = readSequence(channel);\n";
+				continue;
+			}
+
+			out << "\t\t\tbuffer = readFully(channel, " << v1_size(*field) << ");\n";
+			out << "\t\t\t" << read(*field) << "\n";
+		}
+
+		out << "\t\t\tbreak;\n";
+	}
+
+	/**
+		Emits the case of the protocol version 2 decoder switch.
+	**/
+	void emit_v2_case(std::ostream &out, const Layout &layout)
+	{
+		out << "\t\tcase " << layout.type << ":\n";
+		for (Field field: layout.fields)
+		{ out << "\t\t\t" << read(field) << "\n"; }
+		out << "\t\t\tbreak;\n";
+	}
+
+	/**
+		Emits a switch over the Message type with one case per layout.
+	**/
+	void emit_switch(std::ostream &out, const std::vector<Layout> &layouts,
+		void (*emit_case)(std::ostream&, const Layout&), const char *error)
+	{
+		out << "\t\tswitch (message.type)\n\t\t{\n";
+		for (const Layout &layout: layouts)
+		{ emit_case(out, layout); }
+		out << "\t\tdefault:\n"
+			"\t\t\tthrow new CTEException(\"" << error << "\",\n"
+			"\t\t\t\tCTEException.ExceptionType.INVALID_TYPE);\n"
+			"\t\t}\n";
+	}
+
+	/**
+		The helpers shared by all generated encoders and decoders.
+	**/
+	const char *const helpers = R"(	private static int integerSize(int value, int version)
+	{ return version == PROTOCOL_VERSION_1 ? FIELD_SIZE_SIZE : varintSize(value); }
+
+	private static int varintSize(int value)
+	{
+		int size = 1;
+		for (; (value & ~0x7f) != 0; value >>>= 7)
+		{ ++size; }
+		return size;
+	}
+
+	private static byte[] nameBytes(String name, int fieldSize)
+	{
+		byte[] bytes = name == null ? new byte[0] : name.getBytes();
+		return bytes.length > fieldSize ? Arrays.copyOf(bytes, fieldSize) : bytes;
+	}
+
+	private static int nameSize(String name, int fieldSize, int version)
+	{
+		if (version == PROTOCOL_VERSION_1)
+		{ return fieldSize; }
+
+		int length = nameBytes(name, fieldSize).length;
+		return varintSize(length) + length;
+	}
+
+	private static int entryLength(byte[] list, int index)
+	{
+		int offset = index * FIELD_SIZE_DOC_NAME, length = 0;
+		while (list != null && length < FIELD_SIZE_DOC_NAME && offset + length < list.length &&
+			list[offset + length] != 0)
+		{ ++length; }
+		return length;
+	}
+
+	private static int docListSize(byte[] list, int count, int version)
+	{
+		if (version == PROTOCOL_VERSION_1)
+		{ return count * FIELD_SIZE_DOC_NAME; }
+
+		int size = 0;
+		for (int i = 0; i < count; ++i)
+		{ size += varintSize(entryLength(list, i)) + entryLength(list, i); }
+		return size;
+	}
+
+	private static int docEntriesSize(List<DocumentEntry> entries, int version)
+	{
+		int size = 0;
+		for (DocumentEntry entry: entries)
+		{
+			size += nameSize(entry.name, FIELD_SIZE_DOC_NAME, version) +
+				integerSize(entry.size, version) + integerSize(entry.modified, version) +
+				integerSize(entry.editors, version);
+		}
+		return size;
+	}
+
+	private static void putVarint(ByteBuffer buffer, int value)
+	{
+		for (; (value & ~0x7f) != 0; value >>>= 7)
+		{ buffer.put((byte)((value & 0x7f) | 0x80)); }
+		buffer.put((byte)value);
+	}
+
+	private static void putInteger(ByteBuffer buffer, int value, int version)
+	{
+		if (version == PROTOCOL_VERSION_1)
+		{ buffer.putInt(value); }
+		else
+		{ putVarint(buffer, value); }
+	}
+
+	private static void putBytes(ByteBuffer buffer, byte[] bytes, int size)
+	{
+		int copied = bytes == null ? 0 : Math.min(bytes.length, size);
+		buffer.put(bytes == null ? new byte[0] : bytes, 0, copied);
+		buffer.put(new byte[size - copied]);
+	}
+
+	private static void putName(ByteBuffer buffer, String name, int fieldSize, int version)
+	{
+		byte[] bytes = nameBytes(name, fieldSize);
+		if (version == PROTOCOL_VERSION_1)
+		{ putBytes(buffer, bytes, fieldSize); }
+		else
+		{
+			putVarint(buffer, bytes.length);
+			buffer.put(bytes);
+		}
+	}
+
+	private static void putDocList(ByteBuffer buffer, byte[] list, int count, int version)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			int length = entryLength(list, i);
+			if (version != PROTOCOL_VERSION_1)
+			{ putVarint(buffer, length); }
+			buffer.put(list, i * FIELD_SIZE_DOC_NAME, length);
+			if (version == PROTOCOL_VERSION_1)
+			{ buffer.put(new byte[FIELD_SIZE_DOC_NAME - length]); }
+		}
+	}
+
+	private static void putDocEntries(ByteBuffer buffer, List<DocumentEntry> entries, int version)
+	{
+		for (DocumentEntry entry: entries)
+		{
+			putName(buffer, entry.name, FIELD_SIZE_DOC_NAME, version);
+			putInteger(buffer, entry.size, version);
+			putInteger(buffer, entry.modified, version);
+			putInteger(buffer, entry.editors, version);
+		}
+	}
+
+	private static ByteBuffer readFully(ReadableByteChannel channel, int size)
+	throws CTEException, IOException
+	{
+		if (size < 0)
+		{
+			throw new CTEException("negative field size",
+				CTEException.ExceptionType.UNEXPECTED_EXCEPTION);
+		}
+
+		ByteBuffer buffer = ByteBuffer.allocate(size);
+		while (buffer.hasRemaining())
+		{
+			if (channel.read(buffer) < 0)
+			{ throw new EOFException("connection closed within a message"); }
+		}
+		buffer.flip();
+		return buffer;
+	}
+
+	private static int readVarint(ReadableByteChannel channel)
+	throws CTEException, IOException
+	{
+		int value = 0;
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			byte b = readFully(channel, 1).get();
+			value |= (b & 0x7f) << shift;
+			if ((b & 0x80) == 0)
+			{ return value; }
+		}
+		throw new CTEException("varint too long",
+			CTEException.ExceptionType.UNEXPECTED_EXCEPTION);
+	}
+
+	private static int getVarint(ByteBuffer buffer)
+	throws CTEException
+	{
+		int value = 0;
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			byte b = buffer.get();
+			value |= (b & 0x7f) << shift;
+			if ((b & 0x80) == 0)
+			{ return value; }
+		}
+		throw new CTEException("varint too long",
+			CTEException.ExceptionType.UNEXPECTED_EXCEPTION);
+	}
+
+	private static int getInteger(ByteBuffer buffer, int version)
+	throws CTEException
+	{ return version == PROTOCOL_VERSION_1 ? buffer.getInt() : getVarint(buffer); }
+
+	private static byte[] getBytes(ByteBuffer buffer, int size)
+	{
+		byte[] bytes = new byte[size];
+		buffer.get(bytes);
+		return bytes;
+	}
+
+	private static String getName(ByteBuffer buffer, int fieldSize, int version)
+	throws CTEException
+	{
+		byte[] bytes = getBytes(buffer, version == PROTOCOL_VERSION_1 ? fieldSize :
+			getVarint(buffer));
+		int length = 0;
+		while (length < bytes.length && bytes[length] != 0)
+		{ ++length; }
+		return new String(bytes, 0, length);
+	}
+
+	private static byte[] getDocList(ByteBuffer buffer, int count, int version)
+	throws CTEException
+	{
+		byte[] list = new byte[count * FIELD_SIZE_DOC_NAME];
+		for (int i = 0; i < count; ++i)
+		{
+			int length = version == PROTOCOL_VERSION_1 ? FIELD_SIZE_DOC_NAME : getVarint(buffer);
+			if (length > FIELD_SIZE_DOC_NAME)
+			{
+				throw new CTEException("document name too long",
+					CTEException.ExceptionType.UNEXPECTED_EXCEPTION);
+			}
+			buffer.get(list, i * FIELD_SIZE_DOC_NAME, length);
+		}
+		return list;
+	}
+
+	private static List<DocumentEntry> getDocEntries(ByteBuffer buffer, int count, int version)
+	throws CTEException
+	{
+		List<DocumentEntry> entries = new ArrayList<DocumentEntry>();
+		for (int i = 0; i < count; ++i)
+		{
+			String name = getName(buffer, FIELD_SIZE_DOC_NAME, version);
+			int size = getInteger(buffer, version), modified = getInteger(buffer, version);
+			entries.add(new DocumentEntry(name, size, modified, getInteger(buffer, version)));
+		}
+		return entries;
+	}
+
+	private static int operationsSize(List<EditOperation> operations, int version)
+	{
+		int size = integerSize(operations.size(), version);
+		for (EditOperation operation: operations)
+		{
+			size += FIELD_SIZE_BYTE + integerSize(operation.position, version);
+			if (operation.kind != EditOperation.Kind.KIND_INSERT)
+			{ size += integerSize(operation.length, version); }
+			if (operation.kind != EditOperation.Kind.KIND_DELETE)
+			{ size += integerSize(operation.bytes.length, version) + operation.bytes.length; }
+		}
+		return size;
+	}
+
+	private static void putOperations(ByteBuffer buffer, List<EditOperation> operations,
+		int version)
+	{
+		putInteger(buffer, operations.size(), version);
+		for (EditOperation operation: operations)
+		{
+			buffer.put((byte)operation.kind.ordinal());
+			putInteger(buffer, operation.position, version);
+			if (operation.kind != EditOperation.Kind.KIND_INSERT)
+			{ putInteger(buffer, operation.length, version); }
+			if (operation.kind != EditOperation.Kind.KIND_DELETE)
+			{
+				putInteger(buffer, operation.bytes.length, version);
+				buffer.put(operation.bytes);
+			}
+		}
+	}
+
+	private static EditOperation.Kind getKind(byte value)
+	throws CTEException
+	{
+		if (value < 0 || value >= EditOperation.Kind.values().length)
+		{
+			throw new CTEException("invalid edit operation",
+				CTEException.ExceptionType.UNEXPECTED_EXCEPTION);
+		}
+		return EditOperation.Kind.values()[value];
+	}
+
+	private static List<EditOperation> getOperations(ByteBuffer buffer, int version)
+	throws CTEException
+	{
+		int count = getInteger(buffer, version);
+		List<EditOperation> operations = new ArrayList<EditOperation>();
+		for (int i = 0; i < count; ++i)
+		{
+			EditOperation.Kind kind = getKind(buffer.get());
+			int position = getInteger(buffer, version), length = 0;
+			byte[] bytes = new byte[0];
+			if (kind != EditOperation.Kind.KIND_INSERT)
+			{ length = getInteger(buffer, version); }
+			if (kind != EditOperation.Kind.KIND_DELETE)
+			{ bytes = getBytes(buffer, getInteger(buffer, version)); }
+			operations.add(new EditOperation(kind, position, length, bytes));
+		}
+		return operations;
+	}
+
+	private static List<EditOperation> readOperations(ReadableByteChannel channel)
+	throws CTEException, IOException
+	{
+		int count = readFully(channel, FIELD_SIZE_SIZE).getInt();
+		List<EditOperation> operations = new ArrayList<EditOperation>();
+		for (int i = 0; i < count; ++i)
+		{
+			EditOperation.Kind kind = getKind(readFully(channel, FIELD_SIZE_BYTE).get());
+			int position = readFully(channel, FIELD_SIZE_SIZE).getInt(), length = 0;
+			byte[] bytes = new byte[0];
+			if (kind != EditOperation.Kind.KIND_INSERT)
+			{ length = readFully(channel, FIELD_SIZE_SIZE).getInt(); }
+			if (kind != EditOperation.Kind.KIND_DELETE)
+			{ bytes = readFully(channel, readFully(channel, FIELD_SIZE_SIZE).getInt()).array(); }
+			operations.add(new EditOperation(kind, position, length, bytes));
+		}
+		return operations;
+	}
+
+	private static int sequenceSize(List<SequenceOperation> sequence, int version)
+	{
+		int size = integerSize(sequence.size(), version);
+		for (SequenceOperation operation: sequence)
+		{
+			size += FIELD_SIZE_BYTE + integerSize(operation.site, version) +
+				integerSize(operation.clock, version);
+			if (operation.kind == SequenceOperation.Kind.KIND_INSERT)
+			{
+				size += integerSize(operation.originSite, version) +
+					integerSize(operation.originClock, version) +
+					integerSize(operation.bytes.length, version) + operation.bytes.length;
+			}
+			else
+			{ size += integerSize(operation.length, version); }
+		}
+		return size;
+	}
+
+	private static void putSequence(ByteBuffer buffer, List<SequenceOperation> sequence,
+		int version)
+	{
+		putInteger(buffer, sequence.size(), version);
+		for (SequenceOperation operation: sequence)
+		{
+			buffer.put((byte)operation.kind.ordinal());
+			putInteger(buffer, operation.site, version);
+			putInteger(buffer, operation.clock, version);
+			if (operation.kind == SequenceOperation.Kind.KIND_INSERT)
+			{
+				putInteger(buffer, operation.originSite, version);
+				putInteger(buffer, operation.originClock, version);
+				putInteger(buffer, operation.bytes.length, version);
+				buffer.put(operation.bytes);
+			}
+			else
+			{ putInteger(buffer, operation.length, version); }
+		}
+	}
+
+	private static SequenceOperation.Kind getSequenceKind(byte value)
+	throws CTEException
+	{
+		if (value < 0 || value >= SequenceOperation.Kind.values().length)
+		{
+			throw new CTEException("invalid sequence operation",
+				CTEException.ExceptionType.UNEXPECTED_EXCEPTION);
+		}
+		return SequenceOperation.Kind.values()[value];
+	}
+
+	private static List<SequenceOperation> getSequence(ByteBuffer buffer, int version)
+	throws CTEException
+	{
+		int count = getInteger(buffer, version);
+		List<SequenceOperation> sequence = new ArrayList<SequenceOperation>();
+		for (int i = 0; i < count; ++i)
+		{
+			SequenceOperation.Kind kind = getSequenceKind(buffer.get());
+			int site = getInteger(buffer, version), clock = getInteger(buffer, version);
+			int length = 0, originSite = 0, originClock = 0;
+			byte[] bytes = new byte[0];
+			if (kind == SequenceOperation.Kind.KIND_INSERT)
+			{
+				originSite = getInteger(buffer, version);
+				originClock = getInteger(buffer, version);
+				bytes = getBytes(buffer, getInteger(buffer, version));
+			}
+			else
+			{ length = getInteger(buffer, version); }
+			sequence.add(new SequenceOperation(kind, site, clock, length, originSite,
+				originClock, bytes));
+		}
+		return sequence;
+	}
+
+	private static List<SequenceOperation> readSequence(ReadableByteChannel channel)
+	throws CTEException, IOException
+	{
+		int count = readFully(channel, FIELD_SIZE_SIZE).getInt();
+		List<SequenceOperation> sequence = new ArrayList<SequenceOperation>();
+		for (int i = 0; i < count; ++i)
+		{
+			SequenceOperation.Kind kind =
+				getSequenceKind(readFully(channel, FIELD_SIZE_BYTE).get());
+			ByteBuffer id = readFully(channel, 2 * FIELD_SIZE_SIZE);
+			int site = id.getInt(), clock = id.getInt();
+			int length = 0, originSite = 0, originClock = 0;
+			byte[] bytes = new byte[0];
+			if (kind == SequenceOperation.Kind.KIND_INSERT)
+			{
+				ByteBuffer origin = readFully(channel, 3 * FIELD_SIZE_SIZE);
+				originSite = origin.getInt();
+				originClock = origin.getInt();
+				bytes = readFully(channel, origin.getInt()).array();
+			}
+			else
+			{ length = readFully(channel, FIELD_SIZE_SIZE).getInt(); }
+			sequence.add(new SequenceOperation(kind, site, clock, length, originSite,
+				originClock, bytes));
+		}
+		return sequence;
+	}
+
+	private static Message.MessageStatus getStatus(ByteBuffer buffer)
+	{
+		int status = buffer.get();
+		if (status < 0 || status >= Message.MessageStatus.values().length)
+		{ return Message.MessageStatus.STATUS_UNKNOWN; }
+		return Message.MessageStatus.values()[status];
+	}
+)";
+}
+
+int main(void)
+{
+	std::vector<Layout> to_server, to_client;
+
+#define LAYOUT(TYPE, ...) \
+	to_server.push_back(Layout { "TYPE_" #TYPE, \
+		static_cast<int>(Message::MessageType::TYPE_##TYPE), { __VA_ARGS__ } });
+	MESSAGE_LAYOUTS_TO_SERVER(LAYOUT)
+#undef LAYOUT
+#define LAYOUT(TYPE, ...) \
+	to_client.push_back(Layout { "TYPE_" #TYPE, \
+		static_cast<int>(Message::MessageType::TYPE_##TYPE), { __VA_ARGS__ } });
+	MESSAGE_LAYOUTS_TO_CLIENT(LAYOUT)
+#undef LAYOUT
+
+	std::ostream &out = std::cout;
+
+	out << "// Generated by server/tools/generate_java_codec from server/MessageSchema.h.\n"
+		"// Do not edit, run `make java_codec` in server/ instead.\n"
+		"\n"
+		"package de.teamone.cte;\n"
+		"\n"
+		"import java.io.EOFException;\n"
+		"import java.io.IOException;\n"
+		"import java.nio.ByteBuffer;\n"
+		"import java.nio.channels.ReadableByteChannel;\n"
+		"import java.util.ArrayList;\n"
+		"import java.util.Arrays;\n"
+		"import java.util.List;\n"
+		"\n"
+		"import static de.teamone.cte.Message.*;\n"
+		"import static de.teamone.cte.Message.MessageType.*;\n"
+		"\n"
+		"final class MessageCodec\n"
+		"{\n"
+		"\tstatic final int\n"
+		"\t\tPROTOCOL_VERSION_1 = " << int(Message::PROTOCOL_VERSION_1) << ",\n"
+		"\t\tPROTOCOL_VERSION_2 = " << int(Message::PROTOCOL_VERSION_2) << ",\n"
+		// the client keeps 32 bit positions, so it doesn't request version 3
+		"\t\tPROTOCOL_VERSION_LATEST = " << int(Message::PROTOCOL_VERSION_2) << ";\n"
+		"\t\n"
+		"\t// the wire values are the ordinals, make sure they match the server\n"
+		"\tstatic\n"
+		"\t{\n";
+
+	std::vector<const Layout *> checked;
+	for (const std::vector<Layout> *layouts: { &to_server, &to_client })
+	{
+		for (const Layout &layout: *layouts)
+		{
+			bool seen = false;
+			for (const Layout *other: checked)
+			{ seen = seen || other->type == layout.type; }
+			if (seen)
+			{ continue; }
+
+			checked.push_back(&layout);
+			out << "\t\tif (" << layout.type << ".ordinal() != " << layout.value << ")\n"
+				"\t\t{ throw new IllegalStateException(\"" << layout.type <<
+				" doesn't match the server\"); }\n";
+		}
+	}
+
+	out << "\t}\n"
+		"\t\n"
+		"\tprivate MessageCodec()\n"
+		"\t{}\n"
+		"\t\n"
+		"\t/**\n"
+		"\t * Encodes a message for sending it to the server.\n"
+		"\t * @param message\n"
+		"\t * @param version - the negotiated protocol version\n"
+		"\t * @return a buffer containing exactly the frame, ready to be written\n"
+		"\t * @throws CTEException - if the type can't be sent to the server\n"
+		"\t */\n"
+		"\tstatic ByteBuffer encode(Message message, int version)\n"
+		"\tthrows CTEException\n"
+		"\t{\n"
+		"\t\tint size = FIELD_SIZE_TYPE;\n";
+	emit_switch(out, to_server, emit_size_case, "invalid message type for sending");
+	out << "\t\t\n"
+		"\t\tByteBuffer buffer = ByteBuffer.allocate(\n"
+		"\t\t\t(version == PROTOCOL_VERSION_1 ? 0 : varintSize(size)) + size);\n"
+		"\t\tif (version != PROTOCOL_VERSION_1)\n"
+		"\t\t{ putVarint(buffer, size); }\n"
+		"\t\tbuffer.put((byte)message.type.ordinal());\n";
+	emit_switch(out, to_server, emit_write_case, "invalid message type for sending");
+	out << "\t\t\n"
+		"\t\tbuffer.flip();\n"
+		"\t\treturn buffer;\n"
+		"\t}\n"
+		"\t\n"
+		"\t/**\n"
+		"\t * Receives and decodes a message from the server. Blocks until the whole\n"
+		"\t * message has been received.\n"
+		"\t * @param channel\n"
+		"\t * @param version - the negotiated protocol version\n"
+		"\t * @throws CTEException - if the message is invalid\n"
+		"\t * @throws IOException - if an error occurred while reading from the channel\n"
+		"\t */\n"
+		"\tstatic Message decode(ReadableByteChannel channel, int version)\n"
+		"\tthrows CTEException, IOException\n"
+		"\t{\n"
+		"\t\tByteBuffer buffer = version == PROTOCOL_VERSION_1 ?\n"
+		"\t\t\treadFully(channel, FIELD_SIZE_TYPE) : readFully(channel, readVarint(channel));\n"
+		"\t\t\n"
+		"\t\tint value = buffer.get();\n"
+		"\t\tif (value < 0 || value >= MessageType.values().length)\n"
+		"\t\t{\n"
+		"\t\t\tthrow new CTEException(\"invalid message type\",\n"
+		"\t\t\t\tCTEException.ExceptionType.INVALID_TYPE);\n"
+		"\t\t}\n"
+		"\t\tMessageType type = MessageType.values()[value];\n"
+		"\t\tMessage message = new Message(type);\n"
+		"\t\t\n"
+		"\t\ttry\n"
+		"\t\t{\n"
+		"\t\t\tif (version == PROTOCOL_VERSION_1)\n"
+		"\t\t\t{ decodeV1(channel, message); }\n"
+		"\t\t\telse\n"
+		"\t\t\t{\n"
+		"\t\t\t\tdecodeV2(buffer, message);\n"
+		"\t\t\t\tif (buffer.hasRemaining())\n"
+		"\t\t\t\t{\n"
+		"\t\t\t\t\tthrow new CTEException(\"trailing bytes in frame\",\n"
+		"\t\t\t\t\t\tCTEException.ExceptionType.UNEXPECTED_EXCEPTION);\n"
+		"\t\t\t\t}\n"
+		"\t\t\t}\n"
+		"\t\t}\n"
+		"\t\tcatch (java.nio.BufferUnderflowException e)\n"
+		"\t\t{\n"
+		"\t\t\tthrow new CTEException(\"truncated frame\",\n"
+		"\t\t\t\tCTEException.ExceptionType.UNEXPECTED_EXCEPTION, e);\n"
+		"\t\t}\n"
+		"\t\t\n"
+		"\t\treturn message;\n"
+		"\t}\n"
+		"\t\n"
+		"\tprivate static void decodeV1(ReadableByteChannel channel, Message message)\n"
+		"\tthrows CTEException, IOException\n"
+		"\t{\n"
+		"\t\tfinal int version = PROTOCOL_VERSION_1;\n"
+		"\t\tByteBuffer buffer;\n";
+	emit_switch(out, to_client, emit_v1_case, "invalid message type");
+	out << "\t}\n"
+		"\t\n"
+		"\tprivate static void decodeV2(ByteBuffer buffer, Message message)\n"
+		"\tthrows CTEException\n"
+		"\t{\n"
+		"\t\tfinal int version = PROTOCOL_VERSION_2;\n";
+	emit_switch(out, to_client, emit_v2_case, "invalid message type");
+	out << "\t}\n"
+		"\t\n"
+		<< helpers <<
+		"}\n";
+
+	return 0;
+}